@@ -21,13 +21,19 @@
 #define GUAC_COMMON_SSH_SFTP_H
 
 #include "common/json.h"
+#include "common/listing.h"
+#include "common/stat-cache.h"
 #include "ssh.h"
 
 #include <guacamole/object.h>
+#include <guacamole/timestamp.h>
 #include <guacamole/user.h>
 #include <libssh2.h>
 #include <libssh2_sftp.h>
 
+#include <pthread.h>
+#include <stdint.h>
+
 /**
  * Maximum number of bytes per path.
  */
@@ -38,6 +44,46 @@
  */
 #define GUAC_COMMON_SSH_SFTP_MAX_DEPTH 1024
 
+/**
+ * The number of milliseconds that the cached metadata of files on the SFTP
+ * server remains valid. Changes made to the remote filesystem by other means
+ * cannot be detected, thus such changes may not be visible until the
+ * relevant metadata expires.
+ */
+#define GUAC_COMMON_SSH_SFTP_STAT_CACHE_TTL 5000
+
+/**
+ * The default number of blobs of a download which may be sent to the user
+ * without having been acknowledged.
+ */
+#define GUAC_COMMON_SSH_SFTP_DEFAULT_DOWNLOAD_WINDOW 16
+
+/**
+ * The maximum number of bytes to request from the SFTP server with each read
+ * performed on behalf of a download. Larger reads allow libssh2 to pipeline
+ * several SFTP requests at once.
+ */
+#define GUAC_COMMON_SSH_SFTP_DOWNLOAD_READ_SIZE 131072
+
+/**
+ * The number of bytes of each download which may be read ahead of the data
+ * sent to the user.
+ */
+#define GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE 1048576
+
+/**
+ * The maximum number of bytes to pass to the SFTP server with each write
+ * performed on behalf of an upload. Larger writes allow libssh2 to pipeline
+ * several SFTP requests at once.
+ */
+#define GUAC_COMMON_SSH_SFTP_UPLOAD_WRITE_SIZE 131072
+
+/**
+ * The number of bytes of each upload which may be received and acknowledged
+ * ahead of the data actually written to the SFTP server.
+ */
+#define GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE 1048576
+
 /**
  * Representation of an SFTP-driven filesystem object. Unlike guac_object, this
  * structure is not tied to any particular user.
@@ -80,8 +126,242 @@ typedef struct guac_common_ssh_sftp_filesystem {
      */
     int disable_upload;
 
+    /**
+     * The number of blobs of each download which may be sent to the user
+     * without having been acknowledged. By default, this will be
+     * GUAC_COMMON_SSH_SFTP_DEFAULT_DOWNLOAD_WINDOW.
+     */
+    int download_window;
+
+    /**
+     * Lock which serializes all use of the SFTP session, which may be used
+     * concurrently both by the threads handling user input and by the threads
+     * reading ahead on behalf of downloads.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Cache of the metadata of files on the SFTP server, keyed by absolute
+     * path, such that directories may be browsed without a round trip to the
+     * server for each symbolic link or each navigation into a directory.
+     */
+    guac_common_stat_cache* stat_cache;
+
+    /**
+     * The state of the most recent paged directory listing, retained such
+     * that the following page continues that listing rather than reading the
+     * directory again.
+     */
+    guac_common_listing_cache listings;
+
+    /**
+     * Lock which guards the lists of active downloads and uploads. This lock
+     * is distinct
+     * from the lock serializing use of the SFTP session, as that lock may be
+     * held for the duration of a read or write by a transfer's thread.
+     */
+    pthread_mutex_t transfers_lock;
+
+    /**
+     * All downloads which have not yet been freed, stored as a doubly-linked
+     * list, such that their threads can be stopped and joined before the SFTP
+     * session is shut down.
+     */
+    struct guac_common_ssh_sftp_download* downloads;
+
+    /**
+     * All uploads which have not yet been freed, stored as a doubly-linked
+     * list, such that their threads can be stopped and joined before the SFTP
+     * session is shut down.
+     */
+    struct guac_common_ssh_sftp_upload* uploads;
+
 } guac_common_ssh_sftp_filesystem;
 
+/**
+ * The state of an outbound SFTP data transfer (download). Data is read ahead
+ * from the SFTP server by a dedicated thread into a ring buffer, while blobs
+ * are sent from that buffer as the user acknowledges previous blobs, with up
+ * to download_window blobs awaiting acknowledgement at any time.
+ */
+typedef struct guac_common_ssh_sftp_download {
+
+    /**
+     * The SFTP filesystem containing the file being downloaded.
+     */
+    guac_common_ssh_sftp_filesystem* filesystem;
+
+    /**
+     * The file being downloaded.
+     */
+    LIBSSH2_SFTP_HANDLE* file;
+
+    /**
+     * The absolute path of the file being downloaded.
+     */
+    char path[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+
+    /**
+     * The thread reading ahead from the file.
+     */
+    pthread_t thread;
+
+    /**
+     * Lock which guards access to all buffer state and flags of this
+     * download.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever data is added to or removed from
+     * the buffer, or the download is stopped.
+     */
+    pthread_cond_t modified;
+
+    /**
+     * Ring buffer of GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE bytes
+     * containing data read from the file but not yet sent.
+     */
+    char* buffer;
+
+    /**
+     * The offset within the buffer of the next byte to send.
+     */
+    int read_pos;
+
+    /**
+     * The number of bytes within the buffer which have not yet been sent.
+     */
+    int buffered;
+
+    /**
+     * The number of blobs sent which have not yet been acknowledged.
+     */
+    int in_flight;
+
+    /**
+     * Non-zero if the end of the file has been reached or reading has failed,
+     * such that no further data will be added to the buffer.
+     */
+    int eof;
+
+    /**
+     * Non-zero if reading from the file failed.
+     */
+    int error;
+
+    /**
+     * Non-zero if the thread reading ahead from the file should stop.
+     */
+    int stopping;
+
+    /**
+     * The total number of bytes sent to the user.
+     */
+    uint64_t bytes_sent;
+
+    /**
+     * The time at which the download began.
+     */
+    guac_timestamp started;
+
+    /**
+     * The previous download within the list of active downloads of the
+     * filesystem, or NULL if this is the first download.
+     */
+    struct guac_common_ssh_sftp_download* prev;
+
+    /**
+     * The next download within the list of active downloads of the
+     * filesystem, or NULL if this is the last download.
+     */
+    struct guac_common_ssh_sftp_download* next;
+
+} guac_common_ssh_sftp_download;
+
+/**
+ * The state of an inbound SFTP data transfer (upload). Received blobs are
+ * acknowledged as soon as they have been copied into a bounded ring buffer,
+ * while a dedicated thread drains that buffer to the SFTP server using large,
+ * pipelined writes.
+ */
+typedef struct guac_common_ssh_sftp_upload {
+
+    /**
+     * The SFTP filesystem receiving the uploaded file.
+     */
+    guac_common_ssh_sftp_filesystem* filesystem;
+
+    /**
+     * The file being written, or NULL if the file could not be opened.
+     */
+    LIBSSH2_SFTP_HANDLE* file;
+
+    /**
+     * The thread writing buffered data to the file. This thread is running
+     * only if file is non-NULL.
+     */
+    pthread_t thread;
+
+    /**
+     * Lock which guards access to all buffer state and flags of this upload.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever data is added to or removed from
+     * the buffer, or the upload is closed.
+     */
+    pthread_cond_t modified;
+
+    /**
+     * Ring buffer of GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE bytes containing
+     * data received from the user but not yet written.
+     */
+    char* buffer;
+
+    /**
+     * The offset within the buffer of the next byte to write.
+     */
+    int read_pos;
+
+    /**
+     * The number of bytes within the buffer which have not yet been written.
+     */
+    int buffered;
+
+    /**
+     * Non-zero if writing to the file has failed, in which case any further
+     * data received is discarded.
+     */
+    int error;
+
+    /**
+     * Non-zero if no further data will be received, and the thread writing
+     * to the file should exit once the buffer has been drained.
+     */
+    int closing;
+
+    /**
+     * Non-zero if the thread writing to the file should exit immediately,
+     * discarding any data not yet written.
+     */
+    int stopping;
+
+    /**
+     * The previous upload within the list of active uploads of the
+     * filesystem, or NULL if this is the first upload.
+     */
+    struct guac_common_ssh_sftp_upload* prev;
+
+    /**
+     * The next upload within the list of active uploads of the filesystem,
+     * or NULL if this is the last upload.
+     */
+    struct guac_common_ssh_sftp_upload* next;
+
+} guac_common_ssh_sftp_upload;
+
 /**
  * The current state of a directory listing operation.
  */
@@ -95,6 +375,9 @@ typedef struct guac_common_ssh_sftp_ls_state {
     /**
      * Reference to the directory currently being listed over SFTP. This
      * directory must already be open from a call to libssh2_sftp_opendir().
+     * If the entries of the directory are being sorted, all entries are read
+     * into the entries array before the listing begins, and this will be
+     * NULL.
      */
     LIBSSH2_SFTP_HANDLE* directory;
 
@@ -103,6 +386,24 @@ typedef struct guac_common_ssh_sftp_ls_state {
      */
     char directory_name[GUAC_COMMON_SSH_SFTP_MAX_PATH];
 
+    /**
+     * The portion of the directory being listed, as requested by the user.
+     * The path of this page points to directory_name.
+     */
+    guac_common_listing_page page;
+
+    /**
+     * The number of entries of the directory which have been skipped or
+     * listed so far.
+     */
+    int position;
+
+    /**
+     * All entries of the directory, sorted by name, if the listing has been
+     * requested in that order. Unused otherwise.
+     */
+    guac_common_listing_entries entries;
+
     /**
      * The current state of the JSON directory object being written.
      */
@@ -149,8 +450,11 @@ guac_common_ssh_sftp_filesystem* guac_common_ssh_create_sftp_filesystem(
 
 /**
  * Destroys the given filesystem object, disconnecting from SFTP and freeing
- * and associated resources. Any associated session or user objects must be
- * explicitly destroyed.
+ * and associated resources. Any downloads or uploads still in progress are
+ * stopped and freed before the SFTP session is shut down, thus no handlers of
+ * the streams of those transfers may be invoked once this function has been
+ * called. Any associated session or user objects must be explicitly
+ * destroyed.
  *
  * @param filesystem
  *     The filesystem object to destroy.
@@ -207,7 +511,8 @@ void* guac_common_ssh_expose_sftp_filesystem(guac_user* user, void* data);
  * Initiates an SFTP file download to the user via the Guacamole "file"
  * instruction. The download will be automatically monitored and continued
  * after this function terminates in response to "ack" instructions received by
- * the user.
+ * the user, with the file read ahead by a separate thread such that the
+ * handling of those "ack" instructions rarely waits for the SFTP server.
  *
  * @param filesystem
  *     The filesystem containing the file to be downloaded.
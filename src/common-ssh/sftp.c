@@ -19,17 +19,21 @@
 
 #include "common-ssh/sftp.h"
 #include "common-ssh/ssh.h"
+#include "common/stat-cache.h"
 
 #include <guacamole/client.h>
 #include <guacamole/object.h>
 #include <guacamole/protocol.h>
 #include <guacamole/socket.h>
 #include <guacamole/string.h>
+#include <guacamole/timestamp.h>
 #include <guacamole/user.h>
 #include <libssh2.h>
 
 #include <fcntl.h>
+#include <inttypes.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -103,7 +107,8 @@ int guac_common_ssh_sftp_normalize_path(char* fullpath,
 
 /**
  * Translates the last error message received by the SFTP layer of an SSH
- * session into a Guacamole protocol status code.
+ * session into a Guacamole protocol status code. The filesystem must be
+ * locked.
  *
  * @param filesystem
  *     The object (not guac_object) defining the filesystem associated with the
@@ -283,11 +288,272 @@ static int guac_ssh_append_path(char* fullpath, const char* path_a,
 
 }
 
+/**
+ * Writes the given data to the given file in its entirety, continuing after
+ * any partial writes. The filesystem containing the file must be locked.
+ *
+ * @param file
+ *     The file to write to.
+ *
+ * @param data
+ *     The data to write.
+ *
+ * @param length
+ *     The number of bytes of data to write.
+ *
+ * @return
+ *     Zero if all data was written successfully, non-zero otherwise.
+ */
+static int guac_common_ssh_sftp_write_all(LIBSSH2_SFTP_HANDLE* file,
+        const char* data, int length) {
+
+    while (length > 0) {
+
+        ssize_t written = libssh2_sftp_write(file, data, length);
+        if (written <= 0)
+            return 1;
+
+        data += written;
+        length -= written;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Thread which drains the buffer of an inbound SFTP data transfer (upload),
+ * writing its contents to the file being uploaded until the upload is closed
+ * and all buffered data has been written, writing fails, or the upload is
+ * stopped.
+ *
+ * @param data
+ *     The guac_common_ssh_sftp_upload to write on behalf of.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_ssh_sftp_upload_thread(void* data) {
+
+    guac_common_ssh_sftp_upload* upload = (guac_common_ssh_sftp_upload*) data;
+    guac_common_ssh_sftp_filesystem* filesystem = upload->filesystem;
+
+    pthread_mutex_lock(&upload->lock);
+    for (;;) {
+
+        /* Wait for data or for the upload to be closed or stopped */
+        while (upload->buffered == 0 && !upload->closing
+                && !upload->stopping)
+            pthread_cond_wait(&upload->modified, &upload->lock);
+
+        /* Nothing left to do once stopped, or once closed and drained */
+        if (upload->stopping || upload->buffered == 0)
+            break;
+
+        /* Write the buffered data preceding the end of the buffer, which
+         * will not be touched by the receiving side until marked as free */
+        int length = GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE
+            - upload->read_pos;
+
+        if (length > upload->buffered)
+            length = upload->buffered;
+
+        if (length > GUAC_COMMON_SSH_SFTP_UPLOAD_WRITE_SIZE)
+            length = GUAC_COMMON_SSH_SFTP_UPLOAD_WRITE_SIZE;
+
+        pthread_mutex_unlock(&upload->lock);
+
+        pthread_mutex_lock(&filesystem->lock);
+        int failed = guac_common_ssh_sftp_write_all(upload->file,
+                upload->buffer + upload->read_pos, length);
+        pthread_mutex_unlock(&filesystem->lock);
+
+        pthread_mutex_lock(&upload->lock);
+
+        /* Abandon any remaining data if stopped */
+        if (upload->stopping)
+            break;
+
+        /* Discard all remaining data if writing fails */
+        if (failed) {
+            upload->error = 1;
+            upload->buffered = 0;
+            pthread_cond_broadcast(&upload->modified);
+            break;
+        }
+
+        upload->read_pos = (upload->read_pos + length)
+            % GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE;
+        upload->buffered -= length;
+        pthread_cond_broadcast(&upload->modified);
+
+    }
+    pthread_mutex_unlock(&upload->lock);
+
+    return NULL;
+
+}
+
+/**
+ * Allocates the state of a new inbound SFTP data transfer (upload), starting
+ * the thread which will write received data to the given file.
+ *
+ * @param filesystem
+ *     The SFTP filesystem receiving the uploaded file.
+ *
+ * @param file
+ *     The file being written, or NULL if the file could not be opened.
+ *
+ * @return
+ *     A newly-allocated guac_common_ssh_sftp_upload, which will be freed
+ *     automatically when the upload's stream is ended or the filesystem is
+ *     destroyed, or NULL if the upload could not be allocated, in which case
+ *     the given file (if any) has been closed.
+ */
+static guac_common_ssh_sftp_upload* guac_common_ssh_sftp_upload_alloc(
+        guac_common_ssh_sftp_filesystem* filesystem,
+        LIBSSH2_SFTP_HANDLE* file) {
+
+    guac_common_ssh_sftp_upload* upload =
+        calloc(1, sizeof(guac_common_ssh_sftp_upload));
+
+    /* Allocate buffer for data awaiting writing only if the file is open */
+    if (upload != NULL && file != NULL) {
+        upload->buffer = malloc(GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE);
+        if (upload->buffer == NULL) {
+            free(upload);
+            upload = NULL;
+        }
+    }
+
+    /* The file cannot be written without any upload state */
+    if (upload == NULL) {
+
+        guac_client_log(filesystem->ssh_session->client, GUAC_LOG_ERROR,
+                "Unable to allocate state for SFTP upload.");
+
+        if (file != NULL) {
+            pthread_mutex_lock(&filesystem->lock);
+            libssh2_sftp_close(file);
+            pthread_mutex_unlock(&filesystem->lock);
+        }
+
+        return NULL;
+
+    }
+
+    upload->filesystem = filesystem;
+    upload->file = file;
+
+    pthread_mutex_init(&upload->lock, NULL);
+    pthread_cond_init(&upload->modified, NULL);
+
+    /* Track upload such that it can be stopped if the filesystem is
+     * destroyed before the upload is ended */
+    pthread_mutex_lock(&filesystem->transfers_lock);
+    upload->next = filesystem->uploads;
+    if (upload->next != NULL)
+        upload->next->prev = upload;
+    filesystem->uploads = upload;
+    pthread_mutex_unlock(&filesystem->transfers_lock);
+
+    if (file == NULL)
+        return upload;
+
+    /* Fall back to treating the file as unwritable if no thread can be
+     * started to write to it */
+    if (pthread_create(&upload->thread, NULL,
+                guac_common_ssh_sftp_upload_thread, upload)) {
+
+        guac_client_log(filesystem->ssh_session->client, GUAC_LOG_ERROR,
+                "Unable to start thread for SFTP upload.");
+
+        pthread_mutex_lock(&filesystem->lock);
+        libssh2_sftp_close(file);
+        pthread_mutex_unlock(&filesystem->lock);
+
+        upload->file = NULL;
+
+    }
+
+    return upload;
+
+}
+
+/**
+ * Frees the given inbound SFTP data transfer (upload), removing it from the
+ * list of active uploads of its filesystem. The thread writing on behalf of
+ * the upload, if any, must already have been joined, and the file being
+ * uploaded must already have been closed.
+ *
+ * @param upload
+ *     The upload to free.
+ */
+static void guac_common_ssh_sftp_upload_free(
+        guac_common_ssh_sftp_upload* upload) {
+
+    guac_common_ssh_sftp_filesystem* filesystem = upload->filesystem;
+
+    /* Remove from list of active uploads */
+    pthread_mutex_lock(&filesystem->transfers_lock);
+    if (upload->prev != NULL)
+        upload->prev->next = upload->next;
+    else
+        filesystem->uploads = upload->next;
+    if (upload->next != NULL)
+        upload->next->prev = upload->prev;
+    pthread_mutex_unlock(&filesystem->transfers_lock);
+
+    pthread_cond_destroy(&upload->modified);
+    pthread_mutex_destroy(&upload->lock);
+    free(upload->buffer);
+    free(upload);
+
+}
+
+/**
+ * Stops the given inbound SFTP data transfer (upload), discarding any data
+ * not yet written, closes the file being uploaded, and frees the upload.
+ *
+ * @param upload
+ *     The upload to abort.
+ */
+static void guac_common_ssh_sftp_upload_abort(
+        guac_common_ssh_sftp_upload* upload) {
+
+    guac_common_ssh_sftp_filesystem* filesystem = upload->filesystem;
+
+    if (upload->file != NULL) {
+
+        /* Stop writing without waiting for buffered data */
+        pthread_mutex_lock(&upload->lock);
+        upload->stopping = 1;
+        pthread_cond_broadcast(&upload->modified);
+        pthread_mutex_unlock(&upload->lock);
+
+        pthread_join(upload->thread, NULL);
+
+        pthread_mutex_lock(&filesystem->lock);
+        libssh2_sftp_close(upload->file);
+        pthread_mutex_unlock(&filesystem->lock);
+
+    }
+
+    guac_client_log(filesystem->ssh_session->client, GUAC_LOG_DEBUG,
+            "SFTP upload aborted");
+
+    guac_common_ssh_sftp_upload_free(upload);
+
+}
+
 /**
  * Handler for blob messages which continue an inbound SFTP data transfer
  * (upload). The data associated with the given stream is expected to be a
- * pointer to an open LIBSSH2_SFTP_HANDLE for the file to which the data
- * should be written.
+ * pointer to the guac_common_ssh_sftp_upload describing the file to which the
+ * data should be written. Received data is copied into the upload's buffer
+ * and acknowledged immediately, waiting only if that buffer is full, with
+ * the data actually written by the upload's thread.
  *
  * @param user
  *     The user receiving the blob message.
@@ -307,12 +573,46 @@ static int guac_ssh_append_path(char* fullpath, const char* path_a,
 static int guac_common_ssh_sftp_blob_handler(guac_user* user,
         guac_stream* stream, void* data, int length) {
 
-    /* Pull file from stream */
-    LIBSSH2_SFTP_HANDLE* file = (LIBSSH2_SFTP_HANDLE*) stream->data;
+    /* Pull upload state from stream */
+    guac_common_ssh_sftp_upload* upload =
+        (guac_common_ssh_sftp_upload*) stream->data;
+
+    int failed = 1;
+
+    if (upload->file != NULL) {
 
-    /* Attempt write */
-    if (libssh2_sftp_write(file, data, length) == length) {
-        guac_user_log(user, GUAC_LOG_DEBUG, "%i bytes written", length);
+        pthread_mutex_lock(&upload->lock);
+
+        /* Wait for room within buffer */
+        while (!upload->error && GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE
+                - upload->buffered < length)
+            pthread_cond_wait(&upload->modified, &upload->lock);
+
+        /* Queue data for writing, wrapping around the end of the buffer */
+        if (!upload->error) {
+
+            int write_pos = (upload->read_pos + upload->buffered)
+                % GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE;
+
+            int first = GUAC_COMMON_SSH_SFTP_UPLOAD_BUFFER_SIZE - write_pos;
+            if (first > length)
+                first = length;
+
+            memcpy(upload->buffer + write_pos, data, first);
+            memcpy(upload->buffer, (char*) data + first, length - first);
+
+            upload->buffered += length;
+            pthread_cond_broadcast(&upload->modified);
+
+        }
+
+        failed = upload->error;
+        pthread_mutex_unlock(&upload->lock);
+
+    }
+
+    if (!failed) {
+        guac_user_log(user, GUAC_LOG_DEBUG, "%i bytes queued", length);
         guac_protocol_send_ack(user->socket, stream, "SFTP: OK",
                 GUAC_PROTOCOL_STATUS_SUCCESS);
         guac_socket_flush(user->socket);
@@ -333,8 +633,10 @@ static int guac_common_ssh_sftp_blob_handler(guac_user* user,
 /**
  * Handler for end messages which terminate an inbound SFTP data transfer
  * (upload). The data associated with the given stream is expected to be a
- * pointer to an open LIBSSH2_SFTP_HANDLE for the file to which the data
- * has been written and which should now be closed.
+ * pointer to the guac_common_ssh_sftp_upload describing the file to which the
+ * data has been written and which should now be closed. All buffered data is
+ * written before the file is closed, and the upload state is freed by this
+ * handler.
  *
  * @param user
  *     The user receiving the end message.
@@ -348,11 +650,52 @@ static int guac_common_ssh_sftp_blob_handler(guac_user* user,
 static int guac_common_ssh_sftp_end_handler(guac_user* user,
         guac_stream* stream) {
 
-    /* Pull file from stream */
-    LIBSSH2_SFTP_HANDLE* file = (LIBSSH2_SFTP_HANDLE*) stream->data;
+    /* Pull upload state from stream */
+    guac_common_ssh_sftp_upload* upload =
+        (guac_common_ssh_sftp_upload*) stream->data;
+
+    guac_common_ssh_sftp_filesystem* filesystem = upload->filesystem;
+
+    int opened = (upload->file != NULL);
+    int write_failed = 0;
+    int closed = 0;
+
+    if (opened) {
 
-    /* Attempt to close file */
-    if (libssh2_sftp_close(file) == 0) {
+        /* Wait for all buffered data to be written */
+        pthread_mutex_lock(&upload->lock);
+        upload->closing = 1;
+        pthread_cond_broadcast(&upload->modified);
+        pthread_mutex_unlock(&upload->lock);
+
+        pthread_join(upload->thread, NULL);
+        write_failed = upload->error;
+
+        /* Attempt to close file */
+        pthread_mutex_lock(&filesystem->lock);
+        closed = (libssh2_sftp_close(upload->file) == 0);
+        pthread_mutex_unlock(&filesystem->lock);
+
+    }
+
+    stream->data = NULL;
+    guac_common_ssh_sftp_upload_free(upload);
+
+    /* The failure to open the file was reported when the stream was opened */
+    if (!opened) {
+        guac_user_log(user, GUAC_LOG_DEBUG, "Upload ended for file which "
+                "could not be opened");
+        guac_protocol_send_ack(user->socket, stream, "SFTP: File not open",
+                GUAC_PROTOCOL_STATUS_RESOURCE_NOT_FOUND);
+        guac_socket_flush(user->socket);
+    }
+    else if (write_failed) {
+        guac_user_log(user, GUAC_LOG_INFO, "Unable to write to file");
+        guac_protocol_send_ack(user->socket, stream, "SFTP: Write failed",
+                GUAC_PROTOCOL_STATUS_SERVER_ERROR);
+        guac_socket_flush(user->socket);
+    }
+    else if (closed) {
         guac_user_log(user, GUAC_LOG_DEBUG, "File closed");
         guac_protocol_send_ack(user->socket, stream, "SFTP: OK",
                 GUAC_PROTOCOL_STATUS_SUCCESS);
@@ -374,6 +717,7 @@ int guac_common_ssh_sftp_handle_file_stream(
         guac_stream* stream, char* mimetype, char* filename) {
 
     char fullpath[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+    guac_protocol_status status;
     LIBSSH2_SFTP_HANDLE* file;
 
     /* Ignore upload if uploads have been disabled */
@@ -406,13 +750,32 @@ int guac_common_ssh_sftp_handle_file_stream(
     }
 
     /* Open file via SFTP */
+    pthread_mutex_lock(&filesystem->lock);
     file = libssh2_sftp_open(filesystem->sftp_session, fullpath,
             LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
             S_IRUSR | S_IWUSR);
+    status = guac_sftp_get_status(filesystem);
+    pthread_mutex_unlock(&filesystem->lock);
+
+    /* Allocate upload state, which closes the file if allocation fails */
+    guac_common_ssh_sftp_upload* upload =
+        guac_common_ssh_sftp_upload_alloc(filesystem, file);
+
+    if (upload == NULL) {
+        guac_user_log(user, GUAC_LOG_ERROR,
+                "Unable to begin upload of file \"%s\"", fullpath);
+        guac_protocol_send_ack(user->socket, stream, "SFTP: Upload failed",
+                GUAC_PROTOCOL_STATUS_SERVER_ERROR);
+        guac_socket_flush(user->socket);
+        return 0;
+    }
 
     /* Inform of status */
     if (file != NULL) {
 
+        guac_common_stat_cache_invalidate(filesystem->stat_cache, fullpath);
+        guac_common_listing_cache_invalidate(&filesystem->listings);
+
         guac_user_log(user, GUAC_LOG_DEBUG,
                 "File \"%s\" opened",
                 fullpath);
@@ -425,7 +788,7 @@ int guac_common_ssh_sftp_handle_file_stream(
         guac_user_log(user, GUAC_LOG_INFO,
                 "Unable to open file \"%s\"", fullpath);
         guac_protocol_send_ack(user->socket, stream, "SFTP: Open failed",
-                guac_sftp_get_status(filesystem));
+                status);
         guac_socket_flush(user->socket);
     }
 
@@ -434,16 +797,250 @@ int guac_common_ssh_sftp_handle_file_stream(
     stream->end_handler = guac_common_ssh_sftp_end_handler;
 
     /* Store file within stream */
-    stream->data = file;
+    stream->data = upload;
     return 0;
 
 }
 
+/**
+ * Thread which reads ahead from the file of an outbound SFTP data transfer
+ * (download), filling the download's buffer until the end of the file is
+ * reached, reading fails, or the download is stopped.
+ *
+ * @param data
+ *     The guac_common_ssh_sftp_download to read ahead on behalf of.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_ssh_sftp_download_thread(void* data) {
+
+    guac_common_ssh_sftp_download* download =
+        (guac_common_ssh_sftp_download*) data;
+
+    guac_common_ssh_sftp_filesystem* filesystem = download->filesystem;
+
+    pthread_mutex_lock(&download->lock);
+    while (!download->stopping) {
+
+        /* Wait until there is room for another full read */
+        if (GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE - download->buffered
+                < GUAC_COMMON_SSH_SFTP_DOWNLOAD_READ_SIZE) {
+            pthread_cond_wait(&download->modified, &download->lock);
+            continue;
+        }
+
+        /* Read into the free space following the buffered data, which will
+         * not be touched by the sending side until marked as buffered */
+        int write_pos = (download->read_pos + download->buffered)
+            % GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE;
+
+        int length = GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE - write_pos;
+        if (length > GUAC_COMMON_SSH_SFTP_DOWNLOAD_READ_SIZE)
+            length = GUAC_COMMON_SSH_SFTP_DOWNLOAD_READ_SIZE;
+
+        pthread_mutex_unlock(&download->lock);
+
+        pthread_mutex_lock(&filesystem->lock);
+        ssize_t bytes_read = libssh2_sftp_read(download->file,
+                download->buffer + write_pos, length);
+        pthread_mutex_unlock(&filesystem->lock);
+
+        pthread_mutex_lock(&download->lock);
+
+        /* Stop reading at EOF or upon error */
+        if (bytes_read <= 0) {
+            download->eof = 1;
+            download->error = (bytes_read < 0);
+            pthread_cond_broadcast(&download->modified);
+            break;
+        }
+
+        download->buffered += bytes_read;
+        pthread_cond_broadcast(&download->modified);
+
+    }
+    pthread_mutex_unlock(&download->lock);
+
+    return NULL;
+
+}
+
+/**
+ * Opens the file at the given path for reading and begins reading ahead from
+ * that file in a separate thread, returning the state of a new outbound SFTP
+ * data transfer (download).
+ *
+ * @param filesystem
+ *     The SFTP filesystem containing the file to download.
+ *
+ * @param path
+ *     The absolute path of the file to download.
+ *
+ * @return
+ *     A newly-allocated guac_common_ssh_sftp_download, or NULL if the file
+ *     cannot be opened or the download cannot be started.
+ */
+static guac_common_ssh_sftp_download* guac_common_ssh_sftp_download_alloc(
+        guac_common_ssh_sftp_filesystem* filesystem, const char* path) {
+
+    /* Attempt to open file for reading */
+    pthread_mutex_lock(&filesystem->lock);
+    LIBSSH2_SFTP_HANDLE* file = libssh2_sftp_open(filesystem->sftp_session,
+            path, LIBSSH2_FXF_READ, 0);
+    pthread_mutex_unlock(&filesystem->lock);
+
+    if (file == NULL)
+        return NULL;
+
+    guac_common_ssh_sftp_download* download =
+        calloc(1, sizeof(guac_common_ssh_sftp_download));
+
+    /* Allocate buffer to be filled by reading ahead */
+    if (download != NULL) {
+        download->buffer = malloc(GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE);
+        if (download->buffer == NULL) {
+            free(download);
+            download = NULL;
+        }
+    }
+
+    /* The file cannot be downloaded without any download state */
+    if (download == NULL) {
+
+        guac_client_log(filesystem->ssh_session->client, GUAC_LOG_ERROR,
+                "Unable to allocate state for SFTP download.");
+
+        pthread_mutex_lock(&filesystem->lock);
+        libssh2_sftp_close(file);
+        pthread_mutex_unlock(&filesystem->lock);
+
+        return NULL;
+
+    }
+
+    download->filesystem = filesystem;
+    download->file = file;
+    download->started = guac_timestamp_current();
+    guac_strlcpy(download->path, path, sizeof(download->path));
+
+    pthread_mutex_init(&download->lock, NULL);
+    pthread_cond_init(&download->modified, NULL);
+
+    /* Begin reading ahead */
+    if (pthread_create(&download->thread, NULL,
+                guac_common_ssh_sftp_download_thread, download)) {
+
+        pthread_mutex_lock(&filesystem->lock);
+        libssh2_sftp_close(file);
+        pthread_mutex_unlock(&filesystem->lock);
+
+        pthread_cond_destroy(&download->modified);
+        pthread_mutex_destroy(&download->lock);
+        free(download->buffer);
+        free(download);
+        return NULL;
+
+    }
+
+    /* Track download such that it can be stopped if the filesystem is
+     * destroyed before the download completes */
+    pthread_mutex_lock(&filesystem->transfers_lock);
+    download->next = filesystem->downloads;
+    if (download->next != NULL)
+        download->next->prev = download;
+    filesystem->downloads = download;
+    pthread_mutex_unlock(&filesystem->transfers_lock);
+
+    return download;
+
+}
+
+/**
+ * Stops the thread reading ahead on behalf of the given outbound SFTP data
+ * transfer (download), closes the file being downloaded, and frees all
+ * associated memory.
+ *
+ * @param download
+ *     The download to free.
+ */
+static void guac_common_ssh_sftp_download_free(
+        guac_common_ssh_sftp_download* download) {
+
+    guac_common_ssh_sftp_filesystem* filesystem = download->filesystem;
+    guac_client* client = filesystem->ssh_session->client;
+
+    /* Stop reading ahead */
+    pthread_mutex_lock(&download->lock);
+    download->stopping = 1;
+    pthread_cond_broadcast(&download->modified);
+    pthread_mutex_unlock(&download->lock);
+
+    pthread_join(download->thread, NULL);
+
+    /* Remove from list of active downloads */
+    pthread_mutex_lock(&filesystem->transfers_lock);
+    if (download->prev != NULL)
+        download->prev->next = download->next;
+    else
+        filesystem->downloads = download->next;
+    if (download->next != NULL)
+        download->next->prev = download->prev;
+    pthread_mutex_unlock(&filesystem->transfers_lock);
+
+    /* Close file */
+    pthread_mutex_lock(&filesystem->lock);
+    if (libssh2_sftp_close(download->file) == 0)
+        guac_client_log(client, GUAC_LOG_DEBUG, "File closed");
+    else
+        guac_client_log(client, GUAC_LOG_INFO, "Unable to close file");
+    pthread_mutex_unlock(&filesystem->lock);
+
+    pthread_cond_destroy(&download->modified);
+    pthread_mutex_destroy(&download->lock);
+    free(download->buffer);
+    free(download);
+
+}
+
+/**
+ * Logs the number of bytes sent so far for the given outbound SFTP data
+ * transfer (download), along with the time elapsed and resulting throughput.
+ *
+ * @param user
+ *     The user receiving the download.
+ *
+ * @param download
+ *     The download to log.
+ *
+ * @param status
+ *     A human-readable description of the state of the download, such as
+ *     "sent" or "aborted".
+ */
+static void guac_common_ssh_sftp_download_log(guac_user* user,
+        guac_common_ssh_sftp_download* download, const char* status) {
+
+    guac_timestamp duration = guac_timestamp_current() - download->started;
+    uint64_t throughput = duration > 0
+        ? download->bytes_sent * 1000 / 1024 / duration
+        : 0;
+
+    guac_user_log(user, GUAC_LOG_DEBUG, "File \"%s\" %s: %" PRIu64 " bytes "
+            "in %" PRId64 " ms (%" PRIu64 " KiB/s)", download->path, status,
+            download->bytes_sent, (int64_t) duration, throughput);
+
+}
+
 /**
  * Handler for ack messages which continue an outbound SFTP data transfer
  * (download), signaling the current status and requesting additional data.
- * The data associated with the given stream is expected to be a pointer to an
- * open LIBSSH2_SFTP_HANDLE for the file from which the data is to be read.
+ * The data associated with the given stream is expected to be a pointer to
+ * the guac_common_ssh_sftp_download describing the file being downloaded.
+ * Each successful ack acknowledges one previously-sent blob, and as many
+ * blobs are sent in response as are needed to again have the download's
+ * window of blobs awaiting acknowledgement. Blobs are sent from data already
+ * read ahead by the download's thread, waiting for that thread only if no
+ * blobs at all are awaiting acknowledgement.
  *
  * @param user
  *     The user receiving the ack message.
@@ -465,59 +1062,90 @@ int guac_common_ssh_sftp_handle_file_stream(
 static int guac_common_ssh_sftp_ack_handler(guac_user* user,
         guac_stream* stream, char* message, guac_protocol_status status) {
 
-    /* Pull file from stream */
-    LIBSSH2_SFTP_HANDLE* file = (LIBSSH2_SFTP_HANDLE*) stream->data;
+    char blob[GUAC_PROTOCOL_BLOB_MAX_LENGTH];
 
-    /* If successful, read data */
-    if (status == GUAC_PROTOCOL_STATUS_SUCCESS) {
+    /* Pull download state from stream */
+    guac_common_ssh_sftp_download* download =
+        (guac_common_ssh_sftp_download*) stream->data;
 
-        /* Attempt read into buffer */
-        char buffer[4096];
-        int bytes_read = libssh2_sftp_read(file, buffer, sizeof(buffer)); 
+    int window = download->filesystem->download_window;
 
-        /* If bytes read, send as blob */
-        if (bytes_read > 0) {
-            guac_protocol_send_blob(user->socket, stream,
-                    buffer, bytes_read);
+    /* Abort download and return stream to user if unsuccessful */
+    if (status != GUAC_PROTOCOL_STATUS_SUCCESS) {
+        guac_common_ssh_sftp_download_log(user, download, "aborted");
+        guac_user_free_stream(user, stream);
+        guac_common_ssh_sftp_download_free(download);
+        return 0;
+    }
 
-            guac_user_log(user, GUAC_LOG_DEBUG, "%i bytes sent to user",
-                    bytes_read);
+    pthread_mutex_lock(&download->lock);
 
-        }
+    /* The first ack acknowledges the stream itself, not a blob */
+    if (download->in_flight > 0)
+        download->in_flight--;
 
-        /* If bytes could not be read, handle EOF or error condition */
-        else {
+    /* Refill window of unacknowledged blobs */
+    while (download->in_flight < window) {
 
-            /* If EOF, send end */
-            if (bytes_read == 0) {
-                guac_user_log(user, GUAC_LOG_DEBUG, "File sent");
-                guac_protocol_send_end(user->socket, stream);
-                guac_user_free_stream(user, stream);
-            }
+        /* Wait for more data only if no further acks are expected */
+        while (download->buffered == 0 && !download->eof
+                && download->in_flight == 0)
+            pthread_cond_wait(&download->modified, &download->lock);
 
-            /* Otherwise, fail stream */
-            else {
-                guac_user_log(user, GUAC_LOG_INFO, "Error reading file");
-                guac_protocol_send_end(user->socket, stream);
-                guac_user_free_stream(user, stream);
-            }
+        if (download->buffered == 0)
+            break;
 
-            /* Close file */
-            if (libssh2_sftp_close(file) == 0)
-                guac_user_log(user, GUAC_LOG_DEBUG, "File closed");
-            else
-                guac_user_log(user, GUAC_LOG_INFO, "Unable to close file");
+        /* Copy out next blob, which may not span the end of the buffer */
+        int length = GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE
+            - download->read_pos;
 
-        }
+        if (length > download->buffered)
+            length = download->buffered;
 
-        guac_socket_flush(user->socket);
+        if (length > sizeof(blob))
+            length = sizeof(blob);
+
+        memcpy(blob, download->buffer + download->read_pos, length);
+
+        download->read_pos = (download->read_pos + length)
+            % GUAC_COMMON_SSH_SFTP_DOWNLOAD_BUFFER_SIZE;
+        download->buffered -= length;
+        download->bytes_sent += length;
+        download->in_flight++;
+
+        /* Wake reading thread if waiting for space */
+        pthread_cond_broadcast(&download->modified);
+
+        /* Send without blocking the reading thread */
+        pthread_mutex_unlock(&download->lock);
+        guac_protocol_send_blob(user->socket, stream, blob, length);
+        pthread_mutex_lock(&download->lock);
 
     }
 
-    /* Otherwise, return stream to user */
-    else
+    /* The download is complete once all data has been sent and acknowledged */
+    int complete = download->eof && download->buffered == 0
+        && download->in_flight == 0;
+    int error = download->error;
+
+    pthread_mutex_unlock(&download->lock);
+
+    /* End stream if download is complete */
+    if (complete) {
+
+        if (error)
+            guac_user_log(user, GUAC_LOG_INFO, "Error reading file");
+
+        guac_common_ssh_sftp_download_log(user, download,
+                error ? "failed" : "sent");
+
+        guac_protocol_send_end(user->socket, stream);
         guac_user_free_stream(user, stream);
+        guac_common_ssh_sftp_download_free(download);
+
+    }
 
+    guac_socket_flush(user->socket);
     return 0;
 }
 
@@ -526,7 +1154,7 @@ guac_stream* guac_common_ssh_sftp_download_file(
         char* filename) {
 
     guac_stream* stream;
-    LIBSSH2_SFTP_HANDLE* file;
+    guac_common_ssh_sftp_download* download;
 
     /* Ignore download if downloads have been disabled */
     if (filesystem->disable_download) {
@@ -538,10 +1166,9 @@ guac_stream* guac_common_ssh_sftp_download_file(
     }
 
     /* Attempt to open file for reading */
-    file = libssh2_sftp_open(filesystem->sftp_session, filename,
-            LIBSSH2_FXF_READ, 0);
-    if (file == NULL) {
-        guac_user_log(user, GUAC_LOG_INFO, 
+    download = guac_common_ssh_sftp_download_alloc(filesystem, filename);
+    if (download == NULL) {
+        guac_user_log(user, GUAC_LOG_INFO,
                 "Unable to read file \"%s\"", filename);
         return NULL;
     }
@@ -549,7 +1176,7 @@ guac_stream* guac_common_ssh_sftp_download_file(
     /* Allocate stream */
     stream = guac_user_alloc_stream(user);
     stream->ack_handler = guac_common_ssh_sftp_ack_handler;
-    stream->data = file;
+    stream->data = download;
 
     /* Send stream start, strip name */
     filename = basename(filename);
@@ -582,9 +1209,263 @@ void guac_common_ssh_sftp_set_upload_path(
 
 }
 
+/**
+ * Translates a stream name for the given SFTP filesystem object into the
+ * absolute path corresponding to the actual file it represents.
+ *
+ * @param fullpath
+ *     The buffer to populate with the translated path. This buffer MUST be at
+ *     least GUAC_COMMON_SSH_SFTP_MAX_PATH bytes in size.
+ *
+ * @param filesystem
+ *     The SFTP filesystem containing the file.
+ *
+ * @param name
+ *     The name of the stream (file) to translate into an absolute path.
+ *
+ * @return
+ *     Non-zero if translation succeeded, zero otherwise.
+ */
+static int guac_common_ssh_sftp_translate_name(char* fullpath,
+        guac_common_ssh_sftp_filesystem* filesystem, const char* name) {
+
+    char normalized_name[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+
+    /* Normalize stream name into a path, and append to the root path */
+    return guac_common_ssh_sftp_normalize_path(normalized_name, name)
+        && guac_ssh_append_path(fullpath, filesystem->root_path,
+                normalized_name);
+
+}
+
+/**
+ * Converts the given SFTP file attributes, as returned by libssh2, into the
+ * metadata stored within a stat cache.
+ *
+ * @param attributes
+ *     The SFTP file attributes to convert.
+ *
+ * @param info
+ *     The structure to populate with the converted metadata.
+ *
+ * @return
+ *     Non-zero if the attributes include the permissions of the file, and
+ *     thus may be cached, zero otherwise.
+ */
+static int guac_common_ssh_sftp_attributes_to_info(
+        const LIBSSH2_SFTP_ATTRIBUTES* attributes,
+        guac_common_stat_cache_info* info) {
+
+    if (!(attributes->flags & LIBSSH2_SFTP_ATTR_PERMISSIONS))
+        return 0;
+
+    info->directory = LIBSSH2_SFTP_S_ISDIR(attributes->permissions) ? 1 : 0;
+    info->size  = attributes->filesize;
+    info->mtime = attributes->mtime;
+    info->atime = attributes->atime;
+
+    /* SFTP does not expose status change times */
+    info->ctime = attributes->mtime;
+
+    return 1;
+
+}
+
+/**
+ * Retrieves the metadata of the file at the given absolute path on the SFTP
+ * server, following symbolic links, using previously-cached metadata if
+ * available. The lock of the given filesystem must be held.
+ *
+ * @param filesystem
+ *     The SFTP filesystem containing the file.
+ *
+ * @param fullpath
+ *     The absolute path of the file on the SFTP server.
+ *
+ * @param info
+ *     The structure to populate with the metadata of the file.
+ *
+ * @return
+ *     Zero on success, non-zero if the file cannot be stat'd.
+ */
+static int guac_common_ssh_sftp_stat(
+        guac_common_ssh_sftp_filesystem* filesystem, const char* fullpath,
+        guac_common_stat_cache_info* info) {
+
+    LIBSSH2_SFTP_ATTRIBUTES attributes;
+
+    if (guac_common_stat_cache_get(filesystem->stat_cache, fullpath, info))
+        return 0;
+
+    if (libssh2_sftp_stat(filesystem->sftp_session, fullpath, &attributes))
+        return 1;
+
+    /* Attributes lacking permissions are used as-is but never cached */
+    if (!guac_common_ssh_sftp_attributes_to_info(&attributes, info)) {
+        info->directory = LIBSSH2_SFTP_S_ISDIR(attributes.permissions) ? 1 : 0;
+        return 0;
+    }
+
+    guac_common_stat_cache_put(filesystem->stat_cache, fullpath, info);
+    return 0;
+
+}
+
+/**
+ * Frees the given SFTP directory listing state, closing the directory being
+ * listed if still open. The lock of the SFTP filesystem must not be held.
+ *
+ * @param data
+ *     The guac_common_ssh_sftp_ls_state of the directory listing to free.
+ */
+static void guac_common_ssh_sftp_ls_free(void* data) {
+
+    guac_common_ssh_sftp_ls_state* list_state =
+        (guac_common_ssh_sftp_ls_state*) data;
+
+    guac_common_ssh_sftp_filesystem* filesystem = list_state->filesystem;
+
+    if (list_state->directory != NULL) {
+        pthread_mutex_lock(&filesystem->lock);
+        libssh2_sftp_closedir(list_state->directory);
+        pthread_mutex_unlock(&filesystem->lock);
+    }
+
+    guac_common_listing_entries_free(&list_state->entries);
+    free(list_state);
+
+}
+
+/**
+ * Reads all entries of the directory being listed into the entries array of
+ * the given directory listing state, sorting them by name and closing the
+ * directory. The types of all entries other than symbolic links are recorded
+ * as read, such that only symbolic links need be stat'd when listed. The lock
+ * of the SFTP filesystem must be held.
+ *
+ * @param list_state
+ *     The directory listing state whose directory should be read.
+ */
+static void guac_common_ssh_sftp_ls_sort(
+        guac_common_ssh_sftp_ls_state* list_state) {
+
+    char filename[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+    LIBSSH2_SFTP_ATTRIBUTES attributes;
+
+    while (libssh2_sftp_readdir(list_state->directory, filename,
+                sizeof(filename), &attributes) > 0) {
+
+        /* Skip current and parent directory entries */
+        if (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0)
+            continue;
+
+        guac_common_listing_type type;
+        if (!(attributes.flags & LIBSSH2_SFTP_ATTR_PERMISSIONS)
+                || LIBSSH2_SFTP_S_ISLNK(attributes.permissions))
+            type = GUAC_COMMON_LISTING_TYPE_UNKNOWN;
+        else if (LIBSSH2_SFTP_S_ISDIR(attributes.permissions))
+            type = GUAC_COMMON_LISTING_TYPE_DIRECTORY;
+        else
+            type = GUAC_COMMON_LISTING_TYPE_FILE;
+
+        if (guac_common_listing_entries_add(&list_state->entries,
+                    filename, type))
+            break;
+
+    }
+
+    libssh2_sftp_closedir(list_state->directory);
+    list_state->directory = NULL;
+
+    guac_common_listing_entries_sort(&list_state->entries);
+
+}
+
+/**
+ * Retrieves the name of the next entry of the directory being listed,
+ * skipping the current and parent directory entries, and advancing the
+ * position of the listing. If the type of the entry is known without
+ * querying the entry explicitly, any attributes read with that entry are
+ * cached. The lock of the SFTP filesystem must be held.
+ *
+ * @param list_state
+ *     The directory listing state to read from.
+ *
+ * @param filename
+ *     The buffer in which to store the name of the entry. This buffer MUST be
+ *     at least GUAC_COMMON_SSH_SFTP_MAX_PATH bytes in size.
+ *
+ * @param type
+ *     The location in which to store the type of the entry, if known.
+ *
+ * @return
+ *     Non-zero if an entry was read, zero if no entries remain or the
+ *     directory cannot be read.
+ */
+static int guac_common_ssh_sftp_ls_next(
+        guac_common_ssh_sftp_ls_state* list_state, char* filename,
+        guac_common_listing_type* type) {
+
+    LIBSSH2_SFTP_ATTRIBUTES attributes;
+    guac_common_stat_cache_info info;
+
+    /* Read from sorted entries, if sorted */
+    if (list_state->directory == NULL) {
+
+        if (list_state->position >= list_state->entries.count)
+            return 0;
+
+        guac_common_listing_entry* entry =
+            &list_state->entries.entries[list_state->position++];
+
+        guac_strlcpy(filename, entry->name, GUAC_COMMON_SSH_SFTP_MAX_PATH);
+        *type = entry->type;
+        return 1;
+
+    }
+
+    /* Otherwise, read directly from directory */
+    do {
+        if (libssh2_sftp_readdir(list_state->directory, filename,
+                    GUAC_COMMON_SSH_SFTP_MAX_PATH, &attributes) <= 0)
+            return 0;
+    } while (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0);
+
+    list_state->position++;
+
+    /* Symbolic links might point to directories */
+    if (LIBSSH2_SFTP_S_ISLNK(attributes.permissions)) {
+        *type = GUAC_COMMON_LISTING_TYPE_UNKNOWN;
+        return 1;
+    }
+
+    if (LIBSSH2_SFTP_S_ISDIR(attributes.permissions))
+        *type = GUAC_COMMON_LISTING_TYPE_DIRECTORY;
+    else
+        *type = GUAC_COMMON_LISTING_TYPE_FILE;
+
+    /* Cache the attributes included with the entry itself */
+    char absolute_path[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+    char fullpath[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+    if (guac_ssh_append_filename(absolute_path, list_state->directory_name,
+                filename)
+            && guac_common_ssh_sftp_translate_name(fullpath,
+                list_state->filesystem, absolute_path)
+            && guac_common_ssh_sftp_attributes_to_info(&attributes, &info))
+        guac_common_stat_cache_put(list_state->filesystem->stat_cache,
+                fullpath, &info);
+
+    return 1;
+
+}
+
 /**
  * Handler for ack messages received due to receipt of a "body" or "blob"
- * instruction associated with a SFTP directory list operation.
+ * instruction associated with a SFTP directory list operation. Each ack
+ * results in at most one further blob of the directory listing. If only a
+ * single page of the directory was requested, the listing ends after the
+ * last entry of that page with a property whose name is the request for the
+ * following page.
  *
  * @param user
  *     The user receiving the ack message.
@@ -606,36 +1487,72 @@ void guac_common_ssh_sftp_set_upload_path(
 static int guac_common_ssh_sftp_ls_ack_handler(guac_user* user,
         guac_stream* stream, char* message, guac_protocol_status status) {
 
-    int bytes_read;
+    int blob_written = 0;
+    int complete = 0;
+    int retain = 0;
 
     char filename[GUAC_COMMON_SSH_SFTP_MAX_PATH];
-    LIBSSH2_SFTP_ATTRIBUTES attributes;
+    guac_common_listing_type type;
+    guac_common_stat_cache_info info;
 
     guac_common_ssh_sftp_ls_state* list_state =
         (guac_common_ssh_sftp_ls_state*) stream->data;
 
     guac_common_ssh_sftp_filesystem* filesystem = list_state->filesystem;
-
-    LIBSSH2_SFTP* sftp = filesystem->sftp_session;
+    guac_common_listing_page* page = &list_state->page;
 
     /* If unsuccessful, free stream and abort */
     if (status != GUAC_PROTOCOL_STATUS_SUCCESS) {
-        libssh2_sftp_closedir(list_state->directory);
         guac_user_free_stream(user, stream);
-        free(list_state);
+        guac_common_ssh_sftp_ls_free(list_state);
         return 0;
     }
 
-    /* While directory entries remain */
-    while ((bytes_read = libssh2_sftp_readdir(list_state->directory,
-                filename, sizeof(filename), &attributes)) > 0) {
+    /* While directory entries remain and no blob has yet been written */
+    pthread_mutex_lock(&filesystem->lock);
+    while (!blob_written) {
+
+        /* Stop at end of requested page, linking to the following page */
+        if (page->paged && list_state->position >= page->offset + page->limit) {
+
+            char next[GUAC_COMMON_LISTING_MAX_PREFIX_LENGTH
+                + GUAC_COMMON_SSH_SFTP_MAX_PATH];
+
+            /* Only link to pages which are known to be non-empty, if known */
+            if ((list_state->directory != NULL
+                    || list_state->position < list_state->entries.count)
+                    && !guac_common_listing_next(page, next, sizeof(next))) {
+                pthread_mutex_unlock(&filesystem->lock);
+                guac_common_json_write_property(user, stream,
+                        &list_state->json_state, next,
+                        GUAC_COMMON_LISTING_NEXT_MIMETYPE);
+                pthread_mutex_lock(&filesystem->lock);
+                retain = 1;
+            }
 
-        char absolute_path[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+            complete = 1;
+            break;
 
-        /* Skip current and parent directory entries */
-        if (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0)
+        }
+
+        /* Skip directly to the requested page, if sorted */
+        if (list_state->directory == NULL
+                && list_state->position < page->offset)
+            list_state->position = page->offset;
+
+        /* Stop at end of directory */
+        if (!guac_common_ssh_sftp_ls_next(list_state, filename, &type)) {
+            complete = 1;
+            break;
+        }
+
+        /* Skip entries preceding the requested page */
+        if (list_state->position <= page->offset)
             continue;
 
+        char absolute_path[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+        char fullpath[GUAC_COMMON_SSH_SFTP_MAX_PATH];
+
         /* Concatenate into absolute path - skip if invalid */
         if (!guac_ssh_append_filename(absolute_path, 
                     list_state->directory_name, filename)) {
@@ -647,34 +1564,45 @@ static int guac_common_ssh_sftp_ls_ack_handler(guac_user* user,
             continue;
         }
 
-        /* Stat explicitly if symbolic link (might point to directory) */
-        if (LIBSSH2_SFTP_S_ISLNK(attributes.permissions))
-            libssh2_sftp_stat(sftp, absolute_path, &attributes);
+        /* Stat explicitly if type is unknown (might point to directory) */
+        if (type == GUAC_COMMON_LISTING_TYPE_UNKNOWN) {
+            if (guac_common_ssh_sftp_translate_name(fullpath, filesystem,
+                        absolute_path)
+                    && !guac_common_ssh_sftp_stat(filesystem, fullpath, &info)
+                    && info.directory)
+                type = GUAC_COMMON_LISTING_TYPE_DIRECTORY;
+        }
 
         /* Determine mimetype */
         const char* mimetype;
-        if (LIBSSH2_SFTP_S_ISDIR(attributes.permissions))
+        if (type == GUAC_COMMON_LISTING_TYPE_DIRECTORY)
             mimetype = GUAC_USER_STREAM_INDEX_MIMETYPE;
         else
             mimetype = "application/octet-stream";
 
         /* Write entry, waiting for next ack if a blob is written */
-        if (guac_common_json_write_property(user, stream,
-                    &list_state->json_state, absolute_path, mimetype))
-            break;
+        pthread_mutex_unlock(&filesystem->lock);
+        blob_written = guac_common_json_write_property(user, stream,
+                    &list_state->json_state, absolute_path, mimetype);
+        pthread_mutex_lock(&filesystem->lock);
 
     }
+    pthread_mutex_unlock(&filesystem->lock);
 
-    /* Complete JSON and cleanup at end of directory */
-    if (bytes_read <= 0) {
+    /* Complete JSON and cleanup at end of directory or page */
+    if (complete) {
 
         /* Complete JSON object */
         guac_common_json_end_object(user, stream, &list_state->json_state);
         guac_common_json_flush(user, stream, &list_state->json_state);
 
-        /* Clean up resources */
-        libssh2_sftp_closedir(list_state->directory);
-        free(list_state);
+        /* Retain listing for the following page, if any, cleaning up
+         * otherwise */
+        if (retain)
+            guac_common_listing_cache_store(&filesystem->listings, page,
+                    list_state->position, list_state);
+        else
+            guac_common_ssh_sftp_ls_free(list_state);
 
         /* Signal of stream */
         guac_protocol_send_end(user->socket, stream);
@@ -687,38 +1615,6 @@ static int guac_common_ssh_sftp_ls_ack_handler(guac_user* user,
 
 }
 
-/**
- * Translates a stream name for the given SFTP filesystem object into the
- * absolute path corresponding to the actual file it represents.
- *
- * @param fullpath
- *     The buffer to populate with the translated path. This buffer MUST be at
- *     least GUAC_COMMON_SSH_SFTP_MAX_PATH bytes in size.
- *
- * @param object
- *     The Guacamole protocol object associated with the SFTP filesystem.
- *
- * @param name
- *     The name of the stream (file) to translate into an absolute path.
- *
- * @return
- *     Non-zero if translation succeeded, zero otherwise.
- */
-static int guac_common_ssh_sftp_translate_name(char* fullpath,
-        guac_object* object, char* name) {
-
-    char normalized_name[GUAC_COMMON_SSH_SFTP_MAX_PATH];
-
-    guac_common_ssh_sftp_filesystem* filesystem =
-        (guac_common_ssh_sftp_filesystem*) object->data;
-
-    /* Normalize stream name into a path, and append to the root path */
-    return guac_common_ssh_sftp_normalize_path(normalized_name, name)
-        && guac_ssh_append_path(fullpath, filesystem->root_path,
-                normalized_name);
-
-}
-
 /**
  * Handler for get messages. In context of SFTP and the filesystem exposed via
  * the Guacamole protocol, get messages request the body of a file within the
@@ -745,51 +1641,84 @@ static int guac_common_ssh_sftp_get_handler(guac_user* user,
         (guac_common_ssh_sftp_filesystem*) object->data;
 
     LIBSSH2_SFTP* sftp = filesystem->sftp_session;
-    LIBSSH2_SFTP_ATTRIBUTES attributes;
+    guac_common_stat_cache_info info;
+    guac_common_listing_page page;
+
+    /* Determine whether only a page of a directory is requested */
+    if (guac_common_listing_parse(name, &page)) {
+        guac_user_log(user, GUAC_LOG_INFO, "Invalid directory listing "
+                "request \"%s\"", name);
+        return 0;
+    }
 
     /* Translate stream name into filesystem path */
-    if (!guac_common_ssh_sftp_translate_name(fullpath, object, name)) {
+    if (!guac_common_ssh_sftp_translate_name(fullpath, filesystem,
+                page.path)) {
         guac_user_log(user, GUAC_LOG_INFO, "Unable to generate real path "
                 "for stream \"%s\"", name);
         return 0;
     }
 
-    /* Attempt to read file information */
-    if (libssh2_sftp_stat(sftp, fullpath, &attributes)) {
+    /* Attempt to read file information, typically cached by a prior listing */
+    pthread_mutex_lock(&filesystem->lock);
+    int stat_failed = guac_common_ssh_sftp_stat(filesystem, fullpath, &info);
+    pthread_mutex_unlock(&filesystem->lock);
+
+    if (stat_failed) {
         guac_user_log(user, GUAC_LOG_INFO, "Unable to read file \"%s\"",
                 fullpath);
         return 0;
     }
 
     /* If directory, send contents of directory */
-    if (LIBSSH2_SFTP_S_ISDIR(attributes.permissions)) {
+    if (info.directory) {
 
-        /* Open as directory */
-        LIBSSH2_SFTP_HANDLE* dir = libssh2_sftp_opendir(sftp, fullpath);
-        if (dir == NULL) {
-            guac_user_log(user, GUAC_LOG_INFO,
-                    "Unable to read directory \"%s\"", fullpath);
-            return 0;
-        }
-
-        /* Init directory listing state */
+        /* Continue from where the previous page ended, if that listing is
+         * still retained */
         guac_common_ssh_sftp_ls_state* list_state =
-            malloc(sizeof(guac_common_ssh_sftp_ls_state));
+            guac_common_listing_cache_take(&filesystem->listings, &page);
+
+        /* Otherwise, begin a new listing */
+        if (list_state == NULL) {
+
+            /* Open as directory */
+            pthread_mutex_lock(&filesystem->lock);
+            LIBSSH2_SFTP_HANDLE* dir = libssh2_sftp_opendir(sftp, fullpath);
+            pthread_mutex_unlock(&filesystem->lock);
+            if (dir == NULL) {
+                guac_user_log(user, GUAC_LOG_INFO,
+                        "Unable to read directory \"%s\"", fullpath);
+                return 0;
+            }
 
-        list_state->directory = dir;
-        list_state->filesystem = filesystem;
+            /* Init directory listing state */
+            list_state = calloc(1, sizeof(guac_common_ssh_sftp_ls_state));
+            list_state->directory = dir;
+            list_state->filesystem = filesystem;
 
-        int length = guac_strlcpy(list_state->directory_name, name,
-                sizeof(list_state->directory_name));
+            int length = guac_strlcpy(list_state->directory_name, page.path,
+                    sizeof(list_state->directory_name));
+
+            /* Bail out if directory name is too long to store */
+            if (length >= sizeof(list_state->directory_name)) {
+                guac_user_log(user, GUAC_LOG_INFO, "Unable to read "
+                        "directory \"%s\": Path too long", fullpath);
+                guac_common_ssh_sftp_ls_free(list_state);
+                return 0;
+            }
+
+            /* Read all entries up front if they must be sorted */
+            if (page.order == GUAC_COMMON_LISTING_ORDER_NAME) {
+                pthread_mutex_lock(&filesystem->lock);
+                guac_common_ssh_sftp_ls_sort(list_state);
+                pthread_mutex_unlock(&filesystem->lock);
+            }
 
-        /* Bail out if directory name is too long to store */
-        if (length >= sizeof(list_state->directory_name)) {
-            guac_user_log(user, GUAC_LOG_INFO, "Unable to read directory "
-                    "\"%s\": Path too long", fullpath);
-            free(list_state);
-            return 0;
         }
 
+        list_state->page = page;
+        list_state->page.path = list_state->directory_name;
+
         /* Allocate stream for body */
         guac_stream* stream = guac_user_alloc_stream(user);
         stream->ack_handler = guac_common_ssh_sftp_ls_ack_handler;
@@ -804,6 +1733,11 @@ static int guac_common_ssh_sftp_get_handler(guac_user* user,
 
     }
 
+    /* Only directories may be listed in pages */
+    else if (page.paged)
+        guac_user_log(user, GUAC_LOG_INFO, "Unable to list \"%s\": Not a "
+                "directory", fullpath);
+
     /* Otherwise, send file contents */
     else {
 
@@ -815,10 +1749,10 @@ static int guac_common_ssh_sftp_get_handler(guac_user* user,
             return 0;
         }
         
-        /* Open as normal file */
-        LIBSSH2_SFTP_HANDLE* file = libssh2_sftp_open(sftp, fullpath,
-            LIBSSH2_FXF_READ, 0);
-        if (file == NULL) {
+        /* Open as normal file, reading ahead in the background */
+        guac_common_ssh_sftp_download* download =
+            guac_common_ssh_sftp_download_alloc(filesystem, fullpath);
+        if (download == NULL) {
             guac_user_log(user, GUAC_LOG_INFO,
                     "Unable to read file \"%s\"", fullpath);
             return 0;
@@ -827,7 +1761,7 @@ static int guac_common_ssh_sftp_get_handler(guac_user* user,
         /* Allocate stream for body */
         guac_stream* stream = guac_user_alloc_stream(user);
         stream->ack_handler = guac_common_ssh_sftp_ack_handler;
-        stream->data = file;
+        stream->data = download;
 
         /* Associate new stream with get request */
         guac_protocol_send_body(user->socket, object, stream,
@@ -886,19 +1820,37 @@ static int guac_common_ssh_sftp_put_handler(guac_user* user,
     LIBSSH2_SFTP* sftp = filesystem->sftp_session;
 
     /* Translate stream name into filesystem path */
-    if (!guac_common_ssh_sftp_translate_name(fullpath, object, name)) {
+    if (!guac_common_ssh_sftp_translate_name(fullpath, filesystem, name)) {
         guac_user_log(user, GUAC_LOG_INFO, "Unable to generate real path "
                 "for stream \"%s\"", name);
         return 0;
     }
 
     /* Open file via SFTP */
+    pthread_mutex_lock(&filesystem->lock);
     LIBSSH2_SFTP_HANDLE* file = libssh2_sftp_open(sftp, fullpath,
             LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
             S_IRUSR | S_IWUSR);
+    guac_protocol_status status = guac_sftp_get_status(filesystem);
+    pthread_mutex_unlock(&filesystem->lock);
+
+    /* Allocate upload state, which closes the file if allocation fails */
+    guac_common_ssh_sftp_upload* upload =
+        guac_common_ssh_sftp_upload_alloc(filesystem, file);
+
+    if (upload == NULL) {
+        guac_user_log(user, GUAC_LOG_ERROR,
+                "Unable to begin upload of file \"%s\"", fullpath);
+        guac_protocol_send_ack(user->socket, stream, "SFTP: Upload failed",
+                GUAC_PROTOCOL_STATUS_SERVER_ERROR);
+        guac_socket_flush(user->socket);
+        return 0;
+    }
 
     /* Acknowledge stream if successful */
     if (file != NULL) {
+        guac_common_stat_cache_invalidate(filesystem->stat_cache, fullpath);
+        guac_common_listing_cache_invalidate(&filesystem->listings);
         guac_user_log(user, GUAC_LOG_DEBUG, "File \"%s\" opened", fullpath);
         guac_protocol_send_ack(user->socket, stream, "SFTP: File opened",
                 GUAC_PROTOCOL_STATUS_SUCCESS);
@@ -909,7 +1861,7 @@ static int guac_common_ssh_sftp_put_handler(guac_user* user,
         guac_user_log(user, GUAC_LOG_INFO,
                 "Unable to open file \"%s\"", fullpath);
         guac_protocol_send_ack(user->socket, stream, "SFTP: Open failed",
-                guac_sftp_get_status(filesystem));
+                status);
     }
 
     /* Set handlers for file stream */
@@ -917,7 +1869,7 @@ static int guac_common_ssh_sftp_put_handler(guac_user* user,
     stream->end_handler = guac_common_ssh_sftp_end_handler;
 
     /* Store file within stream */
-    stream->data = file;
+    stream->data = upload;
 
     guac_socket_flush(user->socket);
     return 0;
@@ -979,6 +1931,9 @@ guac_common_ssh_sftp_filesystem* guac_common_ssh_create_sftp_filesystem(
     filesystem->disable_download = disable_download;
     filesystem->disable_upload = disable_upload;
 
+    /* Allow several blobs of each download to be in flight at once */
+    filesystem->download_window = GUAC_COMMON_SSH_SFTP_DEFAULT_DOWNLOAD_WINDOW;
+
     /* Normalize and store the provided root path */
     if (!guac_common_ssh_sftp_normalize_path(filesystem->root_path,
                 root_path)) {
@@ -988,6 +1943,21 @@ guac_common_ssh_sftp_filesystem* guac_common_ssh_create_sftp_filesystem(
         return NULL;
     }
 
+    pthread_mutex_init(&filesystem->lock, NULL);
+    pthread_mutex_init(&filesystem->transfers_lock, NULL);
+    filesystem->downloads = NULL;
+    filesystem->uploads = NULL;
+
+    filesystem->stat_cache =
+        guac_common_stat_cache_alloc(GUAC_COMMON_SSH_SFTP_STAT_CACHE_TTL);
+    if (filesystem->stat_cache == NULL)
+        guac_client_log(session->client, GUAC_LOG_WARNING, "Unable to "
+                "allocate file metadata cache. File metadata will not be "
+                "cached.");
+
+    guac_common_listing_cache_init(&filesystem->listings,
+            guac_common_ssh_sftp_ls_free);
+
     /* Generate filesystem name from root path if no name is provided */
     if (name != NULL)
         filesystem->name = strdup(name);
@@ -1005,10 +1975,45 @@ guac_common_ssh_sftp_filesystem* guac_common_ssh_create_sftp_filesystem(
 void guac_common_ssh_destroy_sftp_filesystem(
         guac_common_ssh_sftp_filesystem* filesystem) {
 
+    /* Stop and free all downloads still in progress, each of which removes
+     * itself from the list as it is freed */
+    for (;;) {
+
+        pthread_mutex_lock(&filesystem->transfers_lock);
+        guac_common_ssh_sftp_download* download = filesystem->downloads;
+        pthread_mutex_unlock(&filesystem->transfers_lock);
+
+        if (download == NULL)
+            break;
+
+        guac_common_ssh_sftp_download_free(download);
+
+    }
+
+    /* Likewise abort all uploads which have not been ended */
+    for (;;) {
+
+        pthread_mutex_lock(&filesystem->transfers_lock);
+        guac_common_ssh_sftp_upload* upload = filesystem->uploads;
+        pthread_mutex_unlock(&filesystem->transfers_lock);
+
+        if (upload == NULL)
+            break;
+
+        guac_common_ssh_sftp_upload_abort(upload);
+
+    }
+
+    /* Close any directory retained for a following page */
+    guac_common_listing_cache_destroy(&filesystem->listings);
+
     /* Shutdown SFTP session */
     libssh2_sftp_shutdown(filesystem->sftp_session);
 
     /* Free associated memory */
+    guac_common_stat_cache_free(filesystem->stat_cache);
+    pthread_mutex_destroy(&filesystem->transfers_lock);
+    pthread_mutex_destroy(&filesystem->lock);
     free(filesystem->name);
     free(filesystem);
 
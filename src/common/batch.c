@@ -0,0 +1,481 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "common/batch.h"
+
+#include <guacamole/timestamp.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Removes the largest job from the queue of the given batch, storing that
+ * job within the provided structure. The batch must be locked.
+ *
+ * @param batch
+ *     The batch whose queue should be popped. The queue must not be empty.
+ *
+ * @param job
+ *     The structure in which the removed job should be stored.
+ */
+static void guac_common_batch_pop(guac_common_batch* batch,
+        guac_common_batch_job* job) {
+
+    guac_common_batch_job* jobs = batch->jobs;
+    *job = jobs[0];
+
+    /* Move last job to root and sift down */
+    guac_common_batch_job last = jobs[--batch->job_count];
+    int index = 0;
+    for (;;) {
+
+        int child = index * 2 + 1;
+        if (child >= batch->job_count)
+            break;
+
+        /* Prefer the larger of both children */
+        if (child + 1 < batch->job_count
+                && jobs[child + 1].size > jobs[child].size)
+            child++;
+
+        if (jobs[child].size <= last.size)
+            break;
+
+        jobs[index] = jobs[child];
+        index = child;
+
+    }
+
+    jobs[index] = last;
+
+}
+
+/**
+ * Worker thread which repeatedly claims and processes the largest queued
+ * job until the batch is closed and its queue is empty.
+ *
+ * @param data
+ *     The guac_common_batch being processed.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_batch_worker(void* data) {
+
+    guac_common_batch* batch = (guac_common_batch*) data;
+    guac_common_batch_job job;
+
+    pthread_mutex_lock(&batch->lock);
+    for (;;) {
+
+        /* Wait for work or for the batch to be closed */
+        while (batch->job_count == 0 && !batch->closed)
+            pthread_cond_wait(&batch->modified, &batch->lock);
+
+        /* Nothing left to do once closed and drained */
+        if (batch->job_count == 0)
+            break;
+
+        guac_common_batch_pop(batch, &job);
+
+        /* Process file without holding the lock */
+        pthread_mutex_unlock(&batch->lock);
+        int result = batch->callback(job.path, batch->data);
+        free(job.path);
+        pthread_mutex_lock(&batch->lock);
+
+        batch->total++;
+        if (result)
+            batch->failures++;
+
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    return NULL;
+
+}
+
+guac_common_batch* guac_common_batch_alloc(
+        guac_common_batch_callback* callback, void* data) {
+
+    guac_common_batch* batch = calloc(1, sizeof(guac_common_batch));
+    if (batch == NULL)
+        return NULL;
+
+    batch->callback = callback;
+    batch->data = data;
+
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->modified, NULL);
+
+    return batch;
+
+}
+
+int guac_common_batch_parse_workers(const char* value, int* worker_count) {
+
+    char* end;
+
+    /* Parse string as an integer */
+    errno = 0;
+    long parsed = strtol(value, &end, 10);
+
+    /* Reject anything but a valid number of workers */
+    if (errno != 0 || *value == '\0' || *end != '\0' || parsed < 1
+            || parsed > GUAC_COMMON_BATCH_MAX_WORKERS)
+        return 1;
+
+    *worker_count = parsed;
+    return 0;
+
+}
+
+int guac_common_batch_start(guac_common_batch* batch, int worker_count) {
+
+    if (worker_count < 1 || worker_count > GUAC_COMMON_BATCH_MAX_WORKERS
+            || batch->workers != NULL)
+        return 1;
+
+    batch->workers = malloc(sizeof(pthread_t) * worker_count);
+    if (batch->workers == NULL)
+        return 1;
+
+    /* Start all workers, tracking only those successfully started */
+    for (batch->worker_count = 0; batch->worker_count < worker_count;
+            batch->worker_count++) {
+
+        if (pthread_create(&batch->workers[batch->worker_count], NULL,
+                    guac_common_batch_worker, batch))
+            return 1;
+
+    }
+
+    return 0;
+
+}
+
+int guac_common_batch_add(guac_common_batch* batch, const char* path) {
+
+    /* Queued jobs are ordered by size, so size must be known */
+    struct stat file_stat;
+    if (stat(path, &file_stat))
+        return 1;
+
+    char* path_copy = strdup(path);
+    if (path_copy == NULL)
+        return 1;
+
+    pthread_mutex_lock(&batch->lock);
+
+    /* Refuse new jobs once closed */
+    if (batch->closed) {
+        pthread_mutex_unlock(&batch->lock);
+        free(path_copy);
+        return 1;
+    }
+
+    /* Expand queue if necessary */
+    if (batch->job_count == batch->job_capacity) {
+
+        int capacity = batch->job_capacity ? batch->job_capacity * 2 : 16;
+        guac_common_batch_job* jobs = realloc(batch->jobs,
+                sizeof(guac_common_batch_job) * capacity);
+
+        if (jobs == NULL) {
+            pthread_mutex_unlock(&batch->lock);
+            free(path_copy);
+            return 1;
+        }
+
+        batch->jobs = jobs;
+        batch->job_capacity = capacity;
+
+    }
+
+    /* Add new job as leaf and sift up */
+    int index = batch->job_count++;
+    while (index > 0) {
+
+        int parent = (index - 1) / 2;
+        if (batch->jobs[parent].size >= file_stat.st_size)
+            break;
+
+        batch->jobs[index] = batch->jobs[parent];
+        index = parent;
+
+    }
+
+    batch->jobs[index].path = path_copy;
+    batch->jobs[index].size = file_stat.st_size;
+
+    pthread_cond_signal(&batch->modified);
+    pthread_mutex_unlock(&batch->lock);
+
+    return 0;
+
+}
+
+/**
+ * Searches the given sorted array of strings for the given string, returning
+ * the index at which that string is located or, if not present, the index at
+ * which it would need to be inserted to maintain sort order.
+ *
+ * @param strings
+ *     The sorted array of strings to search.
+ *
+ * @param count
+ *     The number of strings within the array.
+ *
+ * @param str
+ *     The string to search for.
+ *
+ * @return
+ *     The index of the given string, or the index at which it should be
+ *     inserted if not present.
+ */
+static int guac_common_batch_search(char** strings, int count,
+        const char* str) {
+
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strcmp(strings[mid], str) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+
+}
+
+/**
+ * Returns whether the given filename ends with any of the given suffixes.
+ *
+ * @param name
+ *     The filename to test.
+ *
+ * @param suffixes
+ *     A NULL-terminated array of suffixes.
+ *
+ * @return
+ *     Non-zero if the filename ends with at least one of the given suffixes,
+ *     zero otherwise.
+ */
+static int guac_common_batch_has_suffix(const char* name,
+        const char* const* suffixes) {
+
+    size_t length = strlen(name);
+
+    for (; *suffixes != NULL; suffixes++) {
+        size_t suffix_length = strlen(*suffixes);
+        if (length >= suffix_length
+                && strcmp(name + length - suffix_length, *suffixes) == 0)
+            return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Returns whether the given file is currently locked for writing by another
+ * process.
+ *
+ * @param path
+ *     The path of the file to test.
+ *
+ * @return
+ *     Non-zero if the file is locked for writing or cannot be opened, zero
+ *     otherwise.
+ */
+static int guac_common_batch_is_locked(const char* path) {
+
+/* Explicit file locks are required only on POSIX platforms */
+#ifndef __MINGW32__
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return 1;
+
+    /* Test whether a read lock could be acquired */
+    struct flock file_lock = {
+        .l_type   = F_RDLCK,
+        .l_whence = SEEK_SET,
+        .l_start  = 0,
+        .l_len    = 0
+    };
+
+    int locked = fcntl(fd, F_GETLK, &file_lock) == -1
+              || file_lock.l_type != F_UNLCK;
+
+    close(fd);
+    return locked;
+
+#else
+    return 0;
+#endif
+
+}
+
+int guac_common_batch_watch(guac_common_batch* batch, const char* path,
+        const char* const* suffixes) {
+
+    char file_path[PATH_MAX];
+    char out_path[PATH_MAX];
+
+    /* Sorted array of paths which have already been queued */
+    char** seen = NULL;
+    int seen_count = 0;
+    int seen_capacity = 0;
+
+    for (;;) {
+
+        DIR* dir = opendir(path);
+        if (dir == NULL)
+            break;
+
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+
+            /* Ignore hidden files, as well as "." and ".." */
+            const char* name = entry->d_name;
+            if (name[0] == '.')
+                continue;
+
+            /* Ignore output files */
+            if (guac_common_batch_has_suffix(name, suffixes))
+                continue;
+
+            /* Skip paths which are too long */
+            if (snprintf(file_path, sizeof(file_path), "%s/%s",
+                        path, name) >= sizeof(file_path))
+                continue;
+
+            /* Skip files which have already been considered */
+            int seen_index = guac_common_batch_search(seen, seen_count,
+                    file_path);
+            if (seen_index < seen_count
+                    && strcmp(seen[seen_index], file_path) == 0)
+                continue;
+
+            /* Consider only regular files */
+            struct stat file_stat;
+            if (stat(file_path, &file_stat) || !S_ISREG(file_stat.st_mode))
+                continue;
+
+            /* Wait for the recording to be completed */
+            if (guac_common_batch_is_locked(file_path))
+                continue;
+
+            /* Make room to remember file, retrying on the next scan if
+             * memory is not currently available, such that no file is
+             * queued unless it can also be remembered */
+            if (seen_count == seen_capacity) {
+
+                int capacity = seen_capacity ? seen_capacity * 2 : 64;
+                char** expanded = realloc(seen, sizeof(char*) * capacity);
+                if (expanded == NULL)
+                    continue;
+
+                seen = expanded;
+                seen_capacity = capacity;
+
+            }
+
+            char* seen_path = strdup(file_path);
+            if (seen_path == NULL)
+                continue;
+
+            /* Queue file only if not already processed by a previous run */
+            if (snprintf(out_path, sizeof(out_path), "%s%s",
+                        file_path, suffixes[0]) < sizeof(out_path)
+                    && access(out_path, F_OK) != 0)
+                guac_common_batch_add(batch, file_path);
+
+            /* Remember file such that it is never queued twice */
+            memmove(&seen[seen_index + 1], &seen[seen_index],
+                    sizeof(char*) * (seen_count - seen_index));
+            seen[seen_index] = seen_path;
+            seen_count++;
+
+        }
+
+        closedir(dir);
+        guac_timestamp_msleep(GUAC_COMMON_BATCH_WATCH_INTERVAL);
+
+    }
+
+    /* Directory could not be read */
+    int error = errno;
+    for (int i = 0; i < seen_count; i++)
+        free(seen[i]);
+    free(seen);
+
+    errno = error;
+    return 1;
+
+}
+
+int guac_common_batch_wait(guac_common_batch* batch) {
+
+    /* Signal all workers to exit once the queue is drained */
+    pthread_mutex_lock(&batch->lock);
+    batch->closed = 1;
+    pthread_cond_broadcast(&batch->modified);
+    pthread_mutex_unlock(&batch->lock);
+
+    /* Wait for all workers to finish */
+    for (int i = 0; i < batch->worker_count; i++)
+        pthread_join(batch->workers[i], NULL);
+
+    batch->worker_count = 0;
+    return batch->failures;
+
+}
+
+void guac_common_batch_free(guac_common_batch* batch) {
+
+    guac_common_batch_wait(batch);
+
+    /* Free any jobs which were never claimed */
+    for (int i = 0; i < batch->job_count; i++)
+        free(batch->jobs[i].path);
+
+    pthread_cond_destroy(&batch->modified);
+    pthread_mutex_destroy(&batch->lock);
+
+    free(batch->workers);
+    free(batch->jobs);
+    free(batch);
+
+}
+
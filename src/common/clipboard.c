@@ -33,11 +33,21 @@ guac_common_clipboard* guac_common_clipboard_alloc(int size) {
 
     guac_common_clipboard* clipboard = malloc(sizeof(guac_common_clipboard));
 
+    if (size > GUAC_COMMON_CLIPBOARD_MAX_LENGTH)
+        size = GUAC_COMMON_CLIPBOARD_MAX_LENGTH;
+
+    /* Allocate only a single block until more is needed */
+    int allocated = GUAC_COMMON_CLIPBOARD_BLOCK_SIZE;
+    if (allocated > size)
+        allocated = size;
+
     /* Init clipboard */
     clipboard->mimetype[0] = '\0';
-    clipboard->buffer = malloc(size);
+    clipboard->buffer = malloc(allocated);
     clipboard->length = 0;
     clipboard->available = size;
+    clipboard->size = size;
+    clipboard->allocated = allocated;
 
     pthread_mutex_init(&(clipboard->lock), NULL);
 
@@ -132,11 +142,20 @@ void guac_common_clipboard_send(guac_common_clipboard* clipboard, guac_client* c
 
 void guac_common_clipboard_reset(guac_common_clipboard* clipboard,
         const char* mimetype) {
+    guac_common_clipboard_reset_size(clipboard, mimetype, clipboard->size);
+}
+
+void guac_common_clipboard_reset_size(guac_common_clipboard* clipboard,
+        const char* mimetype, int size) {
+
+    if (size > GUAC_COMMON_CLIPBOARD_MAX_LENGTH)
+        size = GUAC_COMMON_CLIPBOARD_MAX_LENGTH;
 
     pthread_mutex_lock(&(clipboard->lock));
 
     /* Clear clipboard contents */
     clipboard->length = 0;
+    clipboard->available = size;
 
     /* Assign given mimetype */
     guac_strlcpy(clipboard->mimetype, mimetype, sizeof(clipboard->mimetype));
@@ -145,7 +164,7 @@ void guac_common_clipboard_reset(guac_common_clipboard* clipboard,
 
 }
 
-void guac_common_clipboard_append(guac_common_clipboard* clipboard, const char* data, int length) {
+int guac_common_clipboard_append(guac_common_clipboard* clipboard, const char* data, int length) {
 
     pthread_mutex_lock(&(clipboard->lock));
 
@@ -154,6 +173,32 @@ void guac_common_clipboard_append(guac_common_clipboard* clipboard, const char*
     if (remaining < length)
         length = remaining;
 
+    /* Grow buffer as needed, doubling its size up to the available length */
+    int required = clipboard->length + length;
+    if (required > clipboard->allocated) {
+
+        int allocated = clipboard->allocated;
+        if (allocated < GUAC_COMMON_CLIPBOARD_BLOCK_SIZE)
+            allocated = GUAC_COMMON_CLIPBOARD_BLOCK_SIZE;
+
+        while (allocated < required)
+            allocated *= 2;
+
+        if (allocated > clipboard->available)
+            allocated = clipboard->available;
+
+        char* buffer = realloc(clipboard->buffer, allocated);
+
+        /* Truncate to existing buffer if memory is not available */
+        if (buffer == NULL)
+            length = clipboard->allocated - clipboard->length;
+        else {
+            clipboard->buffer = buffer;
+            clipboard->allocated = allocated;
+        }
+
+    }
+
     /* Append to buffer */
     memcpy(clipboard->buffer + clipboard->length, data, length);
 
@@ -162,5 +207,7 @@ void guac_common_clipboard_append(guac_common_clipboard* clipboard, const char*
 
     pthread_mutex_unlock(&(clipboard->lock));
 
+    return length;
+
 }
 
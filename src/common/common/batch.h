@@ -0,0 +1,275 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_COMMON_BATCH_H
+#define GUAC_COMMON_BATCH_H
+
+#include "config.h"
+
+#include <pthread.h>
+#include <sys/types.h>
+
+/**
+ * The maximum number of worker threads which may be used to process a single
+ * batch of files.
+ */
+#define GUAC_COMMON_BATCH_MAX_WORKERS 256
+
+/**
+ * The number of milliseconds to wait between successive scans of a watched
+ * directory for newly-completed files.
+ */
+#define GUAC_COMMON_BATCH_WATCH_INTERVAL 1000
+
+/**
+ * Callback which is invoked by a worker thread for each file processed as
+ * part of a batch. Multiple invocations of the callback may run concurrently,
+ * each within a different worker thread.
+ *
+ * @param path
+ *     The path of the file to process.
+ *
+ * @param data
+ *     The arbitrary data provided when the batch was allocated.
+ *
+ * @return
+ *     Zero if the file was processed successfully, non-zero otherwise.
+ */
+typedef int guac_common_batch_callback(const char* path, void* data);
+
+/**
+ * A single file which has been queued for processing but which has not yet
+ * been claimed by any worker thread.
+ */
+typedef struct guac_common_batch_job {
+
+    /**
+     * The path of the file to process.
+     */
+    char* path;
+
+    /**
+     * The size of the file, in bytes, at the time it was queued.
+     */
+    off_t size;
+
+} guac_common_batch_job;
+
+/**
+ * A pool of worker threads which process queued files using a common
+ * callback. Queued files are held within a single shared queue ordered by
+ * file size, with each idle worker claiming the largest remaining file, such
+ * that the longest-running jobs are started first and no worker is left idle
+ * while other work remains.
+ */
+typedef struct guac_common_batch {
+
+    /**
+     * The callback to invoke for each queued file.
+     */
+    guac_common_batch_callback* callback;
+
+    /**
+     * Arbitrary data to pass to the callback.
+     */
+    void* data;
+
+    /**
+     * All worker threads processing this batch.
+     */
+    pthread_t* workers;
+
+    /**
+     * The number of worker threads within the workers array.
+     */
+    int worker_count;
+
+    /**
+     * Lock which guards access to all queue state and counters within this
+     * batch.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever a job is added to the queue or
+     * the queue is closed.
+     */
+    pthread_cond_t modified;
+
+    /**
+     * All queued jobs, arranged as a binary max-heap by file size.
+     */
+    guac_common_batch_job* jobs;
+
+    /**
+     * The number of jobs currently within the queue.
+     */
+    int job_count;
+
+    /**
+     * The number of jobs which may be stored within the jobs array before it
+     * must be reallocated.
+     */
+    int job_capacity;
+
+    /**
+     * Non-zero if no further jobs will be added, and worker threads should
+     * exit once the queue is empty.
+     */
+    int closed;
+
+    /**
+     * The total number of files which have been processed.
+     */
+    int total;
+
+    /**
+     * The number of files for which the callback reported failure.
+     */
+    int failures;
+
+} guac_common_batch;
+
+/**
+ * Allocates a new batch. No files will be processed until worker threads are
+ * started with guac_common_batch_start().
+ *
+ * @param callback
+ *     The callback to invoke for each queued file.
+ *
+ * @param data
+ *     Arbitrary data to pass to the callback.
+ *
+ * @return
+ *     A newly-allocated batch, or NULL if the batch cannot be allocated.
+ */
+guac_common_batch* guac_common_batch_alloc(
+        guac_common_batch_callback* callback, void* data);
+
+/**
+ * Parses the given string as a number of worker threads, such as the value
+ * of a command-line option. The string must consist entirely of a decimal
+ * integer between 1 and GUAC_COMMON_BATCH_MAX_WORKERS inclusive.
+ *
+ * @param value
+ *     The string to parse.
+ *
+ * @param worker_count
+ *     The location in which to store the parsed number of worker threads.
+ *     This is left untouched if the string is not valid.
+ *
+ * @return
+ *     Zero if the string was parsed successfully, non-zero otherwise.
+ */
+int guac_common_batch_parse_workers(const char* value, int* worker_count);
+
+/**
+ * Starts the given number of worker threads, each of which will repeatedly
+ * claim and process the largest file queued within the given batch. Files
+ * which are known prior to starting the batch should be added before calling
+ * this function such that they are processed in order of size. This function
+ * may be invoked at most once for any particular batch.
+ *
+ * @param batch
+ *     The batch to start.
+ *
+ * @param worker_count
+ *     The number of worker threads to start. This value must be between 1 and
+ *     GUAC_COMMON_BATCH_MAX_WORKERS inclusive.
+ *
+ * @return
+ *     Zero if all worker threads were started successfully, non-zero
+ *     otherwise. If non-zero is returned, any worker threads which were
+ *     started will continue to run until guac_common_batch_wait() or
+ *     guac_common_batch_free() is invoked.
+ */
+int guac_common_batch_start(guac_common_batch* batch, int worker_count);
+
+/**
+ * Adds the file at the given path to the given batch. The file will be
+ * processed by the next available worker thread once all larger queued files
+ * have been claimed.
+ *
+ * @param batch
+ *     The batch to add the file to.
+ *
+ * @param path
+ *     The path of the file to add.
+ *
+ * @return
+ *     Zero if the file was added successfully, non-zero otherwise.
+ */
+int guac_common_batch_add(guac_common_batch* batch, const char* path);
+
+/**
+ * Continuously scans the given directory, adding to the given batch each
+ * regular file which is not currently locked for writing. Guacamole acquires
+ * a write lock on session recordings while they are being written, thus each
+ * recording will be added as soon as the session it records has ended. Each
+ * file is added at most once, and files for which a corresponding output
+ * file already exists are ignored. This function does not return unless an
+ * error prevents the directory from being read.
+ *
+ * @param batch
+ *     The batch to add files to.
+ *
+ * @param path
+ *     The path of the directory to watch.
+ *
+ * @param suffixes
+ *     A NULL-terminated array of the suffixes which are appended to the name
+ *     of each input file to produce the names of its output files. Files
+ *     having any of these suffixes are ignored. The first suffix is used to
+ *     determine whether a file has already been processed, and at least one
+ *     suffix must be given.
+ *
+ * @return
+ *     Non-zero if the directory could not be read, in which case errno will
+ *     be set appropriately. This function does not return otherwise.
+ */
+int guac_common_batch_watch(guac_common_batch* batch, const char* path,
+        const char* const* suffixes);
+
+/**
+ * Waits for all files queued within the given batch to be processed, stops
+ * all worker threads, and frees the batch. The number of files processed and
+ * the number of failures should be read from the batch before it is freed
+ * if needed, by calling guac_common_batch_wait() first.
+ *
+ * @param batch
+ *     The batch to free.
+ */
+void guac_common_batch_free(guac_common_batch* batch);
+
+/**
+ * Waits for all files queued within the given batch to be processed and
+ * stops all worker threads. No further files may be added to the batch once
+ * this function has been invoked. The batch must still be freed with
+ * guac_common_batch_free().
+ *
+ * @param batch
+ *     The batch to wait for.
+ *
+ * @return
+ *     The number of files for which processing failed.
+ */
+int guac_common_batch_wait(guac_common_batch* batch);
+
+#endif
+
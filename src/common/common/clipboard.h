@@ -31,6 +31,12 @@
  */
 #define GUAC_COMMON_CLIPBOARD_BLOCK_SIZE 4096
 
+/**
+ * The largest number of bytes which any clipboard may be configured to hold,
+ * regardless of the size requested.
+ */
+#define GUAC_COMMON_CLIPBOARD_MAX_LENGTH 52428800
+
 /**
  * Generic clipboard structure.
  */
@@ -59,10 +65,25 @@ typedef struct guac_common_clipboard {
     int length;
 
     /**
-     * The total number of bytes available in the clipboard buffer.
+     * The total number of bytes which may be stored in the clipboard. Data
+     * beyond this limit is truncated.
      */
     int available;
 
+    /**
+     * The number of bytes which may be stored in the clipboard following a
+     * call to guac_common_clipboard_reset(), as given when the clipboard was
+     * allocated.
+     */
+    int size;
+
+    /**
+     * The number of bytes currently allocated for the clipboard buffer. The
+     * buffer grows as data is appended, up to the number of bytes available,
+     * such that a large limit costs memory only once used.
+     */
+    int allocated;
+
 } guac_common_clipboard;
 
 /**
@@ -97,6 +118,19 @@ void guac_common_clipboard_send(guac_common_clipboard* clipboard, guac_client* c
  */
 void guac_common_clipboard_reset(guac_common_clipboard* clipboard, const char* mimetype);
 
+/**
+ * Clears the clipboard contents and assigns a new mimetype for future data,
+ * allowing up to the given number of bytes to be stored until the clipboard
+ * is next reset. This limit applies only to the new contents, and is itself
+ * limited to GUAC_COMMON_CLIPBOARD_MAX_LENGTH.
+ *
+ * @param clipboard The clipboard to reset.
+ * @param mimetype The mimetype of future data.
+ * @param size The maximum number of bytes to allow within the clipboard.
+ */
+void guac_common_clipboard_reset_size(guac_common_clipboard* clipboard,
+        const char* mimetype, int size);
+
 /**
  * Appends the given data to the current clipboard contents. The data must
  * match the mimetype chosen for the clipboard data by
@@ -105,8 +139,10 @@ void guac_common_clipboard_reset(guac_common_clipboard* clipboard, const char* m
  * @param clipboard The clipboard to append data to.
  * @param data The data to append.
  * @param length The number of bytes to append from the data given.
+ * @return The number of bytes actually appended, which may be less than the
+ *         number of bytes given if the clipboard is full.
  */
-void guac_common_clipboard_append(guac_common_clipboard* clipboard, const char* data, int length);
+int guac_common_clipboard_append(guac_common_clipboard* clipboard, const char* data, int length);
 
 #endif
 
@@ -0,0 +1,413 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_COMMON_LISTING_H
+#define GUAC_COMMON_LISTING_H
+
+#include "config.h"
+
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+
+/**
+ * The character which begins the name of any request for a single page of a
+ * directory listing. As the names of all other requests are absolute paths,
+ * which begin with a slash, such requests are never ambiguous.
+ */
+#define GUAC_COMMON_LISTING_PAGE_PREFIX '?'
+
+/**
+ * The mimetype of the final property of any page of a directory listing after
+ * which further entries may remain. The name of that property is the name of
+ * the request for the following page.
+ */
+#define GUAC_COMMON_LISTING_NEXT_MIMETYPE \
+    "application/vnd.glyptodon.guacamole.stream-index-next+json"
+
+/**
+ * The number of entries within each page of a directory listing if no limit
+ * is specified.
+ */
+#define GUAC_COMMON_LISTING_DEFAULT_LIMIT 1000
+
+/**
+ * The maximum number of entries which may be requested within a single page
+ * of a directory listing.
+ */
+#define GUAC_COMMON_LISTING_MAX_LIMIT 10000
+
+/**
+ * The maximum length of the name of a request for a page of a directory
+ * listing, excluding the path of the directory, in bytes.
+ */
+#define GUAC_COMMON_LISTING_MAX_PREFIX_LENGTH 64
+
+/**
+ * The number of milliseconds for which the state of a paged directory listing
+ * is retained after a page has been sent, such that the following page can
+ * continue from where that page ended rather than reading the directory
+ * again.
+ */
+#define GUAC_COMMON_LISTING_CACHE_TIMEOUT 30000
+
+/**
+ * The order in which the entries of a directory listing are sent.
+ */
+typedef enum guac_common_listing_order {
+
+    /**
+     * Entries are sent in the order they are read from the directory, such
+     * that each entry can be sent as soon as it is read.
+     */
+    GUAC_COMMON_LISTING_ORDER_NONE,
+
+    /**
+     * Entries are sorted by name. All names within the directory must be read
+     * before any entry is sent, though only the entries of the requested page
+     * are stat'd.
+     */
+    GUAC_COMMON_LISTING_ORDER_NAME
+
+} guac_common_listing_order;
+
+/**
+ * The portion of a directory listing requested by the name given within a
+ * "get" instruction. A request for a page has a name of the form:
+ *
+ *     ?offset=OFFSET&limit=LIMIT&order=ORDER&path=PATH
+ *
+ * where all parameters other than "path" are optional and may be given in
+ * any order, and "path" must be last, with the remainder of the name taken
+ * as the absolute path of the directory verbatim. Any name not beginning
+ * with GUAC_COMMON_LISTING_PAGE_PREFIX requests the entire directory.
+ */
+typedef struct guac_common_listing_page {
+
+    /**
+     * The absolute path of the directory being listed. This points into the
+     * name from which the request was parsed.
+     */
+    const char* path;
+
+    /**
+     * Non-zero if only a single page of the directory has been requested,
+     * zero if the entire directory has been requested.
+     */
+    int paged;
+
+    /**
+     * The number of entries to skip before the first entry of the page.
+     */
+    int offset;
+
+    /**
+     * The maximum number of entries within the page, or zero if the entire
+     * directory has been requested.
+     */
+    int limit;
+
+    /**
+     * The order in which entries should be sent.
+     */
+    guac_common_listing_order order;
+
+} guac_common_listing_page;
+
+/**
+ * The type of an entry within a directory, if known without querying the
+ * entry explicitly.
+ */
+typedef enum guac_common_listing_type {
+
+    /**
+     * The type of the entry is not yet known, as may be the case for
+     * symbolic links.
+     */
+    GUAC_COMMON_LISTING_TYPE_UNKNOWN,
+
+    /**
+     * The entry is known to be a directory.
+     */
+    GUAC_COMMON_LISTING_TYPE_DIRECTORY,
+
+    /**
+     * The entry is known to be something other than a directory.
+     */
+    GUAC_COMMON_LISTING_TYPE_FILE
+
+} guac_common_listing_type;
+
+/**
+ * A single entry within a directory, as read while collecting all entries of
+ * that directory for sorting.
+ */
+typedef struct guac_common_listing_entry {
+
+    /**
+     * The name of the entry, which is dynamically allocated.
+     */
+    char* name;
+
+    /**
+     * The type of the entry, if known.
+     */
+    guac_common_listing_type type;
+
+} guac_common_listing_entry;
+
+/**
+ * A growable, sortable array of the entries within a directory.
+ */
+typedef struct guac_common_listing_entries {
+
+    /**
+     * All entries added so far.
+     */
+    guac_common_listing_entry* entries;
+
+    /**
+     * The number of entries within the entries array.
+     */
+    int count;
+
+    /**
+     * The number of entries which may be stored within the entries array
+     * before it must be reallocated.
+     */
+    int capacity;
+
+} guac_common_listing_entries;
+
+/**
+ * Handler which frees the protocol-specific state of a directory listing,
+ * closing the directory being listed if still open.
+ *
+ * @param state
+ *     The directory listing state to free.
+ */
+typedef void guac_common_listing_free_handler(void* state);
+
+/**
+ * The state of the most recent paged directory listing, retained between
+ * pages such that the following page continues from the open directory or
+ * the already-sorted entries of that listing. Each page of a listing is
+ * requested separately, and the state of the listing is retained only if the
+ * request for the following page arrives within
+ * GUAC_COMMON_LISTING_CACHE_TIMEOUT milliseconds and no change to the
+ * filesystem has invalidated the cache in the meantime.
+ */
+typedef struct guac_common_listing_cache {
+
+    /**
+     * Lock which guards access to all members of this structure.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * The handler to invoke to free any retained listing state.
+     */
+    guac_common_listing_free_handler* free_handler;
+
+    /**
+     * The protocol-specific state of the retained listing, or NULL if no
+     * listing is retained.
+     */
+    void* state;
+
+    /**
+     * The absolute path of the directory of the retained listing, which is
+     * dynamically allocated, or NULL if no listing is retained.
+     */
+    char* path;
+
+    /**
+     * The order of the entries of the retained listing.
+     */
+    guac_common_listing_order order;
+
+    /**
+     * The number of entries of the directory which have been skipped or
+     * listed by the retained listing, and thus the offset of the only page
+     * which may continue that listing.
+     */
+    int position;
+
+    /**
+     * The time at which the listing was retained.
+     */
+    guac_timestamp stored;
+
+} guac_common_listing_cache;
+
+/**
+ * Parses the name given within a "get" instruction for a directory, storing
+ * the portion of the listing requested within the given structure.
+ *
+ * @param name
+ *     The name to parse. This string must remain valid for as long as the
+ *     path within the parsed request is used.
+ *
+ * @param page
+ *     The structure to populate with the parsed request.
+ *
+ * @return
+ *     Zero if the name was parsed successfully, non-zero if the name is a
+ *     malformed request for a page.
+ */
+int guac_common_listing_parse(const char* name,
+        guac_common_listing_page* page);
+
+/**
+ * Produces the name of the request for the page immediately following the
+ * given page.
+ *
+ * @param page
+ *     The page preceding the page to request. This page must have been
+ *     requested with a limit.
+ *
+ * @param buffer
+ *     The buffer in which to store the name of the request.
+ *
+ * @param length
+ *     The size of the buffer, in bytes.
+ *
+ * @return
+ *     Zero if the name was stored successfully, non-zero if the buffer is
+ *     too small.
+ */
+int guac_common_listing_next(const guac_common_listing_page* page,
+        char* buffer, int length);
+
+/**
+ * Adds an entry having a copy of the given name to the given array of
+ * entries.
+ *
+ * @param entries
+ *     The array to add the entry to.
+ *
+ * @param name
+ *     The name of the entry.
+ *
+ * @param type
+ *     The type of the entry, if known.
+ *
+ * @return
+ *     Zero if the entry was added, non-zero if insufficient memory is
+ *     available.
+ */
+int guac_common_listing_entries_add(guac_common_listing_entries* entries,
+        const char* name, guac_common_listing_type type);
+
+/**
+ * Sorts the given array of entries by the byte values of their names.
+ *
+ * @param entries
+ *     The array of entries to sort.
+ */
+void guac_common_listing_entries_sort(guac_common_listing_entries* entries);
+
+/**
+ * Frees the names of all entries within the given array, as well as the
+ * storage of the array itself, leaving the array empty. The structure itself
+ * is not freed.
+ *
+ * @param entries
+ *     The array of entries to free.
+ */
+void guac_common_listing_entries_free(guac_common_listing_entries* entries);
+
+/**
+ * Initializes the given listing cache, which will initially retain no
+ * listing.
+ *
+ * @param cache
+ *     The listing cache to initialize.
+ *
+ * @param free_handler
+ *     The handler to invoke to free the state of any listing which is
+ *     retained but never continued.
+ */
+void guac_common_listing_cache_init(guac_common_listing_cache* cache,
+        guac_common_listing_free_handler* free_handler);
+
+/**
+ * Frees any listing retained by the given listing cache and releases all
+ * resources associated with the cache. The structure itself is not freed.
+ *
+ * @param cache
+ *     The listing cache to destroy.
+ */
+void guac_common_listing_cache_destroy(guac_common_listing_cache* cache);
+
+/**
+ * Removes and returns the state of the retained listing which continues at
+ * the given page, if any. A listing continues at a page only if the page is
+ * of the same directory, in the same order, and begins where the retained
+ * listing ended. Any other retained listing is freed, and thus requesting
+ * the first page of a directory always reads that directory again.
+ *
+ * @param cache
+ *     The listing cache to search.
+ *
+ * @param page
+ *     The page being requested.
+ *
+ * @return
+ *     The state of the listing which continues at the given page, which is
+ *     no longer retained by the cache, or NULL if there is no such listing.
+ */
+void* guac_common_listing_cache_take(guac_common_listing_cache* cache,
+        const guac_common_listing_page* page);
+
+/**
+ * Retains the state of the given listing, such that it may be continued by
+ * the page following the given page. Any previously-retained listing is
+ * freed. If the listing cannot be retained, its state is freed immediately.
+ *
+ * @param cache
+ *     The listing cache to store the listing within.
+ *
+ * @param page
+ *     The page of the listing which has just been sent in its entirety.
+ *
+ * @param position
+ *     The number of entries of the directory which have been skipped or
+ *     listed so far.
+ *
+ * @param state
+ *     The protocol-specific state of the listing.
+ */
+void guac_common_listing_cache_store(guac_common_listing_cache* cache,
+        const guac_common_listing_page* page, int position, void* state);
+
+/**
+ * Frees any listing retained by the given listing cache, such that the
+ * following page of that listing reads the directory again. This function
+ * should be invoked whenever the contents of the filesystem may have
+ * changed. The lock of the filesystem, if any, must not be held, as freeing
+ * a listing may require closing its directory.
+ *
+ * @param cache
+ *     The listing cache to invalidate.
+ */
+void guac_common_listing_cache_invalidate(guac_common_listing_cache* cache);
+
+#endif
+
@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef GUAC_COMMON_PARSER_H
+#define GUAC_COMMON_PARSER_H
+
+#include "config.h"
+
+#include <guacamole/parser.h>
+
+/**
+ * The number of bytes of a memory-mapped file which must be consumed by
+ * guac_common_parser_read_mapped() before those bytes are unmapped, freeing
+ * any memory associated with them.
+ */
+#define GUAC_COMMON_PARSER_MAPPED_RELEASE_SIZE 16777216
+
+/**
+ * Handler which is invoked for each instruction parsed by
+ * guac_common_parser_read_mapped(). The opcode, argc, and argv of the given
+ * parser describe the instruction parsed, and point directly into the mapped
+ * file. They are valid only until the handler returns.
+ *
+ * @param parser
+ *     The guac_parser which parsed the instruction.
+ *
+ * @param data
+ *     The arbitrary data given to guac_common_parser_read_mapped().
+ */
+typedef void guac_common_parser_handler(guac_parser* parser, void* data);
+
+/**
+ * Reads all Guacamole instructions from the given file by mapping the file
+ * into memory and parsing each instruction in place with
+ * guac_parser_parse_buffer(), without copying file contents through a
+ * guac_socket. The file is mapped privately, so NULL-terminating each element
+ * in place does not modify the file itself, and portions of the mapping are
+ * released as they are consumed.
+ *
+ * @param fd
+ *     The file descriptor of the open file.
+ *
+ * @param handler
+ *     The handler to invoke for each instruction parsed.
+ *
+ * @param data
+ *     Arbitrary data to pass to the given handler.
+ *
+ * @return
+ *     Zero if all instructions within the file were parsed, -1 if the file
+ *     cannot be mapped into memory, in which case instructions should
+ *     instead be read through a guac_socket, or a positive value if parsing
+ *     fails, in which case guac_error is set appropriately.
+ */
+int guac_common_parser_read_mapped(int fd, guac_common_parser_handler* handler,
+        void* data);
+
+#endif
+
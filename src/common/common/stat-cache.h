@@ -0,0 +1,278 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef GUAC_COMMON_STAT_CACHE_H
+#define GUAC_COMMON_STAT_CACHE_H
+
+#include "config.h"
+
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * The number of hash buckets within each stat cache. This value MUST be a
+ * power of two.
+ */
+#define GUAC_COMMON_STAT_CACHE_BUCKETS 4096
+
+/**
+ * The maximum number of entries which may be stored within a stat cache.
+ * Once this limit is reached, all entries are discarded before more are
+ * added.
+ */
+#define GUAC_COMMON_STAT_CACHE_MAX_ENTRIES 65536
+
+/**
+ * The maximum number of local directories which may be watched for changes
+ * by a single stat cache.
+ */
+#define GUAC_COMMON_STAT_CACHE_MAX_WATCHES 1024
+
+/**
+ * The metadata of a single file, as stored within a stat cache.
+ */
+typedef struct guac_common_stat_cache_info {
+
+    /**
+     * Non-zero if the file is a directory, zero otherwise.
+     */
+    int directory;
+
+    /**
+     * The size of the file, in bytes.
+     */
+    uint64_t size;
+
+    /**
+     * The time the file's status last changed, as a UNIX timestamp.
+     */
+    int64_t ctime;
+
+    /**
+     * The time the file was last modified, as a UNIX timestamp.
+     */
+    int64_t mtime;
+
+    /**
+     * The time the file was last accessed, as a UNIX timestamp.
+     */
+    int64_t atime;
+
+} guac_common_stat_cache_info;
+
+/**
+ * A single cached file, stored within a hash bucket of a stat cache.
+ */
+typedef struct guac_common_stat_cache_entry {
+
+    /**
+     * The next entry within the same hash bucket, or NULL if this is the last
+     * entry.
+     */
+    struct guac_common_stat_cache_entry* next;
+
+    /**
+     * The hash of the path of the file.
+     */
+    uint64_t hash;
+
+    /**
+     * The time after which this entry is no longer valid.
+     */
+    guac_timestamp expires;
+
+    /**
+     * The cached metadata of the file.
+     */
+    guac_common_stat_cache_info info;
+
+    /**
+     * The path of the file, including null terminator.
+     */
+    char path[];
+
+} guac_common_stat_cache_entry;
+
+/**
+ * A local directory which is being watched for changes via inotify.
+ */
+typedef struct guac_common_stat_cache_directory {
+
+    /**
+     * The inotify watch descriptor of the directory.
+     */
+    int wd;
+
+    /**
+     * The path of the directory.
+     */
+    char* path;
+
+} guac_common_stat_cache_directory;
+
+/**
+ * Short-lived cache of file metadata, keyed by path, allowing the metadata of
+ * files within large directories to be retrieved repeatedly without
+ * repeatedly querying the filesystem. Each entry expires after a fixed
+ * duration. Entries may be explicitly invalidated whenever a file is known to
+ * have changed. For local files, directories may additionally be watched via
+ * inotify, where supported, such that changes made by other processes
+ * invalidate the relevant entries automatically. All functions of a stat
+ * cache are threadsafe.
+ */
+typedef struct guac_common_stat_cache {
+
+    /**
+     * Lock which guards access to all entries and watches.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * The number of milliseconds that each entry remains valid.
+     */
+    int ttl;
+
+    /**
+     * The number of entries currently stored.
+     */
+    int count;
+
+    /**
+     * Hash table of all entries, using separate chaining.
+     */
+    guac_common_stat_cache_entry* buckets[GUAC_COMMON_STAT_CACHE_BUCKETS];
+
+    /**
+     * The inotify file descriptor used to watch local directories, or -1 if
+     * no directories are being watched.
+     */
+    int inotify_fd;
+
+    /**
+     * The time that pending inotify events were last processed.
+     */
+    guac_timestamp last_drain;
+
+    /**
+     * All directories currently being watched.
+     */
+    guac_common_stat_cache_directory* watches;
+
+    /**
+     * The number of directories currently being watched.
+     */
+    int watch_count;
+
+} guac_common_stat_cache;
+
+/**
+ * Allocates a new, empty stat cache.
+ *
+ * @param ttl
+ *     The number of milliseconds that each entry should remain valid.
+ *
+ * @return
+ *     A newly-allocated stat cache, which must eventually be freed with
+ *     guac_common_stat_cache_free(), or NULL if the cache cannot be
+ *     allocated. All stat cache functions accept a NULL cache, behaving as if
+ *     the cache were always empty, such that a NULL cache simply disables
+ *     caching.
+ */
+guac_common_stat_cache* guac_common_stat_cache_alloc(int ttl);
+
+/**
+ * Frees the given stat cache, including all entries and watches.
+ *
+ * @param cache
+ *     The stat cache to free.
+ */
+void guac_common_stat_cache_free(guac_common_stat_cache* cache);
+
+/**
+ * Retrieves the cached metadata of the file at the given path, if present
+ * and not yet expired.
+ *
+ * @param cache
+ *     The stat cache to search.
+ *
+ * @param path
+ *     The path of the file.
+ *
+ * @param info
+ *     The structure to populate with the cached metadata of the file.
+ *
+ * @return
+ *     Non-zero if valid metadata was found and stored within info, zero
+ *     otherwise.
+ */
+int guac_common_stat_cache_get(guac_common_stat_cache* cache,
+        const char* path, guac_common_stat_cache_info* info);
+
+/**
+ * Stores the given metadata of the file at the given path, replacing any
+ * existing entry for that path.
+ *
+ * @param cache
+ *     The stat cache to store the metadata within.
+ *
+ * @param path
+ *     The path of the file.
+ *
+ * @param info
+ *     The metadata of the file.
+ */
+void guac_common_stat_cache_put(guac_common_stat_cache* cache,
+        const char* path, const guac_common_stat_cache_info* info);
+
+/**
+ * Invalidates any cached metadata of the file at the given path, as well as
+ * of the directory containing that file, whose own metadata is affected by
+ * files being created, removed or renamed. Paths are separated by forward
+ * slashes.
+ *
+ * @param cache
+ *     The stat cache to remove entries from.
+ *
+ * @param path
+ *     The path of the file which has changed.
+ */
+void guac_common_stat_cache_invalidate(guac_common_stat_cache* cache,
+        const char* path);
+
+/**
+ * Begins watching the local directory at the given path for changes, such
+ * that the cached metadata of the directory and of all files directly within
+ * it is automatically invalidated when changed by any process. If inotify is
+ * not supported, or the limit of GUAC_COMMON_STAT_CACHE_MAX_WATCHES has been
+ * reached, this function has no effect and entries will be invalidated only
+ * explicitly or by expiring. Watching the same directory more than once has
+ * no additional effect.
+ *
+ * @param cache
+ *     The stat cache whose entries should be invalidated upon changes.
+ *
+ * @param path
+ *     The path of the local directory to watch.
+ */
+void guac_common_stat_cache_watch(guac_common_stat_cache* cache,
+        const char* path);
+
+#endif
+
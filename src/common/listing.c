@@ -0,0 +1,310 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "common/listing.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Parses the given non-negative decimal integer, which must end at the next
+ * '&' or at the end of the string.
+ *
+ * @param value
+ *     The string to parse.
+ *
+ * @param max
+ *     The maximum allowed value.
+ *
+ * @param result
+ *     The location in which to store the parsed integer.
+ *
+ * @return
+ *     Zero if a valid integer no greater than max was parsed, non-zero
+ *     otherwise.
+ */
+static int guac_common_listing_parse_int(const char* value, int max,
+        int* result) {
+
+    char* end;
+
+    /* Require at least one digit, without sign or whitespace */
+    if (*value < '0' || *value > '9')
+        return 1;
+
+    errno = 0;
+    long parsed = strtol(value, &end, 10);
+    if (errno || (*end != '&' && *end != '\0') || parsed > max)
+        return 1;
+
+    *result = parsed;
+    return 0;
+
+}
+
+int guac_common_listing_parse(const char* name,
+        guac_common_listing_page* page) {
+
+    page->path = name;
+    page->paged = 0;
+    page->offset = 0;
+    page->limit = 0;
+    page->order = GUAC_COMMON_LISTING_ORDER_NONE;
+
+    /* Any other name requests the entire directory */
+    if (*name != GUAC_COMMON_LISTING_PAGE_PREFIX)
+        return 0;
+
+    page->paged = 1;
+    page->limit = GUAC_COMMON_LISTING_DEFAULT_LIMIT;
+
+    const char* current = name + 1;
+    for (;;) {
+
+        /* The path is always last, and may itself contain '&' */
+        if (strncmp(current, "path=", 5) == 0) {
+            page->path = current + 5;
+            return 0;
+        }
+
+        if (strncmp(current, "offset=", 7) == 0) {
+            if (guac_common_listing_parse_int(current + 7, INT_MAX,
+                        &page->offset))
+                return 1;
+        }
+
+        else if (strncmp(current, "limit=", 6) == 0) {
+            if (guac_common_listing_parse_int(current + 6,
+                        GUAC_COMMON_LISTING_MAX_LIMIT, &page->limit)
+                    || page->limit == 0)
+                return 1;
+        }
+
+        else if (strncmp(current, "order=name&", 11) == 0)
+            page->order = GUAC_COMMON_LISTING_ORDER_NAME;
+
+        else if (strncmp(current, "order=none&", 11) == 0)
+            page->order = GUAC_COMMON_LISTING_ORDER_NONE;
+
+        /* Unknown parameters are ignored */
+
+        /* Advance to next parameter, failing if there is no path */
+        current = strchr(current, '&');
+        if (current == NULL)
+            return 1;
+
+        current++;
+
+    }
+
+}
+
+int guac_common_listing_next(const guac_common_listing_page* page,
+        char* buffer, int length) {
+
+    /* Stop if the following page could not be represented */
+    if (page->offset > INT_MAX - page->limit)
+        return 1;
+
+    int written = snprintf(buffer, length, "%coffset=%i&limit=%i&order=%s"
+            "&path=%s", GUAC_COMMON_LISTING_PAGE_PREFIX,
+            page->offset + page->limit, page->limit,
+            page->order == GUAC_COMMON_LISTING_ORDER_NAME ? "name" : "none",
+            page->path);
+
+    return written < 0 || written >= length;
+
+}
+
+int guac_common_listing_entries_add(guac_common_listing_entries* entries,
+        const char* name, guac_common_listing_type type) {
+
+    /* Expand array if necessary */
+    if (entries->count == entries->capacity) {
+
+        int capacity = entries->capacity ? entries->capacity * 2 : 256;
+        guac_common_listing_entry* expanded = realloc(entries->entries,
+                sizeof(guac_common_listing_entry) * capacity);
+        if (expanded == NULL)
+            return 1;
+
+        entries->entries = expanded;
+        entries->capacity = capacity;
+
+    }
+
+    char* copy = strdup(name);
+    if (copy == NULL)
+        return 1;
+
+    guac_common_listing_entry* entry = &entries->entries[entries->count++];
+    entry->name = copy;
+    entry->type = type;
+
+    return 0;
+
+}
+
+/**
+ * Comparator for qsort() which compares two directory entries by the byte
+ * values of their names.
+ *
+ * @param a
+ *     A pointer to the first guac_common_listing_entry.
+ *
+ * @param b
+ *     A pointer to the second guac_common_listing_entry.
+ *
+ * @return
+ *     A negative value, zero, or a positive value if the first entry sorts
+ *     before, equal to, or after the second entry respectively.
+ */
+static int guac_common_listing_compare(const void* a, const void* b) {
+    return strcmp(((const guac_common_listing_entry*) a)->name,
+            ((const guac_common_listing_entry*) b)->name);
+}
+
+void guac_common_listing_entries_sort(guac_common_listing_entries* entries) {
+    if (entries->count > 1)
+        qsort(entries->entries, entries->count,
+                sizeof(guac_common_listing_entry),
+                guac_common_listing_compare);
+}
+
+void guac_common_listing_entries_free(guac_common_listing_entries* entries) {
+
+    for (int i = 0; i < entries->count; i++)
+        free(entries->entries[i].name);
+
+    free(entries->entries);
+
+    entries->entries = NULL;
+    entries->count = 0;
+    entries->capacity = 0;
+
+}
+
+void guac_common_listing_cache_init(guac_common_listing_cache* cache,
+        guac_common_listing_free_handler* free_handler) {
+
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->free_handler = free_handler;
+    cache->state = NULL;
+    cache->path = NULL;
+    cache->order = GUAC_COMMON_LISTING_ORDER_NONE;
+    cache->position = 0;
+    cache->stored = 0;
+
+}
+
+/**
+ * Removes the retained listing from the given listing cache, if any,
+ * returning its state. The cache must be locked.
+ *
+ * @param cache
+ *     The listing cache to remove the retained listing from.
+ *
+ * @return
+ *     The state of the listing removed, or NULL if no listing was retained.
+ */
+static void* guac_common_listing_cache_remove(
+        guac_common_listing_cache* cache) {
+
+    void* state = cache->state;
+
+    free(cache->path);
+    cache->path = NULL;
+    cache->state = NULL;
+
+    return state;
+
+}
+
+void guac_common_listing_cache_destroy(guac_common_listing_cache* cache) {
+    guac_common_listing_cache_invalidate(cache);
+    pthread_mutex_destroy(&cache->lock);
+}
+
+void* guac_common_listing_cache_take(guac_common_listing_cache* cache,
+        const guac_common_listing_page* page) {
+
+    pthread_mutex_lock(&cache->lock);
+
+    int matches = cache->state != NULL
+        && page->paged && page->offset > 0
+        && page->offset == cache->position
+        && page->order == cache->order
+        && strcmp(page->path, cache->path) == 0
+        && guac_timestamp_current() - cache->stored
+            <= GUAC_COMMON_LISTING_CACHE_TIMEOUT;
+
+    void* state = guac_common_listing_cache_remove(cache);
+
+    pthread_mutex_unlock(&cache->lock);
+
+    /* Any listing which is not continued is no longer needed */
+    if (state != NULL && !matches) {
+        cache->free_handler(state);
+        return NULL;
+    }
+
+    return state;
+
+}
+
+void guac_common_listing_cache_store(guac_common_listing_cache* cache,
+        const guac_common_listing_page* page, int position, void* state) {
+
+    char* path = strdup(page->path);
+    if (path == NULL) {
+        cache->free_handler(state);
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    void* old_state = guac_common_listing_cache_remove(cache);
+
+    cache->state = state;
+    cache->path = path;
+    cache->order = page->order;
+    cache->position = position;
+    cache->stored = guac_timestamp_current();
+
+    pthread_mutex_unlock(&cache->lock);
+
+    if (old_state != NULL)
+        cache->free_handler(old_state);
+
+}
+
+void guac_common_listing_cache_invalidate(guac_common_listing_cache* cache) {
+
+    pthread_mutex_lock(&cache->lock);
+    void* state = guac_common_listing_cache_remove(cache);
+    pthread_mutex_unlock(&cache->lock);
+
+    if (state != NULL)
+        cache->free_handler(state);
+
+}
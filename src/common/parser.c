@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "config.h"
+#include "common/parser.h"
+
+#include <guacamole/error.h>
+#include <guacamole/parser.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <limits.h>
+#include <stddef.h>
+#include <unistd.h>
+
+int guac_common_parser_read_mapped(int fd, guac_common_parser_handler* handler,
+        void* data) {
+
+    /* Only regular files can be mapped */
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) || !S_ISREG(file_stat.st_mode))
+        return -1;
+
+    /* Nothing to read from empty files */
+    size_t size = file_stat.st_size;
+    if (size == 0)
+        return 0;
+
+    char* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+            fd, 0);
+    if (mapping == MAP_FAILED)
+        return -1;
+
+    posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+
+    /* Obtain Guacamole protocol parser */
+    guac_parser* parser = guac_parser_alloc();
+    if (parser == NULL) {
+        guac_error = GUAC_STATUS_NO_MEMORY;
+        guac_error_message = "Unable to allocate parser";
+        munmap(mapping, size);
+        return 1;
+    }
+
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t offset = 0;
+    size_t unmapped = 0;
+
+    /* Continuously parse and handle all instructions */
+    for (;;) {
+
+        size_t remaining = size - offset;
+        int parsed = guac_parser_parse_buffer(parser, mapping + offset,
+                remaining > INT_MAX ? INT_MAX : remaining);
+
+        if (parsed < 0)
+            break;
+
+        handler(parser, data);
+        offset += parsed;
+
+        /* Release consumed pages once a sufficient number have accumulated */
+        size_t consumed = (offset / page_size) * page_size;
+        if (consumed - unmapped >= GUAC_COMMON_PARSER_MAPPED_RELEASE_SIZE) {
+            munmap(mapping + unmapped, consumed - unmapped);
+            unmapped = consumed;
+        }
+
+    }
+
+    munmap(mapping + unmapped, size - unmapped);
+    guac_parser_free(parser);
+
+    /* Reaching the end of the file is the only expected failure */
+    if (guac_error != GUAC_STATUS_CLOSED)
+        return 1;
+
+    return 0;
+
+}
+
@@ -0,0 +1,449 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "config.h"
+#include "common/stat-cache.h"
+
+#include <guacamole/timestamp.h>
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Produces the FNV-1a hash of the given number of bytes of the given path.
+ *
+ * @param path
+ *     The path to hash.
+ *
+ * @param length
+ *     The number of bytes of the path to hash.
+ *
+ * @return
+ *     The hash of the path.
+ */
+static uint64_t guac_common_stat_cache_hash(const char* path, size_t length) {
+
+    uint64_t hash = 0xCBF29CE484222325;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char) path[i];
+        hash *= 0x100000001B3;
+    }
+
+    return hash;
+
+}
+
+/**
+ * Locates the entry for the given number of bytes of the given path. The
+ * stat cache must be locked.
+ *
+ * @param cache
+ *     The stat cache to search.
+ *
+ * @param path
+ *     The path of the file, which need not be null-terminated.
+ *
+ * @param length
+ *     The length of the path, in bytes.
+ *
+ * @param hash
+ *     The hash of the path, as produced by guac_common_stat_cache_hash().
+ *
+ * @return
+ *     A pointer to the link referencing the entry (either the head of its
+ *     bucket or the next pointer of the preceding entry), such that the entry
+ *     may be removed, or a pointer to the NULL link terminating the bucket if
+ *     there is no such entry.
+ */
+static guac_common_stat_cache_entry** guac_common_stat_cache_find(
+        guac_common_stat_cache* cache, const char* path, size_t length,
+        uint64_t hash) {
+
+    guac_common_stat_cache_entry** link =
+        &cache->buckets[hash & (GUAC_COMMON_STAT_CACHE_BUCKETS - 1)];
+
+    for (; *link != NULL; link = &(*link)->next) {
+        guac_common_stat_cache_entry* entry = *link;
+        if (entry->hash == hash && strncmp(entry->path, path, length) == 0
+                && entry->path[length] == '\0')
+            break;
+    }
+
+    return link;
+
+}
+
+/**
+ * Removes the entry for the given number of bytes of the given path, if any.
+ * The stat cache must be locked.
+ *
+ * @param cache
+ *     The stat cache to remove the entry from.
+ *
+ * @param path
+ *     The path of the file, which need not be null-terminated.
+ *
+ * @param length
+ *     The length of the path, in bytes.
+ */
+static void guac_common_stat_cache_remove(guac_common_stat_cache* cache,
+        const char* path, size_t length) {
+
+    guac_common_stat_cache_entry** link = guac_common_stat_cache_find(cache,
+            path, length, guac_common_stat_cache_hash(path, length));
+
+    guac_common_stat_cache_entry* entry = *link;
+    if (entry != NULL) {
+        *link = entry->next;
+        cache->count--;
+        free(entry);
+    }
+
+}
+
+/**
+ * Removes all entries from the given stat cache. The stat cache must be
+ * locked.
+ *
+ * @param cache
+ *     The stat cache to clear.
+ */
+static void guac_common_stat_cache_clear(guac_common_stat_cache* cache) {
+
+    for (int i = 0; i < GUAC_COMMON_STAT_CACHE_BUCKETS; i++) {
+
+        guac_common_stat_cache_entry* entry = cache->buckets[i];
+        while (entry != NULL) {
+            guac_common_stat_cache_entry* next = entry->next;
+            free(entry);
+            entry = next;
+        }
+
+        cache->buckets[i] = NULL;
+
+    }
+
+    cache->count = 0;
+
+}
+
+/**
+ * Removes the entries for the file at the given path and for the directory
+ * containing that file. The stat cache must be locked.
+ *
+ * @param cache
+ *     The stat cache to remove entries from.
+ *
+ * @param path
+ *     The path of the file which has changed.
+ */
+static void guac_common_stat_cache_remove_with_parent(
+        guac_common_stat_cache* cache, const char* path) {
+
+    guac_common_stat_cache_remove(cache, path, strlen(path));
+
+    /* The parent of a top-level file is the root directory */
+    const char* last_slash = strrchr(path, '/');
+    if (last_slash == path)
+        guac_common_stat_cache_remove(cache, "/", 1);
+    else if (last_slash != NULL)
+        guac_common_stat_cache_remove(cache, path, last_slash - path);
+
+}
+
+#ifdef HAVE_INOTIFY
+/**
+ * Processes all pending inotify events, invalidating the entries of any
+ * files which have changed. The stat cache must be locked.
+ *
+ * @param cache
+ *     The stat cache whose entries should be invalidated.
+ */
+static void guac_common_stat_cache_drain(guac_common_stat_cache* cache) {
+
+    char buffer[4096]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+    char path[PATH_MAX];
+    ssize_t length;
+
+    while ((length = read(cache->inotify_fd, buffer, sizeof(buffer))) > 0) {
+
+        char* current = buffer;
+        while (current < buffer + length) {
+
+            const struct inotify_event* event =
+                (const struct inotify_event*) current;
+
+            current += sizeof(struct inotify_event) + event->len;
+
+            /* Events may have been lost, so nothing can be trusted */
+            if (event->mask & IN_Q_OVERFLOW) {
+                guac_common_stat_cache_clear(cache);
+                continue;
+            }
+
+            /* Locate watched directory */
+            int index;
+            for (index = 0; index < cache->watch_count; index++) {
+                if (cache->watches[index].wd == event->wd)
+                    break;
+            }
+
+            if (index == cache->watch_count)
+                continue;
+
+            guac_common_stat_cache_directory* watch = &cache->watches[index];
+
+            /* Invalidate changed file, or the directory itself */
+            if (event->len > 0 && snprintf(path, sizeof(path), "%s/%s",
+                        watch->path, event->name) < sizeof(path))
+                guac_common_stat_cache_remove_with_parent(cache, path);
+            else
+                guac_common_stat_cache_remove_with_parent(cache, watch->path);
+
+            /* Forget directories which are no longer watched */
+            if (event->mask & IN_IGNORED) {
+                free(watch->path);
+                cache->watches[index] = cache->watches[--cache->watch_count];
+            }
+
+        }
+
+    }
+
+}
+
+/**
+ * Begins watching the local directory at the given path for changes, as
+ * described by guac_common_stat_cache_watch(). The stat cache must be locked.
+ *
+ * @param cache
+ *     The stat cache whose entries should be invalidated upon changes.
+ *
+ * @param path
+ *     The path of the local directory to watch.
+ */
+static void guac_common_stat_cache_add_watch(guac_common_stat_cache* cache,
+        const char* path) {
+
+    /* Init inotify upon first use */
+    if (cache->inotify_fd == -1) {
+        cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (cache->inotify_fd == -1)
+            return;
+    }
+
+    int wd = inotify_add_watch(cache->inotify_fd, path, IN_ONLYDIR
+            | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+            | IN_DELETE_SELF | IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM
+            | IN_MOVED_TO);
+
+    if (wd == -1)
+        return;
+
+    /* Watching the same directory again produces the same descriptor */
+    for (int i = 0; i < cache->watch_count; i++) {
+        if (cache->watches[i].wd == wd)
+            return;
+    }
+
+    /* Stop watching if no more watches may be tracked */
+    if (cache->watch_count == GUAC_COMMON_STAT_CACHE_MAX_WATCHES) {
+        inotify_rm_watch(cache->inotify_fd, wd);
+        return;
+    }
+
+    if (cache->watches == NULL)
+        cache->watches = malloc(sizeof(guac_common_stat_cache_directory)
+                * GUAC_COMMON_STAT_CACHE_MAX_WATCHES);
+
+    /* Stop watching if the watch cannot be tracked */
+    char* watch_path = strdup(path);
+    if (cache->watches == NULL || watch_path == NULL) {
+        inotify_rm_watch(cache->inotify_fd, wd);
+        free(watch_path);
+        return;
+    }
+
+    cache->watches[cache->watch_count].wd = wd;
+    cache->watches[cache->watch_count].path = watch_path;
+    cache->watch_count++;
+
+}
+#endif
+
+guac_common_stat_cache* guac_common_stat_cache_alloc(int ttl) {
+
+    guac_common_stat_cache* cache = calloc(1, sizeof(guac_common_stat_cache));
+    if (cache == NULL)
+        return NULL;
+
+    cache->ttl = ttl;
+    cache->inotify_fd = -1;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    return cache;
+
+}
+
+void guac_common_stat_cache_free(guac_common_stat_cache* cache) {
+
+    if (cache == NULL)
+        return;
+
+    guac_common_stat_cache_clear(cache);
+
+#ifdef HAVE_INOTIFY
+    if (cache->inotify_fd != -1)
+        close(cache->inotify_fd);
+#endif
+
+    for (int i = 0; i < cache->watch_count; i++)
+        free(cache->watches[i].path);
+
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->watches);
+    free(cache);
+
+}
+
+int guac_common_stat_cache_get(guac_common_stat_cache* cache,
+        const char* path, guac_common_stat_cache_info* info) {
+
+    /* Nothing is ever cached if the cache could not be allocated */
+    if (cache == NULL)
+        return 0;
+
+    int found = 0;
+    size_t length = strlen(path);
+    guac_timestamp now = guac_timestamp_current();
+
+    pthread_mutex_lock(&cache->lock);
+
+#ifdef HAVE_INOTIFY
+    /* Apply any changes reported since last checked, at most once per
+     * millisecond such that large listings do not check for every file */
+    if (cache->inotify_fd != -1 && now != cache->last_drain) {
+        guac_common_stat_cache_drain(cache);
+        cache->last_drain = now;
+    }
+#endif
+
+    guac_common_stat_cache_entry** link = guac_common_stat_cache_find(cache,
+            path, length, guac_common_stat_cache_hash(path, length));
+
+    guac_common_stat_cache_entry* entry = *link;
+    if (entry != NULL) {
+
+        /* Use entry only if not yet expired */
+        if (now < entry->expires) {
+            *info = entry->info;
+            found = 1;
+        }
+
+        /* Otherwise, remove it */
+        else {
+            *link = entry->next;
+            cache->count--;
+            free(entry);
+        }
+
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    return found;
+
+}
+
+void guac_common_stat_cache_put(guac_common_stat_cache* cache,
+        const char* path, const guac_common_stat_cache_info* info) {
+
+    if (cache == NULL)
+        return;
+
+    size_t length = strlen(path);
+    uint64_t hash = guac_common_stat_cache_hash(path, length);
+
+    /* Simply do not cache the metadata if no entry can be allocated */
+    guac_common_stat_cache_entry* entry =
+        malloc(sizeof(guac_common_stat_cache_entry) + length + 1);
+    if (entry == NULL)
+        return;
+
+    entry->hash = hash;
+    entry->expires = guac_timestamp_current() + cache->ttl;
+    entry->info = *info;
+    memcpy(entry->path, path, length + 1);
+
+    pthread_mutex_lock(&cache->lock);
+
+    /* Replace any existing entry */
+    guac_common_stat_cache_remove(cache, path, length);
+
+    /* Start over if full */
+    if (cache->count >= GUAC_COMMON_STAT_CACHE_MAX_ENTRIES)
+        guac_common_stat_cache_clear(cache);
+
+    guac_common_stat_cache_entry** bucket =
+        &cache->buckets[hash & (GUAC_COMMON_STAT_CACHE_BUCKETS - 1)];
+
+    entry->next = *bucket;
+    *bucket = entry;
+    cache->count++;
+
+    pthread_mutex_unlock(&cache->lock);
+
+}
+
+void guac_common_stat_cache_invalidate(guac_common_stat_cache* cache,
+        const char* path) {
+
+    if (cache == NULL)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    guac_common_stat_cache_remove_with_parent(cache, path);
+    pthread_mutex_unlock(&cache->lock);
+
+}
+
+void guac_common_stat_cache_watch(guac_common_stat_cache* cache,
+        const char* path) {
+
+#ifdef HAVE_INOTIFY
+    if (cache == NULL)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    guac_common_stat_cache_add_watch(cache, path);
+    pthread_mutex_unlock(&cache->lock);
+#endif
+
+}
+
@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/batch.h"
+
+#include <CUnit/CUnit.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * The sizes of each file added to the batch, in the order added. More files
+ * are given than fit within the initial capacity of the queue, such that the
+ * queue must also be expanded.
+ */
+static const int test_sizes[] = {
+    30, 5, 100, 0, 42, 7, 99, 64, 12, 1, 77, 50, 3, 88, 21, 60, 9, 31, 42, 2
+};
+
+/**
+ * The number of files added to the batch.
+ */
+#define TEST_FILES ((int) (sizeof(test_sizes) / sizeof(test_sizes[0])))
+
+/**
+ * The size of each file processed by test_batch_callback(), in the order
+ * processed.
+ */
+static off_t processed[TEST_FILES];
+
+/**
+ * The number of files processed by test_batch_callback().
+ */
+static int processed_count;
+
+/**
+ * Callback which records the size of each processed file, failing for empty
+ * files only.
+ *
+ * @param path
+ *     The path of the file being processed.
+ *
+ * @param data
+ *     Unused.
+ *
+ * @return
+ *     Non-zero if the file is empty, zero otherwise.
+ */
+static int test_batch_callback(const char* path, void* data) {
+
+    struct stat file_stat;
+    CU_ASSERT_FATAL(stat(path, &file_stat) == 0);
+    CU_ASSERT_FATAL(processed_count < TEST_FILES);
+
+    processed[processed_count++] = file_stat.st_size;
+    return file_stat.st_size == 0;
+
+}
+
+/**
+ * Test which verifies that files queued within a batch are processed
+ * largest-first, regardless of the order in which they were added, and that
+ * the failures reported by the callback are counted.
+ */
+void test_batch__order() {
+
+    char dir[] = "/tmp/guac-test-batch-XXXXXX";
+    char paths[TEST_FILES][64];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+
+    guac_common_batch* batch = guac_common_batch_alloc(test_batch_callback,
+            NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(batch);
+
+    /* Queue files of varying sizes before any worker is started */
+    for (int i = 0; i < TEST_FILES; i++) {
+
+        snprintf(paths[i], sizeof(paths[i]), "%s/%i", dir, i);
+
+        FILE* file = fopen(paths[i], "w");
+        CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+        for (int j = 0; j < test_sizes[i]; j++)
+            fputc('x', file);
+        fclose(file);
+
+        CU_ASSERT_EQUAL(guac_common_batch_add(batch, paths[i]), 0);
+
+    }
+
+    /* Files which do not exist cannot be queued */
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_add(batch, "/nonexistent/file"),
+            0);
+
+    /* A single worker processes files strictly in order of size */
+    processed_count = 0;
+    CU_ASSERT_EQUAL_FATAL(guac_common_batch_start(batch, 1), 0);
+    CU_ASSERT_EQUAL(guac_common_batch_wait(batch), 1);
+
+    CU_ASSERT_EQUAL(batch->total, TEST_FILES);
+    CU_ASSERT_EQUAL(processed_count, TEST_FILES);
+
+    CU_ASSERT_EQUAL(processed[0], 100);
+    for (int i = 1; i < processed_count; i++)
+        CU_ASSERT(processed[i] <= processed[i - 1]);
+
+    guac_common_batch_free(batch);
+
+    for (int i = 0; i < TEST_FILES; i++)
+        unlink(paths[i]);
+
+    rmdir(dir);
+
+}
+
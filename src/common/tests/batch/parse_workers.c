@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/batch.h"
+
+#include <CUnit/CUnit.h>
+
+/**
+ * Test which verifies that guac_common_batch_parse_workers() accepts only
+ * decimal integers within the legal range of worker counts, leaving the
+ * stored worker count untouched otherwise.
+ */
+void test_batch__parse_workers() {
+
+    int workers = 0;
+
+    /* Valid counts */
+    CU_ASSERT_EQUAL(guac_common_batch_parse_workers("1", &workers), 0);
+    CU_ASSERT_EQUAL(workers, 1);
+
+    CU_ASSERT_EQUAL(guac_common_batch_parse_workers("16", &workers), 0);
+    CU_ASSERT_EQUAL(workers, 16);
+
+    CU_ASSERT_EQUAL(guac_common_batch_parse_workers("256", &workers), 0);
+    CU_ASSERT_EQUAL(workers, GUAC_COMMON_BATCH_MAX_WORKERS);
+
+    /* Values out of range */
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers("0", &workers), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers("-1", &workers), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers("257", &workers), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers(
+                "99999999999999999999", &workers), 0);
+
+    /* Values which are not entirely a decimal integer */
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers("", &workers), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers("abc", &workers), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers("5x", &workers), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_batch_parse_workers("2.5", &workers), 0);
+
+    /* Failed parses must not modify the stored count */
+    CU_ASSERT_EQUAL(workers, GUAC_COMMON_BATCH_MAX_WORKERS);
+
+}
+
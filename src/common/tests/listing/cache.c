@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/listing.h"
+
+#include <CUnit/CUnit.h>
+
+/**
+ * The number of times test_listing_free() has been invoked.
+ */
+static int freed = 0;
+
+/**
+ * Free handler which counts the listing states freed rather than freeing
+ * them.
+ *
+ * @param state
+ *     The listing state being freed.
+ */
+static void test_listing_free(void* state) {
+    freed++;
+}
+
+/**
+ * Test which verifies that a retained listing is returned only for the page
+ * which continues it, and that any other request frees that listing.
+ */
+void test_listing__cache_continue() {
+
+    int state;
+    guac_common_listing_page page;
+    guac_common_listing_cache cache;
+
+    guac_common_listing_cache_init(&cache, test_listing_free);
+    freed = 0;
+
+    /* The following page continues the listing */
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=0&limit=10&order=name&path=/dir", &page), 0);
+    guac_common_listing_cache_store(&cache, &page, 10, &state);
+
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=10&limit=10&order=name&path=/dir", &page), 0);
+    CU_ASSERT_PTR_EQUAL(guac_common_listing_cache_take(&cache, &page),
+            &state);
+    CU_ASSERT_EQUAL(freed, 0);
+
+    /* Once taken, the listing is no longer retained */
+    CU_ASSERT_PTR_NULL(guac_common_listing_cache_take(&cache, &page));
+
+    /* Pages of other directories, orders, or offsets do not */
+    guac_common_listing_cache_store(&cache, &page, 20, &state);
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=20&limit=10&order=none&path=/dir", &page), 0);
+    CU_ASSERT_PTR_NULL(guac_common_listing_cache_take(&cache, &page));
+    CU_ASSERT_EQUAL(freed, 1);
+
+    guac_common_listing_cache_store(&cache, &page, 20, &state);
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=20&limit=10&order=none&path=/other", &page), 0);
+    CU_ASSERT_PTR_NULL(guac_common_listing_cache_take(&cache, &page));
+    CU_ASSERT_EQUAL(freed, 2);
+
+    guac_common_listing_cache_store(&cache, &page, 20, &state);
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=0&limit=10&order=none&path=/other", &page), 0);
+    CU_ASSERT_PTR_NULL(guac_common_listing_cache_take(&cache, &page));
+    CU_ASSERT_EQUAL(freed, 3);
+
+    guac_common_listing_cache_destroy(&cache);
+    CU_ASSERT_EQUAL(freed, 3);
+
+}
+
+/**
+ * Test which verifies that storing a listing, invalidating the cache, or
+ * destroying the cache frees any listing already retained.
+ */
+void test_listing__cache_invalidate() {
+
+    int state;
+    guac_common_listing_page page;
+    guac_common_listing_cache cache;
+
+    guac_common_listing_cache_init(&cache, test_listing_free);
+    freed = 0;
+
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=0&limit=10&path=/dir", &page), 0);
+
+    guac_common_listing_cache_store(&cache, &page, 10, &state);
+    guac_common_listing_cache_store(&cache, &page, 10, &state);
+    CU_ASSERT_EQUAL(freed, 1);
+
+    guac_common_listing_cache_invalidate(&cache);
+    CU_ASSERT_EQUAL(freed, 2);
+
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=10&limit=10&path=/dir", &page), 0);
+    CU_ASSERT_PTR_NULL(guac_common_listing_cache_take(&cache, &page));
+
+    guac_common_listing_cache_store(&cache, &page, 20, &state);
+    guac_common_listing_cache_destroy(&cache);
+    CU_ASSERT_EQUAL(freed, 3);
+
+}
+
@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/listing.h"
+
+#include <CUnit/CUnit.h>
+
+/**
+ * Test which verifies that guac_common_listing_parse() treats any name which
+ * is not a request for a page as a request for the entire directory.
+ */
+void test_listing__parse_unpaged() {
+
+    guac_common_listing_page page;
+
+    CU_ASSERT_EQUAL(guac_common_listing_parse("/some/dir", &page), 0);
+    CU_ASSERT_STRING_EQUAL(page.path, "/some/dir");
+    CU_ASSERT_FALSE(page.paged);
+    CU_ASSERT_EQUAL(page.offset, 0);
+    CU_ASSERT_EQUAL(page.limit, 0);
+    CU_ASSERT_EQUAL(page.order, GUAC_COMMON_LISTING_ORDER_NONE);
+
+}
+
+/**
+ * Test which verifies that guac_common_listing_parse() parses all parameters
+ * of a request for a page, taking the remainder of the name as the path.
+ */
+void test_listing__parse_paged() {
+
+    guac_common_listing_page page;
+
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?limit=50&order=name&offset=100&path=/a&b", &page), 0);
+    CU_ASSERT_STRING_EQUAL(page.path, "/a&b");
+    CU_ASSERT_TRUE(page.paged);
+    CU_ASSERT_EQUAL(page.offset, 100);
+    CU_ASSERT_EQUAL(page.limit, 50);
+    CU_ASSERT_EQUAL(page.order, GUAC_COMMON_LISTING_ORDER_NAME);
+
+    /* Omitted parameters take their defaults */
+    CU_ASSERT_EQUAL(guac_common_listing_parse("?path=/", &page), 0);
+    CU_ASSERT_STRING_EQUAL(page.path, "/");
+    CU_ASSERT_EQUAL(page.offset, 0);
+    CU_ASSERT_EQUAL(page.limit, GUAC_COMMON_LISTING_DEFAULT_LIMIT);
+    CU_ASSERT_EQUAL(page.order, GUAC_COMMON_LISTING_ORDER_NONE);
+
+}
+
+/**
+ * Test which verifies that guac_common_listing_parse() rejects malformed
+ * requests for pages.
+ */
+void test_listing__parse_invalid() {
+
+    guac_common_listing_page page;
+
+    CU_ASSERT_NOT_EQUAL(guac_common_listing_parse("?offset=1", &page), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_listing_parse("?offset=-1&path=/",
+                &page), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_listing_parse("?offset=1x&path=/",
+                &page), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_listing_parse("?limit=0&path=/",
+                &page), 0);
+    CU_ASSERT_NOT_EQUAL(guac_common_listing_parse("?limit=10001&path=/",
+                &page), 0);
+
+}
+
+/**
+ * Test which verifies that guac_common_listing_next() produces a request for
+ * the following page which parses back to that page.
+ */
+void test_listing__next() {
+
+    char name[256];
+    guac_common_listing_page page;
+    guac_common_listing_page next;
+
+    CU_ASSERT_EQUAL(guac_common_listing_parse(
+                "?offset=20&limit=10&order=name&path=/logs", &page), 0);
+    CU_ASSERT_EQUAL(guac_common_listing_next(&page, name, sizeof(name)), 0);
+    CU_ASSERT_STRING_EQUAL(name, "?offset=30&limit=10&order=name&path=/logs");
+
+    CU_ASSERT_EQUAL(guac_common_listing_parse(name, &next), 0);
+    CU_ASSERT_STRING_EQUAL(next.path, "/logs");
+    CU_ASSERT_EQUAL(next.offset, 30);
+    CU_ASSERT_EQUAL(next.limit, 10);
+    CU_ASSERT_EQUAL(next.order, GUAC_COMMON_LISTING_ORDER_NAME);
+
+    /* Names which do not fit must not be produced */
+    CU_ASSERT_NOT_EQUAL(guac_common_listing_next(&page, name, 8), 0);
+
+}
+
+/**
+ * Test which verifies that guac_common_listing_entries_sort() sorts entries
+ * by the byte values of their names, preserving their types.
+ */
+void test_listing__entries_sort() {
+
+    guac_common_listing_entries entries = { 0 };
+
+    CU_ASSERT_EQUAL(guac_common_listing_entries_add(&entries, "b",
+                GUAC_COMMON_LISTING_TYPE_FILE), 0);
+    CU_ASSERT_EQUAL(guac_common_listing_entries_add(&entries, "C",
+                GUAC_COMMON_LISTING_TYPE_DIRECTORY), 0);
+    CU_ASSERT_EQUAL(guac_common_listing_entries_add(&entries, "a",
+                GUAC_COMMON_LISTING_TYPE_UNKNOWN), 0);
+
+    guac_common_listing_entries_sort(&entries);
+    CU_ASSERT_EQUAL(entries.count, 3);
+    CU_ASSERT_STRING_EQUAL(entries.entries[0].name, "C");
+    CU_ASSERT_EQUAL(entries.entries[0].type,
+            GUAC_COMMON_LISTING_TYPE_DIRECTORY);
+    CU_ASSERT_STRING_EQUAL(entries.entries[1].name, "a");
+    CU_ASSERT_EQUAL(entries.entries[1].type, GUAC_COMMON_LISTING_TYPE_UNKNOWN);
+    CU_ASSERT_STRING_EQUAL(entries.entries[2].name, "b");
+    CU_ASSERT_EQUAL(entries.entries[2].type, GUAC_COMMON_LISTING_TYPE_FILE);
+
+    guac_common_listing_entries_free(&entries);
+    CU_ASSERT_EQUAL(entries.count, 0);
+    CU_ASSERT_PTR_NULL(entries.entries);
+
+}
+
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "common/parser.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/error.h>
+#include <guacamole/parser.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The opcodes and first arguments of each instruction passed to
+ * test_parser_handler(), separated by commas.
+ */
+static char handled[256];
+
+/**
+ * Handler which records the opcode and first argument of each instruction
+ * parsed.
+ *
+ * @param parser
+ *     The guac_parser which parsed the instruction.
+ *
+ * @param data
+ *     Unused.
+ */
+static void test_parser_handler(guac_parser* parser, void* data) {
+
+    size_t length = strlen(handled);
+    snprintf(handled + length, sizeof(handled) - length, "%s%s:%s",
+            length ? "," : "", parser->opcode,
+            parser->argc > 0 ? parser->argv[0] : "");
+
+}
+
+/**
+ * Creates a temporary file containing the given data, returning a file
+ * descriptor for that file. The file is unlinked, and will be removed once
+ * the descriptor is closed.
+ *
+ * @param data
+ *     The data to write to the file.
+ *
+ * @return
+ *     A file descriptor for the temporary file.
+ */
+static int test_parser_file(const char* data) {
+
+    char path[] = "/tmp/guac-test-parser-XXXXXX";
+    int fd = mkstemp(path);
+    CU_ASSERT_FATAL(fd >= 0);
+    unlink(path);
+
+    size_t length = strlen(data);
+    CU_ASSERT_FATAL(write(fd, data, length) == (ssize_t) length);
+
+    return fd;
+
+}
+
+/**
+ * Test which verifies that guac_common_parser_read_mapped() passes each
+ * instruction within a file to the given handler, without modifying the
+ * file itself.
+ */
+void test_parser__read_mapped() {
+
+    const char* data = "4.sync,3.123;5.mouse,2.10,2.20;3.nop;";
+    int fd = test_parser_file(data);
+    handled[0] = '\0';
+
+    CU_ASSERT_EQUAL(guac_common_parser_read_mapped(fd,
+                test_parser_handler, NULL), 0);
+    CU_ASSERT_STRING_EQUAL(handled, "sync:123,mouse:10,nop:");
+
+    /* Elements are NULL-terminated only within the private mapping */
+    char contents[64] = { 0 };
+    CU_ASSERT_EQUAL(pread(fd, contents, sizeof(contents) - 1, 0),
+            (ssize_t) strlen(data));
+    CU_ASSERT_STRING_EQUAL(contents, data);
+
+    close(fd);
+
+}
+
+/**
+ * Test which verifies that guac_common_parser_read_mapped() fails on
+ * malformed instructions, and refuses files which cannot be mapped.
+ */
+void test_parser__read_mapped_errors() {
+
+    /* Instructions preceding a parse error are still handled */
+    int fd = test_parser_file("3.nop;4.sync,x;");
+    handled[0] = '\0';
+
+    CU_ASSERT(guac_common_parser_read_mapped(fd,
+                test_parser_handler, NULL) > 0);
+    CU_ASSERT_EQUAL(guac_error, GUAC_STATUS_PROTOCOL_ERROR);
+    CU_ASSERT_STRING_EQUAL(handled, "nop:");
+    close(fd);
+
+    /* Empty files contain no instructions */
+    fd = test_parser_file("");
+    handled[0] = '\0';
+
+    CU_ASSERT_EQUAL(guac_common_parser_read_mapped(fd,
+                test_parser_handler, NULL), 0);
+    CU_ASSERT_STRING_EQUAL(handled, "");
+    close(fd);
+
+    /* Pipes cannot be mapped */
+    int fds[2];
+    CU_ASSERT_FATAL(pipe(fds) == 0);
+    CU_ASSERT_EQUAL(guac_common_parser_read_mapped(fds[0],
+                test_parser_handler, NULL), -1);
+    close(fds[0]);
+    close(fds[1]);
+
+}
+
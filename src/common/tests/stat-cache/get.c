@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "common/stat-cache.h"
+
+#include <CUnit/CUnit.h>
+
+/**
+ * Test which verifies that guac_common_stat_cache_get() returns metadata
+ * previously stored with guac_common_stat_cache_put(), and only for the
+ * exact path given.
+ */
+void test_stat_cache__get() {
+
+    guac_common_stat_cache_info info = { .directory = 1, .size = 1234 };
+    guac_common_stat_cache_info found;
+
+    guac_common_stat_cache* cache = guac_common_stat_cache_alloc(60000);
+    guac_common_stat_cache_put(cache, "/a/b", &info);
+
+    CU_ASSERT_TRUE(guac_common_stat_cache_get(cache, "/a/b", &found));
+    CU_ASSERT_EQUAL(found.directory, 1);
+    CU_ASSERT_EQUAL(found.size, 1234);
+
+    CU_ASSERT_FALSE(guac_common_stat_cache_get(cache, "/a", &found));
+    CU_ASSERT_FALSE(guac_common_stat_cache_get(cache, "/a/b/c", &found));
+
+    guac_common_stat_cache_free(cache);
+
+}
+
+/**
+ * Test which verifies that guac_common_stat_cache_invalidate() removes the
+ * entries of both the given file and its parent directory, while leaving
+ * the entries of other files within the same directory intact.
+ */
+void test_stat_cache__invalidate() {
+
+    guac_common_stat_cache_info info = { .size = 1 };
+    guac_common_stat_cache_info found;
+
+    guac_common_stat_cache* cache = guac_common_stat_cache_alloc(60000);
+    guac_common_stat_cache_put(cache, "/", &info);
+    guac_common_stat_cache_put(cache, "/a", &info);
+    guac_common_stat_cache_put(cache, "/a/b", &info);
+    guac_common_stat_cache_put(cache, "/a/c", &info);
+
+    guac_common_stat_cache_invalidate(cache, "/a/b");
+    CU_ASSERT_FALSE(guac_common_stat_cache_get(cache, "/a/b", &found));
+    CU_ASSERT_FALSE(guac_common_stat_cache_get(cache, "/a", &found));
+    CU_ASSERT_TRUE(guac_common_stat_cache_get(cache, "/a/c", &found));
+    CU_ASSERT_TRUE(guac_common_stat_cache_get(cache, "/", &found));
+
+    /* The parent of a top-level file is the root directory */
+    guac_common_stat_cache_invalidate(cache, "/a");
+    CU_ASSERT_FALSE(guac_common_stat_cache_get(cache, "/", &found));
+
+    guac_common_stat_cache_free(cache);
+
+}
+
+/**
+ * Test which verifies that entries are no longer returned once they have
+ * expired.
+ */
+void test_stat_cache__expire() {
+
+    guac_common_stat_cache_info info = { .size = 1 };
+    guac_common_stat_cache_info found;
+
+    guac_common_stat_cache* cache = guac_common_stat_cache_alloc(0);
+    guac_common_stat_cache_put(cache, "/a", &info);
+    CU_ASSERT_FALSE(guac_common_stat_cache_get(cache, "/a", &found));
+
+    guac_common_stat_cache_free(cache);
+
+}
+
+/**
+ * Test which verifies that a NULL stat cache, as returned if a stat cache
+ * cannot be allocated, is accepted by all stat cache functions and never
+ * contains any entries.
+ */
+void test_stat_cache__null() {
+
+    guac_common_stat_cache_info info = { .size = 1 };
+    guac_common_stat_cache_info found;
+
+    guac_common_stat_cache_put(NULL, "/a", &info);
+    CU_ASSERT_FALSE(guac_common_stat_cache_get(NULL, "/a", &found));
+
+    guac_common_stat_cache_invalidate(NULL, "/a");
+    guac_common_stat_cache_watch(NULL, "/");
+    guac_common_stat_cache_free(NULL);
+
+}
+
@@ -31,6 +31,8 @@
 
 int guacenc_display_sync(guacenc_display* display, guac_timestamp timestamp) {
 
+    int i;
+
     /* Verify timestamp is not decreasing */
     if (timestamp < display->last_sync) {
         guacenc_log(GUAC_LOG_WARNING, "Decreasing sync timestamp");
@@ -48,12 +50,27 @@ int guacenc_display_sync(guacenc_display* display, guac_timestamp timestamp) {
     guacenc_layer* def_layer = guacenc_display_get_layer(display, 0);
     assert(def_layer != NULL);
 
-    /* Update video timeline */
-    if (guacenc_video_advance_timeline(display->output, timestamp))
-        return 1;
+    /* Update timeline of all videos */
+    for (i = 0; i < display->output_count; i++) {
+        if (guacenc_video_advance_timeline(display->outputs[i], timestamp))
+            return 1;
+    }
+
+    /* Reference flattened display once, regardless of number of videos */
+    AVFrame* source = guacenc_video_source_alloc(def_layer->frame);
+
+    /* Prepare frame for write upon next flush of each video */
+    for (i = 0; i < display->output_count; i++)
+        guacenc_video_prepare_frame(display->outputs[i], source);
+
+    guacenc_video_source_free(source);
+
+    /* Capture thumbnail, if enabled and due */
+    if (display->thumbnails != NULL
+            && guacenc_thumbnails_update(display->thumbnails,
+                def_layer->frame, timestamp))
+        guacenc_log(GUAC_LOG_WARNING, "Failed to capture thumbnail.");
 
-    /* Prepare frame for write upon next flush */
-    guacenc_video_prepare_frame(display->output, def_layer->frame);
     return 0;
 
 }
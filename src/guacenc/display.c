@@ -20,9 +20,12 @@
 #include "config.h"
 #include "cursor.h"
 #include "display.h"
+#include "log.h"
+#include "thumbnails.h"
 #include "video.h"
 
 #include <cairo/cairo.h>
+#include <guacamole/client.h>
 
 #include <stdlib.h>
 
@@ -83,20 +86,13 @@ cairo_operator_t guacenc_display_cairo_operator(guac_composite_mode mask) {
 
 }
 
-guacenc_display* guacenc_display_alloc(const char* path, const char* codec,
-        int width, int height, int bitrate) {
-
-    /* Prepare video encoding */
-    guacenc_video* video = guacenc_video_alloc(path, codec, width, height, bitrate);
-    if (video == NULL)
-        return NULL;
+guacenc_display* guacenc_display_alloc() {
 
     /* Allocate display */
     guacenc_display* display =
         (guacenc_display*) calloc(1, sizeof(guacenc_display));
-
-    /* Associate display with video output */
-    display->output = video;
+    if (display == NULL)
+        return NULL;
 
     /* Allocate special-purpose cursor layer */
     display->cursor = guacenc_cursor_alloc();
@@ -105,16 +101,61 @@ guacenc_display* guacenc_display_alloc(const char* path, const char* codec,
 
 }
 
+int guacenc_display_add_video(guacenc_display* display, const char* path,
+        const char* codec, int width, int height, int bitrate) {
+
+    /* Refuse to add more videos than can be stored */
+    if (display->output_count == GUACENC_DISPLAY_MAX_OUTPUTS) {
+        guacenc_log(GUAC_LOG_ERROR, "No more than %i videos may be encoded "
+                "at once.", GUACENC_DISPLAY_MAX_OUTPUTS);
+        return 1;
+    }
+
+    /* Prepare video encoding */
+    guacenc_video* video = guacenc_video_alloc(path, codec, width, height, bitrate);
+    if (video == NULL)
+        return 1;
+
+    /* Associate display with video output */
+    display->outputs[display->output_count++] = video;
+    return 0;
+
+}
+
+int guacenc_display_add_thumbnails(guacenc_display* display, const char* path,
+        int width, int height, int interval) {
+
+    /* Only one thumbnail strip is supported */
+    if (display->thumbnails != NULL)
+        return 1;
+
+    display->thumbnails = guacenc_thumbnails_alloc(path, width, height,
+            interval);
+
+    return display->thumbnails == NULL;
+
+}
+
 int guacenc_display_free(guacenc_display* display) {
 
     int i;
+    int retval = 0;
 
     /* Ignore NULL display */
     if (display == NULL)
         return 0;
 
-    /* Finalize video */
-    int retval = guacenc_video_free(display->output);
+    /* Finalize all videos */
+    for (i = 0; i < display->output_count; i++) {
+        if (guacenc_video_free(display->outputs[i]))
+            retval = 1;
+    }
+
+    /* Write thumbnails, without failing the encoding of any videos if the
+     * thumbnails alone cannot be written */
+    if (guacenc_thumbnails_free(display->thumbnails))
+        guacenc_log(GUAC_LOG_WARNING, "Thumbnails could not be written. "
+                "Any videos have still been encoded.");
 
     /* Free all buffers */
     for (i = 0; i < GUACENC_DISPLAY_MAX_BUFFERS; i++)
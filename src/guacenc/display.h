@@ -25,6 +25,7 @@
 #include "cursor.h"
 #include "image-stream.h"
 #include "layer.h"
+#include "thumbnails.h"
 #include "video.h"
 
 #include <cairo/cairo.h>
@@ -49,6 +50,12 @@
  */
 #define GUACENC_DISPLAY_MAX_STREAMS 64
 
+/**
+ * The maximum number of videos which may be encoded simultaneously from a
+ * single display.
+ */
+#define GUACENC_DISPLAY_MAX_OUTPUTS 8
+
 /**
  * The current state of the Guacamole video encoder's internal display.
  */
@@ -90,9 +97,22 @@ typedef struct guacenc_display {
     guac_timestamp last_sync;
 
     /**
-     * The video that this display is recording to.
+     * All videos that this display is recording to. Each video is encoded
+     * from the same flattened display, with only scaling and encoding
+     * performed separately for each video.
+     */
+    guacenc_video* outputs[GUACENC_DISPLAY_MAX_OUTPUTS];
+
+    /**
+     * The number of videos within the outputs array.
+     */
+    int output_count;
+
+    /**
+     * The thumbnail strip being generated from this display, or NULL if no
+     * thumbnails are being generated.
      */
-    guacenc_video* output;
+    guacenc_thumbnails* thumbnails;
 
 } guacenc_display;
 
@@ -131,7 +151,23 @@ int guacenc_display_flatten(guacenc_display* display);
 /**
  * Allocates a new Guacamole video encoder display. This display serves as the
  * representation of encoding state, as well as the state of the Guacamole
- * display as instructions are read and handled.
+ * display as instructions are read and handled. The display will not produce
+ * any output until at least one video is added with
+ * guacenc_display_add_video().
+ *
+ * @return
+ *     The newly-allocated Guacamole video encoder display, or NULL if the
+ *     display could not be allocated.
+ */
+guacenc_display* guacenc_display_alloc();
+
+/**
+ * Adds a new video to the given display. Each frame of the display will be
+ * encoded within every video added, with the display being flattened only
+ * once per frame regardless of the number of videos.
+ *
+ * @param display
+ *     The display to add the video to.
  *
  * @param path
  *     The full path to the file in which encoded video should be written.
@@ -151,11 +187,41 @@ int guacenc_display_flatten(guacenc_display* display);
  *     second.
  *
  * @return
- *     The newly-allocated Guacamole video encoder display, or NULL if the
- *     display could not be allocated.
+ *     Zero if the video was added successfully, non-zero if the video could
+ *     not be allocated or GUACENC_DISPLAY_MAX_OUTPUTS videos have already been
+ *     added.
+ */
+int guacenc_display_add_video(guacenc_display* display, const char* path,
+        const char* codec, int width, int height, int bitrate);
+
+/**
+ * Enables generation of a strip of thumbnails for the given display. A
+ * thumbnail of the display will be captured at the given interval, and all
+ * thumbnails will be written as a single PNG image when the display is freed.
+ *
+ * @param display
+ *     The display to generate thumbnails from.
+ *
+ * @param path
+ *     The full path to the file in which the thumbnail strip should be
+ *     written.
+ *
+ * @param width
+ *     The width of each thumbnail, in pixels.
+ *
+ * @param height
+ *     The height of each thumbnail, in pixels.
+ *
+ * @param interval
+ *     The number of milliseconds between the points in time captured by each
+ *     thumbnail.
+ *
+ * @return
+ *     Zero if thumbnail generation was enabled successfully, non-zero
+ *     otherwise.
  */
-guacenc_display* guacenc_display_alloc(const char* path, const char* codec,
-        int width, int height, int bitrate);
+int guacenc_display_add_thumbnails(guacenc_display* display, const char* path,
+        int width, int height, int interval);
 
 /**
  * Frees all memory associated with the given Guacamole video encoder display,
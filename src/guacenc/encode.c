@@ -18,7 +18,10 @@
  */
 
 #include "config.h"
+#include "common/parser.h"
 #include "display.h"
+#include "encode.h"
+#include "guacenc.h"
 #include "instructions.h"
 #include "log.h"
 
@@ -27,11 +30,11 @@
 #include <guacamole/parser.h>
 #include <guacamole/socket.h>
 
-#include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -84,8 +87,135 @@ static int guacenc_read_instructions(guacenc_display* display,
 
 }
 
-int guacenc_encode(const char* path, const char* out_path, const char* codec,
-        int width, int height, int bitrate, bool force) {
+/**
+ * Handles a single instruction parsed from a memory-mapped file by
+ * guac_common_parser_read_mapped().
+ *
+ * @param parser
+ *     The guac_parser which parsed the instruction.
+ *
+ * @param data
+ *     The current internal display of the Guacamole video encoder.
+ */
+static void guacenc_handle_mapped_instruction(guac_parser* parser, void* data) {
+
+    guacenc_display* display = (guacenc_display*) data;
+
+    if (guacenc_handle_instruction(display, parser->opcode,
+            parser->argc, parser->argv)) {
+        guacenc_log(GUAC_LOG_DEBUG, "Handling of \"%s\" instruction "
+                "failed.", parser->opcode);
+    }
+
+}
+
+/**
+ * Generates the name of an output file by appending the given suffix to the
+ * name of the input file.
+ *
+ * @param out_path
+ *     The buffer in which the name of the output file should be stored.
+ *
+ * @param length
+ *     The size of the out_path buffer, in bytes.
+ *
+ * @param path
+ *     The path of the input file.
+ *
+ * @param suffix
+ *     The suffix to append.
+ *
+ * @return
+ *     Zero if the name of the output file was generated successfully,
+ *     non-zero if the name would not fit within the given buffer.
+ */
+static int guacenc_output_path(char* out_path, int length, const char* path,
+        const char* suffix) {
+
+    /* Do not write if filename exceeds maximum length */
+    if (snprintf(out_path, length, "%s%s", path, suffix) >= length) {
+        guacenc_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
+                "Name too long", path);
+        return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Allocates a new display which encodes all of the given videos, along with a
+ * strip of thumbnails if requested.
+ *
+ * @param path
+ *     The path of the input file.
+ *
+ * @param outputs
+ *     An array of the parameters of each video to encode.
+ *
+ * @param output_count
+ *     The number of videos within the outputs array.
+ *
+ * @param thumbnail_interval
+ *     The number of milliseconds between each thumbnail, or zero if no
+ *     thumbnails should be written.
+ *
+ * @return
+ *     A newly-allocated display, or NULL if the display or any of its outputs
+ *     could not be allocated.
+ */
+static guacenc_display* guacenc_encode_display_alloc(const char* path,
+        const guacenc_output* outputs, int output_count,
+        int thumbnail_interval) {
+
+    char out_path[4096];
+    int i;
+
+    guacenc_display* display = guacenc_display_alloc();
+    if (display == NULL)
+        return NULL;
+
+    /* Add each requested video */
+    for (i = 0; i < output_count; i++) {
+
+        const guacenc_output* output = &outputs[i];
+
+        if (guacenc_output_path(out_path, sizeof(out_path), path,
+                    output->suffix)
+                || guacenc_display_add_video(display, out_path, output->codec,
+                    output->width, output->height, output->bitrate)) {
+            guacenc_display_free(display);
+            return NULL;
+        }
+
+        guacenc_log(GUAC_LOG_INFO, "Encoding \"%s\" to \"%s\" ...", path,
+                out_path);
+
+    }
+
+    /* Add thumbnail strip, if requested */
+    if (thumbnail_interval > 0) {
+
+        if (guacenc_output_path(out_path, sizeof(out_path), path,
+                    GUACENC_THUMBNAILS_SUFFIX)
+                || guacenc_display_add_thumbnails(display, out_path,
+                    GUACENC_THUMBNAIL_WIDTH, GUACENC_THUMBNAIL_HEIGHT,
+                    thumbnail_interval)) {
+            guacenc_display_free(display);
+            return NULL;
+        }
+
+        guacenc_log(GUAC_LOG_INFO, "Writing thumbnails of \"%s\" to "
+                "\"%s\" ...", path, out_path);
+
+    }
+
+    return display;
+
+}
+
+int guacenc_encode(const char* path, const guacenc_output* outputs,
+        int output_count, int thumbnail_interval, bool force) {
 
     /* Open input file */
     int fd = open(path, O_RDONLY);
@@ -122,14 +252,28 @@ int guacenc_encode(const char* path, const char* out_path, const char* codec,
     }
 
     /* Allocate display for encoding process */
-    guacenc_display* display = guacenc_display_alloc(out_path, codec,
-            width, height, bitrate);
+    guacenc_display* display = guacenc_encode_display_alloc(path, outputs,
+            output_count, thumbnail_interval);
     if (display == NULL) {
         close(fd);
         return 1;
     }
 
-    /* Obtain guac_socket wrapping file descriptor */
+    /* Parse directly from a memory mapping of the file, if possible */
+    int result = guac_common_parser_read_mapped(fd,
+            guacenc_handle_mapped_instruction, display);
+    if (result != -1) {
+        close(fd);
+        if (result) {
+            guacenc_log(GUAC_LOG_ERROR, "%s: %s",
+                    path, guac_status_string(guac_error));
+            guacenc_display_free(display);
+            return 1;
+        }
+        return guacenc_display_free(display);
+    }
+
+    /* Otherwise, obtain guac_socket wrapping file descriptor */
     guac_socket* socket = guac_socket_open(fd);
     if (socket == NULL) {
         guacenc_log(GUAC_LOG_ERROR, "%s: %s", path,
@@ -139,8 +283,6 @@ int guacenc_encode(const char* path, const char* out_path, const char* codec,
         return 1;
     }
 
-    guacenc_log(GUAC_LOG_INFO, "Encoding \"%s\" to \"%s\" ...", path, out_path);
-
     /* Attempt to read all instructions in the file */
     if (guacenc_read_instructions(display, path, socket)) {
         guac_socket_free(socket);
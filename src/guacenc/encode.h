@@ -25,7 +25,44 @@
 #include <stdbool.h>
 
 /**
- * Encodes the given Guacamole protocol dump as video. A read lock will be
+ * The parameters of a single video to be encoded from a recording.
+ */
+typedef struct guacenc_output {
+
+    /**
+     * The suffix which is appended to the name of the input file to produce
+     * the name of the file in which this video should be written.
+     */
+    const char* suffix;
+
+    /**
+     * The name of the codec to use for the video encoding, as defined by
+     * ffmpeg / libavcodec.
+     */
+    const char* codec;
+
+    /**
+     * The width of the desired video, in pixels.
+     */
+    int width;
+
+    /**
+     * The height of the desired video, in pixels.
+     */
+    int height;
+
+    /**
+     * The desired overall bitrate of the resulting encoded video, in bits per
+     * second.
+     */
+    int bitrate;
+
+} guacenc_output;
+
+/**
+ * Encodes the given Guacamole protocol dump as one or more videos. The
+ * recording is read and rendered only once, with each rendered frame being
+ * scaled and encoded separately for each requested video. A read lock will be
  * acquired on the input file to ensure that in-progress recordings are not
  * encoded. This behavior can be overridden by specifying true for the force
  * parameter.
@@ -33,22 +70,17 @@
  * @param path
  *     The path to the file containing the raw Guacamole protocol dump.
  *
- * @param out_path
- *     The full path to the file in which encoded video should be written.
- *
- * @param codec
- *     The name of the codec to use for the video encoding, as defined by
- *     ffmpeg / libavcodec.
- *
- * @param width
- *     The width of the desired video, in pixels.
+ * @param outputs
+ *     An array of the parameters of each video to encode.
  *
- * @param height
- *     The height of the desired video, in pixels.
+ * @param output_count
+ *     The number of videos within the outputs array. This value must be
+ *     between 1 and GUACENC_DISPLAY_MAX_OUTPUTS inclusive.
  *
- * @param bitrate
- *     The desired overall bitrate of the resulting encoded video, in bits per
- *     second.
+ * @param thumbnail_interval
+ *     The number of milliseconds between each thumbnail within a strip of
+ *     thumbnails written alongside the encoded videos, or zero if no
+ *     thumbnails should be written.
  *
  * @param force
  *     Perform the encoding, even if the input file appears to be an
@@ -58,8 +90,8 @@
  *     Zero on success, non-zero if an error prevented successful encoding of
  *     the video.
  */
-int guacenc_encode(const char* path, const char* out_path, const char* codec,
-        int width, int height, int bitrate, bool force);
+int guacenc_encode(const char* path, const guacenc_output* outputs,
+        int output_count, int thumbnail_interval, bool force);
 
 #endif
 
@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include "common/batch.h"
+#include "display.h"
 #include "encode.h"
 #include "guacenc.h"
 #include "log.h"
@@ -27,27 +29,205 @@
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 
+#include <errno.h>
 #include <getopt.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+
+/**
+ * All long options accepted by guacenc, in the format required by
+ * getopt_long().
+ */
+static const struct option guacenc_long_options[] = {
+    { "watch", required_argument, NULL, 'w' },
+    { NULL,    0,                 NULL, 0   }
+};
+
+/**
+ * The suffixes of all files which may be written by guacenc, in the format
+ * required by guac_common_batch_watch().
+ */
+static const char* const guacenc_output_suffixes[] = {
+    GUACENC_OUTPUT_SUFFIX,
+    GUACENC_CODEC_OUTPUT_SUFFIX,
+    GUACENC_THUMBNAILS_SUFFIX,
+    NULL
+};
+
+/**
+ * The encoding options which apply to all input files.
+ */
+typedef struct guacenc_options {
+
+    /**
+     * The parameters of all videos to encode from each input file. The first
+     * video is the primary output video, written to a file having the
+     * GUACENC_OUTPUT_SUFFIX suffix.
+     */
+    guacenc_output outputs[GUACENC_DISPLAY_MAX_OUTPUTS];
+
+    /**
+     * Storage for the suffixes of all additional output videos, with each
+     * suffix corresponding to the video at the same index within outputs.
+     */
+    char suffixes[GUACENC_DISPLAY_MAX_OUTPUTS][GUACENC_MAX_SUFFIX_LENGTH];
+
+    /**
+     * The number of videos within the outputs array.
+     */
+    int output_count;
+
+    /**
+     * The number of milliseconds between each thumbnail within the thumbnail
+     * strip written for each input file, or zero if no thumbnails should be
+     * written.
+     */
+    int thumbnail_interval;
+
+    /**
+     * Whether input files should be encoded even if they appear to be
+     * in-progress recordings.
+     */
+    bool force;
+
+} guacenc_options;
+
+/**
+ * Parses the given description of an additional output video, adding that
+ * video to the given options. The description must be of the form
+ * "WIDTHxHEIGHT[:BITRATE[:CODEC]]". If omitted, the bitrate defaults to
+ * GUACENC_DEFAULT_BITRATE, and the codec defaults to GUACENC_DEFAULT_CODEC.
+ *
+ * @param arg
+ *     The description to parse. This string will be modified.
+ *
+ * @param options
+ *     The options to add the output video to.
+ *
+ * @return
+ *     Zero if the description was valid and the video was added, non-zero
+ *     otherwise.
+ */
+static int guacenc_parse_output(char* arg, guacenc_options* options) {
+
+    /* Refuse to add more videos than a display can encode */
+    if (options->output_count == GUACENC_DISPLAY_MAX_OUTPUTS)
+        return 1;
+
+    guacenc_output* output = &options->outputs[options->output_count];
+    char* suffix = options->suffixes[options->output_count];
+
+    output->bitrate = GUACENC_DEFAULT_BITRATE;
+    output->codec = GUACENC_DEFAULT_CODEC;
+
+    /* Split off codec, if given */
+    char* codec = NULL;
+    char* bitrate = strchr(arg, ':');
+    if (bitrate != NULL) {
+
+        *(bitrate++) = '\0';
+
+        codec = strchr(bitrate, ':');
+        if (codec != NULL) {
+            *(codec++) = '\0';
+            if (*codec == '\0' || strchr(codec, '/') != NULL)
+                return 1;
+            output->codec = codec;
+        }
+
+        if (guacenc_parse_int(bitrate, &output->bitrate))
+            return 1;
+
+    }
+
+    if (guacenc_parse_dimensions(arg, &output->width, &output->height))
+        return 1;
+
+    /* Name each video after its dimensions and (if not default) codec */
+    int length;
+    if (codec != NULL)
+        length = snprintf(suffix, GUACENC_MAX_SUFFIX_LENGTH,
+                ".%ix%i.%s" GUACENC_CODEC_OUTPUT_SUFFIX,
+                output->width, output->height, codec);
+    else
+        length = snprintf(suffix, GUACENC_MAX_SUFFIX_LENGTH,
+                ".%ix%i" GUACENC_OUTPUT_SUFFIX,
+                output->width, output->height);
+
+    if (length >= GUACENC_MAX_SUFFIX_LENGTH)
+        return 1;
+
+    output->suffix = suffix;
+    options->output_count++;
+    return 0;
+
+}
+
+/**
+ * Encodes the given input file, writing the result to a new file having the
+ * same name with an additional ".m4v" suffix, as well as to any additional
+ * output videos and thumbnail strip requested. This function is invoked by
+ * each worker thread of the guac_common_batch processing all input files.
+ *
+ * @param path
+ *     The path of the input file to encode.
+ *
+ * @param data
+ *     A pointer to the guacenc_options which apply to all input files.
+ *
+ * @return
+ *     Zero if encoding succeeded, non-zero otherwise.
+ */
+static int guacenc_process_file(const char* path, void* data) {
+
+    guacenc_options* options = (guacenc_options*) data;
+
+    /* Attempt encoding, log granular success/failure at debug level */
+    if (guacenc_encode(path, options->outputs, options->output_count,
+                options->thumbnail_interval, options->force)) {
+        guacenc_log(GUAC_LOG_DEBUG, "%s was NOT successfully encoded.", path);
+        return 1;
+    }
+
+    guacenc_log(GUAC_LOG_DEBUG, "%s was successfully encoded.", path);
+    return 0;
+
+}
 
 int main(int argc, char* argv[]) {
 
     int i;
 
     /* Load defaults */
-    bool force = false;
-    int width = GUACENC_DEFAULT_WIDTH;
-    int height = GUACENC_DEFAULT_HEIGHT;
-    int bitrate = GUACENC_DEFAULT_BITRATE;
+    guacenc_options options = {
+        .outputs = {{
+            .suffix  = GUACENC_OUTPUT_SUFFIX,
+            .codec   = GUACENC_DEFAULT_CODEC,
+            .width   = GUACENC_DEFAULT_WIDTH,
+            .height  = GUACENC_DEFAULT_HEIGHT,
+            .bitrate = GUACENC_DEFAULT_BITRATE
+        }},
+        .output_count       = 1,
+        .thumbnail_interval = 0,
+        .force              = false
+    };
+
+    guacenc_output* primary = &options.outputs[0];
+
+    int jobs = GUACENC_DEFAULT_JOBS;
+    const char* watch_path = NULL;
 
     /* Parse arguments */
     int opt;
-    while ((opt = getopt(argc, argv, "s:r:f")) != -1) {
+    while ((opt = getopt_long(argc, argv, "s:r:o:t:j:w:f",
+                    guacenc_long_options, NULL)) != -1) {
 
         /* -s: Dimensions (WIDTHxHEIGHT) */
         if (opt == 's') {
-            if (guacenc_parse_dimensions(optarg, &width, &height)) {
+            if (guacenc_parse_dimensions(optarg, &primary->width,
+                        &primary->height)) {
                 guacenc_log(GUAC_LOG_ERROR, "Invalid dimensions.");
                 goto invalid_options;
             }
@@ -55,15 +235,46 @@ int main(int argc, char* argv[]) {
 
         /* -r: Bitrate (bits per second) */
         else if (opt == 'r') {
-            if (guacenc_parse_int(optarg, &bitrate)) {
+            if (guacenc_parse_int(optarg, &primary->bitrate)) {
                 guacenc_log(GUAC_LOG_ERROR, "Invalid bitrate.");
                 goto invalid_options;
             }
         }
 
+        /* -o: Additional output video (WIDTHxHEIGHT[:BITRATE[:CODEC]]) */
+        else if (opt == 'o') {
+            if (guacenc_parse_output(optarg, &options)) {
+                guacenc_log(GUAC_LOG_ERROR, "Invalid output video.");
+                goto invalid_options;
+            }
+        }
+
+        /* -t: Thumbnail interval (seconds) */
+        else if (opt == 't') {
+            int interval;
+            if (guacenc_parse_int(optarg, &interval)
+                    || interval > INT_MAX / 1000) {
+                guacenc_log(GUAC_LOG_ERROR, "Invalid thumbnail interval.");
+                goto invalid_options;
+            }
+            options.thumbnail_interval = interval * 1000;
+        }
+
+        /* -j: Number of files to encode concurrently */
+        else if (opt == 'j') {
+            if (guac_common_batch_parse_workers(optarg, &jobs)) {
+                guacenc_log(GUAC_LOG_ERROR, "Invalid number of jobs.");
+                goto invalid_options;
+            }
+        }
+
+        /* -w, --watch: Directory to watch for completed recordings */
+        else if (opt == 'w')
+            watch_path = optarg;
+
         /* -f: Force */
         else if (opt == 'f')
-            force = true;
+            options.force = true;
 
         /* Invalid option */
         else {
@@ -90,45 +301,63 @@ int main(int argc, char* argv[]) {
     int failures = 0;
 
     /* Abort if no files given */
-    if (total_files <= 0) {
+    if (total_files <= 0 && watch_path == NULL) {
         guacenc_log(GUAC_LOG_INFO, "No input files specified. Nothing to do.");
         return 0;
     }
 
     guacenc_log(GUAC_LOG_INFO, "%i input file(s) provided.", total_files);
 
-    guacenc_log(GUAC_LOG_INFO, "Video will be encoded at %ix%i "
-            "and %i bps.", width, height, bitrate);
-
-    /* Encode all input files */
-    for (i = optind; i < argc; i++) {
-
-        /* Get current filename */
-        const char* path = argv[i];
+    for (i = 0; i < options.output_count; i++) {
+        guacenc_output* output = &options.outputs[i];
+        guacenc_log(GUAC_LOG_INFO, "Video will be encoded at %ix%i "
+                "and %i bps using \"%s\" (%s).", output->width,
+                output->height, output->bitrate, output->codec,
+                output->suffix);
+    }
 
-        /* Generate output filename */
-        char out_path[4096];
-        int len = snprintf(out_path, sizeof(out_path), "%s.m4v", path);
+    if (options.thumbnail_interval > 0)
+        guacenc_log(GUAC_LOG_INFO, "Thumbnails will be captured every "
+                "%i second(s).", options.thumbnail_interval / 1000);
 
-        /* Do not write if filename exceeds maximum length */
-        if (len >= sizeof(out_path)) {
-            guacenc_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
-                    "Name too long", path);
-            continue;
-        }
+    /* Queue all input files, failing any which do not exist */
+    guac_common_batch* batch = guac_common_batch_alloc(guacenc_process_file, &options);
+    if (batch == NULL) {
+        guacenc_log(GUAC_LOG_ERROR, "Unable to allocate batch.");
+        return 1;
+    }
 
-        /* Attempt encoding, log granular success/failure at debug level */
-        if (guacenc_encode(path, out_path, "mpeg4",
-                    width, height, bitrate, force)) {
+    for (i = optind; i < argc; i++) {
+        if (guac_common_batch_add(batch, argv[i])) {
+            guacenc_log(GUAC_LOG_ERROR, "%s: %s", argv[i], strerror(errno));
             failures++;
-            guacenc_log(GUAC_LOG_DEBUG,
-                    "%s was NOT successfully encoded.", path);
         }
-        else
-            guacenc_log(GUAC_LOG_DEBUG, "%s was successfully encoded.", path);
+    }
+
+    /* Start workers which will encode all queued files */
+    if (guac_common_batch_start(batch, jobs)) {
+        guacenc_log(GUAC_LOG_ERROR, "Unable to start %i worker(s).", jobs);
+        guac_common_batch_free(batch);
+        return 1;
+    }
+
+    guacenc_log(GUAC_LOG_DEBUG, "Encoding using %i worker(s).", jobs);
 
+    /* Continue encoding recordings as they are completed, if requested */
+    if (watch_path != NULL) {
+        guacenc_log(GUAC_LOG_INFO, "Watching \"%s\" for completed "
+                "recordings ...", watch_path);
+        guac_common_batch_watch(batch, watch_path, guacenc_output_suffixes);
+        guacenc_log(GUAC_LOG_ERROR, "Cannot watch \"%s\": %s", watch_path,
+                strerror(errno));
     }
 
+    /* Wait for all queued files to be encoded */
+    guac_common_batch_wait(batch);
+    total_files = failures + batch->total;
+    failures += batch->failures;
+    guac_common_batch_free(batch);
+
     /* Warn if at least one file failed */
     if (failures != 0)
         guacenc_log(GUAC_LOG_WARNING, "Encoding failed for %i of %i file(s).",
@@ -147,10 +376,13 @@ invalid_options:
     fprintf(stderr, "USAGE: %s"
             " [-s WIDTHxHEIGHT]"
             " [-r BITRATE]"
+            " [-o WIDTHxHEIGHT[:BITRATE[:CODEC]]]..."
+            " [-t SECONDS]"
+            " [-j JOBS]"
+            " [-w DIRECTORY]"
             " [-f]"
             " [FILE]...\n", argv[0]);
 
     return 1;
 
 }
-
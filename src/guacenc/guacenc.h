@@ -49,5 +49,54 @@
  */
 #define GUACENC_DEFAULT_LOG_LEVEL GUAC_LOG_INFO
 
+/**
+ * The number of input files which should be encoded concurrently, if no other
+ * number of jobs is given on the command line.
+ */
+#define GUACENC_DEFAULT_JOBS 1
+
+/**
+ * The suffix which is appended to the name of each input file to produce the
+ * name of the corresponding output video file.
+ */
+#define GUACENC_OUTPUT_SUFFIX ".m4v"
+
+/**
+ * The codec used to encode videos for which no other codec is given on the
+ * command line, as defined by ffmpeg / libavcodec.
+ */
+#define GUACENC_DEFAULT_CODEC "mpeg4"
+
+/**
+ * The suffix of the names of additional output video files which are encoded
+ * with a codec other than GUACENC_DEFAULT_CODEC. As the container used for
+ * GUACENC_OUTPUT_SUFFIX supports only that codec, such videos are written
+ * within a container which supports any codec.
+ */
+#define GUACENC_CODEC_OUTPUT_SUFFIX ".mkv"
+
+/**
+ * The maximum length of the suffix appended to the name of each input file to
+ * produce the name of any additional output video file, in bytes, including
+ * NULL terminator.
+ */
+#define GUACENC_MAX_SUFFIX_LENGTH 64
+
+/**
+ * The suffix which is appended to the name of each input file to produce the
+ * name of the corresponding thumbnail strip, if thumbnails are requested.
+ */
+#define GUACENC_THUMBNAILS_SUFFIX ".thumbs.png"
+
+/**
+ * The width of each thumbnail within a thumbnail strip, in pixels.
+ */
+#define GUACENC_THUMBNAIL_WIDTH 160
+
+/**
+ * The height of each thumbnail within a thumbnail strip, in pixels.
+ */
+#define GUACENC_THUMBNAIL_HEIGHT 120
+
 #endif
 
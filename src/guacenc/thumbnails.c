@@ -0,0 +1,240 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "buffer.h"
+#include "log.h"
+#include "thumbnails.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/timestamp.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+guacenc_thumbnails* guacenc_thumbnails_alloc(const char* path,
+        int width, int height, int interval) {
+
+    /* Open output file, refusing to overwrite existing files */
+    int fd = open(path, O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        guacenc_log(GUAC_LOG_ERROR, "Failed to open thumbnail file "
+                "\"%s\": %s", path, strerror(errno));
+        return NULL;
+    }
+
+    FILE* output = fdopen(fd, "wb");
+    if (output == NULL) {
+        guacenc_log(GUAC_LOG_ERROR, "Failed to allocate stream for "
+                "thumbnail file \"%s\": %s", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    guacenc_thumbnails* thumbnails = calloc(1, sizeof(guacenc_thumbnails));
+    if (thumbnails == NULL) {
+        fclose(output);
+        return NULL;
+    }
+
+    thumbnails->output = output;
+    thumbnails->path = strdup(path);
+    thumbnails->width = width;
+    thumbnails->height = height;
+    thumbnails->interval = interval;
+
+    /* Wrap thumbnails into as many rows as necessary to remain within the
+     * maximum image size */
+    thumbnails->columns = GUACENC_THUMBNAILS_MAX_DIMENSION / width;
+    thumbnails->max_count = thumbnails->columns
+        * (GUACENC_THUMBNAILS_MAX_DIMENSION / height);
+
+    if (thumbnails->max_count > GUACENC_THUMBNAILS_MAX_COUNT)
+        thumbnails->max_count = GUACENC_THUMBNAILS_MAX_COUNT;
+
+    /* Never allocate space for more columns than can ever be used */
+    if (thumbnails->columns > thumbnails->max_count)
+        thumbnails->columns = thumbnails->max_count;
+
+    thumbnails->stride = cairo_format_stride_for_width(CAIRO_FORMAT_RGB24,
+            width * thumbnails->columns);
+
+    return thumbnails;
+
+}
+
+int guacenc_thumbnails_update(guacenc_thumbnails* thumbnails,
+        guacenc_buffer* buffer, guac_timestamp timestamp) {
+
+    /* Ignore buffers with no image data */
+    if (buffer == NULL || buffer->surface == NULL)
+        return 0;
+
+    /* Capture thumbnails only at the requested interval */
+    if (thumbnails->next_timestamp != 0
+            && timestamp < thumbnails->next_timestamp)
+        return 0;
+
+    thumbnails->next_timestamp = timestamp + thumbnails->interval;
+
+    /* Stop capturing once the image is full */
+    if (thumbnails->count == thumbnails->max_count)
+        return 0;
+
+    /* Add another row of (black) space to the image if all rows are full */
+    size_t row_size = (size_t) thumbnails->stride * thumbnails->height;
+    if (thumbnails->count == thumbnails->rows * thumbnails->columns) {
+
+        unsigned char* image = realloc(thumbnails->image,
+                row_size * (thumbnails->rows + 1));
+
+        if (image == NULL)
+            return 1;
+
+        memset(image + row_size * thumbnails->rows, 0, row_size);
+        thumbnails->image = image;
+        thumbnails->rows++;
+
+    }
+
+    /* Draw thumbnail directly into its place within the image */
+    int row = thumbnails->count / thumbnails->columns;
+    int column = thumbnails->count % thumbnails->columns;
+
+    cairo_surface_t* surface = cairo_image_surface_create_for_data(
+            thumbnails->image + row_size * row + column * thumbnails->width * 4,
+            CAIRO_FORMAT_RGB24, thumbnails->width, thumbnails->height,
+            thumbnails->stride);
+
+    /* Scale buffer to fit thumbnail, preserving aspect ratio */
+    double scale_x = (double) thumbnails->width / buffer->width;
+    double scale_y = (double) thumbnails->height / buffer->height;
+    double scale = scale_x < scale_y ? scale_x : scale_y;
+
+    cairo_t* cairo = cairo_create(surface);
+
+    /* Fill any remaining space with black */
+    cairo_set_source_rgb(cairo, 0, 0, 0);
+    cairo_paint(cairo);
+
+    /* Draw scaled buffer centered within thumbnail */
+    cairo_translate(cairo,
+            (thumbnails->width - buffer->width * scale) / 2,
+            (thumbnails->height - buffer->height * scale) / 2);
+    cairo_scale(cairo, scale, scale);
+    cairo_set_source_surface(cairo, buffer->surface, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cairo), CAIRO_FILTER_GOOD);
+    cairo_paint(cairo);
+
+    cairo_destroy(cairo);
+    cairo_surface_destroy(surface);
+
+    thumbnails->count++;
+
+    if (thumbnails->count == thumbnails->max_count)
+        guacenc_log(GUAC_LOG_WARNING, "Maximum of %i thumbnails reached. No "
+                "further thumbnails will be captured.", thumbnails->max_count);
+
+    return 0;
+
+}
+
+/**
+ * Writes the given data to the output stream of a thumbnail strip. The
+ * behavior of this function is dictated by cairo_write_func_t.
+ *
+ * @param closure
+ *     The FILE to which the data should be written.
+ *
+ * @param data
+ *     The data to write.
+ *
+ * @param length
+ *     The number of bytes to write.
+ *
+ * @return
+ *     CAIRO_STATUS_SUCCESS if all data was written successfully,
+ *     CAIRO_STATUS_WRITE_ERROR otherwise.
+ */
+static cairo_status_t guacenc_thumbnails_write(void* closure,
+        const unsigned char* data, unsigned int length) {
+
+    FILE* output = (FILE*) closure;
+
+    if (fwrite(data, 1, length, output) != length)
+        return CAIRO_STATUS_WRITE_ERROR;
+
+    return CAIRO_STATUS_SUCCESS;
+
+}
+
+int guacenc_thumbnails_free(guacenc_thumbnails* thumbnails) {
+
+    int retval = 0;
+
+    /* Ignore NULL thumbnails */
+    if (thumbnails == NULL)
+        return 0;
+
+    /* Write all thumbnails side by side, omitting any unused columns if
+     * all thumbnails fit within a single row */
+    if (thumbnails->count > 0) {
+
+        int columns = thumbnails->columns;
+        if (columns > thumbnails->count)
+            columns = thumbnails->count;
+
+        cairo_surface_t* strip = cairo_image_surface_create_for_data(
+                thumbnails->image, CAIRO_FORMAT_RGB24,
+                thumbnails->width * columns,
+                thumbnails->height * thumbnails->rows,
+                thumbnails->stride);
+
+        if (cairo_surface_write_to_png_stream(strip, guacenc_thumbnails_write,
+                    thumbnails->output) != CAIRO_STATUS_SUCCESS) {
+            guacenc_log(GUAC_LOG_ERROR, "Unable to write thumbnails.");
+            retval = 1;
+        }
+
+        cairo_surface_destroy(strip);
+
+    }
+
+    if (fclose(thumbnails->output))
+        retval = 1;
+
+    /* Do not leave behind an incomplete or empty image */
+    if ((retval || thumbnails->count == 0) && thumbnails->path != NULL)
+        unlink(thumbnails->path);
+
+    free(thumbnails->path);
+    free(thumbnails->image);
+    free(thumbnails);
+
+    return retval;
+
+}
+
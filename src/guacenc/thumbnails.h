@@ -0,0 +1,190 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACENC_THUMBNAILS_H
+#define GUACENC_THUMBNAILS_H
+
+#include "config.h"
+#include "buffer.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/timestamp.h>
+
+#include <stdio.h>
+
+/**
+ * The maximum width or height of the PNG image containing all thumbnails, in
+ * pixels. This is the largest image surface supported by Cairo.
+ */
+#define GUACENC_THUMBNAILS_MAX_DIMENSION 32767
+
+/**
+ * The maximum number of thumbnails captured within a single thumbnail strip.
+ * As the PNG image containing all thumbnails is built in memory, this bounds
+ * the memory required by long recordings (roughly 160 MB for 160x120
+ * thumbnails), with no further thumbnails captured once reached.
+ */
+#define GUACENC_THUMBNAILS_MAX_COUNT 2048
+
+/**
+ * A strip of thumbnails which is actively being generated. Each thumbnail is
+ * a downscaled copy of the display taken at regular intervals, drawn
+ * directly into its place within the image being built, and all thumbnails
+ * are written side by side as a single PNG image once the strip is freed. If
+ * the thumbnails would not fit within a single row, they are wrapped into a
+ * grid of rows read left to right, top to bottom.
+ */
+typedef struct guacenc_thumbnails {
+
+    /**
+     * Output stream to which the PNG image will be written once complete.
+     */
+    FILE* output;
+
+    /**
+     * The full path to the PNG file being written, such that an incomplete
+     * file can be removed if writing fails.
+     */
+    char* path;
+
+    /**
+     * The width of each thumbnail, in pixels.
+     */
+    int width;
+
+    /**
+     * The height of each thumbnail, in pixels.
+     */
+    int height;
+
+    /**
+     * The number of milliseconds between the points in time captured by each
+     * thumbnail.
+     */
+    int interval;
+
+    /**
+     * The timestamp at or after which the next thumbnail should be captured,
+     * or 0 if no thumbnail has yet been captured.
+     */
+    guac_timestamp next_timestamp;
+
+    /**
+     * The image data of all rows of thumbnails captured so far, in
+     * CAIRO_FORMAT_RGB24, with each row of pixels being stride bytes long.
+     * Space within the final row which has not yet received a thumbnail is
+     * black.
+     */
+    unsigned char* image;
+
+    /**
+     * The number of bytes within each row of pixels of the image.
+     */
+    int stride;
+
+    /**
+     * The number of rows of thumbnails for which space has been allocated
+     * within the image.
+     */
+    int rows;
+
+    /**
+     * The number of thumbnails captured so far.
+     */
+    int count;
+
+    /**
+     * The number of thumbnails within each row of the PNG image.
+     */
+    int columns;
+
+    /**
+     * The maximum number of thumbnails which fit within the PNG image. Once
+     * this many thumbnails have been captured, no further thumbnails are
+     * captured.
+     */
+    int max_count;
+
+} guacenc_thumbnails;
+
+/**
+ * Allocates a new thumbnail strip, creating the PNG file at the given path.
+ * If the file already exists, generation of thumbnails will be aborted, and
+ * the original file contents will be preserved.
+ *
+ * @param path
+ *     The full path to the file in which the thumbnail strip should be
+ *     written.
+ *
+ * @param width
+ *     The width of each thumbnail, in pixels.
+ *
+ * @param height
+ *     The height of each thumbnail, in pixels.
+ *
+ * @param interval
+ *     The number of milliseconds between the points in time captured by each
+ *     thumbnail.
+ *
+ * @return
+ *     A newly-allocated thumbnail strip, or NULL if the output file cannot be
+ *     created.
+ */
+guacenc_thumbnails* guacenc_thumbnails_alloc(const char* path,
+        int width, int height, int interval);
+
+/**
+ * Captures a new thumbnail of the given buffer if at least the configured
+ * interval has elapsed since the previous thumbnail was captured. The buffer
+ * is scaled to fit the thumbnail while preserving its aspect ratio.
+ *
+ * @param thumbnails
+ *     The thumbnail strip to update.
+ *
+ * @param buffer
+ *     The guacenc_buffer containing the flattened display.
+ *
+ * @param timestamp
+ *     The timestamp of the frame contained within the buffer, as dictated by
+ *     a parsed "sync" instruction.
+ *
+ * @return
+ *     Zero if the thumbnail strip was updated successfully or no update was
+ *     necessary, non-zero if an error occurs.
+ */
+int guacenc_thumbnails_update(guacenc_thumbnails* thumbnails,
+        guacenc_buffer* buffer, guac_timestamp timestamp);
+
+/**
+ * Writes all captured thumbnails to the output file as a single PNG image,
+ * freeing all resources associated with the given thumbnail strip. If the
+ * image cannot be written, or no thumbnails were captured, the output file is
+ * removed. If the given thumbnail strip is NULL, this function has no effect.
+ *
+ * @param thumbnails
+ *     The thumbnail strip to write and free, which may be NULL.
+ *
+ * @return
+ *     Zero if the thumbnail strip was written successfully, non-zero
+ *     otherwise.
+ */
+int guacenc_thumbnails_free(guacenc_thumbnails* thumbnails);
+
+#endif
+
@@ -36,7 +36,6 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
@@ -155,6 +154,11 @@ guacenc_video* guacenc_video_alloc(const char* path, const char* codec_name,
     video->last_timestamp = 0;
     video->next_pts = 0;
 
+    /* Scaling context is allocated when the first frame is prepared */
+    video->sws = NULL;
+    video->last_source_width = 0;
+    video->last_source_height = 0;
+
     return video;
 
     /* Free all allocated data in case of failure */
@@ -282,186 +286,126 @@ int guacenc_video_advance_timeline(guacenc_video* video,
 
 }
 
-/**
- * Converts the given Guacamole video encoder buffer to a frame in the format
- * required by libavcodec / libswscale. Black margins of the specified sizes
- * will be added. No scaling is performed; the image data is copied verbatim.
- *
- * @param buffer
- *     The guacenc_buffer to copy as a new AVFrame.
- *
- * @param lsize
- *     The size of the letterboxes to add, in pixels. Letterboxes are the
- *     horizontal black boxes added to images which are scaled down to fit the
- *     destination because they are too wide (the width is scaled to exactly
- *     fit the destination, resulting in extra space at the top and bottom).
- *
- * @param psize
- *     The size of the pillarboxes to add, in pixels. Pillarboxes are the
- *     vertical black boxes added to images which are scaled down to fit the
- *     destination because they are too tall (the height is scaled to exactly
- *     fit the destination, resulting in extra space on the sides).
- *
- * @return
- *     A pointer to a newly-allocated AVFrame containing exactly the same image
- *     data as the given buffer. The image data within the frame and the frame
- *     itself must be manually freed later.
- */
-static AVFrame* guacenc_video_frame_convert(guacenc_buffer* buffer, int lsize,
-        int psize) {
-
-    /* Init size of left/right pillarboxes */
-    int left = psize;
-    int right = psize;
+AVFrame* guacenc_video_source_alloc(guacenc_buffer* buffer) {
 
-    /* Init size of top/bottom letterboxes */
-    int top = lsize;
-    int bottom = lsize;
+    /* Ignore NULL buffers */
+    if (buffer == NULL || buffer->surface == NULL)
+        return NULL;
 
     /* Prepare source frame for buffer */
     AVFrame* frame = av_frame_alloc();
     if (frame == NULL)
         return NULL;
 
-    /* Copy buffer properties to frame */
-    frame->format = AV_PIX_FMT_RGB32;
-    frame->width = buffer->width + left + right;
-    frame->height = buffer->height + top + bottom;
-
-    /* Allocate actual backing data for frame */
-    if (av_image_alloc(frame->data, frame->linesize, frame->width,
-                frame->height, frame->format, 32) < 0) {
-        av_frame_free(&frame);
-        return NULL;
-    }
-
     /* Flush any pending operations */
     cairo_surface_flush(buffer->surface);
 
-    /* Get pointer to source image data */
-    unsigned char* src_data = buffer->image;
-    int src_stride = buffer->stride;
-
-    /* Get pointer to destination image data */
-    unsigned char* dst_data = frame->data[0];
-    int dst_stride = frame->linesize[0];
-
-    /* Get source/destination dimensions */
-    int width = buffer->width;
-    int height = buffer->height;
-
-    /* Source buffer is guaranteed to fit within destination buffer */
-    assert(width <= frame->width);
-    assert(height <= frame->height);
-
-    /* Add top margin */
-    while (top > 0) {
-        memset(dst_data, 0, frame->width * 4);
-        dst_data += dst_stride;
-        top--;
-    }
+    /* Point frame directly at the image data of the buffer (no copy) */
+    frame->format = AV_PIX_FMT_RGB32;
+    frame->width = buffer->width;
+    frame->height = buffer->height;
+    frame->data[0] = buffer->image;
+    frame->linesize[0] = buffer->stride;
 
-    /* Copy all data from source buffer to destination frame */
-    while (height > 0) {
+    return frame;
 
-        /* Calculate size of margin and data regions */
-        int left_size = left * 4;
-        int data_size = width * 4;
-        int right_size = right * 4;
+}
 
-        /* Add left margin */
-        memset(dst_data, 0, left_size);
+void guacenc_video_source_free(AVFrame* source) {
 
-        /* Copy data */
-        memcpy(dst_data + left_size, src_data, data_size);
+    /* Image data is owned by the source buffer, not the frame */
+    if (source != NULL)
+        av_frame_free(&source);
 
-        /* Add right margin */
-        memset(dst_data + left_size + data_size, 0, right_size);
+}
 
-        dst_data += dst_stride;
-        src_data += src_stride;
+/**
+ * Fills the given YUV420P frame entirely with black.
+ *
+ * @param frame
+ *     The frame to fill.
+ */
+static void guacenc_video_frame_clear(AVFrame* frame) {
 
-        height--;
+    int y;
 
-    }
+    /* Luma of black within the limited range produced by libswscale */
+    for (y = 0; y < frame->height; y++)
+        memset(frame->data[0] + y * frame->linesize[0], 16, frame->width);
 
-    /* Add bottom margin */
-    while (bottom > 0) {
-        memset(dst_data, 0, frame->width * 4);
-        dst_data += dst_stride;
-        bottom--;
+    /* Chroma of black (neutral) */
+    for (y = 0; y < (frame->height + 1) / 2; y++) {
+        memset(frame->data[1] + y * frame->linesize[1], 128,
+                (frame->width + 1) / 2);
+        memset(frame->data[2] + y * frame->linesize[2], 128,
+                (frame->width + 1) / 2);
     }
 
-    /* Frame converted */
-    return frame;
-
 }
 
-void guacenc_video_prepare_frame(guacenc_video* video, guacenc_buffer* buffer) {
+void guacenc_video_prepare_frame(guacenc_video* video, AVFrame* source) {
 
-    int lsize;
-    int psize;
+    int width;
+    int height;
 
-    /* Ignore NULL buffers */
-    if (buffer == NULL || buffer->surface == NULL)
+    /* Ignore NULL sources */
+    if (source == NULL || source->width <= 0 || source->height <= 0)
         return;
 
     /* Obtain destination frame */
     AVFrame* dst = video->next_frame;
 
-    /* Determine width of image if height is scaled to match destination */
-    int scaled_width = buffer->width * dst->height / buffer->height;
-
-    /* Determine height of image if width is scaled to match destination */
-    int scaled_height = buffer->height * dst->width / buffer->width;
-
-    /* If height-based scaling results in a fit width, add pillarboxes */
-    if (scaled_width <= dst->width) {
-        lsize = 0;
-        psize = (dst->width - scaled_width)
-               * buffer->height / dst->height / 2;
+    /* Scale to exactly fit the destination width or height, whichever
+     * preserves the aspect ratio of the source */
+    if ((int64_t) source->width * dst->height
+            > (int64_t) source->height * dst->width) {
+        width = dst->width;
+        height = (int64_t) source->height * dst->width / source->width;
     }
-
-    /* If width-based scaling results in a fit width, add letterboxes */
     else {
-        assert(scaled_height <= dst->height);
-        psize = 0;
-        lsize = (dst->height - scaled_height)
-               * buffer->width / dst->width / 2;
+        width = (int64_t) source->width * dst->height / source->height;
+        height = dst->height;
     }
 
-    /* Prepare source frame for buffer */
-    AVFrame* src = guacenc_video_frame_convert(buffer, lsize, psize);
-    if (src == NULL) {
-        guacenc_log(GUAC_LOG_WARNING, "Failed to allocate source frame. "
-                "Frame dropped.");
-        return;
+    /* Keep scaled region aligned with chroma subsampling */
+    width = (width & ~1) < 2 ? 2 : (width & ~1);
+    height = (height & ~1) < 2 ? 2 : (height & ~1);
+
+    /* Center scaled region, leaving letterboxes or pillarboxes */
+    int x = ((dst->width - width) / 2) & ~1;
+    int y = ((dst->height - height) / 2) & ~1;
+
+    /* Boxes need only be redrawn when the scaled region changes */
+    if (source->width != video->last_source_width
+            || source->height != video->last_source_height) {
+        guacenc_video_frame_clear(dst);
+        video->last_source_width = source->width;
+        video->last_source_height = source->height;
     }
 
-    /* Prepare scaling context */
-    struct SwsContext* sws = sws_getContext(src->width, src->height,
-            AV_PIX_FMT_RGB32, dst->width, dst->height, AV_PIX_FMT_YUV420P,
+    /* Reuse scaling context unless source dimensions have changed */
+    video->sws = sws_getCachedContext(video->sws,
+            source->width, source->height, AV_PIX_FMT_RGB32,
+            width, height, AV_PIX_FMT_YUV420P,
             SWS_BICUBIC, NULL, NULL, NULL);
 
     /* Abort if scaling context could not be created */
-    if (sws == NULL) {
+    if (video->sws == NULL) {
         guacenc_log(GUAC_LOG_WARNING, "Failed to allocate software scaling "
                 "context. Frame dropped.");
-        av_freep(&src->data[0]);
-        av_frame_free(&src);
         return;
     }
 
-    /* Apply scaling, copying the source frame to the destination */
-    sws_scale(sws, (const uint8_t* const*) src->data, src->linesize,
-            0, src->height, dst->data, dst->linesize);
-
-    /* Free scaling context */
-    sws_freeContext(sws);
+    /* Locate scaled region within each plane of destination */
+    uint8_t* const dst_data[] = {
+        dst->data[0] + y * dst->linesize[0] + x,
+        dst->data[1] + (y / 2) * dst->linesize[1] + x / 2,
+        dst->data[2] + (y / 2) * dst->linesize[2] + x / 2
+    };
 
-    /* Free source frame */
-    av_freep(&src->data[0]);
-    av_frame_free(&src);
+    /* Apply scaling, copying the source frame to the destination */
+    sws_scale(video->sws, (const uint8_t* const*) source->data,
+            source->linesize, 0, source->height, dst_data, dst->linesize);
 
 }
 
@@ -493,6 +437,9 @@ int guacenc_video_free(guacenc_video* video) {
         avio_close(video->container_format_context->pb);
     }
 
+    /* Free scaling context */
+    sws_freeContext(video->sws);
+
     /* Free frame encoding data */
     av_freep(&video->next_frame->data[0]);
     av_frame_free(&video->next_frame);
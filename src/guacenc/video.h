@@ -34,6 +34,8 @@
 #include <libavformat/avformat.h>
 #endif
 
+#include <libswscale/swscale.h>
+
 #include <stdint.h>
 #include <stdio.h>
 
@@ -102,6 +104,25 @@ typedef struct guacenc_video {
      */
     guac_timestamp last_timestamp;
 
+    /**
+     * The libswscale context used to scale each source frame to the size of
+     * this video, or NULL if no frame has yet been prepared. This context is
+     * reused for as long as the source frame dimensions remain the same.
+     */
+    struct SwsContext* sws;
+
+    /**
+     * The width of the most recently prepared source frame, in pixels, or 0
+     * if no frame has yet been prepared.
+     */
+    int last_source_width;
+
+    /**
+     * The height of the most recently prepared source frame, in pixels, or 0
+     * if no frame has yet been prepared.
+     */
+    int last_source_height;
+
 } guacenc_video;
 
 /**
@@ -159,25 +180,56 @@ int guacenc_video_advance_timeline(guacenc_video* video,
         guac_timestamp timestamp);
 
 /**
- * Stores the given buffer within the given video structure such that it will
- * be written if it falls within proper frame boundaries. If the timeline of
- * the video (as dictated by guacenc_video_advance_timeline()) is not at a
- * frame boundary with respect to the video framerate (it occurs between frame
- * boundaries), the prepared frame will only be written if another frame is not
- * prepared within the same pair of frame boundaries). The prepared frame will
- * not be written until it is implicitly flushed through updates to the video
+ * Wraps the image data of the given buffer within a new AVFrame in the format
+ * required by libswscale, without copying that image data. A single source
+ * frame can be prepared for any number of videos of differing sizes through
+ * guacenc_video_prepare_frame(), such that the flattened display need only
+ * be converted once regardless of the number of videos being encoded. The
+ * returned frame is valid only until the buffer is next modified, and must be
+ * freed with guacenc_video_source_free().
+ *
+ * @param buffer
+ *     The guacenc_buffer representing the image data of the frame.
+ *
+ * @return
+ *     A newly-allocated AVFrame referencing the image data of the given
+ *     buffer, or NULL if the buffer is NULL, has no image data, or the frame
+ *     cannot be allocated.
+ */
+AVFrame* guacenc_video_source_alloc(guacenc_buffer* buffer);
+
+/**
+ * Frees the given source frame, as allocated by guacenc_video_source_alloc().
+ * The image data referenced by the frame is not freed. If the given frame is
+ * NULL, this function has no effect.
+ *
+ * @param source
+ *     The source frame to free, which may be NULL.
+ */
+void guacenc_video_source_free(AVFrame* source);
+
+/**
+ * Scales the given source frame into the given video structure such that it
+ * will be written if it falls within proper frame boundaries. The source
+ * frame is scaled to fit the video while preserving its aspect ratio, with
+ * any remaining space filled with black. If the timeline of the video (as
+ * dictated by guacenc_video_advance_timeline()) is not at a frame boundary
+ * with respect to the video framerate (it occurs between frame boundaries),
+ * the prepared frame will only be written if another frame is not prepared
+ * within the same pair of frame boundaries). The prepared frame will not be
+ * written until it is implicitly flushed through updates to the video
  * timeline or through reaching the end of the encoding process
  * (guacenc_video_free()).
  *
  * @param video
- *     The video in which the given buffer should be queued for possible
+ *     The video in which the given frame should be queued for possible
  *     writing (depending on timing vs. video framerate).
  *
- * @param buffer
- *     The guacenc_buffer representing the image data of the frame that should
- *     be queued.
+ * @param source
+ *     The source frame, as returned by guacenc_video_source_alloc(), or NULL
+ *     if there is no frame to prepare.
  */
-void guacenc_video_prepare_frame(guacenc_video* video, guacenc_buffer* buffer);
+void guacenc_video_prepare_frame(guacenc_video* video, AVFrame* source);
 
 /**
  * Frees all resources associated with the given video, finalizing the encoding
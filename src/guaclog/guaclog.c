@@ -19,28 +19,154 @@
 
 #include "config.h"
 
+#include "common/batch.h"
 #include "guaclog.h"
+#include "index.h"
 #include "interpret.h"
 #include "log.h"
 
+#include <errno.h>
 #include <getopt.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * All long options accepted by guaclog, in the format required by
+ * getopt_long().
+ */
+static const struct option guaclog_long_options[] = {
+    { "watch", required_argument, NULL, 'w' },
+    { NULL,    0,                 NULL, 0   }
+};
+
+/**
+ * The suffixes of all files which may be written by guaclog, in the format
+ * required by guac_common_batch_watch().
+ */
+static const char* const guaclog_output_suffixes[] = {
+    GUACLOG_OUTPUT_SUFFIX,
+    GUACLOG_INDEX_SUFFIX,
+    NULL
+};
+
+/**
+ * The interpreting options which apply to all input files.
+ */
+typedef struct guaclog_options {
+
+    /**
+     * Whether input files should be interpreted even if they appear to be
+     * in-progress recordings.
+     */
+    bool force;
+
+    /**
+     * Whether a keystroke index should be produced for each input file in
+     * addition to its human-readable log.
+     */
+    bool index;
+
+} guaclog_options;
+
+/**
+ * Interprets the given input file, writing the result to a new file having
+ * the same name with an additional ".txt" suffix, and any keystroke index to
+ * a new file having an additional ".idx" suffix. This function is invoked by
+ * each worker thread of the guac_common_batch processing all input files.
+ *
+ * @param path
+ *     The path of the input file to interpret.
+ *
+ * @param data
+ *     A pointer to the guaclog_options which apply to all input files.
+ *
+ * @return
+ *     Zero if interpreting succeeded, non-zero otherwise.
+ */
+static int guaclog_process_file(const char* path, void* data) {
+
+    guaclog_options* options = (guaclog_options*) data;
+
+    /* Generate output filenames */
+    char out_path[4096];
+    char index_path[4096];
+    int len = snprintf(out_path, sizeof(out_path), "%s" GUACLOG_OUTPUT_SUFFIX,
+            path);
+    int index_len = snprintf(index_path, sizeof(index_path),
+            "%s" GUACLOG_INDEX_SUFFIX, path);
+
+    /* Do not write if filename exceeds maximum length */
+    if (len >= sizeof(out_path) || index_len >= sizeof(index_path)) {
+        guaclog_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
+                "Name too long", path);
+        return 1;
+    }
+
+    /* Attempt interpreting, log granular success/failure at debug level */
+    if (guaclog_interpret(path, out_path,
+                options->index ? index_path : NULL, options->force)) {
+        guaclog_log(GUAC_LOG_DEBUG,
+                "%s was NOT successfully interpreted.", path);
+        return 1;
+    }
+
+    guaclog_log(GUAC_LOG_DEBUG, "%s was successfully interpreted.", path);
+    return 0;
+
+}
 
 int main(int argc, char* argv[]) {
 
     int i;
 
+    /* Track number of overall failures */
+    int failures = 0;
+
     /* Load defaults */
-    bool force = false;
+    guaclog_options options = {
+        .force = false,
+        .index = false
+    };
+
+    const char* query = NULL;
+    const char* merge_path = NULL;
+    int jobs = GUACLOG_DEFAULT_JOBS;
+    const char* watch_path = NULL;
 
     /* Parse arguments */
     int opt;
-    while ((opt = getopt(argc, argv, "s:r:f")) != -1) {
+    while ((opt = getopt_long(argc, argv, "j:w:iq:m:f",
+                    guaclog_long_options, NULL)) != -1) {
+
+        /* -j: Number of files to interpret concurrently */
+        if (opt == 'j') {
+            if (guac_common_batch_parse_workers(optarg, &jobs)) {
+                guaclog_log(GUAC_LOG_ERROR, "Invalid number of jobs.");
+                goto invalid_options;
+            }
+        }
+
+        /* -w, --watch: Directory to watch for completed recordings */
+        else if (opt == 'w')
+            watch_path = optarg;
+
+        /* -i: Produce keystroke index */
+        else if (opt == 'i')
+            options.index = true;
+
+        /* -q: Search keystroke indexes */
+        else if (opt == 'q')
+            query = optarg;
+
+        /* -m: Merge keystroke indexes */
+        else if (opt == 'm')
+            merge_path = optarg;
 
         /* -f: Force */
-        if (opt == 'f')
-            force = true;
+        else if (opt == 'f')
+            options.force = true;
 
         /* Invalid option */
         else {
@@ -49,51 +175,77 @@ int main(int argc, char* argv[]) {
 
     }
 
+    /* Searching and merging operate on indexes, not recordings */
+    if (query != NULL && merge_path != NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Only one of -q and -m may be given.");
+        goto invalid_options;
+    }
+
+    /* Search all given indexes, writing matches to STDOUT */
+    if (query != NULL) {
+        for (i = optind; i < argc; i++) {
+            if (guaclog_index_query(argv[i], query))
+                failures++;
+        }
+        return failures != 0;
+    }
+
+    /* Merge all given indexes into a single index */
+    if (merge_path != NULL)
+        return guaclog_index_merge(merge_path, argc - optind, argv + optind);
+
     /* Log start */
     guaclog_log(GUAC_LOG_INFO, "Guacamole input log interpreter (guaclog) "
             "version " VERSION);
 
-    /* Track number of overall failures */
     int total_files = argc - optind;
-    int failures = 0;
 
     /* Abort if no files given */
-    if (total_files <= 0) {
+    if (total_files <= 0 && watch_path == NULL) {
         guaclog_log(GUAC_LOG_INFO, "No input files specified. Nothing to do.");
         return 0;
     }
 
     guaclog_log(GUAC_LOG_INFO, "%i input file(s) provided.", total_files);
 
-    /* Interpret all input files */
-    for (i = optind; i < argc; i++) {
-
-        /* Get current filename */
-        const char* path = argv[i];
-
-        /* Generate output filename */
-        char out_path[4096];
-        int len = snprintf(out_path, sizeof(out_path), "%s.txt", path);
-
-        /* Do not write if filename exceeds maximum length */
-        if (len >= sizeof(out_path)) {
-            guaclog_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
-                    "Name too long", path);
-            continue;
-        }
+    /* Queue all input files, failing any which do not exist */
+    guac_common_batch* batch = guac_common_batch_alloc(guaclog_process_file, &options);
+    if (batch == NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Unable to allocate batch.");
+        return 1;
+    }
 
-        /* Attempt interpreting, log granular success/failure at debug level */
-        if (guaclog_interpret(path, out_path, force)) {
+    for (i = optind; i < argc; i++) {
+        if (guac_common_batch_add(batch, argv[i])) {
+            guaclog_log(GUAC_LOG_ERROR, "%s: %s", argv[i], strerror(errno));
             failures++;
-            guaclog_log(GUAC_LOG_DEBUG,
-                    "%s was NOT successfully interpreted.", path);
         }
-        else
-            guaclog_log(GUAC_LOG_DEBUG, "%s was successfully "
-                    "interpreted.", path);
+    }
+
+    /* Start workers which will interpret all queued files */
+    if (guac_common_batch_start(batch, jobs)) {
+        guaclog_log(GUAC_LOG_ERROR, "Unable to start %i worker(s).", jobs);
+        guac_common_batch_free(batch);
+        return 1;
+    }
 
+    guaclog_log(GUAC_LOG_DEBUG, "Interpreting using %i worker(s).", jobs);
+
+    /* Continue interpreting recordings as they are completed, if requested */
+    if (watch_path != NULL) {
+        guaclog_log(GUAC_LOG_INFO, "Watching \"%s\" for completed "
+                "recordings ...", watch_path);
+        guac_common_batch_watch(batch, watch_path, guaclog_output_suffixes);
+        guaclog_log(GUAC_LOG_ERROR, "Cannot watch \"%s\": %s", watch_path,
+                strerror(errno));
     }
 
+    /* Wait for all queued files to be interpreted */
+    guac_common_batch_wait(batch);
+    total_files = failures + batch->total;
+    failures += batch->failures;
+    guac_common_batch_free(batch);
+
     /* Warn if at least one file failed */
     if (failures != 0)
         guaclog_log(GUAC_LOG_WARNING, "Interpreting failed for %i of %i "
@@ -110,10 +262,14 @@ int main(int argc, char* argv[]) {
 invalid_options:
 
     fprintf(stderr, "USAGE: %s"
+            " [-j JOBS]"
+            " [-w DIRECTORY]"
+            " [-i]"
             " [-f]"
-            " [FILE]...\n", argv[0]);
+            " [FILE]...\n"
+            "       %s -q TERM [INDEX]...\n"
+            "       %s -m OUTPUT [INDEX]...\n", argv[0], argv[0], argv[0]);
 
     return 1;
 
 }
-
@@ -27,5 +27,23 @@
  */
 #define GUACLOG_DEFAULT_LOG_LEVEL GUAC_LOG_INFO
 
+/**
+ * The number of input files which should be interpreted concurrently, if no
+ * other number of jobs is given on the command line.
+ */
+#define GUACLOG_DEFAULT_JOBS 1
+
+/**
+ * The suffix which is appended to the name of each input file to produce the
+ * name of the corresponding human-readable output file.
+ */
+#define GUACLOG_OUTPUT_SUFFIX ".txt"
+
+/**
+ * The suffix which is appended to the name of each input file to produce the
+ * name of the corresponding keystroke index file.
+ */
+#define GUACLOG_INDEX_SUFFIX ".idx"
+
 #endif
 
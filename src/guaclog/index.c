@@ -0,0 +1,585 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "index.h"
+#include "log.h"
+
+#include <guacamole/timestamp.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The fields of a single line of an index file. Each field is a pointer into
+ * the original line and is NOT NULL-terminated.
+ */
+typedef struct guaclog_index_line {
+
+    /**
+     * The token typed.
+     */
+    const char* token;
+
+    /**
+     * The length of the token, in bytes.
+     */
+    size_t token_length;
+
+    /**
+     * The path of the recording in which the token was typed.
+     */
+    const char* recording;
+
+    /**
+     * The length of the recording path, in bytes.
+     */
+    size_t recording_length;
+
+    /**
+     * The number of milliseconds between the start of the recording and the
+     * first key press of the token.
+     */
+    guac_timestamp offset;
+
+} guaclog_index_line;
+
+/**
+ * Splits the given line of an index file into its fields.
+ *
+ * @param line
+ *     The line to parse, which need not be NULL-terminated.
+ *
+ * @param length
+ *     The length of the line, in bytes, excluding any trailing newline.
+ *
+ * @param parsed
+ *     The structure in which the parsed fields should be stored.
+ *
+ * @return
+ *     Zero if the line was parsed successfully, non-zero if the line is
+ *     malformed.
+ */
+static int guaclog_index_parse_line(const char* line, size_t length,
+        guaclog_index_line* parsed) {
+
+    const char* end = line + length;
+
+    /* Locate end of token */
+    const char* tab = memchr(line, '\t', length);
+    if (tab == NULL)
+        return 1;
+
+    parsed->token = line;
+    parsed->token_length = tab - line;
+
+    /* Locate end of recording path */
+    const char* recording = tab + 1;
+    tab = memchr(recording, '\t', end - recording);
+    if (tab == NULL)
+        return 1;
+
+    parsed->recording = recording;
+    parsed->recording_length = tab - recording;
+
+    /* Parse offset (digits only) */
+    guac_timestamp offset = 0;
+    const char* current;
+    for (current = tab + 1; current < end; current++) {
+        if (*current < '0' || *current > '9')
+            return 1;
+        offset = offset * 10 + (*current - '0');
+    }
+
+    parsed->offset = offset;
+    return 0;
+
+}
+
+/**
+ * Compares two byte strings which are not NULL-terminated, using the same
+ * ordering as strcmp().
+ *
+ * @return
+ *     A negative value if a sorts before b, a positive value if a sorts after
+ *     b, or zero if both are identical.
+ */
+static int guaclog_index_compare_field(const char* a, size_t a_length,
+        const char* b, size_t b_length) {
+
+    int result = memcmp(a, b, a_length < b_length ? a_length : b_length);
+    if (result)
+        return result;
+
+    return (a_length > b_length) - (a_length < b_length);
+
+}
+
+/**
+ * Compares two parsed index lines by token, then recording, then offset.
+ *
+ * @return
+ *     A negative value if a sorts before b, a positive value if a sorts after
+ *     b, or zero if both are identical.
+ */
+static int guaclog_index_compare_lines(const guaclog_index_line* a,
+        const guaclog_index_line* b) {
+
+    int result = guaclog_index_compare_field(a->token, a->token_length,
+            b->token, b->token_length);
+    if (result)
+        return result;
+
+    result = guaclog_index_compare_field(a->recording, a->recording_length,
+            b->recording, b->recording_length);
+    if (result)
+        return result;
+
+    return (a->offset > b->offset) - (a->offset < b->offset);
+
+}
+
+/**
+ * Comparator for qsort() which orders guaclog_index_entry structures by
+ * token, then by offset.
+ */
+static int guaclog_index_compare_entries(const void* a, const void* b) {
+
+    const guaclog_index_entry* entry_a = (const guaclog_index_entry*) a;
+    const guaclog_index_entry* entry_b = (const guaclog_index_entry*) b;
+
+    int result = strcmp(entry_a->token, entry_b->token);
+    if (result)
+        return result;
+
+    return (entry_a->offset > entry_b->offset)
+         - (entry_a->offset < entry_b->offset);
+
+}
+
+/**
+ * Opens a new output stream for the file at the given path, refusing to
+ * overwrite any existing file.
+ *
+ * @param path
+ *     The path of the file to create.
+ *
+ * @return
+ *     A new output stream, or NULL if the file cannot be created.
+ */
+static FILE* guaclog_index_open_output(const char* path) {
+
+    int fd = open(path, O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        guaclog_log(GUAC_LOG_ERROR, "Failed to open index file \"%s\": %s",
+                path, strerror(errno));
+        return NULL;
+    }
+
+    FILE* output = fdopen(fd, "wb");
+    if (output == NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Failed to allocate stream for index "
+                "file \"%s\": %s", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    return output;
+
+}
+
+guaclog_index* guaclog_index_alloc(const char* path, const char* recording) {
+
+    /* Store absolute path to recording, if possible, such that indexes
+     * remain meaningful after being merged */
+    char absolute[PATH_MAX];
+    if (realpath(recording, absolute) != NULL)
+        recording = absolute;
+
+    /* Tabs and newlines within the path would corrupt the index */
+    if (strpbrk(recording, "\t\n") != NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Cannot index \"%s\": Path contains tab "
+                "or newline characters.", recording);
+        return NULL;
+    }
+
+    /* Allocate everything before creating the index file, such that an
+     * empty index is never left behind */
+    guaclog_index* index = calloc(1, sizeof(guaclog_index));
+    if (index == NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Cannot index \"%s\": Out of memory.",
+                recording);
+        return NULL;
+    }
+
+    index->recording = strdup(recording);
+    if (index->recording == NULL) {
+        guaclog_log(GUAC_LOG_ERROR, "Cannot index \"%s\": Out of memory.",
+                recording);
+        free(index);
+        return NULL;
+    }
+
+    index->output = guaclog_index_open_output(path);
+    if (index->output == NULL) {
+        free(index->recording);
+        free(index);
+        return NULL;
+    }
+
+    return index;
+
+}
+
+int guaclog_index_add(guaclog_index* index, const char* token,
+        guac_timestamp offset) {
+
+    /* Expand entry array if necessary */
+    if (index->entry_count == index->entry_capacity) {
+
+        int capacity = index->entry_capacity ? index->entry_capacity * 2 : 256;
+        guaclog_index_entry* entries = realloc(index->entries,
+                sizeof(guaclog_index_entry) * capacity);
+
+        if (entries == NULL)
+            return 1;
+
+        index->entries = entries;
+        index->entry_capacity = capacity;
+
+    }
+
+    char* token_copy = strdup(token);
+    if (token_copy == NULL)
+        return 1;
+
+    guaclog_index_entry* entry = &index->entries[index->entry_count++];
+    entry->token = token_copy;
+    entry->offset = offset;
+
+    return 0;
+
+}
+
+int guaclog_index_free(guaclog_index* index) {
+
+    int i;
+
+    /* Ignore NULL index */
+    if (index == NULL)
+        return 0;
+
+    /* Write all entries in sorted order */
+    qsort(index->entries, index->entry_count, sizeof(guaclog_index_entry),
+            guaclog_index_compare_entries);
+
+    for (i = 0; i < index->entry_count; i++) {
+        guaclog_index_entry* entry = &index->entries[i];
+        fprintf(index->output, "%s\t%s\t%" PRId64 "\n", entry->token,
+                index->recording, (int64_t) entry->offset);
+        free(entry->token);
+    }
+
+    int result = fclose(index->output) ? 1 : 0;
+
+    free(index->entries);
+    free(index->recording);
+    free(index);
+
+    return result;
+
+}
+
+/**
+ * A single index file being merged, along with its current line.
+ */
+typedef struct guaclog_index_merge_input {
+
+    /**
+     * Input stream for the index file.
+     */
+    FILE* input;
+
+    /**
+     * The current line, as read by getline(), or NULL if no more lines
+     * remain.
+     */
+    char* line;
+
+    /**
+     * The size of the buffer allocated for the current line by getline().
+     */
+    size_t line_size;
+
+    /**
+     * The parsed fields of the current line.
+     */
+    guaclog_index_line parsed;
+
+} guaclog_index_merge_input;
+
+/**
+ * Advances the given merge input to its next well-formed line. If no further
+ * lines remain, the input's current line is freed and set to NULL.
+ *
+ * @param input
+ *     The merge input to advance.
+ */
+static void guaclog_index_merge_next(guaclog_index_merge_input* input) {
+
+    ssize_t length;
+    while ((length = getline(&input->line, &input->line_size,
+                    input->input)) != -1) {
+
+        /* Strip trailing newline */
+        if (length > 0 && input->line[length - 1] == '\n')
+            length--;
+
+        /* Skip any malformed lines */
+        if (!guaclog_index_parse_line(input->line, length, &input->parsed))
+            return;
+
+    }
+
+    free(input->line);
+    input->line = NULL;
+
+}
+
+int guaclog_index_merge(const char* out_path, int count, char* const* paths) {
+
+    int i;
+    int result = 0;
+
+    guaclog_index_merge_input* inputs = calloc(count,
+            sizeof(guaclog_index_merge_input));
+    if (inputs == NULL)
+        return 1;
+
+    /* Open all inputs, positioning each at its first line */
+    for (i = 0; i < count; i++) {
+
+        inputs[i].input = fopen(paths[i], "rb");
+        if (inputs[i].input == NULL) {
+            guaclog_log(GUAC_LOG_ERROR, "%s: %s", paths[i], strerror(errno));
+            result = 1;
+            goto cleanup;
+        }
+
+        guaclog_index_merge_next(&inputs[i]);
+
+    }
+
+    FILE* output = guaclog_index_open_output(out_path);
+    if (output == NULL) {
+        result = 1;
+        goto cleanup;
+    }
+
+    /* Repeatedly write the smallest current line of all inputs */
+    for (;;) {
+
+        guaclog_index_merge_input* next = NULL;
+        for (i = 0; i < count; i++) {
+            if (inputs[i].line != NULL && (next == NULL
+                    || guaclog_index_compare_lines(&inputs[i].parsed,
+                        &next->parsed) < 0))
+                next = &inputs[i];
+        }
+
+        /* Merge is complete once all inputs are exhausted */
+        if (next == NULL)
+            break;
+
+        fprintf(output, "%.*s\t%.*s\t%" PRId64 "\n",
+                (int) next->parsed.token_length, next->parsed.token,
+                (int) next->parsed.recording_length, next->parsed.recording,
+                (int64_t) next->parsed.offset);
+
+        guaclog_index_merge_next(next);
+
+    }
+
+    if (fclose(output)) {
+        guaclog_log(GUAC_LOG_ERROR, "%s: %s", out_path, strerror(errno));
+        result = 1;
+    }
+
+cleanup:
+    for (i = 0; i < count; i++) {
+        if (inputs[i].input != NULL)
+            fclose(inputs[i].input);
+        free(inputs[i].line);
+    }
+
+    free(inputs);
+    return result;
+
+}
+
+/**
+ * Returns the offset of the start of the line containing the given offset
+ * within the given mapped index file.
+ *
+ * @param data
+ *     The contents of the index file.
+ *
+ * @param offset
+ *     The offset of any byte within the line.
+ *
+ * @return
+ *     The offset of the first byte of the line containing the given offset.
+ */
+static size_t guaclog_index_line_start(const char* data, size_t offset) {
+
+    while (offset > 0 && data[offset - 1] != '\n')
+        offset--;
+
+    return offset;
+
+}
+
+/**
+ * Returns the offset of the end of the line beginning at the given offset
+ * within the given mapped index file, excluding any trailing newline.
+ *
+ * @param data
+ *     The contents of the index file.
+ *
+ * @param size
+ *     The size of the index file, in bytes.
+ *
+ * @param offset
+ *     The offset of the first byte of the line.
+ *
+ * @return
+ *     The offset of the newline ending the line, or the size of the index
+ *     file if the line is not terminated by a newline.
+ */
+static size_t guaclog_index_line_end(const char* data, size_t size,
+        size_t offset) {
+
+    const char* newline = memchr(data + offset, '\n', size - offset);
+    if (newline == NULL)
+        return size;
+
+    return newline - data;
+
+}
+
+int guaclog_index_query(const char* path, const char* term) {
+
+    /* Trailing asterisk denotes a prefix search */
+    size_t term_length = strlen(term);
+    bool prefix = (term_length > 0 && term[term_length - 1] == '*');
+    if (prefix)
+        term_length--;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        guaclog_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+        return 1;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat)) {
+        guaclog_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    /* Empty indexes contain no matches */
+    size_t size = file_stat.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    const char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        guaclog_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+        return 1;
+    }
+
+    /* Binary search for the first line whose token is not less than the
+     * term */
+    size_t low = 0;
+    size_t high = size;
+    while (low < high) {
+
+        size_t start = guaclog_index_line_start(data, low + (high - low) / 2);
+        size_t end = guaclog_index_line_end(data, size, start);
+
+        /* Malformed lines are treated as sorting before all terms */
+        guaclog_index_line line;
+        if (guaclog_index_parse_line(data + start, end - start, &line)
+                || guaclog_index_compare_field(line.token, line.token_length,
+                    term, term_length) < 0)
+            low = end + 1;
+        else
+            high = start;
+
+    }
+
+    /* Print all matching lines */
+    size_t start = low;
+    while (start < size) {
+
+        size_t end = guaclog_index_line_end(data, size, start);
+
+        guaclog_index_line line;
+        if (guaclog_index_parse_line(data + start, end - start, &line))
+            break;
+
+        /* Stop at first token which does not match */
+        if (line.token_length < term_length
+                || (!prefix && line.token_length != term_length)
+                || memcmp(line.token, term, term_length) != 0)
+            break;
+
+        guac_timestamp offset = line.offset;
+        printf("%.*s\t%" PRId64 ":%02i:%02i.%03i\t%.*s\n",
+                (int) line.recording_length, line.recording,
+                (int64_t) (offset / 3600000),
+                (int) (offset / 60000 % 60),
+                (int) (offset / 1000 % 60),
+                (int) (offset % 1000),
+                (int) line.token_length, line.token);
+
+        start = end + 1;
+
+    }
+
+    munmap((void*) data, size);
+    return 0;
+
+}
+
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACLOG_INDEX_H
+#define GUACLOG_INDEX_H
+
+#include "config.h"
+
+#include <guacamole/timestamp.h>
+
+#include <stdio.h>
+
+/**
+ * The maximum length of any single indexed token, in bytes, including NULL
+ * terminator. Longer tokens are truncated.
+ */
+#define GUACLOG_MAX_TOKEN_LENGTH 256
+
+/**
+ * A single typed token, along with the point within the recording at which
+ * typing of that token began.
+ */
+typedef struct guaclog_index_entry {
+
+    /**
+     * The token typed, as a NULL-terminated UTF-8 string.
+     */
+    char* token;
+
+    /**
+     * The number of milliseconds between the start of the recording and the
+     * first key press of the token.
+     */
+    guac_timestamp offset;
+
+} guaclog_index_entry;
+
+/**
+ * An in-progress keystroke index for a single recording. Index files consist
+ * of one entry per line, each line having the form:
+ *
+ *     TOKEN <tab> RECORDING <tab> OFFSET
+ *
+ * Lines are sorted by token, then by recording, then by offset, such that any
+ * number of index files may be merged into a single index with a simple
+ * k-way merge, and such that tokens may be found with a binary search.
+ */
+typedef struct guaclog_index {
+
+    /**
+     * The path of the recording being indexed.
+     */
+    char* recording;
+
+    /**
+     * Output stream to which the index will be written once complete.
+     */
+    FILE* output;
+
+    /**
+     * All entries added so far, in the order they were added.
+     */
+    guaclog_index_entry* entries;
+
+    /**
+     * The number of entries within the entries array.
+     */
+    int entry_count;
+
+    /**
+     * The number of entries which may be stored within the entries array
+     * before it must be reallocated.
+     */
+    int entry_capacity;
+
+} guaclog_index;
+
+/**
+ * Allocates a new keystroke index for the given recording, creating the
+ * index file at the given path. Existing files will not be overwritten.
+ *
+ * @param path
+ *     The full path to the file in which the index should be written.
+ *
+ * @param recording
+ *     The path of the recording being indexed. If possible, this path will be
+ *     resolved to an absolute path before being stored within the index.
+ *
+ * @return
+ *     A newly-allocated keystroke index, or NULL if the index file cannot be
+ *     created or memory cannot be allocated.
+ */
+guaclog_index* guaclog_index_alloc(const char* path, const char* recording);
+
+/**
+ * Adds the given token to the given index.
+ *
+ * @param index
+ *     The index to add the token to.
+ *
+ * @param token
+ *     The token to add, as a NULL-terminated UTF-8 string.
+ *
+ * @param offset
+ *     The number of milliseconds between the start of the recording and the
+ *     first key press of the token.
+ *
+ * @return
+ *     Zero if the token was added successfully, non-zero if memory for the
+ *     token could not be allocated, in which case the index is unchanged.
+ */
+int guaclog_index_add(guaclog_index* index, const char* token,
+        guac_timestamp offset);
+
+/**
+ * Sorts and writes all entries within the given index to its index file,
+ * freeing all associated memory. If the given index is NULL, this function
+ * has no effect.
+ *
+ * @param index
+ *     The index to write and free, which may be NULL.
+ *
+ * @return
+ *     Zero if the index was written successfully, non-zero otherwise.
+ */
+int guaclog_index_free(guaclog_index* index);
+
+/**
+ * Merges the given index files into a single index file. Existing files will
+ * not be overwritten.
+ *
+ * @param out_path
+ *     The full path to the file in which the merged index should be written.
+ *
+ * @param count
+ *     The number of index files to merge.
+ *
+ * @param paths
+ *     The paths of all index files to merge.
+ *
+ * @return
+ *     Zero if the index files were merged successfully, non-zero otherwise.
+ */
+int guaclog_index_merge(const char* out_path, int count, char* const* paths);
+
+/**
+ * Searches the given index file for the given term, writing each matching
+ * entry to STDOUT. If the term ends with an asterisk, all tokens beginning
+ * with the remainder of the term match. Otherwise, only tokens identical to
+ * the term match. As index files are sorted, the search requires only a
+ * binary search of the index file rather than a full scan.
+ *
+ * @param path
+ *     The path of the index file to search.
+ *
+ * @param term
+ *     The term to search for.
+ *
+ * @return
+ *     Zero if the index file was searched successfully (regardless of whether
+ *     any matches were found), non-zero otherwise.
+ */
+int guaclog_index_query(const char* path, const char* term);
+
+#endif
+
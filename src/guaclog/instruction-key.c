@@ -36,6 +36,10 @@ int guaclog_handle_key(guaclog_state* state, int argc, char** argv) {
     int keysym = atoi(argv[0]);
     bool pressed = (atoi(argv[1]) != 0);
 
+    /* Track timestamp of key event, if present */
+    if (argc >= 3)
+        guaclog_state_update_timestamp(state, strtoll(argv[2], NULL, 10));
+
     /* Update interpreter state accordingly */
     return guaclog_state_update_key(state, keysym, pressed);
 
@@ -25,8 +25,9 @@
 #include <string.h>
 
 guaclog_instruction_handler_mapping guaclog_instruction_handler_map[] = {
-    {"key", guaclog_handle_key},
-    {NULL,  NULL}
+    {"key",  guaclog_handle_key},
+    {"sync", guaclog_handle_sync},
+    {NULL,   NULL}
 };
 
 int guaclog_handle_instruction(guaclog_state* state, const char* opcode,
@@ -104,5 +104,10 @@ int guaclog_handle_instruction(guaclog_state* state,
  */
 guaclog_instruction_handler guaclog_handle_key;
 
+/**
+ * Handler for the Guacamole "sync" instruction.
+ */
+guaclog_instruction_handler guaclog_handle_sync;
+
 #endif
 
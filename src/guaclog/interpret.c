@@ -18,6 +18,9 @@
  */
 
 #include "config.h"
+#include "common/parser.h"
+#include "guaclog.h"
+#include "index.h"
 #include "instructions.h"
 #include "log.h"
 #include "state.h"
@@ -27,7 +30,6 @@
 #include <guacamole/parser.h>
 #include <guacamole/socket.h>
 
-#include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -81,7 +83,26 @@ static int guaclog_read_instructions(guaclog_state* state,
 
 }
 
-int guaclog_interpret(const char* path, const char* out_path, bool force) {
+/**
+ * Handles a single instruction parsed from a memory-mapped file by
+ * guac_common_parser_read_mapped().
+ *
+ * @param parser
+ *     The guac_parser which parsed the instruction.
+ *
+ * @param data
+ *     The current state of the Guacamole input log interpreter.
+ */
+static void guaclog_handle_mapped_instruction(guac_parser* parser, void* data) {
+
+    guaclog_state* state = (guaclog_state*) data;
+    guaclog_handle_instruction(state, parser->opcode,
+            parser->argc, parser->argv);
+
+}
+
+int guaclog_interpret(const char* path, const char* out_path,
+        const char* index_path, bool force) {
 
     /* Open input file */
     int fd = open(path, O_RDONLY);
@@ -124,7 +145,34 @@ int guaclog_interpret(const char* path, const char* out_path, bool force) {
         return 1;
     }
 
-    /* Obtain guac_socket wrapping file descriptor */
+    /* Produce keystroke index alongside human-readable log, if requested */
+    if (index_path != NULL) {
+        state->index = guaclog_index_alloc(index_path, path);
+        if (state->index == NULL) {
+            close(fd);
+            guaclog_state_free(state);
+            return 1;
+        }
+    }
+
+    guaclog_log(GUAC_LOG_INFO, "Writing input events from \"%s\" "
+            "to \"%s\" ...", path, out_path);
+
+    /* Parse directly from a memory mapping of the file, if possible */
+    int result = guac_common_parser_read_mapped(fd,
+            guaclog_handle_mapped_instruction, state);
+    if (result != -1) {
+        close(fd);
+        if (result) {
+            guaclog_log(GUAC_LOG_ERROR, "%s: %s",
+                    path, guac_status_string(guac_error));
+            guaclog_state_free(state);
+            return 1;
+        }
+        return guaclog_state_free(state);
+    }
+
+    /* Otherwise, obtain guac_socket wrapping file descriptor */
     guac_socket* socket = guac_socket_open(fd);
     if (socket == NULL) {
         guaclog_log(GUAC_LOG_ERROR, "%s: %s", path,
@@ -134,9 +182,6 @@ int guaclog_interpret(const char* path, const char* out_path, bool force) {
         return 1;
     }
 
-    guaclog_log(GUAC_LOG_INFO, "Writing input events from \"%s\" "
-            "to \"%s\" ...", path, out_path);
-
     /* Attempt to read all instructions in the file */
     if (guaclog_read_instructions(state, path, socket)) {
         guac_socket_free(socket);
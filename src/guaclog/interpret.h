@@ -37,6 +37,11 @@
  * @param out_path
  *     The full path to the file in which interpreted log should be written.
  *
+ * @param index_path
+ *     The full path to the file in which a keystroke index of all tokens
+ *     typed should be written, or NULL if no keystroke index should be
+ *     produced.
+ *
  * @param force
  *     Interpret even if the input file appears to be an in-progress log (has
  *     an associated lock).
@@ -45,7 +50,8 @@
  *     Zero on success, non-zero if an error prevented successful
  *     interpretation of the log.
  */
-int guaclog_interpret(const char* path, const char* out_path, bool force);
+int guaclog_interpret(const char* path, const char* out_path,
+        const char* index_path, bool force);
 
 #endif
 
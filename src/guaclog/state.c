@@ -61,6 +61,9 @@ guaclog_state* guaclog_state_alloc(const char* path) {
     /* No keys are initially tracked */
     state->active_keys = 0;
 
+    /* No events have yet been read */
+    state->start_timestamp = -1;
+
     return state;
 
     /* Free all allocated data in case of failure */
@@ -75,6 +78,89 @@ fail_output_fd:
 
 }
 
+/**
+ * Ends the token currently being typed, adding that token to the keystroke
+ * index if an index is being produced. If no token is currently being typed,
+ * this function has no effect.
+ *
+ * @param state
+ *     The Guacamole input log interpreter state being updated.
+ */
+static void guaclog_state_end_token(guaclog_state* state) {
+
+    if (state->token_length == 0)
+        return;
+
+    state->token[state->token_length] = '\0';
+    state->token_length = 0;
+
+    if (state->index == NULL)
+        return;
+
+    /* Tokens typed before the first sync are placed at the very start */
+    guac_timestamp offset = state->token_timestamp - state->start_timestamp;
+    if (state->start_timestamp == -1 || offset < 0)
+        offset = 0;
+
+    if (guaclog_index_add(state->index, state->token, offset))
+        guaclog_log(GUAC_LOG_WARNING, "Unable to index token: Out of "
+                "memory.");
+
+}
+
+/**
+ * Appends the given typed value to the token currently being typed. If the
+ * value is whitespace, the current token is ended instead. Values which do
+ * not fit within the token buffer are dropped.
+ *
+ * @param state
+ *     The Guacamole input log interpreter state being updated.
+ *
+ * @param value
+ *     The value typed, as a NULL-terminated UTF-8 string.
+ */
+static void guaclog_state_append_token(guaclog_state* state,
+        const char* value) {
+
+    /* Whitespace separates tokens */
+    if (strcmp(value, " ") == 0 || strcmp(value, "\n") == 0) {
+        guaclog_state_end_token(state);
+        return;
+    }
+
+    /* Note start of new tokens */
+    if (state->token_length == 0)
+        state->token_timestamp = state->timestamp;
+
+    /* Append value only if it fits */
+    int length = strlen(value);
+    if (state->token_length + length < sizeof(state->token)) {
+        memcpy(state->token + state->token_length, value, length);
+        state->token_length += length;
+    }
+
+}
+
+/**
+ * Removes the last character from the token currently being typed, as would
+ * happen if the user pressed backspace.
+ *
+ * @param state
+ *     The Guacamole input log interpreter state being updated.
+ */
+static void guaclog_state_erase_token(guaclog_state* state) {
+
+    /* Skip past any UTF-8 continuation bytes */
+    while (state->token_length > 0
+            && (state->token[state->token_length - 1] & 0xC0) == 0x80)
+        state->token_length--;
+
+    /* Remove the leading byte of the final character */
+    if (state->token_length > 0)
+        state->token_length--;
+
+}
+
 int guaclog_state_free(guaclog_state* state) {
 
     int i;
@@ -90,8 +176,12 @@ int guaclog_state_free(guaclog_state* state) {
     /* Close output file */
     fclose(state->output);
 
+    /* Write keystroke index, including any final token */
+    guaclog_state_end_token(state);
+    int result = guaclog_index_free(state->index);
+
     free(state);
-    return 0;
+    return result;
 
 }
 
@@ -208,6 +298,21 @@ static bool guaclog_state_is_shortcut(guaclog_state* state) {
 
 }
 
+void guaclog_state_update_timestamp(guaclog_state* state,
+        guac_timestamp timestamp) {
+    state->timestamp = timestamp;
+}
+
+void guaclog_state_sync(guaclog_state* state, guac_timestamp timestamp) {
+
+    /* The first sync marks the start of the recording */
+    if (state->start_timestamp == -1)
+        state->start_timestamp = timestamp;
+
+    state->timestamp = timestamp;
+
+}
+
 int guaclog_state_update_key(guaclog_state* state, int keysym, bool pressed) {
 
     int i;
@@ -253,14 +358,27 @@ int guaclog_state_update_key(guaclog_state* state, int keysym, bool pressed) {
 
             fprintf(state->output, "%s>", keydef->value);
 
+            /* Shortcuts separate tokens */
+            guaclog_state_end_token(state);
+
         }
 
         /* Print the key itself */
         else {
-            if (keydef->value != NULL)
+            if (keydef->value != NULL) {
                 fprintf(state->output, "%s", keydef->value);
-            else
+                guaclog_state_append_token(state, keydef->value);
+            }
+            else {
                 fprintf(state->output, "<%s>", keydef->name);
+
+                /* Backspace edits the current token, while all other
+                 * non-printable keys separate tokens */
+                if (keydef->keysym == GUACLOG_KEYSYM_BACKSPACE)
+                    guaclog_state_erase_token(state);
+                else
+                    guaclog_state_end_token(state);
+            }
         }
 
     }
@@ -21,8 +21,11 @@
 #define GUACLOG_STATE_H
 
 #include "config.h"
+#include "index.h"
 #include "keydef.h"
 
+#include <guacamole/timestamp.h>
+
 #include <stdbool.h>
 #include <stdio.h>
 
@@ -71,6 +74,44 @@ typedef struct guaclog_state {
      */
     guaclog_key_state key_states[GUACLOG_MAX_KEYS];
 
+    /**
+     * The keystroke index to which each typed token should be added, or NULL
+     * if no index is being produced. The index is owned by the state and
+     * will be written and freed along with the state.
+     */
+    guaclog_index* index;
+
+    /**
+     * The token currently being typed, as a NULL-terminated UTF-8 string.
+     */
+    char token[GUACLOG_MAX_TOKEN_LENGTH];
+
+    /**
+     * The length of the token currently being typed, in bytes, excluding
+     * NULL terminator.
+     */
+    int token_length;
+
+    /**
+     * The timestamp of the first key press of the token currently being
+     * typed.
+     */
+    guac_timestamp token_timestamp;
+
+    /**
+     * The timestamp of the first "sync" instruction within the recording,
+     * which marks the start of the recording and is the origin of all offsets
+     * within the keystroke index, or -1 if no "sync" instruction has yet been
+     * read.
+     */
+    guac_timestamp start_timestamp;
+
+    /**
+     * The timestamp of the most recent timestamped event within the
+     * recording, whether a "sync" instruction or a key event.
+     */
+    guac_timestamp timestamp;
+
 } guaclog_state;
 
 /**
@@ -90,8 +131,9 @@ guaclog_state* guaclog_state_alloc(const char* path);
 
 /**
  * Frees all memory associated with the given Guacamole input log interpreter
- * state, and finishes any remaining interpreting process. If the given state
- * is NULL, this function has no effect.
+ * state, and finishes any remaining interpreting process, including writing
+ * any associated keystroke index. If the given state is NULL, this function
+ * has no effect.
  *
  * @param state
  *     The Guacamole input log interpreter state to free, which may be NULL.
@@ -102,6 +144,34 @@ guaclog_state* guaclog_state_alloc(const char* path);
  */
 int guaclog_state_free(guaclog_state* state);
 
+/**
+ * Updates the current timestamp of the given Guacamole input log interpreter
+ * state to the timestamp of a key event. Unlike guaclog_state_sync(), this
+ * never establishes the start of the recording.
+ *
+ * @param state
+ *     The Guacamole input log interpreter state being updated.
+ *
+ * @param timestamp
+ *     The timestamp of the event currently being interpreted.
+ */
+void guaclog_state_update_timestamp(guaclog_state* state,
+        guac_timestamp timestamp);
+
+/**
+ * Updates the current timestamp of the given Guacamole input log interpreter
+ * state to the timestamp of a "sync" instruction. The first "sync"
+ * instruction marks the start of the recording, with all offsets within the
+ * keystroke index being relative to its timestamp.
+ *
+ * @param state
+ *     The Guacamole input log interpreter state being updated.
+ *
+ * @param timestamp
+ *     The timestamp of the "sync" instruction currently being interpreted.
+ */
+void guaclog_state_sync(guaclog_state* state, guac_timestamp timestamp);
+
 /**
  * Updates the given Guacamole input log interpreter state, marking the given
  * key as pressed or released.
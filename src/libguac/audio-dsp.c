@@ -0,0 +1,370 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "audio-dsp.h"
+#include "guacamole/audio.h"
+#include "guacamole/client.h"
+#include "guacamole/timestamp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Converts the given PCM data to 16-bit samples, downmixing stereo to mono
+ * if the stream's encoder expects only one channel. Each combination of
+ * formats is handled by a separate loop such that no loop branches per
+ * sample.
+ *
+ * @param audio
+ *     The audio stream whose PCM format should be used.
+ *
+ * @param data
+ *     The PCM data to convert, in the format of the audio stream.
+ *
+ * @param frames
+ *     The number of frames of PCM data to convert.
+ *
+ * @param samples
+ *     The buffer to receive the converted samples.
+ */
+static void guac_audio_dsp_convert(guac_audio_stream* audio,
+        const unsigned char* data, int frames, int16_t* samples) {
+
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
+    int downmix = audio->channels == 2 && dsp->channels == 1;
+
+    /* 16-bit samples, stereo downmixed to mono */
+    if (audio->bps == 16 && downmix) {
+        for (int i = 0; i < frames; i++, data += 4)
+            samples[i] = ((int16_t) (data[0] | (data[1] << 8))
+                        + (int16_t) (data[2] | (data[3] << 8))) >> 1;
+    }
+
+    /* 16-bit samples, channels unchanged */
+    else if (audio->bps == 16) {
+        int count = frames * audio->channels;
+        for (int i = 0; i < count; i++, data += 2)
+            samples[i] = (int16_t) (data[0] | (data[1] << 8));
+    }
+
+    /* 8-bit samples, stereo downmixed to mono */
+    else if (downmix) {
+        for (int i = 0; i < frames; i++, data += 2)
+            samples[i] = (data[0] + data[1] - 256) << 7;
+    }
+
+    /* 8-bit samples, channels unchanged */
+    else {
+        int count = frames * audio->channels;
+        for (int i = 0; i < count; i++)
+            samples[i] = (data[i] - 128) << 8;
+    }
+
+}
+
+/**
+ * Converts the given 16-bit samples back to the bits per sample of the given
+ * audio stream.
+ *
+ * @param audio
+ *     The audio stream whose PCM format should be used.
+ *
+ * @param samples
+ *     The samples to convert.
+ *
+ * @param count
+ *     The number of samples to convert, across all channels.
+ *
+ * @param data
+ *     The buffer to receive the converted PCM data.
+ *
+ * @return
+ *     The number of bytes written to the given buffer.
+ */
+static int guac_audio_dsp_pack(guac_audio_stream* audio,
+        const int16_t* samples, int count, unsigned char* data) {
+
+    if (audio->bps == 16) {
+        for (int i = 0; i < count; i++) {
+            *(data++) = samples[i] & 0xFF;
+            *(data++) = (samples[i] >> 8) & 0xFF;
+        }
+        return count * 2;
+    }
+
+    for (int i = 0; i < count; i++)
+        data[i] = (samples[i] >> 8) + 128;
+
+    return count;
+
+}
+
+/**
+ * Returns the peak absolute value of the given 16-bit samples.
+ *
+ * @param samples
+ *     The samples to test.
+ *
+ * @param count
+ *     The number of samples to test, across all channels.
+ *
+ * @return
+ *     The largest absolute value of any of the given samples.
+ */
+static int guac_audio_dsp_peak(const int16_t* samples, int count) {
+
+    int peak = 0;
+
+    for (int i = 0; i < count; i++) {
+        int value = samples[i] < 0 ? -samples[i] : samples[i];
+        peak = value > peak ? value : peak;
+    }
+
+    return peak;
+
+}
+
+/**
+ * Processes a single block of PCM data consisting only of complete frames,
+ * passing the result to the encoder of the given audio stream unless the
+ * block is dropped due to silence or pacing.
+ *
+ * @param audio
+ *     The audio stream receiving the PCM data.
+ *
+ * @param data
+ *     The PCM data to process, in the format of the audio stream.
+ *
+ * @param frames
+ *     The number of frames of PCM data to process. This may not exceed
+ *     GUAC_AUDIO_DSP_BLOCK_SIZE.
+ *
+ * @param lag
+ *     Pointer to the processing lag of the users of the stream's client, in
+ *     milliseconds, or to a negative value if the lag has not yet been
+ *     calculated for the current write. The lag is calculated and stored
+ *     only if needed.
+ */
+static void guac_audio_dsp_process(guac_audio_stream* audio,
+        const unsigned char* data, int frames, int* lag) {
+
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
+    int channels = dsp->channels;
+
+    int16_t* samples = dsp->samples;
+    guac_audio_dsp_convert(audio, data, frames, samples);
+
+    /* Drop audio once silence has persisted beyond the hold period */
+    if (guac_audio_dsp_peak(samples, frames * channels)
+            <= GUAC_AUDIO_DSP_SILENCE_THRESHOLD) {
+
+        dsp->silent_frames += frames;
+        if (dsp->silent_frames >= GUAC_AUDIO_DSP_SILENCE_HOLD
+                * audio->rate / 1000) {
+
+            /* Send any audio preceding the silence immediately */
+            if (dsp->start != 0 && audio->encoder->flush_handler)
+                audio->encoder->flush_handler(audio);
+
+            /* Keep resampler aligned with the dropped input */
+            if (dsp->resample)
+                guac_audio_resampler_skip(&dsp->resampler, frames);
+
+            dsp->silent_frames = GUAC_AUDIO_DSP_SILENCE_HOLD
+                * audio->rate / 1000;
+            dsp->start = 0;
+            return;
+
+        }
+
+    }
+    else
+        dsp->silent_frames = 0;
+
+    /* Resample if necessary */
+    if (dsp->resample) {
+        frames = guac_audio_resampler_process(&dsp->resampler, dsp->samples,
+                frames, dsp->resampled);
+        samples = dsp->resampled;
+    }
+
+    /* Restart the timeline if previously idle or behind real time */
+    guac_timestamp now = guac_timestamp_current();
+    guac_timestamp end = dsp->start
+        + dsp->sent_frames * 1000 / dsp->rate;
+
+    if (dsp->start == 0 || end < now) {
+        dsp->start = now;
+        dsp->sent_frames = 0;
+        end = now;
+    }
+
+    /* Drop audio which would play too far ahead of the client */
+    if (*lag < 0)
+        *lag = guac_client_get_processing_lag(audio->client);
+
+    if (end - now + *lag > GUAC_AUDIO_DSP_MAX_LEAD)
+        return;
+
+    int length = guac_audio_dsp_pack(audio, samples, frames * channels,
+            dsp->output);
+
+    audio->encoder->write_handler(audio, dsp->output, length);
+    dsp->sent_frames += frames;
+
+}
+
+guac_audio_dsp* guac_audio_dsp_alloc() {
+    return calloc(1, sizeof(guac_audio_dsp));
+}
+
+void guac_audio_dsp_reset(guac_audio_stream* audio, int rate, int channels) {
+
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
+
+    if (dsp->resample)
+        guac_audio_resampler_free(&dsp->resampler);
+
+    /* Fall back to the rate of the stream if the resampler cannot be
+     * initialized */
+    dsp->resample = (rate != audio->rate);
+    if (dsp->resample && guac_audio_resampler_init(&dsp->resampler,
+                channels, audio->rate, rate, GUAC_AUDIO_DSP_BLOCK_SIZE)) {
+        guac_client_log(audio->client, GUAC_LOG_WARNING, "Unable to "
+                "initialize resampler. Audio will be sent at %i Hz rather "
+                "than %i Hz.", audio->rate, rate);
+        dsp->resample = 0;
+        rate = audio->rate;
+    }
+
+    dsp->rate = rate;
+    dsp->channels = channels;
+
+    /* Reallocate buffers for new format */
+    int max_output = GUAC_AUDIO_DSP_BLOCK_SIZE;
+    if (dsp->resample)
+        max_output = guac_audio_resampler_max_output(&dsp->resampler,
+                GUAC_AUDIO_DSP_BLOCK_SIZE);
+
+    free(dsp->samples);
+    free(dsp->resampled);
+    free(dsp->output);
+
+    dsp->samples = malloc(sizeof(int16_t) * channels
+            * GUAC_AUDIO_DSP_BLOCK_SIZE);
+    dsp->resampled = malloc(sizeof(int16_t) * channels * max_output);
+    dsp->output = malloc(sizeof(int16_t) * channels * max_output);
+
+    /* Pass PCM data through unmodified if the buffers cannot be allocated */
+    if (dsp->samples == NULL || dsp->resampled == NULL
+            || dsp->output == NULL) {
+
+        guac_client_log(audio->client, GUAC_LOG_WARNING, "Unable to "
+                "allocate audio processing buffers. Audio will be sent "
+                "unprocessed.");
+
+        if (dsp->resample)
+            guac_audio_resampler_free(&dsp->resampler);
+
+        free(dsp->samples);
+        free(dsp->resampled);
+        free(dsp->output);
+
+        dsp->samples = NULL;
+        dsp->resampled = NULL;
+        dsp->output = NULL;
+        dsp->resample = 0;
+        dsp->rate = audio->rate;
+        dsp->channels = audio->channels;
+
+    }
+
+    dsp->partial_length = 0;
+    dsp->silent_frames = 0;
+    dsp->start = 0;
+    dsp->sent_frames = 0;
+
+}
+
+void guac_audio_dsp_write(guac_audio_stream* audio,
+        const unsigned char* data, int length) {
+
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
+    int frame_size = audio->channels * audio->bps / 8;
+    int lag = -1;
+
+    /* Pass PCM data through unmodified if no buffers could be allocated */
+    if (dsp->samples == NULL) {
+        audio->encoder->write_handler(audio, data, length);
+        return;
+    }
+
+    /* Complete any frame split across writes */
+    if (dsp->partial_length > 0) {
+
+        int remaining = frame_size - dsp->partial_length;
+        if (remaining > length)
+            remaining = length;
+
+        memcpy(dsp->partial + dsp->partial_length, data, remaining);
+        dsp->partial_length += remaining;
+        data += remaining;
+        length -= remaining;
+
+        if (dsp->partial_length < frame_size)
+            return;
+
+        guac_audio_dsp_process(audio, dsp->partial, 1, &lag);
+        dsp->partial_length = 0;
+
+    }
+
+    /* Process all complete frames in blocks */
+    while (length >= frame_size) {
+
+        int frames = length / frame_size;
+        if (frames > GUAC_AUDIO_DSP_BLOCK_SIZE)
+            frames = GUAC_AUDIO_DSP_BLOCK_SIZE;
+
+        guac_audio_dsp_process(audio, data, frames, &lag);
+        data += frames * frame_size;
+        length -= frames * frame_size;
+
+    }
+
+    /* Retain any trailing partial frame */
+    memcpy(dsp->partial, data, length);
+    dsp->partial_length = length;
+
+}
+
+void guac_audio_dsp_free(guac_audio_dsp* dsp) {
+
+    if (dsp->resample)
+        guac_audio_resampler_free(&dsp->resampler);
+
+    free(dsp->samples);
+    free(dsp->resampled);
+    free(dsp->output);
+    free(dsp);
+}
+
@@ -0,0 +1,234 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_AUDIO_DSP_H
+#define GUAC_AUDIO_DSP_H
+
+#include "config.h"
+
+#include "guacamole/audio.h"
+#include "guacamole/audio-resampler.h"
+#include "guacamole/timestamp-types.h"
+
+#include <stdint.h>
+
+/**
+ * The maximum number of frames of PCM data (one sample for each channel)
+ * processed at once. Larger writes are processed in blocks of this size.
+ */
+#define GUAC_AUDIO_DSP_BLOCK_SIZE 1024
+
+/**
+ * The lowest rate that PCM data will be resampled to, in samples per second,
+ * regardless of the rate requested by the user.
+ */
+#define GUAC_AUDIO_DSP_MIN_RATE 8000
+
+/**
+ * The peak absolute value of 16-bit samples at or below which audio is
+ * considered silent. This is roughly -60 dBFS, well below anything audible
+ * over typical playback, but above the dither and noise floor of most
+ * sources.
+ */
+#define GUAC_AUDIO_DSP_SILENCE_THRESHOLD 32
+
+/**
+ * The amount of continuous silence which must be received before silent
+ * audio is dropped, in milliseconds. Brief silence, such as the quiet
+ * between notes or words, is always sent, such that only genuinely idle
+ * audio is suppressed.
+ */
+#define GUAC_AUDIO_DSP_SILENCE_HOLD 250
+
+/**
+ * The maximum amount of audio which may be sent ahead of real time, in
+ * milliseconds, including the processing lag of connected users. Audio
+ * received beyond this point is dropped rather than being allowed to build
+ * latency within the client.
+ */
+#define GUAC_AUDIO_DSP_MAX_LEAD 1000
+
+/**
+ * The processing applied to all PCM data written to a guac_audio_stream
+ * before that data is passed to the stream's encoder. PCM data is converted
+ * to 16-bit samples, downmixed and resampled to the format requested by the
+ * user for whom the encoder was selected, dropped if silent or if too far
+ * ahead of real time, and converted back to the bits per sample of the
+ * stream. This processing stage is private to libguac, and is associated
+ * with each guac_audio_stream by guac_audio_stream_alloc().
+ */
+typedef struct guac_audio_dsp {
+
+    /**
+     * The number of samples per second of PCM data provided to the encoder.
+     * This will differ from the rate of the PCM data sent to the stream if
+     * the user for whom the encoder was selected requested a lower rate, or
+     * if the encoder does not support that rate.
+     */
+    int rate;
+
+    /**
+     * The number of audio channels per sample of PCM data provided to the
+     * encoder. This will differ from the number of channels of the PCM data
+     * sent to the stream if the user for whom the encoder was selected
+     * requested mono audio.
+     */
+    int channels;
+
+    /**
+     * The maximum rate requested by the user for whom the encoder was
+     * selected, in samples per second, or zero if no limit was requested.
+     */
+    int max_rate;
+
+    /**
+     * The maximum number of channels requested by the user for whom the
+     * encoder was selected, or zero if no limit was requested.
+     */
+    int max_channels;
+
+    /**
+     * Whether resampling is required.
+     */
+    int resample;
+
+    /**
+     * The resampler converting from the rate of the stream to the rate
+     * provided to the encoder. This resampler is initialized only if
+     * resampling is required.
+     */
+    guac_audio_resampler resampler;
+
+    /**
+     * Any trailing bytes of the PCM data most recently written which did
+     * not form a complete frame.
+     */
+    unsigned char partial[4];
+
+    /**
+     * The number of bytes stored within the partial buffer.
+     */
+    int partial_length;
+
+    /**
+     * The current block of PCM data, converted to 16-bit samples and
+     * downmixed.
+     */
+    int16_t* samples;
+
+    /**
+     * The current block of PCM data after resampling.
+     */
+    int16_t* resampled;
+
+    /**
+     * The current block of PCM data in the format expected by the encoder.
+     */
+    unsigned char* output;
+
+    /**
+     * The number of consecutive frames of silence received.
+     */
+    int silent_frames;
+
+    /**
+     * The time at which the first frame passed to the encoder since the
+     * stream last fell behind or went silent was sent, or zero if no such
+     * frame has yet been sent.
+     */
+    guac_timestamp start;
+
+    /**
+     * The number of frames passed to the encoder since the start timestamp.
+     */
+    int64_t sent_frames;
+
+} guac_audio_dsp;
+
+/**
+ * Returns the processing stage of the given audio stream.
+ *
+ * @param audio
+ *     The audio stream whose processing stage should be returned. This
+ *     stream must have been allocated with guac_audio_stream_alloc().
+ *
+ * @return
+ *     The processing stage of the given audio stream.
+ */
+guac_audio_dsp* guac_audio_stream_get_dsp(guac_audio_stream* audio);
+
+/**
+ * Allocates a new processing stage for an audio stream. The stage must be
+ * configured with guac_audio_dsp_reset() before PCM data is written.
+ *
+ * @return
+ *     A newly-allocated guac_audio_dsp.
+ */
+guac_audio_dsp* guac_audio_dsp_alloc();
+
+/**
+ * Reconfigures the processing stage of the given audio stream such that PCM
+ * data in the current format of that stream is converted to the given rate
+ * and number of channels, storing those values as the rate and channels of
+ * the processing stage. This function must be invoked whenever
+ * the PCM format of the stream changes, and before the stream's encoder
+ * begins. If the buffers required for processing cannot be allocated, PCM
+ * data is instead passed to the encoder unmodified, and the rate and channels
+ * of the processing stage are set to those of the stream.
+ *
+ * @param audio
+ *     The audio stream whose processing stage should be reconfigured.
+ *
+ * @param rate
+ *     The rate of the PCM data to provide to the encoder, in samples per
+ *     second.
+ *
+ * @param channels
+ *     The number of channels of the PCM data to provide to the encoder.
+ *     This may not exceed the number of channels of the stream.
+ */
+void guac_audio_dsp_reset(guac_audio_stream* audio, int rate, int channels);
+
+/**
+ * Processes the given PCM data, passing the result to the encoder of the
+ * given audio stream. The PCM data must be in the format of the audio
+ * stream, and need not consist of complete frames.
+ *
+ * @param audio
+ *     The audio stream receiving the PCM data.
+ *
+ * @param data
+ *     The PCM data to process.
+ *
+ * @param length
+ *     The number of bytes of PCM data to process.
+ */
+void guac_audio_dsp_write(guac_audio_stream* audio,
+        const unsigned char* data, int length);
+
+/**
+ * Frees the given processing stage.
+ *
+ * @param dsp
+ *     The guac_audio_dsp to free.
+ */
+void guac_audio_dsp_free(guac_audio_dsp* dsp);
+
+#endif
+
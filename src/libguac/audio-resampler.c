@@ -0,0 +1,281 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/audio-resampler.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Returns the greatest common divisor of the given positive integers.
+ *
+ * @param a
+ *     The first integer.
+ *
+ * @param b
+ *     The second integer.
+ *
+ * @return
+ *     The greatest common divisor of a and b.
+ */
+static int guac_audio_resampler_gcd(int a, int b) {
+
+    while (b != 0) {
+        int remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+
+    return a;
+
+}
+
+int guac_audio_resampler_init(guac_audio_resampler* resampler,
+        int channels, int input_rate, int output_rate, int max_frames) {
+
+    /* Input frames must not be skipped entirely when downsampling */
+    int ratio = (input_rate + output_rate - 1) / output_rate;
+    if (ratio > GUAC_AUDIO_RESAMPLER_MAX_TAPS)
+        return 1;
+
+    int gcd = guac_audio_resampler_gcd(input_rate, output_rate);
+    resampler->channels = channels;
+    resampler->max_frames = max_frames;
+    resampler->in_rate = input_rate / gcd;
+    resampler->out_rate = output_rate / gcd;
+
+    resampler->phases = resampler->out_rate;
+    if (resampler->phases > GUAC_AUDIO_RESAMPLER_MAX_PHASES)
+        resampler->phases = GUAC_AUDIO_RESAMPLER_MAX_PHASES;
+
+    /* Cutoff relative to input Nyquist frequency, lengthening the filter in
+     * proportion when downsampling such that it spans the same duration */
+    double cutoff = 0.95;
+    int taps = GUAC_AUDIO_RESAMPLER_TAPS;
+    if (output_rate < input_rate) {
+
+        cutoff *= (double) output_rate / input_rate;
+
+        taps = ratio > GUAC_AUDIO_RESAMPLER_MAX_TAPS
+                / GUAC_AUDIO_RESAMPLER_TAPS
+            ? GUAC_AUDIO_RESAMPLER_MAX_TAPS
+            : GUAC_AUDIO_RESAMPLER_TAPS * ratio;
+
+    }
+
+    resampler->taps = taps;
+    resampler->filter = malloc(sizeof(int16_t) * taps * resampler->phases);
+    resampler->history = calloc(taps + max_frames,
+            sizeof(int16_t) * channels);
+
+    if (resampler->filter == NULL || resampler->history == NULL) {
+        guac_audio_resampler_free(resampler);
+        return 1;
+    }
+
+    double weights[GUAC_AUDIO_RESAMPLER_MAX_TAPS];
+    for (int phase = 0; phase < resampler->phases; phase++) {
+
+        double sum = 0;
+        double fraction = (double) phase / resampler->phases;
+
+        /* Calculate weight of each tap relative to the output frame, which
+         * lies between the middle two taps */
+        for (int tap = 0; tap < taps; tap++) {
+
+            double t = tap - (taps / 2 - 1) - fraction;
+            double x = M_PI * cutoff * t;
+
+            double sinc = (x == 0) ? 1.0 : sin(x) / x;
+            double window = 0.42 + 0.5 * cos(2 * M_PI * t / taps)
+                                 + 0.08 * cos(4 * M_PI * t / taps);
+
+            weights[tap] = sinc * window;
+            sum += weights[tap];
+
+        }
+
+        /* Store normalized, fixed-point coefficients */
+        for (int tap = 0; tap < taps; tap++)
+            resampler->filter[phase * taps + tap] = lround(weights[tap] / sum
+                    * (1 << GUAC_AUDIO_RESAMPLER_FILTER_BITS));
+
+    }
+
+    /* Begin with silence preceding the first frame, such that the first
+     * output frame aligns with the first input frame */
+    resampler->history_frames = taps / 2 - 1;
+    resampler->position = 0;
+
+    return 0;
+
+}
+
+void guac_audio_resampler_free(guac_audio_resampler* resampler) {
+
+    free(resampler->filter);
+    free(resampler->history);
+
+    resampler->filter = NULL;
+    resampler->history = NULL;
+
+}
+
+int guac_audio_resampler_max_output(guac_audio_resampler* resampler,
+        int frames) {
+    return (int64_t) (frames + resampler->taps) * resampler->out_rate
+        / resampler->in_rate + 1;
+}
+
+/**
+ * Produces as many output frames as possible from the frames within the
+ * history buffer of the given resampler, retaining only those frames still
+ * required for future output. The number of channels is given as a
+ * parameter such that the compiler may produce a dedicated filter loop for
+ * each supported number of channels.
+ *
+ * @param resampler
+ *     The resampler to use.
+ *
+ * @param channels
+ *     The number of channels within each frame.
+ *
+ * @param output
+ *     The buffer to receive all output frames.
+ *
+ * @return
+ *     The number of frames written to the output buffer.
+ */
+static inline int guac_audio_resampler_filter(
+        guac_audio_resampler* resampler, const int channels,
+        int16_t* output) {
+
+    const int taps = resampler->taps;
+    int16_t* history = resampler->history;
+
+    int in_rate = resampler->in_rate;
+    int out_rate = resampler->out_rate;
+    int phases = resampler->phases;
+    int position = resampler->position;
+
+    int base = 0;
+    int count = 0;
+
+    while (base + taps <= resampler->history_frames) {
+
+        /* Select filter phase closest to position of output frame */
+        int phase = (phases == out_rate) ? position
+            : (int64_t) position * phases / out_rate;
+
+        const int16_t* coefficients = resampler->filter + phase * taps;
+        const int16_t* frame = history + base * channels;
+
+        for (int channel = 0; channel < channels; channel++) {
+
+            int32_t sum = 0;
+            for (int tap = 0; tap < taps; tap++)
+                sum += frame[tap * channels + channel] * coefficients[tap];
+
+            /* Round and clamp to 16-bit range */
+            sum = (sum + (1 << (GUAC_AUDIO_RESAMPLER_FILTER_BITS - 1)))
+                >> GUAC_AUDIO_RESAMPLER_FILTER_BITS;
+
+            sum = sum > INT16_MAX ? INT16_MAX : sum;
+            sum = sum < INT16_MIN ? INT16_MIN : sum;
+
+            *(output++) = sum;
+
+        }
+
+        /* Advance to next output frame */
+        position += in_rate;
+        base += position / out_rate;
+        position %= out_rate;
+        count++;
+
+    }
+
+    /* Retain only frames not yet fully consumed */
+    resampler->history_frames -= base;
+    memmove(history, history + base * channels,
+            sizeof(int16_t) * channels * resampler->history_frames);
+
+    resampler->position = position;
+    return count;
+
+}
+
+int guac_audio_resampler_process(guac_audio_resampler* resampler,
+        const int16_t* input, int frames, int16_t* output) {
+
+    int channels = resampler->channels;
+
+    /* Append input to any frames retained from previous blocks */
+    memcpy(resampler->history + resampler->history_frames * channels, input,
+            sizeof(int16_t) * channels * frames);
+    resampler->history_frames += frames;
+
+    if (channels == 1)
+        return guac_audio_resampler_filter(resampler, 1, output);
+
+    return guac_audio_resampler_filter(resampler, 2, output);
+
+}
+
+void guac_audio_resampler_skip(guac_audio_resampler* resampler, int frames) {
+
+    int channels = resampler->channels;
+    int taps = resampler->taps;
+    int64_t in_rate = resampler->in_rate;
+    int64_t out_rate = resampler->out_rate;
+
+    /* Total frames available had the silence been appended */
+    int64_t available = (int64_t) resampler->history_frames + frames;
+
+    /* Number of output frames which that input would have produced, each
+     * requiring all taps to be available */
+    int64_t limit = (available - taps + 1) * out_rate - resampler->position;
+    int64_t count = limit > 0 ? (limit + in_rate - 1) / in_rate : 0;
+
+    /* Advance past the input consumed by those output frames */
+    int64_t offset = resampler->position + count * in_rate;
+    int64_t base = offset / out_rate;
+    resampler->position = offset % out_rate;
+
+    /* Retain any frames preceding the silence which are still required,
+     * followed by silence */
+    int retained = base < resampler->history_frames
+        ? resampler->history_frames - base : 0;
+
+    memmove(resampler->history,
+            resampler->history + (resampler->history_frames - retained)
+                * channels,
+            sizeof(int16_t) * channels * retained);
+
+    resampler->history_frames = available - base;
+    memset(resampler->history + retained * channels, 0,
+            sizeof(int16_t) * channels
+            * (resampler->history_frames - retained));
+
+}
+
@@ -19,6 +19,7 @@
 
 #include "config.h"
 
+#include "audio-dsp.h"
 #include "guacamole/audio.h"
 #include "guacamole/client.h"
 #include "guacamole/protocol.h"
@@ -26,13 +27,44 @@
 #include "guacamole/user.h"
 #include "raw_encoder.h"
 
+#ifdef ENABLE_OPUS
+#include "opus_encoder.h"
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * A guac_audio_stream along with the state of that stream which is private
+ * to libguac. Each guac_audio_stream allocated by guac_audio_stream_alloc()
+ * is actually the first member of one of these structures, such that the
+ * layout of guac_audio_stream itself need not expose that state.
+ */
+typedef struct guac_audio_stream_internal {
+
+    /**
+     * The public portion of the audio stream. This MUST be the first member
+     * of this structure.
+     */
+    guac_audio_stream audio;
+
+    /**
+     * The processing applied to all PCM data written to the audio stream
+     * before that data is passed to the stream's encoder.
+     */
+    guac_audio_dsp* dsp;
+
+} guac_audio_stream_internal;
+
+guac_audio_dsp* guac_audio_stream_get_dsp(guac_audio_stream* audio) {
+    return ((guac_audio_stream_internal*) audio)->dsp;
+}
+
 /**
  * Sets the encoder associated with the given guac_audio_stream, automatically
- * invoking its begin_handler. The guac_audio_stream MUST NOT already be
- * associated with an encoder.
+ * reconfiguring the stream's processing stage for the format accepted by
+ * that encoder and invoking its begin_handler. The guac_audio_stream MUST NOT
+ * already be associated with an encoder.
  *
  * @param audio
  *     The guac_audio_stream whose encoder is being set.
@@ -43,6 +75,30 @@
 static void guac_audio_stream_set_encoder(guac_audio_stream* audio,
         guac_audio_encoder* encoder) {
 
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
+
+    int rate = audio->rate;
+    int channels = audio->channels;
+
+    /* Apply any limits requested by the user, within reason */
+    if (dsp->max_rate > 0 && dsp->max_rate < rate)
+        rate = dsp->max_rate;
+
+    if (rate < GUAC_AUDIO_DSP_MIN_RATE)
+        rate = audio->rate < GUAC_AUDIO_DSP_MIN_RATE
+            ? audio->rate : GUAC_AUDIO_DSP_MIN_RATE;
+
+    if (dsp->max_channels > 0 && dsp->max_channels < channels)
+        channels = dsp->max_channels;
+
+#ifdef ENABLE_OPUS
+    /* Opus supports only specific rates */
+    if (encoder == opus_encoder)
+        rate = guac_opus_encoder_get_rate(rate);
+#endif
+
+    guac_audio_dsp_reset(audio, rate, channels);
+
     /* Call handler, if defined */
     if (encoder != NULL && encoder->begin_handler)
         encoder->begin_handler(audio);
@@ -52,11 +108,70 @@ static void guac_audio_stream_set_encoder(guac_audio_stream* audio,
 
 }
 
+/**
+ * Tests whether the given audio mimetype, as declared by a user, refers to
+ * the given type of audio. The declared mimetype may contain "rate" and
+ * "channels" parameters, such as "audio/L16;rate=22050,channels=1", which
+ * denote the maximum rate and number of channels the user wishes to receive.
+ * The values of any such parameters are stored in the given integers, which
+ * are otherwise left untouched.
+ *
+ * @param mimetype
+ *     The audio mimetype declared by the user.
+ *
+ * @param type
+ *     The mimetype of the audio produced by an encoder, without parameters.
+ *
+ * @param rate
+ *     Pointer to an integer which should receive the value of the "rate"
+ *     parameter, if present.
+ *
+ * @param channels
+ *     Pointer to an integer which should receive the value of the "channels"
+ *     parameter, if present.
+ *
+ * @return
+ *     Non-zero if the declared mimetype refers to the given type of audio,
+ *     zero otherwise.
+ */
+static int guac_audio_mimetype_matches(const char* mimetype,
+        const char* type, int* rate, int* channels) {
+
+    size_t length = strlen(type);
+
+    /* Type must match exactly, ignoring parameters */
+    if (strncmp(mimetype, type, length) != 0)
+        return 0;
+
+    const char* params = mimetype + length;
+    if (*params != '\0' && *params != ';')
+        return 0;
+
+    /* Parse any parameters */
+    while (*params != '\0') {
+
+        params++;
+
+        if (strncmp(params, "rate=", 5) == 0)
+            *rate = atoi(params + 5);
+
+        else if (strncmp(params, "channels=", 9) == 0)
+            *channels = atoi(params + 9);
+
+        params += strcspn(params, ";,");
+
+    }
+
+    return 1;
+
+}
+
 /**
  * Assigns a new audio encoder to the given guac_audio_stream based on the
  * audio mimetypes declared as supported by the given user. If no audio encoder
  * can be found, no new audio encoder is assigned, and the existing encoder is
- * left untouched (if any).
+ * left untouched (if any). Any limits on rate or channels declared along with
+ * the matching mimetype are applied to the audio stream.
  *
  * @param user
  *     The user whose supported audio mimetypes should determine the audio
@@ -76,6 +191,7 @@ static void* guac_audio_assign_encoder(guac_user* user, void* data) {
     int i;
 
     guac_audio_stream* audio = (guac_audio_stream*) data;
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
     int bps = audio->bps;
 
     /* If no user is provided, or an encoder has already been assigned,
@@ -83,19 +199,38 @@ static void* guac_audio_assign_encoder(guac_user* user, void* data) {
     if (user == NULL || audio->encoder != NULL)
         return audio->encoder;
 
-    /* For each supported mimetype, check for an associated encoder */
+    /* Ignore users which do not support audio at all */
+    if (user->info.audio_mimetypes == NULL)
+        return audio->encoder;
+
+    /* Assign the encoder of the first supported mimetype, honoring the
+     * order of preference declared by the user */
     for (i=0; user->info.audio_mimetypes[i] != NULL; i++) {
 
         const char* mimetype = user->info.audio_mimetypes[i];
 
+#ifdef ENABLE_OPUS
+        /* Opus encodes only 16-bit PCM */
+        if (bps == 16 && guac_audio_mimetype_matches(mimetype,
+                    opus_encoder->mimetype, &dsp->max_rate,
+                    &dsp->max_channels)) {
+            guac_audio_stream_set_encoder(audio, opus_encoder);
+            break;
+        }
+#endif
+
         /* If 16-bit raw audio is supported, done. */
-        if (bps == 16 && strcmp(mimetype, raw16_encoder->mimetype) == 0) {
+        if (bps == 16 && guac_audio_mimetype_matches(mimetype,
+                    raw16_encoder->mimetype, &dsp->max_rate,
+                    &dsp->max_channels)) {
             guac_audio_stream_set_encoder(audio, raw16_encoder);
             break;
         }
 
         /* If 8-bit raw audio is supported, done. */
-        if (bps == 8 && strcmp(mimetype, raw8_encoder->mimetype) == 0) {
+        if (bps == 8 && guac_audio_mimetype_matches(mimetype,
+                    raw8_encoder->mimetype, &dsp->max_rate,
+                    &dsp->max_channels)) {
             guac_audio_stream_set_encoder(audio, raw8_encoder);
             break;
         }
@@ -110,16 +245,29 @@ static void* guac_audio_assign_encoder(guac_user* user, void* data) {
 guac_audio_stream* guac_audio_stream_alloc(guac_client* client,
         guac_audio_encoder* encoder, int rate, int channels, int bps) {
 
+    guac_audio_stream_internal* internal;
     guac_audio_stream* audio;
 
     /* Allocate stream */
-    audio = (guac_audio_stream*) calloc(1, sizeof(guac_audio_stream));
+    internal = calloc(1, sizeof(guac_audio_stream_internal));
+    if (internal == NULL)
+        return NULL;
+
+    audio = &internal->audio;
     audio->client = client;
     audio->stream = guac_client_alloc_stream(client);
 
     /* Abort allocation if underlying stream cannot be allocated */
     if (audio->stream == NULL) {
-        free(audio);
+        free(internal);
+        return NULL;
+    }
+
+    /* Abort allocation if processing stage cannot be allocated */
+    internal->dsp = guac_audio_dsp_alloc();
+    if (internal->dsp == NULL) {
+        guac_client_free_stream(client, audio->stream);
+        free(internal);
         return NULL;
     }
 
@@ -128,6 +276,9 @@ guac_audio_stream* guac_audio_stream_alloc(guac_client* client,
     audio->channels = channels;
     audio->bps = bps;
 
+    /* Pass PCM through unmodified until an encoder is assigned */
+    guac_audio_dsp_reset(audio, rate, channels);
+
     /* Assign encoder if explicitly provided */
     if (encoder != NULL)
         guac_audio_stream_set_encoder(audio, encoder);
@@ -198,16 +349,17 @@ void guac_audio_stream_free(guac_audio_stream* audio) {
     guac_client_free_stream(audio->client, audio->stream);
 
     /* Free associated data */
-    free(audio);
+    guac_audio_dsp_free(guac_audio_stream_get_dsp(audio));
+    free((guac_audio_stream_internal*) audio);
 
 }
 
 void guac_audio_stream_write_pcm(guac_audio_stream* audio, 
         const unsigned char* data, int length) {
 
-    /* Write data */
+    /* Process and write data */
     if (audio->encoder != NULL && audio->encoder->write_handler)
-        audio->encoder->write_handler(audio, data, length);
+        guac_audio_dsp_write(audio, data, length);
 
 }
 
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_AUDIO_RESAMPLER_CONSTANTS_H
+#define GUAC_AUDIO_RESAMPLER_CONSTANTS_H
+
+/**
+ * Constants related to the resampling of 16-bit PCM audio.
+ *
+ * @file audio-resampler-constants.h
+ */
+
+/**
+ * The number of taps of the resampling filter for each multiple by which the
+ * input rate exceeds the output rate. Each output frame is thus calculated
+ * from input spanning the same duration, regardless of the ratio between
+ * rates.
+ */
+#define GUAC_AUDIO_RESAMPLER_TAPS 16
+
+/**
+ * The maximum number of taps of the resampling filter. If the input rate
+ * exceeds the output rate by more than this many multiples of
+ * GUAC_AUDIO_RESAMPLER_TAPS, the filter is shortened, weakening its
+ * attenuation of frequencies above the output Nyquist frequency. Input rates
+ * exceeding the output rate by more than this many multiples cannot be
+ * resampled at all.
+ */
+#define GUAC_AUDIO_RESAMPLER_MAX_TAPS 256
+
+/**
+ * The number of fractional bits within each coefficient of the resampling
+ * filter. This leaves sufficient headroom for filter output to be accumulated
+ * in 32 bits.
+ */
+#define GUAC_AUDIO_RESAMPLER_FILTER_BITS 14
+
+/**
+ * The maximum number of phases of the resampling filter. If the ratio between
+ * the input and output rates cannot be represented exactly within this many
+ * phases, the fractional position of each output frame is quantized to the
+ * nearest available phase.
+ */
+#define GUAC_AUDIO_RESAMPLER_MAX_PHASES 256
+
+#endif
+
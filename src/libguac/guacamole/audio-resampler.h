@@ -0,0 +1,201 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_AUDIO_RESAMPLER_H
+#define GUAC_AUDIO_RESAMPLER_H
+
+/**
+ * Provides functions and structures for resampling interleaved 16-bit PCM
+ * audio from one rate to another.
+ *
+ * @file audio-resampler.h
+ */
+
+#include "audio-resampler-constants.h"
+#include "audio-types.h"
+
+#include <stdint.h>
+
+/**
+ * Polyphase resampler for interleaved 16-bit PCM, using a Blackman-windowed
+ * sinc filter whose cutoff lies just below the lower of the input and output
+ * Nyquist frequencies. When downsampling, the filter thus also removes
+ * frequencies which could not be represented at the output rate, rather than
+ * allowing those frequencies to alias.
+ */
+struct guac_audio_resampler {
+
+    /**
+     * The number of channels within each frame.
+     */
+    int channels;
+
+    /**
+     * The number of taps within each phase of the filter.
+     */
+    int taps;
+
+    /**
+     * The filter coefficients of each phase, stored consecutively with taps
+     * coefficients per phase.
+     */
+    int16_t* filter;
+
+    /**
+     * The number of phases within the filter.
+     */
+    int phases;
+
+    /**
+     * The input rate divided by the greatest common divisor of the input and
+     * output rates.
+     */
+    int in_rate;
+
+    /**
+     * The output rate divided by the greatest common divisor of the input and
+     * output rates.
+     */
+    int out_rate;
+
+    /**
+     * The fractional position of the next output frame between two input
+     * frames, in units of 1/out_rate input frames.
+     */
+    int position;
+
+    /**
+     * The maximum number of frames which may be provided in a single call to
+     * guac_audio_resampler_process().
+     */
+    int max_frames;
+
+    /**
+     * Received frames awaiting filtering, with the first frame being the
+     * first filter tap of the next output frame. This buffer has space for
+     * taps + max_frames frames.
+     */
+    int16_t* history;
+
+    /**
+     * The number of frames currently stored within the history buffer.
+     */
+    int history_frames;
+
+};
+
+/**
+ * Initializes the given resampler for converting interleaved 16-bit PCM
+ * from one rate to another, calculating the coefficients of each phase of
+ * its filter. The resampler must eventually be freed with
+ * guac_audio_resampler_free() if initialization succeeds.
+ *
+ * @param resampler
+ *     The resampler to initialize.
+ *
+ * @param channels
+ *     The number of channels within each frame. Legal values are 1 or 2.
+ *
+ * @param input_rate
+ *     The rate of the PCM data provided to the resampler, in samples per
+ *     second.
+ *
+ * @param output_rate
+ *     The rate of the PCM data produced by the resampler, in samples per
+ *     second.
+ *
+ * @param max_frames
+ *     The maximum number of frames which will be provided in a single call
+ *     to guac_audio_resampler_process().
+ *
+ * @return
+ *     Zero if the resampler was initialized successfully, non-zero if the
+ *     input rate exceeds the output rate by more than
+ *     GUAC_AUDIO_RESAMPLER_MAX_TAPS multiples or insufficient memory is
+ *     available.
+ */
+int guac_audio_resampler_init(guac_audio_resampler* resampler,
+        int channels, int input_rate, int output_rate, int max_frames);
+
+/**
+ * Frees all memory associated with the given resampler. The resampler must
+ * be reinitialized with guac_audio_resampler_init() before further use.
+ *
+ * @param resampler
+ *     The resampler to free.
+ */
+void guac_audio_resampler_free(guac_audio_resampler* resampler);
+
+/**
+ * Returns the maximum number of frames which guac_audio_resampler_process()
+ * may produce from the given number of input frames.
+ *
+ * @param resampler
+ *     The resampler that will be used.
+ *
+ * @param frames
+ *     The number of input frames.
+ *
+ * @return
+ *     The maximum number of output frames.
+ */
+int guac_audio_resampler_max_output(guac_audio_resampler* resampler,
+        int frames);
+
+/**
+ * Resamples the given block of interleaved 16-bit PCM, continuing from the
+ * frames of any previous blocks.
+ *
+ * @param resampler
+ *     The resampler to use.
+ *
+ * @param input
+ *     The PCM data to resample.
+ *
+ * @param frames
+ *     The number of frames of PCM data within the input buffer. This may not
+ *     exceed the max_frames value given when the resampler was initialized.
+ *
+ * @param output
+ *     The buffer to receive the resampled PCM data, which must have space
+ *     for at least the number of frames returned by
+ *     guac_audio_resampler_max_output().
+ *
+ * @return
+ *     The number of frames written to the output buffer.
+ */
+int guac_audio_resampler_process(guac_audio_resampler* resampler,
+        const int16_t* input, int frames, int16_t* output);
+
+/**
+ * Advances the given resampler past the given number of frames of silence
+ * without producing output, as if those frames had been resampled and the
+ * result discarded. Subsequent output thus remains aligned with the input,
+ * and is not filtered together with input preceding the silence.
+ *
+ * @param resampler
+ *     The resampler to advance.
+ *
+ * @param frames
+ *     The number of frames of silence to skip.
+ */
+void guac_audio_resampler_skip(guac_audio_resampler* resampler, int frames);
+
+#endif
+
@@ -38,5 +38,10 @@ typedef struct guac_audio_stream guac_audio_stream;
  */
 typedef struct guac_audio_encoder guac_audio_encoder;
 
+/**
+ * Resampler which converts interleaved 16-bit PCM from one rate to another.
+ */
+typedef struct guac_audio_resampler guac_audio_resampler;
+
 #endif
 
@@ -128,7 +128,11 @@ struct guac_audio_stream {
  *     The guac_client for which this audio stream is being allocated. The
  *     connection owner is given priority when determining the level of audio
  *     support. It is currently assumed that all other joining users on the
- *     connection will have the same level of audio support.
+ *     connection will have the same level of audio support. A user may
+ *     request a lower rate or mono audio by declaring support for an audio
+ *     mimetype with "rate" or "channels" parameters, such as
+ *     "audio/L16;rate=22050,channels=1", in which case the PCM data is
+ *     converted to that format before being encoded.
  *
  * @param encoder
  *     The guac_audio_encoder to use when encoding audio, or NULL if libguac
@@ -208,7 +212,11 @@ void guac_audio_stream_free(guac_audio_stream* stream);
 /**
  * Writes PCM data to the given audio stream. This PCM data will be
  * automatically encoded by the audio encoder associated with this stream. The
- * PCM data must be 2-channel, 44100 Hz, with signed 16-bit samples.
+ * PCM data must be in the format given when the stream was allocated or last
+ * reset, but need not consist of complete samples. Before being encoded, the
+ * PCM data is resampled and downmixed to the format requested by the user for
+ * whom the encoder was selected, if any. Audio which has been silent for
+ * some time, or which would play too far ahead of the client, is dropped.
  *
  * @param stream
  *     The guac_audio_stream to write PCM data through.
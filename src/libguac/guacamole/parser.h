@@ -162,6 +162,36 @@ void guac_parser_free(guac_parser* parser);
  */
 int guac_parser_read(guac_parser* parser, guac_socket* socket, int usec_timeout);
 
+/**
+ * Parses a single instruction directly from the start of the given buffer,
+ * without copying the instruction into the parser's internal buffer. The
+ * opcode and arguments of the parsed instruction will point into the given
+ * buffer, and thus the buffer must remain valid for as long as the parsed
+ * instruction is in use. The contents of the buffer will be modified, as
+ * each element of the instruction is NULL-terminated in place. This is
+ * intended for parsing instructions from data which is already entirely in
+ * memory, such as a memory-mapped file.
+ *
+ * If an error occurs parsing the instruction, -1 is returned, and guac_error
+ * is set appropriately. If the buffer ends before a complete instruction can
+ * be parsed, guac_error is set to GUAC_STATUS_CLOSED.
+ *
+ * @param parser
+ *     The guac_parser to parse instruction data with.
+ *
+ * @param buffer
+ *     The buffer containing the instruction to parse, starting at the first
+ *     byte of the buffer.
+ *
+ * @param length
+ *     The number of bytes available within the buffer.
+ *
+ * @return
+ *     The number of bytes of the buffer consumed by the parsed instruction,
+ *     or -1 if no complete instruction could be parsed.
+ */
+int guac_parser_parse_buffer(guac_parser* parser, void* buffer, int length);
+
 /**
  * Reads a single instruction from the given guac_socket. This operates
  * identically to guac_parser_read(), except that an error is returned if
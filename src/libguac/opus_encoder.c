@@ -0,0 +1,359 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "audio-dsp.h"
+#include "guacamole/audio.h"
+#include "guacamole/client.h"
+#include "guacamole/protocol.h"
+#include "guacamole/socket.h"
+#include "guacamole/user.h"
+#include "opus_encoder.h"
+
+#include <opus/opus.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Returns whether the given user declared support for Opus-encoded audio.
+ * Users which did not declare such support receive the same audio as raw,
+ * 16-bit PCM.
+ *
+ * @param user
+ *     The user to test.
+ *
+ * @return
+ *     Non-zero if the given user supports Opus, zero otherwise.
+ */
+static int guac_opus_encoder_user_supported(guac_user* user) {
+
+    const char** mimetypes = user->info.audio_mimetypes;
+    size_t length = strlen(opus_encoder->mimetype);
+
+    if (mimetypes == NULL)
+        return 0;
+
+    /* Match type exactly, ignoring any parameters */
+    for (; *mimetypes != NULL; mimetypes++) {
+        const char* mimetype = *mimetypes;
+        if (strncmp(mimetype, opus_encoder->mimetype, length) == 0
+                && (mimetype[length] == '\0' || mimetype[length] == ';'))
+            return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Sends the "audio" instruction describing the given audio stream to the
+ * given user, declaring the stream as Opus if the user supports Opus, and
+ * as raw, 16-bit PCM otherwise.
+ *
+ * @param user
+ *     The user that should receive the "audio" instruction.
+ *
+ * @param data
+ *     The audio stream being described.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_opus_encoder_send_audio(guac_user* user, void* data) {
+
+    guac_audio_stream* audio = (guac_audio_stream*) data;
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
+    char mimetype[256];
+
+    /* Produce mimetype string from format info */
+    if (guac_opus_encoder_user_supported(user))
+        snprintf(mimetype, sizeof(mimetype), "audio/opus;rate=%i,channels=%i",
+                dsp->rate, dsp->channels);
+    else
+        snprintf(mimetype, sizeof(mimetype), "audio/L16;rate=%i,channels=%i",
+                dsp->rate, dsp->channels);
+
+    /* Associate stream */
+    guac_protocol_send_audio(user->socket, audio->stream, mimetype);
+
+    return NULL;
+
+}
+
+/**
+ * Sends the frame most recently encoded by the Opus encoder of the given
+ * audio stream to the given user, either as the encoded packet or, if the
+ * user does not support Opus, as raw, 16-bit PCM.
+ *
+ * @param user
+ *     The user that should receive the frame.
+ *
+ * @param data
+ *     The audio stream whose frame should be sent.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_opus_encoder_send_frame(guac_user* user, void* data) {
+
+    guac_audio_stream* audio = (guac_audio_stream*) data;
+    guac_opus_encoder_state* state = (guac_opus_encoder_state*) audio->data;
+
+    if (guac_opus_encoder_user_supported(user)) {
+        if (state->packet_length > 0)
+            guac_protocol_send_blob(user->socket, audio->stream,
+                    state->packet, state->packet_length);
+        return NULL;
+    }
+
+    /* Convert frame to little-endian PCM only once, and only if needed */
+    int count = state->frame_size * guac_audio_stream_get_dsp(audio)->channels;
+    if (!state->raw_ready) {
+        for (int i = 0; i < count; i++) {
+            state->raw[i * 2]     = state->frame[i] & 0xFF;
+            state->raw[i * 2 + 1] = (state->frame[i] >> 8) & 0xFF;
+        }
+        state->raw_ready = 1;
+    }
+
+    guac_protocol_send_blobs(user->socket, audio->stream, state->raw,
+            count * sizeof(int16_t));
+
+    return NULL;
+
+}
+
+/**
+ * Encodes the frame currently buffered by the Opus encoder of the given audio
+ * stream, sending the resulting packet as a single blob to each user that
+ * supports Opus, and the frame itself as raw PCM to all other users. If the
+ * frame is not yet complete, it is padded with silence.
+ *
+ * @param audio
+ *     The audio stream whose buffered frame should be encoded.
+ */
+static void guac_opus_encoder_encode_frame(guac_audio_stream* audio) {
+
+    guac_opus_encoder_state* state = (guac_opus_encoder_state*) audio->data;
+    int channels = guac_audio_stream_get_dsp(audio)->channels;
+
+    /* Pad incomplete frames with silence */
+    memset(state->frame + state->frame_written * channels, 0,
+            (state->frame_size - state->frame_written) * channels
+            * sizeof(int16_t));
+
+    state->packet_length = 0;
+    if (state->encoder != NULL)
+        state->packet_length = opus_encode(state->encoder, state->frame,
+                state->frame_size, state->packet, sizeof(state->packet));
+
+    state->raw_ready = 0;
+    guac_client_foreach_user(audio->client, guac_opus_encoder_send_frame,
+            audio);
+
+    state->frame_written = 0;
+
+}
+
+/**
+ * Appends a single sample for each channel to the frame currently buffered
+ * by the Opus encoder of the given audio stream, encoding that frame if it
+ * is complete.
+ *
+ * @param audio
+ *     The audio stream whose buffered frame should receive the sample.
+ *
+ * @param sample
+ *     The 16-bit sample of each channel.
+ */
+static void guac_opus_encoder_push_sample(guac_audio_stream* audio,
+        const int16_t* sample) {
+
+    guac_opus_encoder_state* state = (guac_opus_encoder_state*) audio->data;
+    int channels = guac_audio_stream_get_dsp(audio)->channels;
+
+    memcpy(state->frame + state->frame_written * channels, sample,
+            channels * sizeof(int16_t));
+
+    if (++state->frame_written == state->frame_size)
+        guac_opus_encoder_encode_frame(audio);
+
+}
+
+int guac_opus_encoder_get_rate(int rate) {
+
+    static const int supported_rates[] = { 8000, 12000, 16000, 24000 };
+
+    for (int i = 0; i < sizeof(supported_rates) / sizeof(int); i++) {
+        if (rate <= supported_rates[i])
+            return supported_rates[i];
+    }
+
+    return 48000;
+
+}
+
+static void guac_opus_encoder_begin_handler(guac_audio_stream* audio) {
+
+    int error;
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
+    int rate = dsp->rate;
+    int channels = dsp->channels;
+
+    audio->data = NULL;
+
+    guac_opus_encoder_state* state =
+        calloc(1, sizeof(guac_opus_encoder_state));
+    if (state == NULL) {
+        guac_client_log(audio->client, GUAC_LOG_WARNING, "Unable to "
+                "allocate Opus encoder state. Audio will not be sent.");
+        return;
+    }
+
+    state->frame_size = rate * GUAC_OPUS_ENCODER_FRAME_DURATION / 1000;
+    state->frame = malloc(state->frame_size * channels * sizeof(int16_t));
+    state->raw = malloc(state->frame_size * channels * sizeof(int16_t));
+
+    /* Without a frame buffer, no audio can be sent at all (the stream is
+     * left unannounced, and all other handlers do nothing) */
+    if (state->frame == NULL || state->raw == NULL) {
+        guac_client_log(audio->client, GUAC_LOG_WARNING, "Unable to "
+                "allocate Opus frame buffers. Audio will not be sent.");
+        free(state->frame);
+        free(state->raw);
+        free(state);
+        return;
+    }
+
+    audio->data = state;
+
+    state->encoder = opus_encoder_create(rate, channels,
+            OPUS_APPLICATION_AUDIO, &error);
+
+    if (error == OPUS_OK)
+        opus_encoder_ctl(state->encoder, OPUS_SET_BITRATE(
+                    GUAC_OPUS_ENCODER_BITRATE_PER_CHANNEL * channels));
+    else {
+        guac_client_log(audio->client, GUAC_LOG_WARNING, "Unable to "
+                "initialize Opus encoder (error %i). Audio will be "
+                "silent for users which support only Opus.", error);
+        state->encoder = NULL;
+    }
+
+    /* Notify each user of existence of stream, in the format that user
+     * supports */
+    guac_client_foreach_user(audio->client, guac_opus_encoder_send_audio,
+            audio);
+
+}
+
+static void guac_opus_encoder_join_handler(guac_audio_stream* audio,
+        guac_user* user) {
+
+    /* The stream was never announced if the encoder could not begin */
+    if (audio->data == NULL)
+        return;
+
+    /* Notify user of existence of stream */
+    guac_opus_encoder_send_audio(user, audio);
+
+}
+
+static void guac_opus_encoder_end_handler(guac_audio_stream* audio) {
+
+    guac_opus_encoder_state* state = (guac_opus_encoder_state*) audio->data;
+
+    /* Nothing to end if the encoder could not begin */
+    if (state == NULL)
+        return;
+
+    /* Encode any remaining partial frame */
+    if (state->frame_written > 0)
+        guac_opus_encoder_encode_frame(audio);
+
+    /* Send end of stream */
+    guac_protocol_send_end(audio->client->socket, audio->stream);
+
+    /* Free state information */
+    if (state->encoder != NULL)
+        opus_encoder_destroy(state->encoder);
+
+    free(state->frame);
+    free(state->raw);
+    free(state);
+
+    audio->data = NULL;
+
+}
+
+static void guac_opus_encoder_write_handler(guac_audio_stream* audio,
+        const unsigned char* pcm_data, int length) {
+
+    int channels = guac_audio_stream_get_dsp(audio)->channels;
+    int sample_size = channels * audio->bps / 8;
+    int16_t sample[2];
+
+    /* Drop all audio if the encoder could not begin */
+    if (audio->data == NULL)
+        return;
+
+    /* Convert each sample to signed 16-bit and append to frame */
+    for (; length >= sample_size; length -= sample_size) {
+
+        for (int channel = 0; channel < channels; channel++) {
+            if (audio->bps == 8)
+                sample[channel] = (*(pcm_data++) - 128) << 8;
+            else {
+                sample[channel] = (int16_t) (pcm_data[0]
+                        | (pcm_data[1] << 8));
+                pcm_data += 2;
+            }
+        }
+
+        guac_opus_encoder_push_sample(audio, sample);
+
+    }
+
+}
+
+static void guac_opus_encoder_flush_handler(guac_audio_stream* audio) {
+
+    /* Each packet is sent as soon as it is encoded. Incomplete frames remain
+     * buffered, as Opus can encode only complete frames, and padding each
+     * with silence would introduce audible gaps. */
+
+}
+
+/* Opus encoder handlers */
+guac_audio_encoder _opus_encoder = {
+    .mimetype      = "audio/opus",
+    .begin_handler = guac_opus_encoder_begin_handler,
+    .write_handler = guac_opus_encoder_write_handler,
+    .flush_handler = guac_opus_encoder_flush_handler,
+    .join_handler  = guac_opus_encoder_join_handler,
+    .end_handler   = guac_opus_encoder_end_handler
+};
+
+/* Actual encoder definition */
+guac_audio_encoder* opus_encoder = &_opus_encoder;
+
@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_OPUS_ENCODER_H
+#define GUAC_OPUS_ENCODER_H
+
+#include "config.h"
+
+#include "guacamole/audio.h"
+
+#include <opus/opus.h>
+
+#include <stdint.h>
+
+/**
+ * The duration of the audio encoded within each Opus packet, in
+ * milliseconds. Each packet is sent as a single blob.
+ */
+#define GUAC_OPUS_ENCODER_FRAME_DURATION 20
+
+/**
+ * The target bitrate of the encoded audio for each channel, in bits per
+ * second.
+ */
+#define GUAC_OPUS_ENCODER_BITRATE_PER_CHANNEL 48000
+
+/**
+ * The maximum size of a single encoded Opus packet, in bytes, as recommended
+ * by the libopus documentation.
+ */
+#define GUAC_OPUS_ENCODER_MAX_PACKET_SIZE 4000
+
+/**
+ * The current state of the Opus encoder. Provided PCM is converted to 16-bit
+ * samples and buffered until a complete frame is available for encoding.
+ */
+typedef struct guac_opus_encoder_state {
+
+    /**
+     * The libopus encoder.
+     */
+    OpusEncoder* encoder;
+
+    /**
+     * The number of samples per channel within each frame.
+     */
+    int frame_size;
+
+    /**
+     * Interleaved 16-bit samples of the frame currently being buffered.
+     */
+    int16_t* frame;
+
+    /**
+     * The number of samples per channel currently stored within the frame
+     * buffer.
+     */
+    int frame_written;
+
+    /**
+     * The frame most recently encoded, as little-endian, 16-bit PCM, for
+     * users which do not support Opus.
+     */
+    unsigned char* raw;
+
+    /**
+     * Whether the raw buffer currently contains the frame most recently
+     * encoded.
+     */
+    int raw_ready;
+
+    /**
+     * Buffer for each encoded packet.
+     */
+    unsigned char packet[GUAC_OPUS_ENCODER_MAX_PACKET_SIZE];
+
+    /**
+     * The length of the packet most recently encoded, in bytes, or zero if
+     * that frame could not be encoded.
+     */
+    int packet_length;
+
+} guac_opus_encoder_state;
+
+/**
+ * Audio encoder which compresses PCM with Opus, sending each Opus packet as
+ * a single blob. Users which do not declare support for Opus receive the
+ * same audio as raw, 16-bit PCM.
+ */
+extern guac_audio_encoder* opus_encoder;
+
+/**
+ * Returns the lowest rate supported by Opus which is at least the given rate,
+ * or the highest rate supported by Opus if the given rate exceeds all
+ * supported rates. PCM provided to the Opus encoder must be resampled to
+ * this rate.
+ *
+ * @param rate
+ *     The rate of the available PCM data, in samples per second.
+ *
+ * @return
+ *     The rate at which the PCM data should be encoded, in samples per
+ *     second.
+ */
+int guac_opus_encoder_get_rate(int rate);
+
+#endif
+
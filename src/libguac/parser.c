@@ -266,6 +266,44 @@ int guac_parser_read(guac_parser* parser, guac_socket* socket, int usec_timeout)
 
 }
 
+int guac_parser_parse_buffer(guac_parser* parser, void* buffer, int length) {
+
+    char* char_buffer = (char*) buffer;
+    int offset = 0;
+
+    /* Always begin a new instruction */
+    guac_parser_reset(parser);
+
+    while (parser->state != GUAC_PARSE_COMPLETE
+        && parser->state != GUAC_PARSE_ERROR) {
+
+        /* Parse directly from buffer */
+        int parsed = guac_parser_append(parser, char_buffer + offset,
+                length - offset);
+
+        /* Buffer ends before instruction is complete */
+        if (parsed == 0 && parser->state != GUAC_PARSE_ERROR) {
+            guac_error = GUAC_STATUS_CLOSED;
+            guac_error_message = "End of buffer reached while "
+                                 "reading instruction";
+            return -1;
+        }
+
+        offset += parsed;
+
+    }
+
+    /* Fail on error */
+    if (parser->state == GUAC_PARSE_ERROR) {
+        guac_error = GUAC_STATUS_PROTOCOL_ERROR;
+        guac_error_message = "Instruction parse error";
+        return -1;
+    }
+
+    return offset;
+
+}
+
 int guac_parser_expect(guac_parser* parser, guac_socket* socket, int usec_timeout, const char* opcode) {
 
     /* Read next instruction */
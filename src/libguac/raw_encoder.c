@@ -19,6 +19,7 @@
 
 #include "config.h"
 
+#include "audio-dsp.h"
 #include "guacamole/audio.h"
 #include "guacamole/client.h"
 #include "guacamole/protocol.h"
@@ -34,10 +35,11 @@ static void raw_encoder_send_audio(guac_audio_stream* audio,
         guac_socket* socket) {
 
     char mimetype[256];
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
 
     /* Produce mimetype string from format info */
     snprintf(mimetype, sizeof(mimetype), "audio/L%i;rate=%i,channels=%i",
-            audio->bps, audio->rate, audio->channels);
+            audio->bps, dsp->rate, dsp->channels);
 
     /* Associate stream */
     guac_protocol_send_audio(socket, audio->stream, mimetype);
@@ -47,6 +49,7 @@ static void raw_encoder_send_audio(guac_audio_stream* audio,
 static void raw_encoder_begin_handler(guac_audio_stream* audio) {
 
     raw_encoder_state* state;
+    guac_audio_dsp* dsp = guac_audio_stream_get_dsp(audio);
 
     /* Broadcast existence of stream */
     raw_encoder_send_audio(audio, audio->client->socket);
@@ -55,7 +58,7 @@ static void raw_encoder_begin_handler(guac_audio_stream* audio) {
     audio->data = state = malloc(sizeof(raw_encoder_state));
     state->written = 0;
     state->length = GUAC_RAW_ENCODER_BUFFER_SIZE
-                    * audio->rate * audio->channels * audio->bps
+                    * dsp->rate * dsp->channels * audio->bps
                     / 8 / 1000;
 
     state->buffer = malloc(state->length);
@@ -0,0 +1,173 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/audio-resampler.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * The number of frames provided to the resampler in each call to
+ * guac_audio_resampler_process().
+ */
+#define BLOCK_SIZE 1024
+
+/**
+ * The number of blocks of input provided to the resampler by each test.
+ */
+#define BLOCKS 16
+
+/**
+ * The peak amplitude of the test tone.
+ */
+#define AMPLITUDE 16000
+
+/**
+ * Returns the value of the given frame of a 440 Hz test tone sampled at the
+ * given rate.
+ *
+ * @param frame
+ *     The index of the frame to return.
+ *
+ * @param rate
+ *     The sample rate of the test tone, in samples per second.
+ *
+ * @return
+ *     The sample value at the given frame.
+ */
+static int16_t test_tone(int frame, int rate) {
+    return lround(AMPLITUDE * sin(2 * M_PI * 440.0 * frame / rate));
+}
+
+/**
+ * Test which verifies that resampling to the same rate leaves a low
+ * frequency tone intact, with each output frame aligned with the input frame
+ * at the same index.
+ */
+void test_audio_resampler__identity() {
+
+    guac_audio_resampler resampler;
+    CU_ASSERT_FATAL(guac_audio_resampler_init(&resampler, 1, 48000, 48000,
+                BLOCK_SIZE) == 0);
+
+    int16_t input[BLOCK_SIZE];
+    int16_t* output = malloc(sizeof(int16_t)
+            * guac_audio_resampler_max_output(&resampler, BLOCK_SIZE));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(output);
+
+    int in_frame = 0;
+    int out_frame = 0;
+    int max_error = 0;
+
+    for (int block = 0; block < BLOCKS; block++) {
+
+        for (int i = 0; i < BLOCK_SIZE; i++)
+            input[i] = test_tone(in_frame++, 48000);
+
+        int count = guac_audio_resampler_process(&resampler, input,
+                BLOCK_SIZE, output);
+
+        for (int i = 0; i < count; i++) {
+            int error = abs(output[i] - test_tone(out_frame++, 48000));
+            max_error = error > max_error ? error : max_error;
+        }
+
+    }
+
+    /* Every input frame but the last few must have been produced */
+    CU_ASSERT(out_frame <= in_frame);
+    CU_ASSERT(out_frame >= in_frame - resampler.taps);
+
+    /* Tone must be unchanged but for rounding (less than 0.1% error) */
+    CU_ASSERT(max_error <= AMPLITUDE / 1000);
+
+    guac_audio_resampler_free(&resampler);
+    free(output);
+
+}
+
+/**
+ * Test which verifies that the number of frames produced by the resampler
+ * matches the ratio between the input and output rates, and that no single
+ * call produces more frames than guac_audio_resampler_max_output() allows.
+ */
+void test_audio_resampler__length() {
+
+    static const int rates[][2] = {
+        { 44100, 16000 },
+        { 48000, 8000  },
+        { 22050, 48000 },
+        { 8000,  44100 },
+        { 44100, 48000 }
+    };
+
+    for (int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+
+        int in_rate = rates[i][0];
+        int out_rate = rates[i][1];
+
+        guac_audio_resampler resampler;
+        CU_ASSERT_FATAL(guac_audio_resampler_init(&resampler, 2, in_rate,
+                    out_rate, BLOCK_SIZE) == 0);
+
+        int max_output = guac_audio_resampler_max_output(&resampler,
+                BLOCK_SIZE);
+
+        int16_t input[BLOCK_SIZE * 2] = { 0 };
+        int16_t* output = malloc(sizeof(int16_t) * 2 * max_output);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(output);
+
+        int64_t total = 0;
+        for (int block = 0; block < BLOCKS; block++) {
+            int count = guac_audio_resampler_process(&resampler, input,
+                    BLOCK_SIZE, output);
+            CU_ASSERT(count <= max_output);
+            total += count;
+        }
+
+        /* All input must have been resampled but for the frames still
+         * within the filter, which spans taps input frames */
+        int64_t expected = (int64_t) BLOCKS * BLOCK_SIZE * out_rate / in_rate;
+        int64_t pending = (int64_t) resampler.taps * out_rate / in_rate + 1;
+        CU_ASSERT(total <= expected + 1);
+        CU_ASSERT(total >= expected - pending);
+
+        guac_audio_resampler_free(&resampler);
+        free(output);
+
+    }
+
+}
+
+/**
+ * Test which verifies that input rates exceeding the output rate by more
+ * than the maximum length of the filter are refused.
+ */
+void test_audio_resampler__unsupported() {
+
+    guac_audio_resampler resampler;
+
+    CU_ASSERT(guac_audio_resampler_init(&resampler, 1,
+                8000 * (GUAC_AUDIO_RESAMPLER_MAX_TAPS + 1), 8000,
+                BLOCK_SIZE) != 0);
+
+}
+
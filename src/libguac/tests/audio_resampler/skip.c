@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/audio-resampler.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The number of frames provided to the resampler in each call to
+ * guac_audio_resampler_process().
+ */
+#define BLOCK_SIZE 1024
+
+/**
+ * Fills the given buffer with deterministic, non-silent stereo test data.
+ *
+ * @param buffer
+ *     The buffer to fill, which must have space for BLOCK_SIZE stereo
+ *     frames.
+ *
+ * @param seed
+ *     An arbitrary value which varies the generated data.
+ */
+static void fill_block(int16_t* buffer, int seed) {
+    for (int i = 0; i < BLOCK_SIZE * 2; i++)
+        buffer[i] = (int16_t) ((i * 7919 + seed * 104729) % 20000 - 10000);
+}
+
+/**
+ * Test which verifies that skipping silence with guac_audio_resampler_skip()
+ * leaves the resampler in the same state as resampling the same amount of
+ * silence and discarding the result, for a variety of rates and lengths of
+ * silence, such that output following the silence is identical.
+ */
+void test_audio_resampler__skip() {
+
+    static const int rates[][2] = {
+        { 44100, 16000 },
+        { 48000, 8000  },
+        { 22050, 48000 },
+        { 44100, 48000 }
+    };
+
+    static const int silence[] = { 1, 15, 100, 1024, 3000, 20000 };
+
+    int16_t input[BLOCK_SIZE * 2];
+    int16_t zeros[BLOCK_SIZE * 2] = { 0 };
+
+    for (int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        for (int j = 0; j < sizeof(silence) / sizeof(silence[0]); j++) {
+
+            guac_audio_resampler processed;
+            guac_audio_resampler skipped;
+
+            CU_ASSERT_FATAL(guac_audio_resampler_init(&processed, 2,
+                        rates[i][0], rates[i][1], BLOCK_SIZE) == 0);
+            CU_ASSERT_FATAL(guac_audio_resampler_init(&skipped, 2,
+                        rates[i][0], rates[i][1], BLOCK_SIZE) == 0);
+
+            int max_output = guac_audio_resampler_max_output(&processed,
+                    BLOCK_SIZE);
+
+            int16_t* expected = malloc(sizeof(int16_t) * 2 * max_output);
+            int16_t* actual = malloc(sizeof(int16_t) * 2 * max_output);
+            CU_ASSERT_PTR_NOT_NULL_FATAL(expected);
+            CU_ASSERT_PTR_NOT_NULL_FATAL(actual);
+
+            /* Identical audio preceding the silence */
+            fill_block(input, 1);
+            guac_audio_resampler_process(&processed, input, BLOCK_SIZE,
+                    expected);
+            guac_audio_resampler_process(&skipped, input, BLOCK_SIZE,
+                    actual);
+
+            /* Resample silence in one, skip silence in the other */
+            for (int remaining = silence[j]; remaining > 0;
+                    remaining -= BLOCK_SIZE) {
+                int frames = remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+                guac_audio_resampler_process(&processed, zeros, frames,
+                        expected);
+            }
+
+            guac_audio_resampler_skip(&skipped, silence[j]);
+
+            /* Output following the silence must then be identical */
+            for (int block = 2; block < 5; block++) {
+
+                fill_block(input, block);
+
+                int expected_count = guac_audio_resampler_process(
+                        &processed, input, BLOCK_SIZE, expected);
+                int actual_count = guac_audio_resampler_process(
+                        &skipped, input, BLOCK_SIZE, actual);
+
+                CU_ASSERT_EQUAL_FATAL(expected_count, actual_count);
+                CU_ASSERT(memcmp(expected, actual,
+                            sizeof(int16_t) * 2 * expected_count) == 0);
+
+            }
+
+            guac_audio_resampler_free(&processed);
+            guac_audio_resampler_free(&skipped);
+            free(expected);
+            free(actual);
+
+        }
+    }
+
+}
+
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/error.h>
+#include <guacamole/parser.h>
+
+#include <stdlib.h>
+
+/**
+ * Test which verifies that guac_parser_parse_buffer() parses consecutive
+ * Guacamole instructions in place from a single buffer, reporting the number
+ * of bytes consumed by each instruction, and reports GUAC_STATUS_CLOSED if the
+ * buffer ends partway through an instruction.
+ */
+void test_parser__parse_buffer() {
+
+    /* Allocate parser */
+    guac_parser* parser = guac_parser_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parser);
+
+    /* Two complete instructions followed by a partial instruction */
+    char buffer[] = "4.test,8.testdata,5.zxcvb;"
+                    "5.test2,13.guacamoletest;"
+                    "4.sync,3.12";
+
+    char* current = buffer;
+    int remaining = sizeof(buffer) - 1;
+
+    /* Parse first instruction */
+    int parsed = guac_parser_parse_buffer(parser, current, remaining);
+    CU_ASSERT_EQUAL_FATAL(parsed, 26);
+    CU_ASSERT_EQUAL(parser->state, GUAC_PARSE_COMPLETE);
+    CU_ASSERT_EQUAL_FATAL(parser->argc, 2);
+    CU_ASSERT_STRING_EQUAL(parser->opcode,  "test");
+    CU_ASSERT_STRING_EQUAL(parser->argv[0], "testdata");
+    CU_ASSERT_STRING_EQUAL(parser->argv[1], "zxcvb");
+
+    /* Parsed elements must point directly into the buffer */
+    CU_ASSERT_PTR_EQUAL(parser->opcode, buffer + 2);
+
+    current += parsed;
+    remaining -= parsed;
+
+    /* Parse second instruction */
+    parsed = guac_parser_parse_buffer(parser, current, remaining);
+    CU_ASSERT_EQUAL_FATAL(parsed, 25);
+    CU_ASSERT_EQUAL_FATAL(parser->argc, 1);
+    CU_ASSERT_STRING_EQUAL(parser->opcode,  "test2");
+    CU_ASSERT_STRING_EQUAL(parser->argv[0], "guacamoletest");
+
+    current += parsed;
+    remaining -= parsed;
+
+    /* Final instruction is incomplete */
+    CU_ASSERT_EQUAL(guac_parser_parse_buffer(parser, current, remaining), -1);
+    CU_ASSERT_EQUAL(guac_error, GUAC_STATUS_CLOSED);
+
+    guac_parser_free(parser);
+
+}
+
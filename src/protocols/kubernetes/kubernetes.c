@@ -21,6 +21,7 @@
 
 #include "argv.h"
 #include "client.h"
+#include "common/clipboard.h"
 #include "common/recording.h"
 #include "io.h"
 #include "kubernetes.h"
@@ -251,6 +252,10 @@ void* guac_kubernetes_client_thread(void* data) {
         goto fail;
     }
 
+    /* Allow as much text to be copied as configured */
+    guac_terminal_set_copy_limit(kubernetes_client->term,
+            settings->clipboard_buffer_size);
+
     /* Send current values of exposed arguments to owner only */
     guac_client_for_owner(client, guac_kubernetes_send_current_argv,
             kubernetes_client);
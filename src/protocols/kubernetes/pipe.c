@@ -18,6 +18,7 @@
  */
 
 #include "kubernetes.h"
+#include "terminal/search.h"
 #include "terminal/terminal.h"
 #include "pipe.h"
 
@@ -42,6 +43,12 @@ int guac_kubernetes_pipe_handler(guac_user* user, guac_stream* stream,
         return 0;
     }
 
+    /* Search terminal if pipe has required name */
+    if (strcmp(name, GUAC_KUBERNETES_SEARCH_PIPE_NAME) == 0) {
+        guac_terminal_search_stream(kubernetes_client->term, user, stream);
+        return 0;
+    }
+
     /* No other inbound pipe streams are supported */
     guac_protocol_send_ack(user->socket, stream, "No such input stream.",
             GUAC_PROTOCOL_STATUS_RESOURCE_NOT_FOUND);
@@ -52,6 +52,7 @@ const char* GUAC_KUBERNETES_CLIENT_ARGS[] = {
     "scrollback",
     "disable-copy",
     "disable-paste",
+    "clipboard-buffer-size",
     NULL
 };
 
@@ -232,6 +233,13 @@ enum KUBERNETES_ARGS_IDX {
      */
     IDX_DISABLE_PASTE,
 
+    /**
+     * The maximum number of bytes of text which may be copied from the
+     * terminal to the clipboard. By default, 256 KiB may be copied. Values
+     * larger than 50 MiB are reduced to 50 MiB.
+     */
+    IDX_CLIPBOARD_BUFFER_SIZE,
+
     KUBERNETES_ARGS_COUNT
 };
 
@@ -390,6 +398,14 @@ guac_kubernetes_settings* guac_kubernetes_parse_args(guac_user* user,
         guac_user_parse_args_boolean(user, GUAC_KUBERNETES_CLIENT_ARGS, argv,
                 IDX_DISABLE_PASTE, false);
 
+    /* Parse maximum clipboard size */
+    settings->clipboard_buffer_size =
+        guac_user_parse_args_int(user, GUAC_KUBERNETES_CLIENT_ARGS, argv,
+                IDX_CLIPBOARD_BUFFER_SIZE, GUAC_KUBERNETES_DEFAULT_CLIPBOARD_BUFFER_SIZE);
+
+    if (settings->clipboard_buffer_size <= 0)
+        settings->clipboard_buffer_size = GUAC_KUBERNETES_DEFAULT_CLIPBOARD_BUFFER_SIZE;
+
     /* Parsing was successful */
     return settings;
 
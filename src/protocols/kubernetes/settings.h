@@ -62,6 +62,12 @@
  */
 #define GUAC_KUBERNETES_DEFAULT_MAX_SCROLLBACK 1000
 
+/**
+ * The default maximum number of bytes of text which may be copied from the
+ * terminal to the clipboard.
+ */
+#define GUAC_KUBERNETES_DEFAULT_CLIPBOARD_BUFFER_SIZE 262144
+
 /**
  * Settings for the Kubernetes connection. The values for this structure are
  * parsed from the arguments given during the Guacamole protocol handshake
@@ -184,6 +190,12 @@ typedef struct guac_kubernetes_settings {
      */
     bool disable_paste;
 
+    /**
+     * The maximum number of bytes of text which may be copied from the
+     * terminal to the clipboard.
+     */
+    int clipboard_buffer_size;
+
     /**
      * The path in which the typescript should be saved, if enabled. If no
      * typescript should be saved, this will be NULL.
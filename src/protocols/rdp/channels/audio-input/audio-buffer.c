@@ -26,10 +26,10 @@
 #include <guacamole/stream.h>
 #include <guacamole/user.h>
 
-#include <assert.h>
 #include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 guac_rdp_audio_buffer* guac_rdp_audio_buffer_alloc() {
     guac_rdp_audio_buffer* buffer = calloc(1, sizeof(guac_rdp_audio_buffer));
@@ -37,6 +37,204 @@ guac_rdp_audio_buffer* guac_rdp_audio_buffer_alloc() {
     return buffer;
 }
 
+/**
+ * Decoder for 16-bit mono input and mono output.
+ */
+static void guac_rdp_audio_buffer_decode_s16_1_1(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames; i++, input += 2)
+        output[i] = (int16_t) (input[0] | (input[1] << 8));
+}
+
+/**
+ * Decoder for 16-bit mono input and stereo output.
+ */
+static void guac_rdp_audio_buffer_decode_s16_1_2(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames; i++, input += 2)
+        output[i * 2] = output[i * 2 + 1]
+            = (int16_t) (input[0] | (input[1] << 8));
+}
+
+/**
+ * Decoder for 16-bit stereo input and mono output.
+ */
+static void guac_rdp_audio_buffer_decode_s16_2_1(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames; i++, input += 4)
+        output[i] = ((int16_t) (input[0] | (input[1] << 8))
+                   + (int16_t) (input[2] | (input[3] << 8))) >> 1;
+}
+
+/**
+ * Decoder for 16-bit stereo input and stereo output.
+ */
+static void guac_rdp_audio_buffer_decode_s16_2_2(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames * 2; i++, input += 2)
+        output[i] = (int16_t) (input[0] | (input[1] << 8));
+}
+
+/**
+ * Decoder for 8-bit mono input and mono output.
+ */
+static void guac_rdp_audio_buffer_decode_s8_1_1(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames; i++)
+        output[i] = (int8_t) input[i] * 256;
+}
+
+/**
+ * Decoder for 8-bit mono input and stereo output.
+ */
+static void guac_rdp_audio_buffer_decode_s8_1_2(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames; i++)
+        output[i * 2] = output[i * 2 + 1] = (int8_t) input[i] * 256;
+}
+
+/**
+ * Decoder for 8-bit stereo input and mono output.
+ */
+static void guac_rdp_audio_buffer_decode_s8_2_1(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames; i++)
+        output[i] = ((int8_t) input[i * 2] + (int8_t) input[i * 2 + 1]) * 128;
+}
+
+/**
+ * Decoder for 8-bit stereo input and stereo output.
+ */
+static void guac_rdp_audio_buffer_decode_s8_2_2(const unsigned char* input,
+        int frames, int16_t* output) {
+    for (int i = 0; i < frames * 2; i++)
+        output[i] = (int8_t) input[i] * 256;
+}
+
+/**
+ * All decoders, indexed by input bytes per sample, input channels, and output
+ * channels, each less one.
+ */
+static guac_rdp_audio_buffer_decoder* const guac_rdp_audio_buffer_decoders[2][2][2] = {
+    {
+        { guac_rdp_audio_buffer_decode_s8_1_1,
+          guac_rdp_audio_buffer_decode_s8_1_2 },
+        { guac_rdp_audio_buffer_decode_s8_2_1,
+          guac_rdp_audio_buffer_decode_s8_2_2 }
+    },
+    {
+        { guac_rdp_audio_buffer_decode_s16_1_1,
+          guac_rdp_audio_buffer_decode_s16_1_2 },
+        { guac_rdp_audio_buffer_decode_s16_2_1,
+          guac_rdp_audio_buffer_decode_s16_2_2 }
+    }
+};
+
+/**
+ * Encoder for 16-bit output.
+ */
+static void guac_rdp_audio_buffer_encode_s16(const int16_t* input, int count,
+        unsigned char* output) {
+    for (int i = 0; i < count; i++) {
+        output[i * 2]     = input[i] & 0xFF;
+        output[i * 2 + 1] = (input[i] >> 8) & 0xFF;
+    }
+}
+
+/**
+ * Encoder for 8-bit output.
+ */
+static void guac_rdp_audio_buffer_encode_s8(const int16_t* input, int count,
+        unsigned char* output) {
+    for (int i = 0; i < count; i++)
+        output[i] = (input[i] >> 8) & 0xFF;
+}
+
+/**
+ * Selects the conversion kernels and allocates the conversion buffers of the
+ * given audio buffer according to its input and output formats. If either
+ * format is not yet known or is unsupported, all received audio is ignored.
+ * The audio buffer must be locked.
+ *
+ * @param audio_buffer
+ *     The audio buffer to configure.
+ */
+static void guac_rdp_audio_buffer_configure(
+        guac_rdp_audio_buffer* audio_buffer) {
+
+    guac_rdp_audio_format* in = &audio_buffer->in_format;
+    guac_rdp_audio_format* out = &audio_buffer->out_format;
+
+    /* Release any previous configuration */
+    if (audio_buffer->resample)
+        guac_audio_resampler_free(&audio_buffer->resampler);
+
+    free(audio_buffer->samples);
+    free(audio_buffer->resampled);
+    audio_buffer->samples = NULL;
+    audio_buffer->resampled = NULL;
+    audio_buffer->resample = 0;
+    audio_buffer->decoder = NULL;
+    audio_buffer->encoder = NULL;
+    audio_buffer->partial_length = 0;
+
+    /* Both formats must be known */
+    if (audio_buffer->stream == NULL || audio_buffer->packet == NULL)
+        return;
+
+    /* Only 8- and 16-bit mono or stereo audio is supported */
+    if (in->bps < 1 || in->bps > 2 || in->channels < 1 || in->channels > 2
+            || out->bps < 1 || out->bps > 2
+            || out->channels < 1 || out->channels > 2
+            || in->rate <= 0 || out->rate <= 0) {
+        guac_user_log(audio_buffer->user, GUAC_LOG_WARNING, "Unsupported "
+                "audio input conversion. Audio input will be ignored.");
+        return;
+    }
+
+    /* Resample only if rates differ */
+    if (in->rate != out->rate) {
+
+        if (guac_audio_resampler_init(&audio_buffer->resampler,
+                    out->channels, in->rate, out->rate,
+                    GUAC_RDP_AUDIO_BUFFER_CHUNK_SIZE)) {
+            guac_user_log(audio_buffer->user, GUAC_LOG_WARNING, "Unable to "
+                    "resample audio input from %i Hz to %i Hz. Audio input "
+                    "will be ignored.", in->rate, out->rate);
+            return;
+        }
+
+        audio_buffer->resample = 1;
+
+        int max_output = guac_audio_resampler_max_output(
+                &audio_buffer->resampler, GUAC_RDP_AUDIO_BUFFER_CHUNK_SIZE);
+
+        audio_buffer->resampled = malloc(sizeof(int16_t) * out->channels
+                * max_output);
+
+    }
+
+    audio_buffer->samples = malloc(sizeof(int16_t) * out->channels
+            * GUAC_RDP_AUDIO_BUFFER_CHUNK_SIZE);
+
+    /* Ignore received audio if the conversion buffers cannot be allocated */
+    if (audio_buffer->samples == NULL || (audio_buffer->resample
+                && audio_buffer->resampled == NULL)) {
+        guac_user_log(audio_buffer->user, GUAC_LOG_WARNING, "Unable to "
+                "allocate audio input conversion buffers. Audio input will "
+                "be ignored.");
+        return;
+    }
+
+    audio_buffer->decoder = guac_rdp_audio_buffer_decoders
+        [in->bps - 1][in->channels - 1][out->channels - 1];
+
+    audio_buffer->encoder = (out->bps == 2)
+        ? guac_rdp_audio_buffer_encode_s16
+        : guac_rdp_audio_buffer_encode_s8;
+
+}
+
 /**
  * Sends an "ack" instruction over the socket associated with the Guacamole
  * stream over which audio data is being received. The "ack" instruction will
@@ -97,6 +295,9 @@ void guac_rdp_audio_buffer_set_stream(guac_rdp_audio_buffer* audio_buffer,
             audio_buffer->in_format.rate,
             audio_buffer->in_format.bps);
 
+    /* Select conversion kernels for new input format */
+    guac_rdp_audio_buffer_configure(audio_buffer);
+
     pthread_mutex_unlock(&(audio_buffer->lock));
 
 }
@@ -111,6 +312,9 @@ void guac_rdp_audio_buffer_set_output(guac_rdp_audio_buffer* audio_buffer,
     audio_buffer->out_format.channels = channels;
     audio_buffer->out_format.bps = bps;
 
+    /* Select conversion kernels for new output format */
+    guac_rdp_audio_buffer_configure(audio_buffer);
+
     pthread_mutex_unlock(&(audio_buffer->lock));
 
 }
@@ -131,9 +335,16 @@ void guac_rdp_audio_buffer_begin(guac_rdp_audio_buffer* audio_buffer,
                               * audio_buffer->out_format.channels
                               * audio_buffer->out_format.bps;
 
-    /* Allocate new buffer */
+    /* Allocate new buffer, ignoring received audio if allocation fails */
     free(audio_buffer->packet);
     audio_buffer->packet = malloc(audio_buffer->packet_size);
+    if (audio_buffer->packet == NULL && audio_buffer->user != NULL)
+        guac_user_log(audio_buffer->user, GUAC_LOG_WARNING, "Unable to "
+                "allocate audio input packet buffer. Audio input will be "
+                "ignored.");
+
+    /* Select conversion kernels now that the output is ready */
+    guac_rdp_audio_buffer_configure(audio_buffer);
 
     /* Acknowledge stream creation (if stream is ready to receive) */
     guac_rdp_audio_buffer_ack(audio_buffer,
@@ -144,144 +355,152 @@ void guac_rdp_audio_buffer_begin(guac_rdp_audio_buffer* audio_buffer,
 }
 
 /**
- * Reads a single sample from the given buffer of data, using the input
- * format defined within the given audio buffer. Each read sample is
- * translated to a signed 16-bit value, even if the input format is 8-bit.
- * The offset into the given buffer will be determined according to the
- * input and output formats, the number of bytes sent thus far, and the
- * number of bytes received (excluding the contents of the buffer).
+ * Encodes the given signed 16-bit samples into the packet of the given audio
+ * buffer, invoking the flush handler each time the packet is filled. The
+ * audio buffer must be locked.
  *
  * @param audio_buffer
- *     The audio buffer dictating the format of the given data buffer, as
- *     well as the offset from which the sample should be read.
- *
- * @param buffer
- *     The buffer of raw PCM audio data from which the sample should be read.
- *     This buffer MUST NOT contain data already taken into account by the
- *     audio buffer's total_bytes_received counter.
+ *     The audio buffer to write to.
  *
- * @param length
- *     The number of bytes within the given buffer of PCM data.
+ * @param samples
+ *     The samples to write, having the number of channels of the output
+ *     format.
  *
- * @param sample
- *     A pointer to the int16_t in which the read sample should be stored. If
- *     the input format is 8-bit, the sample will be shifted left by 8 bits
- *     to produce a 16-bit sample.
- *
- * @return
- *     Non-zero if a sample was successfully read, zero if no data remains
- *     within the given buffer that has not already been mapped to an
- *     output sample.
+ * @param count
+ *     The number of samples to write, across all channels.
  */
-static int guac_rdp_audio_buffer_read_sample(
-        guac_rdp_audio_buffer* audio_buffer, const char* buffer, int length,
-        int16_t* sample) {
-
-    int in_bps = audio_buffer->in_format.bps;
-    int in_rate = audio_buffer->in_format.rate;
-    int in_channels = audio_buffer->in_format.channels;
+static void guac_rdp_audio_buffer_emit(guac_rdp_audio_buffer* audio_buffer,
+        const int16_t* samples, int count) {
 
     int out_bps = audio_buffer->out_format.bps;
-    int out_rate = audio_buffer->out_format.rate;
-    int out_channels = audio_buffer->out_format.channels;
 
-    /* Calculate position within audio output */
-    int current_sample  = audio_buffer->total_bytes_sent / out_bps;
-    int current_frame   = current_sample / out_channels;
-    int current_channel = current_sample % out_channels;
+    while (count > 0) {
 
-    /* Map output channel to input channel */
-    if (current_channel >= in_channels)
-        current_channel = in_channels - 1;
+        /* Fill as much of the current packet as possible */
+        int available = (audio_buffer->packet_size
+                - audio_buffer->bytes_written) / out_bps;
 
-    /* Transform output position to input position */
-    current_frame = (int) current_frame * ((double) in_rate / out_rate);
-    current_sample = current_frame * in_channels + current_channel;
+        if (available > count)
+            available = count;
 
-    /* Calculate offset within given buffer from absolute input position */
-    int offset = current_sample * in_bps
-               - audio_buffer->total_bytes_received;
+        audio_buffer->encoder(samples, available, (unsigned char*)
+                audio_buffer->packet + audio_buffer->bytes_written);
 
-    /* It should be impossible for the offset to ever go negative */
-    assert(offset >= 0);
+        audio_buffer->bytes_written += available * out_bps;
+        samples += available;
+        count -= available;
 
-    /* Apply offset to buffer */
-    buffer += offset;
-    length -= offset;
+        /* Invoke flush handler if full */
+        if (audio_buffer->bytes_written == audio_buffer->packet_size) {
 
-    /* Read only if sufficient data is present in the given buffer */
-    if (length < in_bps)
-        return 0;
+            /* Only actually invoke if defined */
+            if (audio_buffer->flush_handler)
+                audio_buffer->flush_handler(audio_buffer->packet,
+                        audio_buffer->bytes_written, audio_buffer->data);
+
+            /* Reset buffer in all cases */
+            audio_buffer->bytes_written = 0;
+
+        }
 
-    /* Simply read sample directly if input is 16-bit */
-    if (in_bps == 2) {
-        *sample = *((int16_t*) buffer);
-        return 1;
     }
 
-    /* Translate to 16-bit if input is 8-bit */
-    if (in_bps == 1) {
-        *sample = *buffer << 8;
-        return 1;
+}
+
+/**
+ * Converts the given complete frames of received audio to the output format,
+ * writing the result to the packet of the given audio buffer. The audio
+ * buffer must be locked, and conversion kernels must have been selected.
+ *
+ * @param audio_buffer
+ *     The audio buffer to write to.
+ *
+ * @param input
+ *     The received audio frames, in the input format.
+ *
+ * @param frames
+ *     The number of frames to convert. This value may not exceed
+ *     GUAC_RDP_AUDIO_BUFFER_CHUNK_SIZE.
+ */
+static void guac_rdp_audio_buffer_convert(guac_rdp_audio_buffer* audio_buffer,
+        const unsigned char* input, int frames) {
+
+    int channels = audio_buffer->out_format.channels;
+    int16_t* samples = audio_buffer->samples;
+
+    audio_buffer->decoder(input, frames, samples);
+
+    /* Resample if necessary */
+    if (audio_buffer->resample) {
+        frames = guac_audio_resampler_process(&audio_buffer->resampler,
+                samples, frames, audio_buffer->resampled);
+        samples = audio_buffer->resampled;
     }
 
-    /* Accepted audio formats are required to be 8- or 16-bit */
-    return 0;
+    guac_rdp_audio_buffer_emit(audio_buffer, samples, frames * channels);
 
 }
 
 void guac_rdp_audio_buffer_write(guac_rdp_audio_buffer* audio_buffer,
         char* buffer, int length) {
 
-    int16_t sample;
-
     pthread_mutex_lock(&(audio_buffer->lock));
 
-    /* Ignore packet if there is no buffer */
-    if (audio_buffer->packet_size == 0 || audio_buffer->packet == NULL) {
+    /* Ignore packet if there is no buffer or the format is unsupported */
+    if (audio_buffer->packet_size == 0 || audio_buffer->packet == NULL
+            || audio_buffer->decoder == NULL) {
         pthread_mutex_unlock(&(audio_buffer->lock));
         return;
     }
 
-    int out_bps = audio_buffer->out_format.bps;
+    const unsigned char* input = (const unsigned char*) buffer;
+    int frame_size = audio_buffer->in_format.channels
+                   * audio_buffer->in_format.bps;
 
-    /* Continuously write packets until no data remains */
-    while (guac_rdp_audio_buffer_read_sample(audio_buffer,
-                buffer, length, &sample) > 0) {
+    /* Complete any frame left partially received by the previous write */
+    if (audio_buffer->partial_length > 0) {
 
-        char* current = audio_buffer->packet + audio_buffer->bytes_written;
+        int needed = frame_size - audio_buffer->partial_length;
+        if (needed > length)
+            needed = length;
 
-        /* Store as 16-bit or 8-bit, depending on output format */
-        if (out_bps == 2)
-            *((int16_t*) current) = sample;
-        else if (out_bps == 1)
-            *current = sample >> 8;
+        memcpy(audio_buffer->partial + audio_buffer->partial_length,
+                input, needed);
 
-        /* Accepted audio formats are required to be 8- or 16-bit */
-        else
-            assert(0);
+        audio_buffer->partial_length += needed;
+        input += needed;
+        length -= needed;
 
-        /* Update byte counters */
-        audio_buffer->bytes_written += out_bps;
-        audio_buffer->total_bytes_sent += out_bps;
+        if (audio_buffer->partial_length == frame_size) {
+            guac_rdp_audio_buffer_convert(audio_buffer,
+                    audio_buffer->partial, 1);
+            audio_buffer->partial_length = 0;
+        }
 
-        /* Invoke flush handler if full */
-        if (audio_buffer->bytes_written == audio_buffer->packet_size) {
+    }
 
-            /* Only actually invoke if defined */
-            if (audio_buffer->flush_handler)
-                audio_buffer->flush_handler(audio_buffer->packet,
-                        audio_buffer->bytes_written, audio_buffer->data);
+    /* Convert all complete frames in fixed-size chunks */
+    int frames = length / frame_size;
+    while (frames > 0) {
 
-            /* Reset buffer in all cases */
-            audio_buffer->bytes_written = 0;
+        int chunk = frames;
+        if (chunk > GUAC_RDP_AUDIO_BUFFER_CHUNK_SIZE)
+            chunk = GUAC_RDP_AUDIO_BUFFER_CHUNK_SIZE;
 
-        }
+        guac_rdp_audio_buffer_convert(audio_buffer, input, chunk);
 
-    } /* end packet write loop */
+        input += chunk * frame_size;
+        length -= chunk * frame_size;
+        frames -= chunk;
 
-    /* Track current position in audio stream */
-    audio_buffer->total_bytes_received += length;
+    }
+
+    /* Retain any trailing partial frame for the next write */
+    if (length > 0) {
+        memcpy(audio_buffer->partial + audio_buffer->partial_length,
+                input, length);
+        audio_buffer->partial_length += length;
+    }
 
     pthread_mutex_unlock(&(audio_buffer->lock));
 
@@ -304,20 +523,25 @@ void guac_rdp_audio_buffer_end(guac_rdp_audio_buffer* audio_buffer) {
     audio_buffer->packet_size = 0;
     audio_buffer->flush_handler = NULL;
 
-    /* Reset I/O counters */
-    audio_buffer->total_bytes_sent = 0;
-    audio_buffer->total_bytes_received = 0;
-
     /* Free packet (if any) */
     free(audio_buffer->packet);
     audio_buffer->packet = NULL;
 
+    /* Release conversion state */
+    guac_rdp_audio_buffer_configure(audio_buffer);
+
     pthread_mutex_unlock(&(audio_buffer->lock));
 
 }
 
 void guac_rdp_audio_buffer_free(guac_rdp_audio_buffer* audio_buffer) {
     pthread_mutex_destroy(&(audio_buffer->lock));
+
+    if (audio_buffer->resample)
+        guac_audio_resampler_free(&audio_buffer->resampler);
+
+    free(audio_buffer->samples);
+    free(audio_buffer->resampled);
     free(audio_buffer->packet);
     free(audio_buffer);
 }
@@ -20,9 +20,18 @@
 #ifndef GUAC_RDP_CHANNELS_AUDIO_INPUT_AUDIO_BUFFER_H
 #define GUAC_RDP_CHANNELS_AUDIO_INPUT_AUDIO_BUFFER_H
 
+#include <guacamole/audio-resampler.h>
 #include <guacamole/stream.h>
 #include <guacamole/user.h>
 #include <pthread.h>
+#include <stdint.h>
+
+/**
+ * The maximum number of frames of received audio converted at once. Larger
+ * writes are converted in chunks of this size, such that no allocation is
+ * required while audio is being received.
+ */
+#define GUAC_RDP_AUDIO_BUFFER_CHUNK_SIZE 256
 
 /**
  * Handler which is invoked when a guac_rdp_audio_buffer's internal packet
@@ -66,6 +75,39 @@ typedef struct guac_rdp_audio_format {
 
 } guac_rdp_audio_format;
 
+/**
+ * Conversion kernel which translates received PCM frames into signed 16-bit
+ * samples having the number of channels of the output format.
+ *
+ * @param input
+ *     The received PCM frames, in the input format.
+ *
+ * @param frames
+ *     The number of frames to convert.
+ *
+ * @param output
+ *     The buffer to receive the converted samples, which must have space for
+ *     the given number of frames in the output format.
+ */
+typedef void guac_rdp_audio_buffer_decoder(const unsigned char* input,
+        int frames, int16_t* output);
+
+/**
+ * Conversion kernel which translates signed 16-bit samples into the sample
+ * size of the output format.
+ *
+ * @param input
+ *     The samples to convert.
+ *
+ * @param count
+ *     The number of samples to convert, across all channels.
+ *
+ * @param output
+ *     The buffer to receive the converted samples.
+ */
+typedef void guac_rdp_audio_buffer_encoder(const int16_t* input, int count,
+        unsigned char* output);
+
 /**
  * A buffer of arbitrary audio data. Received audio data can be written to this
  * buffer, and will automatically be flushed via a given handler once the
@@ -117,16 +159,52 @@ typedef struct guac_rdp_audio_buffer {
     int bytes_written;
 
     /**
-     * The total number of bytes having ever been received by the Guacamole
-     * server for the current audio stream.
+     * The kernel converting received PCM to signed 16-bit samples having the
+     * number of channels of the output format, or NULL if the input and
+     * output formats are not both known and supported.
+     */
+    guac_rdp_audio_buffer_decoder* decoder;
+
+    /**
+     * The kernel converting signed 16-bit samples to the sample size of the
+     * output format, or NULL if the output format is not supported.
+     */
+    guac_rdp_audio_buffer_encoder* encoder;
+
+    /**
+     * Any trailing bytes of the audio data most recently received which did
+     * not form a complete frame.
+     */
+    unsigned char partial[4];
+
+    /**
+     * The number of bytes stored within the partial buffer.
+     */
+    int partial_length;
+
+    /**
+     * Whether received audio must be resampled.
+     */
+    int resample;
+
+    /**
+     * The resampler converting received audio to the output rate, if
+     * resampling is required.
+     */
+    guac_audio_resampler resampler;
+
+    /**
+     * Received audio converted to signed 16-bit samples having the number of
+     * channels of the output format, with space for a single chunk of
+     * received audio.
      */
-    int total_bytes_received;
+    int16_t* samples;
 
     /**
-     * The total number of bytes having ever been sent to the RDP server for
-     * the current audio stream.
+     * Converted samples after resampling, with space for the output of a
+     * single chunk of received audio, or NULL if resampling is not required.
      */
-    int total_bytes_sent;
+    int16_t* resampled;
 
     /**
      * All audio data being prepared for sending to the AUDIO_INPUT channel.
@@ -139,7 +139,6 @@ void guac_rdpdr_fs_process_read(guac_rdp_common_svc* svc,
 
     UINT32 length;
     UINT64 offset;
-    char* buffer;
     int bytes_read;
 
     wStream* output_stream;
@@ -164,15 +163,21 @@ void guac_rdpdr_fs_process_read(guac_rdp_common_svc* svc,
     if (length > GUAC_RDP_MAX_READ_BUFFER)
         length = GUAC_RDP_MAX_READ_BUFFER;
 
-    /* Allocate buffer */
-    buffer = malloc(length);
+    /* Allocate response assuming success, such that data can be read
+     * directly into the response */
+    output_stream = guac_rdpdr_new_io_completion(device,
+            iorequest->completion_id, STATUS_SUCCESS, 4+length);
+    size_t length_pos = Stream_GetPosition(output_stream);
+    Stream_Seek_UINT32(output_stream); /* Length (written below) */
 
     /* Attempt read */
     bytes_read = guac_rdp_fs_read((guac_rdp_fs*) device->data,
-            iorequest->file_id, offset, buffer, length);
+            iorequest->file_id, offset, Stream_Pointer(output_stream),
+            length);
 
     /* If error, return invalid parameter */
     if (bytes_read < 0) {
+        Stream_Free(output_stream, TRUE);
         output_stream = guac_rdpdr_new_io_completion(device,
                 iorequest->completion_id, guac_rdp_fs_get_status(bytes_read), 4);
         Stream_Write_UINT32(output_stream, 0); /* Length */
@@ -180,14 +185,14 @@ void guac_rdpdr_fs_process_read(guac_rdp_common_svc* svc,
 
     /* Otherwise, send bytes read */
     else {
-        output_stream = guac_rdpdr_new_io_completion(device,
-                iorequest->completion_id, STATUS_SUCCESS, 4+bytes_read);
-        Stream_Write_UINT32(output_stream, bytes_read);  /* Length */
-        Stream_Write(output_stream, buffer, bytes_read); /* ReadData */
+        Stream_Seek(output_stream, bytes_read);      /* ReadData */
+        size_t end_pos = Stream_GetPosition(output_stream);
+        Stream_SetPosition(output_stream, length_pos);
+        Stream_Write_UINT32(output_stream, bytes_read); /* Length */
+        Stream_SetPosition(output_stream, end_pos);
     }
 
     guac_rdp_common_svc_write(svc, output_stream);
-    free(buffer);
 
 }
 
@@ -523,39 +528,37 @@ void guac_rdpdr_fs_process_query_directory(guac_rdp_common_svc* svc,
         if (guac_rdp_fs_convert_path(file->absolute_path,
                     entry_name, entry_path) == 0) {
 
-            int entry_file_id;
+            guac_rdp_fs_metadata entry;
 
             /* Pattern defined and match fails, continue with next file */
             if (guac_rdp_fs_matches(entry_path, file->dir_pattern))
                 continue;
 
-            /* Open directory entry */
-            entry_file_id = guac_rdp_fs_open((guac_rdp_fs*) device->data,
-                    entry_path, FILE_READ_DATA, 0, FILE_OPEN, 0);
-
-            if (entry_file_id >= 0) {
+            /* Retrieve metadata of directory entry, typically from cache */
+            if (guac_rdp_fs_get_metadata((guac_rdp_fs*) device->data,
+                        entry_path, &entry) == 0) {
 
                 /* Dispatch to appropriate class-specific handler */
                 switch (fs_information_class) {
 
                     case FileDirectoryInformation:
                         guac_rdpdr_fs_process_query_directory_info(svc, device,
-                                iorequest, entry_name, entry_file_id);
+                                iorequest, entry_name, &entry);
                         break;
 
                     case FileFullDirectoryInformation:
                         guac_rdpdr_fs_process_query_full_directory_info(svc,
-                                device, iorequest, entry_name, entry_file_id);
+                                device, iorequest, entry_name, &entry);
                         break;
 
                     case FileBothDirectoryInformation:
                         guac_rdpdr_fs_process_query_both_directory_info(svc,
-                                device, iorequest, entry_name, entry_file_id);
+                                device, iorequest, entry_name, &entry);
                         break;
 
                     case FileNamesInformation:
                         guac_rdpdr_fs_process_query_names_info(svc, device,
-                                iorequest, entry_name, entry_file_id);
+                                iorequest, entry_name, &entry);
                         break;
 
                     default:
@@ -564,7 +567,6 @@ void guac_rdpdr_fs_process_query_directory(guac_rdp_common_svc* svc,
                                 fs_information_class);
                 }
 
-                guac_rdp_fs_close((guac_rdp_fs*) device->data, entry_file_id);
                 return;
 
             } /* end if file exists */
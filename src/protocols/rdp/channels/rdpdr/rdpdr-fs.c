@@ -19,6 +19,7 @@
 
 #include "channels/rdpdr/rdpdr-fs.h"
 #include "channels/rdpdr/rdpdr-fs-messages.h"
+#include "channels/rdpdr/rdpdr-workers.h"
 #include "channels/rdpdr/rdpdr.h"
 #include "rdp.h"
 
@@ -34,6 +35,29 @@ void guac_rdpdr_device_fs_iorequest_handler(guac_rdp_common_svc* svc,
         guac_rdpdr_device* device, guac_rdpdr_iorequest* iorequest,
         wStream* input_stream) {
 
+    guac_rdpdr_workers* workers = device->workers;
+
+    /* Reads and writes are processed concurrently by the worker pool, while
+     * all other requests may affect the files being read or written and must
+     * wait for all outstanding reads and writes to complete */
+    if (workers != NULL) {
+
+        if (iorequest->major_func == IRP_MJ_READ) {
+            guac_rdpdr_workers_submit(workers, guac_rdpdr_fs_process_read,
+                    iorequest, input_stream);
+            return;
+        }
+
+        if (iorequest->major_func == IRP_MJ_WRITE) {
+            guac_rdpdr_workers_submit(workers, guac_rdpdr_fs_process_write,
+                    iorequest, input_stream);
+            return;
+        }
+
+        guac_rdpdr_workers_wait(workers);
+
+    }
+
     switch (iorequest->major_func) {
 
         /* File open */
@@ -111,6 +135,9 @@ void guac_rdpdr_device_fs_iorequest_handler(guac_rdp_common_svc* svc,
 void guac_rdpdr_device_fs_free_handler(guac_rdp_common_svc* svc,
         guac_rdpdr_device* device) {
 
+    if (device->workers != NULL)
+        guac_rdpdr_workers_free(device->workers);
+
     Stream_Free(device->device_announce, 1);
     
 }
@@ -150,5 +177,8 @@ void guac_rdpdr_register_fs(guac_rdp_common_svc* svc, char* drive_name) {
     /* Init data */
     device->data = rdp_client->filesystem;
 
+    /* Process reads and writes concurrently */
+    device->workers = guac_rdpdr_workers_alloc(svc, device);
+
 }
 
@@ -0,0 +1,245 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "channels/common-svc.h"
+#include "channels/rdpdr/rdpdr-workers.h"
+#include "channels/rdpdr/rdpdr.h"
+
+#include <guacamole/client.h>
+#include <winpr/stream.h>
+#include <winpr/wtypes.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Thread which repeatedly processes the first job within the queue of a
+ * single worker until the worker pool is stopped.
+ *
+ * @param data
+ *     The guac_rdpdr_worker whose queue should be processed.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_rdpdr_worker_thread(void* data) {
+
+    guac_rdpdr_worker* worker = (guac_rdpdr_worker*) data;
+    guac_rdpdr_workers* workers = worker->workers;
+
+    pthread_mutex_lock(&workers->lock);
+    for (;;) {
+
+        /* Wait for work or for the pool to be stopped */
+        while (worker->head == NULL && !workers->stopping)
+            pthread_cond_wait(&workers->modified, &workers->lock);
+
+        if (worker->head == NULL)
+            break;
+
+        /* Leave job at head of queue until processed, such that the
+         * queue is not considered empty while work remains */
+        guac_rdpdr_job* job = worker->head;
+        pthread_mutex_unlock(&workers->lock);
+
+        /* Process request without holding the lock */
+        wStream* input_stream = Stream_New(job->data, job->length);
+        job->handler(workers->svc, workers->device, &job->iorequest,
+                input_stream);
+        Stream_Free(input_stream, FALSE);
+
+        pthread_mutex_lock(&workers->lock);
+
+        /* Remove job from queue */
+        worker->head = job->next;
+        if (worker->head == NULL)
+            worker->tail = NULL;
+
+        /* Keep job (and its buffer) for reuse */
+        job->next = workers->unused;
+        workers->unused = job;
+
+        workers->pending--;
+        pthread_cond_broadcast(&workers->modified);
+
+    }
+    pthread_mutex_unlock(&workers->lock);
+
+    return NULL;
+
+}
+
+guac_rdpdr_workers* guac_rdpdr_workers_alloc(guac_rdp_common_svc* svc,
+        guac_rdpdr_device* device) {
+
+    guac_rdpdr_workers* workers = calloc(1, sizeof(guac_rdpdr_workers));
+    if (workers == NULL) {
+        guac_client_log(svc->client, GUAC_LOG_WARNING, "Unable to allocate "
+                "worker pool for device \"%s\". I/O requests will be "
+                "processed synchronously.", device->device_name);
+        return NULL;
+    }
+
+    workers->svc = svc;
+    workers->device = device;
+
+    pthread_mutex_init(&workers->lock, NULL);
+    pthread_cond_init(&workers->modified, NULL);
+
+    /* Start all workers, tracking only those successfully started */
+    for (; workers->worker_count < GUAC_RDPDR_WORKERS;
+            workers->worker_count++) {
+
+        guac_rdpdr_worker* worker = &workers->workers[workers->worker_count];
+        worker->workers = workers;
+
+        if (pthread_create(&worker->thread, NULL,
+                    guac_rdpdr_worker_thread, worker))
+            break;
+
+    }
+
+    /* Fall back to processing requests synchronously if no threads could be
+     * started at all */
+    if (workers->worker_count == 0) {
+        guac_client_log(svc->client, GUAC_LOG_WARNING, "Unable to start "
+                "worker threads for device \"%s\". I/O requests will be "
+                "processed synchronously.", device->device_name);
+        guac_rdpdr_workers_free(workers);
+        return NULL;
+    }
+
+    return workers;
+
+}
+
+void guac_rdpdr_workers_submit(guac_rdpdr_workers* workers,
+        guac_rdpdr_device_iorequest_handler* handler,
+        guac_rdpdr_iorequest* iorequest, wStream* input_stream) {
+
+    size_t length = Stream_GetRemainingLength(input_stream);
+
+    pthread_mutex_lock(&workers->lock);
+
+    /* Reuse a previously-completed job if possible */
+    guac_rdpdr_job* job = workers->unused;
+    if (job != NULL)
+        workers->unused = job->next;
+    else
+        job = calloc(1, sizeof(guac_rdpdr_job));
+
+    /* Grow buffer only if too small for the request */
+    if (job != NULL && (job->data == NULL || job->capacity < length)) {
+
+        free(job->data);
+        job->capacity = length > 0 ? length : 1;
+        job->data = malloc(job->capacity);
+
+        /* Keep the job for reuse (without a buffer) if allocation fails */
+        if (job->data == NULL) {
+            job->capacity = 0;
+            job->next = workers->unused;
+            workers->unused = job;
+            job = NULL;
+        }
+
+    }
+
+    /* Process request synchronously if it cannot be queued, first waiting
+     * for queued requests such that requests are still processed in order */
+    if (job == NULL) {
+
+        while (workers->pending > 0)
+            pthread_cond_wait(&workers->modified, &workers->lock);
+
+        pthread_mutex_unlock(&workers->lock);
+
+        guac_client_log(workers->svc->client, GUAC_LOG_DEBUG, "Unable to "
+                "queue I/O request for device \"%s\". Processing request "
+                "synchronously.", workers->device->device_name);
+
+        handler(workers->svc, workers->device, iorequest, input_stream);
+        return;
+
+    }
+
+    job->handler = handler;
+    job->iorequest = *iorequest;
+    job->length = length;
+    job->next = NULL;
+    memcpy(job->data, Stream_Pointer(input_stream), length);
+
+    /* Requests for the same file are always processed by the same worker,
+     * and thus in order */
+    guac_rdpdr_worker* worker = &workers->workers[
+        (unsigned int) iorequest->file_id % workers->worker_count];
+
+    if (worker->tail != NULL)
+        worker->tail->next = job;
+    else
+        worker->head = job;
+
+    worker->tail = job;
+    workers->pending++;
+
+    pthread_cond_broadcast(&workers->modified);
+    pthread_mutex_unlock(&workers->lock);
+
+}
+
+void guac_rdpdr_workers_wait(guac_rdpdr_workers* workers) {
+
+    pthread_mutex_lock(&workers->lock);
+
+    while (workers->pending > 0)
+        pthread_cond_wait(&workers->modified, &workers->lock);
+
+    pthread_mutex_unlock(&workers->lock);
+
+}
+
+void guac_rdpdr_workers_free(guac_rdpdr_workers* workers) {
+
+    guac_rdpdr_workers_wait(workers);
+
+    /* Signal all workers to exit */
+    pthread_mutex_lock(&workers->lock);
+    workers->stopping = 1;
+    pthread_cond_broadcast(&workers->modified);
+    pthread_mutex_unlock(&workers->lock);
+
+    /* Wait for all workers to finish */
+    for (int i = 0; i < workers->worker_count; i++)
+        pthread_join(workers->workers[i].thread, NULL);
+
+    /* Free all reusable jobs */
+    guac_rdpdr_job* job = workers->unused;
+    while (job != NULL) {
+        guac_rdpdr_job* next = job->next;
+        free(job->data);
+        free(job);
+        job = next;
+    }
+
+    pthread_cond_destroy(&workers->modified);
+    pthread_mutex_destroy(&workers->lock);
+    free(workers);
+
+}
+
@@ -0,0 +1,227 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef GUAC_RDP_CHANNELS_RDPDR_WORKERS_H
+#define GUAC_RDP_CHANNELS_RDPDR_WORKERS_H
+
+#include "channels/common-svc.h"
+#include "channels/rdpdr/rdpdr.h"
+
+#include <winpr/stream.h>
+
+#include <pthread.h>
+
+/**
+ * The number of worker threads servicing the I/O requests of each device
+ * using a worker pool.
+ */
+#define GUAC_RDPDR_WORKERS 4
+
+/**
+ * A single I/O request which has been queued for processing by a worker
+ * thread, including a copy of the remaining data of the PDU containing that
+ * request. Jobs are reused once processed, such that the buffers of
+ * previously-processed jobs are reused for subsequent requests.
+ */
+typedef struct guac_rdpdr_job {
+
+    /**
+     * The handler which should process this request.
+     */
+    guac_rdpdr_device_iorequest_handler* handler;
+
+    /**
+     * The contents of the common RDPDR Device I/O Request header of this
+     * request.
+     */
+    guac_rdpdr_iorequest iorequest;
+
+    /**
+     * The remaining data of the PDU containing this request, following the
+     * common RDPDR Device I/O Request header.
+     */
+    BYTE* data;
+
+    /**
+     * The number of bytes of data within the data buffer.
+     */
+    size_t length;
+
+    /**
+     * The size of the data buffer, in bytes.
+     */
+    size_t capacity;
+
+    /**
+     * The next job within the same queue, or NULL if this is the last job.
+     */
+    struct guac_rdpdr_job* next;
+
+} guac_rdpdr_job;
+
+/**
+ * A worker thread which processes the jobs of its own queue, in order.
+ */
+typedef struct guac_rdpdr_worker {
+
+    /**
+     * The thread processing this worker's queue.
+     */
+    pthread_t thread;
+
+    /**
+     * The pool containing this worker.
+     */
+    guac_rdpdr_workers* workers;
+
+    /**
+     * The first job within this worker's queue, or NULL if the queue is
+     * empty.
+     */
+    guac_rdpdr_job* head;
+
+    /**
+     * The last job within this worker's queue, or NULL if the queue is empty.
+     */
+    guac_rdpdr_job* tail;
+
+} guac_rdpdr_worker;
+
+/**
+ * Pool of worker threads which process the I/O requests of a single device
+ * concurrently. Requests are assigned to workers by file ID, such that
+ * requests for the same file are always processed in order while requests
+ * for different files may be processed at the same time.
+ */
+struct guac_rdpdr_workers {
+
+    /**
+     * The static virtual channel instance being used for RDPDR.
+     */
+    guac_rdp_common_svc* svc;
+
+    /**
+     * The device whose I/O requests are processed by this pool.
+     */
+    guac_rdpdr_device* device;
+
+    /**
+     * Lock which guards access to all queues, the pool of unused jobs, and
+     * all counters and flags of this pool.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever a job is queued or completed, or
+     * the pool is stopped.
+     */
+    pthread_cond_t modified;
+
+    /**
+     * All worker threads of this pool.
+     */
+    guac_rdpdr_worker workers[GUAC_RDPDR_WORKERS];
+
+    /**
+     * The number of worker threads which were successfully started.
+     */
+    int worker_count;
+
+    /**
+     * The number of jobs which have been queued but not yet completed.
+     */
+    int pending;
+
+    /**
+     * Jobs which have been completed and may be reused, or NULL if there are
+     * no such jobs.
+     */
+    guac_rdpdr_job* unused;
+
+    /**
+     * Non-zero if all worker threads should exit.
+     */
+    int stopping;
+
+};
+
+/**
+ * Allocates a new pool of worker threads which will process I/O requests
+ * received for the given device.
+ *
+ * @param svc
+ *     The static virtual channel instance being used for RDPDR.
+ *
+ * @param device
+ *     The device whose I/O requests will be processed by the new pool.
+ *
+ * @return
+ *     A newly-allocated worker pool, or NULL if no worker threads could be
+ *     started.
+ */
+guac_rdpdr_workers* guac_rdpdr_workers_alloc(guac_rdp_common_svc* svc,
+        guac_rdpdr_device* device);
+
+/**
+ * Queues the given I/O request for processing by the given handler within
+ * one of the worker threads of the given pool. The remaining data of the
+ * given stream is copied, and the stream may be freed once this function
+ * returns. If the request cannot be queued due to lack of memory, it is
+ * instead processed by the given handler within the calling thread, after
+ * all previously-queued requests have been completed.
+ *
+ * @param workers
+ *     The worker pool which should process the request.
+ *
+ * @param handler
+ *     The handler which should process the request.
+ *
+ * @param iorequest
+ *     The contents of the common RDPDR Device I/O Request header of the
+ *     request.
+ *
+ * @param input_stream
+ *     The remaining data within the received PDU, following the common RDPDR
+ *     Device I/O Request header.
+ */
+void guac_rdpdr_workers_submit(guac_rdpdr_workers* workers,
+        guac_rdpdr_device_iorequest_handler* handler,
+        guac_rdpdr_iorequest* iorequest, wStream* input_stream);
+
+/**
+ * Waits for all I/O requests queued within the given pool to be completed.
+ * This function must be invoked prior to processing any request which may
+ * affect the requests processed by the pool, such as the opening or closing
+ * of files.
+ *
+ * @param workers
+ *     The worker pool to wait for.
+ */
+void guac_rdpdr_workers_wait(guac_rdpdr_workers* workers);
+
+/**
+ * Waits for all I/O requests queued within the given pool to be completed,
+ * stops all worker threads, and frees the pool.
+ *
+ * @param workers
+ *     The worker pool to free.
+ */
+void guac_rdpdr_workers_free(guac_rdpdr_workers* workers);
+
+#endif
+
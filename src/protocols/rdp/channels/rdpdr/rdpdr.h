@@ -38,6 +38,12 @@
  */
 typedef struct guac_rdpdr_device guac_rdpdr_device;
 
+/**
+ * Pool of worker threads which process the I/O requests of a device
+ * concurrently.
+ */
+typedef struct guac_rdpdr_workers guac_rdpdr_workers;
+
 /**
  * The contents of the header common to all RDPDR Device I/O Requests. See:
  *
@@ -164,6 +170,13 @@ struct guac_rdpdr_device {
      */
     void* data;
 
+    /**
+     * Pool of worker threads which process I/O requests for this device that
+     * may be safely processed concurrently, or NULL if all I/O requests are
+     * processed within the thread receiving them.
+     */
+    guac_rdpdr_workers* workers;
+
 };
 
 /**
@@ -43,9 +43,7 @@ void guac_rdpsnd_formats_handler(guac_rdp_common_svc* svc,
 
     guac_client* client = svc->client;
     guac_rdpsnd* rdpsnd = (guac_rdpsnd*) svc->data;
-
-    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
-    guac_audio_stream* audio = rdp_client->audio;
+    guac_rdpsnd_scheduler* scheduler = rdpsnd->scheduler;
 
     /* Reset own format count */
     rdpsnd->format_count = 0;
@@ -93,7 +91,7 @@ void guac_rdpsnd_formats_handler(guac_rdp_common_svc* svc,
     Stream_Write_UINT8(output_stream,  0);
 
     /* Check each server format, respond if supported and audio is enabled */
-    if (audio != NULL) {
+    if (scheduler != NULL) {
         for (i=0; i < server_format_count; i++) {
 
             unsigned char* format_start;
@@ -158,7 +156,8 @@ void guac_rdpsnd_formats_handler(guac_rdp_common_svc* svc,
 
                     /* Ensure audio stream is configured to use accepted
                      * format */
-                    guac_audio_stream_reset(audio, NULL, rate, channels, bps);
+                    guac_rdpsnd_scheduler_reset(scheduler, rate, channels,
+                            bps);
 
                     /* Queue format for sending as accepted */
                     Stream_EnsureRemainingCapacity(output_stream,
@@ -264,11 +263,8 @@ void guac_rdpsnd_wave_info_handler(guac_rdp_common_svc* svc,
 
     int format;
 
-    guac_client* client = svc->client;
     guac_rdpsnd* rdpsnd = (guac_rdpsnd*) svc->data;
-
-    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
-    guac_audio_stream* audio = rdp_client->audio;
+    guac_rdpsnd_scheduler* scheduler = rdpsnd->scheduler;
 
     /* Check to make sure audio stream contains a minimum number of bytes. */
     if (Stream_GetRemainingLength(input_stream) < 12) {
@@ -296,9 +292,9 @@ void guac_rdpsnd_wave_info_handler(guac_rdp_common_svc* svc,
     rdpsnd->next_pdu_is_wave = TRUE;
 
     /* Reset audio stream if format has changed */
-    if (audio != NULL) {
+    if (scheduler != NULL) {
         if (format < GUAC_RDP_MAX_FORMATS)
-            guac_audio_stream_reset(audio, NULL,
+            guac_rdpsnd_scheduler_reset(scheduler,
                     rdpsnd->formats[format].rate,
                     rdpsnd->formats[format].channels,
                     rdpsnd->formats[format].bps);
@@ -314,12 +310,12 @@ void guac_rdpsnd_wave_info_handler(guac_rdp_common_svc* svc,
 void guac_rdpsnd_wave_handler(guac_rdp_common_svc* svc,
         wStream* input_stream, guac_rdpsnd_pdu_header* header) {
 
-    guac_client* client = svc->client;
     guac_rdpsnd* rdpsnd = (guac_rdpsnd*) svc->data;
+    guac_rdpsnd_scheduler* scheduler = rdpsnd->scheduler;
+
+    /* The number of milliseconds until the wave will have been played */
+    int delay = 0;
 
-    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
-    guac_audio_stream* audio = rdp_client->audio;
-    
     /* Verify that the stream has bytes to cover the wave size plus header. */
     if (Stream_Length(input_stream) < (rdpsnd->incoming_wave_size + 4)) {
         guac_client_log(svc->client, GUAC_LOG_WARNING, "Audio Wave PDU does "
@@ -337,18 +333,18 @@ void guac_rdpsnd_wave_handler(guac_rdp_common_svc* svc,
     /* Copy over first four bytes */
     memcpy(buffer, rdpsnd->initial_wave_data, 4);
 
-    /* Write rest of audio packet */
-    if (audio != NULL) {
-        guac_audio_stream_write_pcm(audio, buffer,
+    /* Queue audio packet for sending at the appropriate time */
+    if (scheduler != NULL)
+        delay = guac_rdpsnd_scheduler_write(scheduler, buffer,
                 rdpsnd->incoming_wave_size + 4);
-        guac_audio_stream_flush(audio);
-    }
 
-    /* Write Wave Confirmation PDU */
+    /* Write Wave Confirmation PDU, timestamped with the time the wave will
+     * have been played such that the server can pace further audio */
     Stream_Write_UINT8(output_stream, SNDC_WAVECONFIRM);
     Stream_Write_UINT8(output_stream, 0);
     Stream_Write_UINT16(output_stream, 4);
-    Stream_Write_UINT16(output_stream, rdpsnd->server_timestamp);
+    Stream_Write_UINT16(output_stream,
+            (rdpsnd->server_timestamp + delay) & 0xFFFF);
     Stream_Write_UINT8(output_stream, rdpsnd->waveinfo_block_number);
     Stream_Write_UINT8(output_stream, 0);
 
@@ -0,0 +1,437 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "channels/rdpsnd/rdpsnd-scheduler.h"
+
+#include <guacamole/audio.h>
+#include <guacamole/client.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Returns the number of bytes within the given duration of audio in the
+ * current format of the given scheduler. The returned value is always a
+ * whole number of frames.
+ *
+ * @param scheduler
+ *     The scheduler whose format should be used.
+ *
+ * @param msec
+ *     The duration of audio, in milliseconds.
+ *
+ * @return
+ *     The number of bytes within the given duration of audio.
+ */
+static int guac_rdpsnd_scheduler_bytes(guac_rdpsnd_scheduler* scheduler,
+        int msec) {
+    return (int64_t) scheduler->rate * msec / 1000 * scheduler->frame_size;
+}
+
+/**
+ * Reallocates the queue of the given scheduler for the current format of its
+ * audio stream, discarding any queued audio. The scheduler must be locked.
+ * If the queue cannot be allocated, the scheduler is left without a queue,
+ * and all audio subsequently written is dropped.
+ *
+ * @param scheduler
+ *     The scheduler to reconfigure.
+ *
+ * @return
+ *     Zero if the queue was successfully allocated, non-zero otherwise.
+ */
+static int guac_rdpsnd_scheduler_configure(
+        guac_rdpsnd_scheduler* scheduler) {
+
+    guac_audio_stream* audio = scheduler->audio;
+
+    scheduler->rate = audio->rate;
+    scheduler->frame_size = audio->channels * audio->bps / 8;
+    scheduler->capacity = guac_rdpsnd_scheduler_bytes(scheduler,
+            GUAC_RDPSND_SCHEDULER_QUEUE_SIZE);
+
+    scheduler->start = 0;
+    scheduler->length = 0;
+    scheduler->playing = 0;
+
+    free(scheduler->buffer);
+    scheduler->buffer = malloc(scheduler->capacity);
+
+    if (scheduler->buffer == NULL) {
+        scheduler->capacity = 0;
+        return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Removes the given number of bytes from the head of the queue of the given
+ * scheduler. The scheduler must be locked.
+ *
+ * @param scheduler
+ *     The scheduler whose queue should be advanced.
+ *
+ * @param length
+ *     The number of bytes to remove. This may not exceed the number of bytes
+ *     queued.
+ */
+static void guac_rdpsnd_scheduler_advance(guac_rdpsnd_scheduler* scheduler,
+        int length) {
+    scheduler->start = (scheduler->start + length) % scheduler->capacity;
+    scheduler->length -= length;
+}
+
+/**
+ * Drops the given number of bytes of the oldest audio, logging the amount of
+ * audio dropped once it reaches one second. Queued audio is dropped first.
+ * Any bytes beyond those queued are assumed to be dropped by the caller from
+ * audio not yet queued. The scheduler must be locked.
+ *
+ * @param scheduler
+ *     The scheduler whose audio should be dropped.
+ *
+ * @param length
+ *     The number of bytes to drop.
+ */
+static void guac_rdpsnd_scheduler_drop(guac_rdpsnd_scheduler* scheduler,
+        int length) {
+
+    int queued = length;
+    if (queued > scheduler->length)
+        queued = scheduler->length;
+
+    if (queued > 0)
+        guac_rdpsnd_scheduler_advance(scheduler, queued);
+
+    scheduler->dropped += length;
+    if (scheduler->dropped >= guac_rdpsnd_scheduler_bytes(scheduler, 1000)) {
+        guac_client_log(scheduler->client, GUAC_LOG_DEBUG, "Dropped %i ms of "
+                "queued audio to remain within latency budget.",
+                scheduler->dropped / scheduler->frame_size * 1000
+                / scheduler->rate);
+        scheduler->dropped = 0;
+    }
+
+}
+
+/**
+ * Writes the given number of bytes from the head of the queue of the given
+ * scheduler to the audio stream, flushing the audio stream such that the
+ * written audio is sent as a single packet. The scheduler must be locked.
+ *
+ * @param scheduler
+ *     The scheduler whose queued audio should be sent.
+ *
+ * @param length
+ *     The number of bytes to send. This may not exceed the number of bytes
+ *     queued.
+ */
+static void guac_rdpsnd_scheduler_send(guac_rdpsnd_scheduler* scheduler,
+        int length) {
+
+    if (length == 0)
+        return;
+
+    /* Write data up to end of buffer */
+    int first = scheduler->capacity - scheduler->start;
+    if (first > length)
+        first = length;
+
+    guac_audio_stream_write_pcm(scheduler->audio,
+            scheduler->buffer + scheduler->start, first);
+
+    /* Write any remaining data from beginning of buffer */
+    if (length > first)
+        guac_audio_stream_write_pcm(scheduler->audio, scheduler->buffer,
+                length - first);
+
+    guac_audio_stream_flush(scheduler->audio);
+    guac_rdpsnd_scheduler_advance(scheduler, length);
+
+}
+
+/**
+ * Waits up to the given number of milliseconds for the queue of the given
+ * scheduler to be modified. The scheduler must be locked.
+ *
+ * @param scheduler
+ *     The scheduler to wait for.
+ *
+ * @param msec
+ *     The maximum number of milliseconds to wait.
+ */
+static void guac_rdpsnd_scheduler_wait(guac_rdpsnd_scheduler* scheduler,
+        int msec) {
+
+    struct timespec timeout;
+    clock_gettime(CLOCK_REALTIME, &timeout);
+
+    timeout.tv_sec += msec / 1000;
+    timeout.tv_nsec += (msec % 1000) * 1000000;
+
+    if (timeout.tv_nsec >= 1000000000) {
+        timeout.tv_sec++;
+        timeout.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(&scheduler->modified, &scheduler->lock, &timeout);
+
+}
+
+/**
+ * Thread which sends queued audio in packets of fixed duration, paced in real
+ * time, until the scheduler is stopped.
+ *
+ * @param data
+ *     The guac_rdpsnd_scheduler sending audio.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_rdpsnd_scheduler_thread(void* data) {
+
+    guac_rdpsnd_scheduler* scheduler = (guac_rdpsnd_scheduler*) data;
+
+    pthread_mutex_lock(&scheduler->lock);
+    while (!scheduler->stopping) {
+
+        guac_timestamp now = guac_timestamp_current();
+
+        /* Begin sending once the jitter buffer is full, or once no further
+         * audio has been received for the duration of a packet */
+        if (!scheduler->playing) {
+
+            if (scheduler->length == 0
+                    || (scheduler->length < guac_rdpsnd_scheduler_bytes(
+                            scheduler, GUAC_RDPSND_SCHEDULER_JITTER_BUFFER)
+                        && now - scheduler->last_queued
+                            < GUAC_RDPSND_SCHEDULER_PACKET_DURATION)) {
+                guac_rdpsnd_scheduler_wait(scheduler,
+                        GUAC_RDPSND_SCHEDULER_PACKET_DURATION);
+                continue;
+            }
+
+            scheduler->playing = 1;
+            scheduler->packets = 0;
+            scheduler->next_packet = now;
+
+        }
+
+        /* Wait until next packet is due */
+        if (now < scheduler->next_packet) {
+            guac_rdpsnd_scheduler_wait(scheduler,
+                    scheduler->next_packet - now);
+            continue;
+        }
+
+        /* Refill jitter buffer if the queue has run dry */
+        if (scheduler->length == 0) {
+            scheduler->playing = 0;
+            continue;
+        }
+
+        /* Drop oldest audio in excess of the latency budget, accounting for
+         * the time taken by the client to process what has been sent */
+        pthread_mutex_unlock(&scheduler->lock);
+        int budget = GUAC_RDPSND_SCHEDULER_LATENCY_BUDGET
+            - guac_client_get_processing_lag(scheduler->client);
+        pthread_mutex_lock(&scheduler->lock);
+
+        if (budget < GUAC_RDPSND_SCHEDULER_JITTER_BUFFER)
+            budget = GUAC_RDPSND_SCHEDULER_JITTER_BUFFER;
+
+        int excess = scheduler->length
+            - guac_rdpsnd_scheduler_bytes(scheduler, budget);
+
+        if (excess > 0)
+            guac_rdpsnd_scheduler_drop(scheduler, excess);
+
+        /* Send next packet, sized such that partial frames per packet do
+         * not accumulate */
+        int64_t frames = (int64_t) scheduler->rate
+            * GUAC_RDPSND_SCHEDULER_PACKET_DURATION;
+
+        int length = (frames * (scheduler->packets + 1) / 1000
+                - frames * scheduler->packets / 1000)
+            * scheduler->frame_size;
+
+        /* Wait for a full packet unless input appears to have stopped, in
+         * which case the remainder is sent as-is */
+        if (length > scheduler->length) {
+
+            int idle = now - scheduler->last_queued;
+            if (idle < GUAC_RDPSND_SCHEDULER_PACKET_DURATION) {
+                guac_rdpsnd_scheduler_wait(scheduler,
+                        GUAC_RDPSND_SCHEDULER_PACKET_DURATION - idle);
+                continue;
+            }
+
+            length = scheduler->length;
+
+        }
+
+        guac_rdpsnd_scheduler_send(scheduler, length);
+        scheduler->packets++;
+
+        /* Schedule following packet, without attempting to catch up after
+         * stalls */
+        scheduler->next_packet += GUAC_RDPSND_SCHEDULER_PACKET_DURATION;
+        if (scheduler->next_packet < now)
+            scheduler->next_packet = now;
+
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+
+    return NULL;
+
+}
+
+guac_rdpsnd_scheduler* guac_rdpsnd_scheduler_alloc(guac_client* client,
+        guac_audio_stream* audio) {
+
+    guac_rdpsnd_scheduler* scheduler =
+        calloc(1, sizeof(guac_rdpsnd_scheduler));
+
+    if (scheduler == NULL)
+        return NULL;
+
+    scheduler->client = client;
+    scheduler->audio = audio;
+
+    if (guac_rdpsnd_scheduler_configure(scheduler)) {
+        free(scheduler);
+        return NULL;
+    }
+
+    pthread_mutex_init(&scheduler->lock, NULL);
+    pthread_cond_init(&scheduler->modified, NULL);
+
+    if (pthread_create(&scheduler->thread, NULL,
+                guac_rdpsnd_scheduler_thread, scheduler)) {
+        pthread_cond_destroy(&scheduler->modified);
+        pthread_mutex_destroy(&scheduler->lock);
+        free(scheduler->buffer);
+        free(scheduler);
+        return NULL;
+    }
+
+    return scheduler;
+
+}
+
+void guac_rdpsnd_scheduler_reset(guac_rdpsnd_scheduler* scheduler,
+        int rate, int channels, int bps) {
+
+    guac_audio_stream* audio = scheduler->audio;
+
+    pthread_mutex_lock(&scheduler->lock);
+
+    /* Do nothing if nothing is changing */
+    if (rate == audio->rate && channels == audio->channels
+            && bps == audio->bps) {
+        pthread_mutex_unlock(&scheduler->lock);
+        return;
+    }
+
+    /* Audio already queued must be sent in its original format */
+    guac_rdpsnd_scheduler_send(scheduler, scheduler->length);
+
+    guac_audio_stream_reset(audio, NULL, rate, channels, bps);
+    if (guac_rdpsnd_scheduler_configure(scheduler))
+        guac_client_log(scheduler->client, GUAC_LOG_WARNING, "Unable to "
+                "allocate audio queue. Audio will be dropped.");
+
+    pthread_mutex_unlock(&scheduler->lock);
+
+}
+
+int guac_rdpsnd_scheduler_write(guac_rdpsnd_scheduler* scheduler,
+        const unsigned char* data, int length) {
+
+    pthread_mutex_lock(&scheduler->lock);
+
+    /* Drop all audio if no queue could be allocated */
+    if (scheduler->buffer == NULL) {
+        pthread_mutex_unlock(&scheduler->lock);
+        return 0;
+    }
+
+    /* Drop oldest audio to make room, including the oldest of the given
+     * audio if more than the queue can hold */
+    int overflow = scheduler->length + length - scheduler->capacity;
+    if (overflow > 0) {
+
+        guac_rdpsnd_scheduler_drop(scheduler, overflow);
+
+        if (length > scheduler->capacity) {
+            data += length - scheduler->capacity;
+            length = scheduler->capacity;
+        }
+
+    }
+
+    /* Queue data, wrapping around end of buffer as necessary */
+    int end = (scheduler->start + scheduler->length) % scheduler->capacity;
+    int first = scheduler->capacity - end;
+    if (first > length)
+        first = length;
+
+    memcpy(scheduler->buffer + end, data, first);
+    memcpy(scheduler->buffer, data + first, length - first);
+
+    scheduler->length += length;
+    scheduler->last_queued = guac_timestamp_current();
+
+    /* Calculate time until queued audio has been sent in full */
+    int delay = (int64_t) scheduler->length / scheduler->frame_size * 1000
+        / scheduler->rate;
+
+    pthread_cond_signal(&scheduler->modified);
+    pthread_mutex_unlock(&scheduler->lock);
+
+    return delay;
+
+}
+
+void guac_rdpsnd_scheduler_free(guac_rdpsnd_scheduler* scheduler) {
+
+    /* Stop sending thread */
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->stopping = 1;
+    pthread_cond_signal(&scheduler->modified);
+    pthread_mutex_unlock(&scheduler->lock);
+
+    pthread_join(scheduler->thread, NULL);
+
+    /* Send anything remaining */
+    guac_rdpsnd_scheduler_send(scheduler, scheduler->length);
+
+    pthread_cond_destroy(&scheduler->modified);
+    pthread_mutex_destroy(&scheduler->lock);
+    free(scheduler->buffer);
+    free(scheduler);
+
+}
+
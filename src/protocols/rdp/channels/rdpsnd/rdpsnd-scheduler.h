@@ -0,0 +1,229 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_RDP_CHANNELS_RDPSND_SCHEDULER_H
+#define GUAC_RDP_CHANNELS_RDPSND_SCHEDULER_H
+
+#include <guacamole/audio.h>
+#include <guacamole/client.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * The duration of audio sent within each packet, in milliseconds.
+ */
+#define GUAC_RDPSND_SCHEDULER_PACKET_DURATION 20
+
+/**
+ * The amount of audio which must be queued before packets are sent after the
+ * queue has run dry, in milliseconds. This absorbs jitter in the delivery of
+ * Wave PDUs by the RDP server such that brief delays do not result in gaps.
+ */
+#define GUAC_RDPSND_SCHEDULER_JITTER_BUFFER 60
+
+/**
+ * The maximum amount of audio which may be queued, in milliseconds, including
+ * the processing lag of connected users. If the queue grows beyond this
+ * budget, the oldest audio is dropped such that latency does not accumulate
+ * over the course of long sessions.
+ */
+#define GUAC_RDPSND_SCHEDULER_LATENCY_BUDGET 300
+
+/**
+ * The size of the queue of audio awaiting sending, in milliseconds. The
+ * equivalent size in bytes will vary by PCM rate, number of channels, and bits
+ * per sample.
+ */
+#define GUAC_RDPSND_SCHEDULER_QUEUE_SIZE 1000
+
+/**
+ * Output scheduler which queues PCM received within Wave PDUs and writes that
+ * PCM to the audio stream in packets of fixed duration, paced in real time by
+ * a dedicated thread. Packet size and timing therefore no longer depend on
+ * how the RDP server happens to group and deliver audio.
+ */
+typedef struct guac_rdpsnd_scheduler {
+
+    /**
+     * The client associated with the audio stream.
+     */
+    guac_client* client;
+
+    /**
+     * The audio stream receiving all scheduled packets.
+     */
+    guac_audio_stream* audio;
+
+    /**
+     * The thread sending queued audio.
+     */
+    pthread_t thread;
+
+    /**
+     * Lock which guards access to the queue and to the audio stream.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever audio is queued or the scheduler
+     * is stopping.
+     */
+    pthread_cond_t modified;
+
+    /**
+     * Non-zero if the sending thread should stop.
+     */
+    int stopping;
+
+    /**
+     * Circular buffer of queued PCM, in the current format of the audio
+     * stream.
+     */
+    unsigned char* buffer;
+
+    /**
+     * The size of the circular buffer, in bytes.
+     */
+    int capacity;
+
+    /**
+     * The offset of the oldest queued byte within the circular buffer.
+     */
+    int start;
+
+    /**
+     * The number of bytes currently queued.
+     */
+    int length;
+
+    /**
+     * The size of a single frame (one sample for each channel) in the
+     * current format of the audio stream, in bytes.
+     */
+    int frame_size;
+
+    /**
+     * The number of samples per second in the current format of the audio
+     * stream.
+     */
+    int rate;
+
+    /**
+     * Non-zero if packets are currently being sent, zero if waiting for the
+     * jitter buffer to fill.
+     */
+    int playing;
+
+    /**
+     * The time at which the next packet should be sent.
+     */
+    guac_timestamp next_packet;
+
+    /**
+     * The number of packets sent since packets last began being sent. The
+     * size of each packet is derived from this value such that packets of
+     * fractional duration in frames do not accumulate rounding error.
+     */
+    int64_t packets;
+
+    /**
+     * The time at which audio was last queued.
+     */
+    guac_timestamp last_queued;
+
+    /**
+     * The number of bytes dropped due to the latency budget since this
+     * value was last logged.
+     */
+    int dropped;
+
+} guac_rdpsnd_scheduler;
+
+/**
+ * Allocates a new scheduler which writes to the given audio stream, starting
+ * its sending thread.
+ *
+ * @param client
+ *     The client associated with the audio stream.
+ *
+ * @param audio
+ *     The audio stream which should receive all scheduled packets.
+ *
+ * @return
+ *     A newly-allocated scheduler, or NULL if the scheduler could not be
+ *     allocated or its sending thread could not be started.
+ */
+guac_rdpsnd_scheduler* guac_rdpsnd_scheduler_alloc(guac_client* client,
+        guac_audio_stream* audio);
+
+/**
+ * Changes the format of the PCM provided to the given scheduler, resetting
+ * its audio stream with guac_audio_stream_reset(). Any audio queued in the
+ * previous format is written to the audio stream immediately. If the format
+ * is unchanged, this function has no effect.
+ *
+ * @param scheduler
+ *     The scheduler whose format should change.
+ *
+ * @param rate
+ *     The number of samples per second of PCM.
+ *
+ * @param channels
+ *     The number of audio channels per sample of PCM.
+ *
+ * @param bps
+ *     The number of bits per sample per channel of PCM.
+ */
+void guac_rdpsnd_scheduler_reset(guac_rdpsnd_scheduler* scheduler,
+        int rate, int channels, int bps);
+
+/**
+ * Queues the given PCM for sending, dropping the oldest queued audio if the
+ * queue is full.
+ *
+ * @param scheduler
+ *     The scheduler to queue PCM within.
+ *
+ * @param data
+ *     The PCM to queue, in the current format of the scheduler.
+ *
+ * @param length
+ *     The number of bytes of PCM to queue.
+ *
+ * @return
+ *     The approximate number of milliseconds until the given PCM will have
+ *     been sent in full.
+ */
+int guac_rdpsnd_scheduler_write(guac_rdpsnd_scheduler* scheduler,
+        const unsigned char* data, int length);
+
+/**
+ * Stops the sending thread of the given scheduler, writing any queued audio
+ * to the audio stream, and frees the scheduler. The audio stream itself is
+ * not freed.
+ *
+ * @param scheduler
+ *     The scheduler to free.
+ */
+void guac_rdpsnd_scheduler_free(guac_rdpsnd_scheduler* scheduler);
+
+#endif
+
@@ -86,14 +86,32 @@ void guac_rdpsnd_process_receive(guac_rdp_common_svc* svc,
 
 void guac_rdpsnd_process_connect(guac_rdp_common_svc* svc) {
 
+    guac_client* client = svc->client;
+    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
+
     guac_rdpsnd* rdpsnd = (guac_rdpsnd*) calloc(1, sizeof(guac_rdpsnd));
     svc->data = rdpsnd;
 
+    /* Schedule all audio received, if audio is enabled */
+    if (rdp_client->audio != NULL) {
+        rdpsnd->scheduler = guac_rdpsnd_scheduler_alloc(client,
+                rdp_client->audio);
+        if (rdpsnd->scheduler == NULL)
+            guac_client_log(client, GUAC_LOG_WARNING, "Audio output could "
+                    "not be scheduled. Sound will not work.");
+    }
+
 }
 
 void guac_rdpsnd_process_terminate(guac_rdp_common_svc* svc) {
+
     guac_rdpsnd* rdpsnd = (guac_rdpsnd*) svc->data;
+
+    if (rdpsnd->scheduler != NULL)
+        guac_rdpsnd_scheduler_free(rdpsnd->scheduler);
+
     free(rdpsnd);
+
 }
 
 void guac_rdpsnd_load_plugin(rdpContext* context) {
@@ -21,6 +21,7 @@
 #define GUAC_RDP_CHANNELS_RDPSND_H
 
 #include "channels/common-svc.h"
+#include "channels/rdpsnd/rdpsnd-scheduler.h"
 
 #include <freerdp/freerdp.h>
 #include <guacamole/client.h>
@@ -103,6 +104,12 @@ typedef struct guac_rdpsnd {
      */
     int format_count;
 
+    /**
+     * The scheduler which paces all received audio into packets of fixed
+     * duration, or NULL if audio is disabled.
+     */
+    guac_rdpsnd_scheduler* scheduler;
+
 } guac_rdpsnd;
 
 /**
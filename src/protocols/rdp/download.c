@@ -35,6 +35,34 @@
 
 #include <stdlib.h>
 
+/**
+ * Allocates the transfer status of a new download of the file having the
+ * given ID, advising the operating system that the beginning of that file
+ * will be read soon.
+ *
+ * @param fs
+ *     The filesystem containing the file being downloaded.
+ *
+ * @param file_id
+ *     The ID of the file being downloaded, as returned by guac_rdp_fs_open().
+ *
+ * @return
+ *     A newly-allocated guac_rdp_download_status, which must be freed with
+ *     free() once the download is complete.
+ */
+static guac_rdp_download_status* guac_rdp_download_status_alloc(
+        guac_rdp_fs* fs, int file_id) {
+
+    guac_rdp_download_status* download_status =
+        calloc(1, sizeof(guac_rdp_download_status));
+
+    download_status->file_id = file_id;
+    guac_rdp_fs_read_ahead(fs, file_id, 0, GUAC_RDP_DOWNLOAD_BUFFER_SIZE);
+
+    return download_status;
+
+}
+
 int guac_rdp_download_ack_handler(guac_user* user, guac_stream* stream,
         char* message, guac_protocol_status status) {
 
@@ -51,50 +79,116 @@ int guac_rdp_download_ack_handler(guac_user* user, guac_stream* stream,
         return 0;
     }
 
-    /* If successful, read data */
-    if (status == GUAC_PROTOCOL_STATUS_SUCCESS) {
+    /* Abort download and return stream to user if unsuccessful */
+    if (status != GUAC_PROTOCOL_STATUS_SUCCESS) {
+        guac_rdp_fs_close(fs, download_status->file_id);
+        guac_user_free_stream(user, stream);
+        free(download_status);
+        return 0;
+    }
+
+    /* The first ack acknowledges the stream itself, not a blob */
+    if (download_status->in_flight > 0)
+        download_status->in_flight--;
 
-        /* Attempt read into buffer */
-        char buffer[4096];
-        int bytes_read = guac_rdp_fs_read(fs,
-                download_status->file_id,
-                download_status->offset, buffer, sizeof(buffer));
+    /* Refill window of unacknowledged blobs */
+    while (download_status->in_flight < GUAC_RDP_DOWNLOAD_WINDOW) {
+
+        /* Refill buffer with a single read once exhausted */
+        if (download_status->buffer_pos == download_status->buffer_length) {
+
+            if (download_status->eof)
+                break;
+
+            int bytes_read = guac_rdp_fs_read(fs,
+                    download_status->file_id, download_status->offset,
+                    download_status->buffer,
+                    sizeof(download_status->buffer));
+
+            /* Stop reading at EOF or upon error */
+            if (bytes_read <= 0) {
+
+                if (bytes_read < 0)
+                    guac_user_log(user, GUAC_LOG_ERROR,
+                            "Error reading file for download");
+
+                download_status->eof = 1;
+                break;
+
+            }
 
-        /* If bytes read, send as blob */
-        if (bytes_read > 0) {
             download_status->offset += bytes_read;
-            guac_protocol_send_blob(user->socket, stream,
-                    buffer, bytes_read);
-        }
+            download_status->buffer_length = bytes_read;
+            download_status->buffer_pos = 0;
 
-        /* If EOF, send end */
-        else if (bytes_read == 0) {
-            guac_protocol_send_end(user->socket, stream);
-            guac_user_free_stream(user, stream);
-            free(download_status);
-        }
+            /* Allow the following data to be read while this is sent */
+            guac_rdp_fs_read_ahead(fs, download_status->file_id,
+                    download_status->offset, GUAC_RDP_DOWNLOAD_BUFFER_SIZE);
 
-        /* Otherwise, fail stream */
-        else {
-            guac_user_log(user, GUAC_LOG_ERROR,
-                    "Error reading file for download");
-            guac_protocol_send_end(user->socket, stream);
-            guac_user_free_stream(user, stream);
-            free(download_status);
         }
 
-        guac_socket_flush(user->socket);
+        /* Send next blob from buffer */
+        int length = download_status->buffer_length
+            - download_status->buffer_pos;
+
+        if (length > GUAC_PROTOCOL_BLOB_MAX_LENGTH)
+            length = GUAC_PROTOCOL_BLOB_MAX_LENGTH;
+
+        guac_protocol_send_blob(user->socket, stream,
+                download_status->buffer + download_status->buffer_pos,
+                length);
+
+        download_status->buffer_pos += length;
+        download_status->in_flight++;
 
     }
 
-    /* Otherwise, return stream to user */
-    else
+    /* End stream once all data has been sent and acknowledged */
+    if (download_status->eof && download_status->in_flight == 0) {
+        guac_protocol_send_end(user->socket, stream);
         guac_user_free_stream(user, stream);
+        guac_rdp_fs_close(fs, download_status->file_id);
+        free(download_status);
+    }
 
+    guac_socket_flush(user->socket);
     return 0;
 
 }
 
+/**
+ * Begins sending the given directory listing to the given user as the body of
+ * the given object.
+ *
+ * @param user
+ *     The user who requested the directory listing.
+ *
+ * @param object
+ *     The object associated with the request.
+ *
+ * @param ls_status
+ *     The state of the directory listing to send.
+ *
+ * @param name
+ *     The name of the request, as received in the "get" instruction.
+ */
+static void guac_rdp_download_list(guac_user* user, guac_object* object,
+        guac_rdp_ls_status* ls_status, const char* name) {
+
+    /* Allocate stream for body */
+    guac_stream* stream = guac_user_alloc_stream(user);
+    stream->ack_handler = guac_rdp_ls_ack_handler;
+    stream->data = ls_status;
+
+    /* Init JSON object state */
+    guac_common_json_begin_object(user, stream, &ls_status->json_state);
+
+    /* Associate new stream with get request */
+    guac_protocol_send_body(user->socket, object, stream,
+            GUAC_USER_STREAM_INDEX_MIMETYPE, name);
+
+}
+
 int guac_rdp_download_get_handler(guac_user* user, guac_object* object,
         char* name) {
 
@@ -106,8 +200,28 @@ int guac_rdp_download_get_handler(guac_user* user, guac_object* object,
     if (fs == NULL)
         return 0;
 
+    /* Determine whether only a page of a directory is requested */
+    guac_common_listing_page page;
+    if (guac_common_listing_parse(name, &page)) {
+        guac_user_log(user, GUAC_LOG_INFO, "Invalid directory listing "
+                "request \"%s\"", name);
+        return 0;
+    }
+
+    /* Continue from where the previous page ended, if that listing is still
+     * retained */
+    guac_rdp_ls_status* ls_status =
+        guac_common_listing_cache_take(&fs->listings, &page);
+    if (ls_status != NULL) {
+        ls_status->page = page;
+        ls_status->page.path = ls_status->directory_name;
+        guac_rdp_download_list(user, object, ls_status, name);
+        return 0;
+    }
+
     /* Attempt to open file for reading */
-    int file_id = guac_rdp_fs_open(fs, name, GENERIC_READ, 0, FILE_OPEN, 0);
+    int file_id = guac_rdp_fs_open(fs, page.path, GENERIC_READ, 0,
+            FILE_OPEN, 0);
     if (file_id < 0) {
         guac_user_log(user, GUAC_LOG_INFO, "Unable to read file \"%s\"",
                 name);
@@ -127,34 +241,31 @@ int guac_rdp_download_get_handler(guac_user* user, guac_object* object,
     if (file->attributes & FILE_ATTRIBUTE_DIRECTORY) {
 
         /* Create stream data */
-        guac_rdp_ls_status* ls_status = malloc(sizeof(guac_rdp_ls_status));
-        ls_status->fs = fs;
-        ls_status->file_id = file_id;
-        guac_strlcpy(ls_status->directory_name, name,
-                sizeof(ls_status->directory_name));
-
-        /* Allocate stream for body */
-        guac_stream* stream = guac_user_alloc_stream(user);
-        stream->ack_handler = guac_rdp_ls_ack_handler;
-        stream->data = ls_status;
+        ls_status = guac_rdp_ls_status_alloc(fs, file_id, &page);
+        if (ls_status == NULL) {
+            guac_user_log(user, GUAC_LOG_INFO, "Unable to read directory "
+                    "\"%s\": Path too long", page.path);
+            guac_rdp_fs_close(fs, file_id);
+            return 0;
+        }
 
-        /* Init JSON object state */
-        guac_common_json_begin_object(user, stream,
-                &ls_status->json_state);
+        guac_rdp_download_list(user, object, ls_status, name);
 
-        /* Associate new stream with get request */
-        guac_protocol_send_body(user->socket, object, stream,
-                GUAC_USER_STREAM_INDEX_MIMETYPE, name);
+    }
 
+    /* Only directories may be listed in pages */
+    else if (page.paged) {
+        guac_user_log(user, GUAC_LOG_INFO, "Unable to list \"%s\": Not a "
+                "directory", page.path);
+        guac_rdp_fs_close(fs, file_id);
     }
 
     /* Otherwise, send file contents if downloads are allowed */
     else if (!fs->disable_download) {
 
         /* Create stream data */
-        guac_rdp_download_status* download_status = malloc(sizeof(guac_rdp_download_status));
-        download_status->file_id = file_id;
-        download_status->offset = 0;
+        guac_rdp_download_status* download_status =
+            guac_rdp_download_status_alloc(fs, file_id);
 
         /* Allocate stream for body */
         guac_stream* stream = guac_user_alloc_stream(user);
@@ -208,11 +319,10 @@ void* guac_rdp_download_to_user(guac_user* user, void* data) {
 
         /* Associate stream with transfer status */
         guac_stream* stream = guac_user_alloc_stream(user);
-        guac_rdp_download_status* download_status = malloc(sizeof(guac_rdp_download_status));
+        guac_rdp_download_status* download_status =
+            guac_rdp_download_status_alloc(filesystem, file_id);
         stream->data = download_status;
         stream->ack_handler = guac_rdp_download_ack_handler;
-        download_status->file_id = file_id;
-        download_status->offset = 0;
 
         guac_user_log(user, GUAC_LOG_DEBUG, "%s: Initiating download "
                 "of \"%s\"", __func__, path);
@@ -28,6 +28,19 @@
 
 #include <stdint.h>
 
+/**
+ * The number of blobs of a download which may be sent to the user without
+ * having been acknowledged.
+ */
+#define GUAC_RDP_DOWNLOAD_WINDOW 16
+
+/**
+ * The number of bytes to read from the file being downloaded at once. Blobs
+ * are sent from this buffer until exhausted, at which point the buffer is
+ * refilled with a single read.
+ */
+#define GUAC_RDP_DOWNLOAD_BUFFER_SIZE 262144
+
 /**
  * The transfer status of a file being downloaded.
  */
@@ -39,10 +52,37 @@ typedef struct guac_rdp_download_status {
     int file_id;
 
     /**
-     * The current position within the file.
+     * The position within the file of the next byte to read into the buffer.
      */
     uint64_t offset;
 
+    /**
+     * The number of blobs sent which have not yet been acknowledged.
+     */
+    int in_flight;
+
+    /**
+     * Non-zero if the end of the file has been reached or reading has failed,
+     * such that the download is complete once the buffer has been sent and
+     * all blobs have been acknowledged.
+     */
+    int eof;
+
+    /**
+     * The number of bytes of data within the buffer.
+     */
+    int buffer_length;
+
+    /**
+     * The offset within the buffer of the next byte to send.
+     */
+    int buffer_pos;
+
+    /**
+     * Data read from the file which has not necessarily been sent yet.
+     */
+    char buffer[GUAC_RDP_DOWNLOAD_BUFFER_SIZE];
+
 } guac_rdp_download_status;
 
 /**
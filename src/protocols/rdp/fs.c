@@ -17,9 +17,12 @@
  * under the License.
  */
 
+#include "config.h"
 #include "fs.h"
 #include "download.h"
+#include "ls.h"
 #include "upload.h"
+#include "common/stat-cache.h"
 
 #include <guacamole/client.h>
 #include <guacamole/object.h>
@@ -67,12 +70,19 @@ guac_rdp_fs* guac_rdp_fs_alloc(guac_client* client, const char* drive_path,
     fs->open_files = 0;
     fs->disable_download = disable_download;
     fs->disable_upload = disable_upload;
+    fs->stat_cache = guac_common_stat_cache_alloc(GUAC_RDP_FS_STAT_CACHE_TTL);
+    if (fs->stat_cache == NULL)
+        guac_client_log(client, GUAC_LOG_WARNING, "Unable to allocate file "
+                "metadata cache. File metadata will not be cached.");
+    guac_common_listing_cache_init(&fs->listings, guac_rdp_ls_status_free);
 
     return fs;
 
 }
 
 void guac_rdp_fs_free(guac_rdp_fs* fs) {
+    guac_common_listing_cache_destroy(&fs->listings);
+    guac_common_stat_cache_free(fs->stat_cache);
     guac_pool_free(fs->file_id_pool);
     free(fs->drive_path);
     free(fs);
@@ -115,7 +125,9 @@ void* guac_rdp_fs_expose(guac_user* user, void* data) {
  * Translates an absolute Windows path to an absolute path which is within the
  * "drive path" specified in the connection settings. No checking is performed
  * on the path provided, which is assumed to have already been normalized and
- * validated as absolute.
+ * validated as absolute. The root directory translates to the drive path
+ * itself, such that each file has exactly one real path, and the real path of
+ * any directory is the prefix of the real paths of the files within it.
  *
  * @param fs
  *     The filesystem containing the file whose path is being translated.
@@ -149,6 +161,10 @@ static void __guac_rdp_fs_translate_path(guac_rdp_fs* fs,
 
     }
 
+    /* The root directory is the drive path itself */
+    if (strcmp(virtual_path, "\\") == 0)
+        virtual_path++;
+
     /* Translate path */
     for (; i<GUAC_RDP_FS_MAX_PATH-1; i++) {
 
@@ -171,6 +187,25 @@ static void __guac_rdp_fs_translate_path(guac_rdp_fs* fs,
 
 }
 
+/**
+ * Converts the given file status, as returned by stat() or fstat(), into the
+ * metadata stored within a stat cache.
+ *
+ * @param file_stat
+ *     The file status to convert.
+ *
+ * @param info
+ *     The structure to populate with the converted metadata.
+ */
+static void __guac_rdp_fs_stat_to_info(const struct stat* file_stat,
+        guac_common_stat_cache_info* info) {
+    info->directory = S_ISDIR(file_stat->st_mode);
+    info->size  = file_stat->st_size;
+    info->ctime = file_stat->st_ctime;
+    info->mtime = file_stat->st_mtime;
+    info->atime = file_stat->st_atime;
+}
+
 int guac_rdp_fs_get_errorcode(int err) {
 
     /* Translate errno codes to GUAC_RDP_FS codes */
@@ -312,6 +347,7 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
         /* Supersede (replace) if exists, otherwise create */
         case FILE_SUPERSEDE:
             unlink(real_path);
+            guac_common_stat_cache_invalidate(fs->stat_cache, real_path);
             flags |= O_CREAT | O_TRUNC;
             break;
 
@@ -333,6 +369,10 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
                 return guac_rdp_fs_get_errorcode(errno);
             }
         }
+        else {
+            guac_common_stat_cache_invalidate(fs->stat_cache, real_path);
+            guac_common_listing_cache_invalidate(&fs->listings);
+        }
 
         /* Unset O_CREAT and O_EXCL as directory must exist before open() */
         flags &= ~(O_CREAT | O_EXCL);
@@ -359,6 +399,16 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    /* Files which may have been created or truncated have changed, as has
+     * the directory containing any newly-created file */
+    if (flags & (O_CREAT | O_TRUNC))
+        guac_common_stat_cache_invalidate(fs->stat_cache, real_path);
+
+    /* Any file which may have been created may be missing from a retained
+     * directory listing */
+    if (flags & O_CREAT)
+        guac_common_listing_cache_invalidate(&fs->listings);
+
     /* Get file ID, init file */
     file_id = guac_pool_next_int(fs->file_id_pool);
     file = &(fs->files[file_id]);
@@ -377,6 +427,11 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
     /* Attempt to pull file information */
     if (fstat(fd, &file_stat) == 0) {
 
+        /* Cache information for future directory listings */
+        guac_common_stat_cache_info info;
+        __guac_rdp_fs_stat_to_info(&file_stat, &info);
+        guac_common_stat_cache_put(fs->stat_cache, real_path, &info);
+
         /* Load size and times */
         file->size  = file_stat.st_size;
         file->ctime = WINDOWS_TIME(file_stat.st_ctime);
@@ -422,8 +477,7 @@ int guac_rdp_fs_read(guac_rdp_fs* fs, int file_id, uint64_t offset,
     }
 
     /* Attempt read */
-    lseek(file->fd, offset, SEEK_SET);
-    bytes_read = read(file->fd, buffer, length);
+    bytes_read = pread(file->fd, buffer, length, offset);
 
     /* Translate errno on error */
     if (bytes_read < 0)
@@ -446,18 +500,30 @@ int guac_rdp_fs_write(guac_rdp_fs* fs, int file_id, uint64_t offset,
     }
 
     /* Attempt write */
-    lseek(file->fd, offset, SEEK_SET);
-    bytes_written = write(file->fd, buffer, length);
+    bytes_written = pwrite(file->fd, buffer, length, offset);
 
     /* Translate errno on error */
     if (bytes_written < 0)
         return guac_rdp_fs_get_errorcode(errno);
 
+    guac_common_stat_cache_invalidate(fs->stat_cache, file->real_path);
+
     file->bytes_written += bytes_written;
     return bytes_written;
 
 }
 
+void guac_rdp_fs_read_ahead(guac_rdp_fs* fs, int file_id, uint64_t offset,
+        int length) {
+
+#ifdef HAVE_POSIX_FADVISE
+    guac_rdp_fs_file* file = guac_rdp_fs_get_file(fs, file_id);
+    if (file != NULL)
+        posix_fadvise(file->fd, offset, length, POSIX_FADV_WILLNEED);
+#endif
+
+}
+
 int guac_rdp_fs_rename(guac_rdp_fs* fs, int file_id,
         const char* new_path) {
 
@@ -494,6 +560,10 @@ int guac_rdp_fs_rename(guac_rdp_fs* fs, int file_id,
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    guac_common_stat_cache_invalidate(fs->stat_cache, file->real_path);
+    guac_common_stat_cache_invalidate(fs->stat_cache, real_path);
+    guac_common_listing_cache_invalidate(&fs->listings);
+
     return 0;
 
 }
@@ -524,6 +594,9 @@ int guac_rdp_fs_delete(guac_rdp_fs* fs, int file_id) {
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    guac_common_stat_cache_invalidate(fs->stat_cache, file->real_path);
+    guac_common_listing_cache_invalidate(&fs->listings);
+
     return 0;
 
 }
@@ -546,6 +619,8 @@ int guac_rdp_fs_truncate(guac_rdp_fs* fs, int file_id, int length) {
         return guac_rdp_fs_get_errorcode(errno);
     }
 
+    guac_common_stat_cache_invalidate(fs->stat_cache, file->real_path);
+
     return 0;
 
 }
@@ -600,6 +675,10 @@ const char* guac_rdp_fs_read_dir(guac_rdp_fs* fs, int file_id) {
         file->dir = fdopendir(file->fd);
         if (file->dir == NULL)
             return NULL;
+
+        /* Keep metadata of listed files current with changes made locally */
+        guac_common_stat_cache_watch(fs->stat_cache, file->real_path);
+
     }
 
     /* Read next entry, stop if error or no more entries */
@@ -611,6 +690,48 @@ const char* guac_rdp_fs_read_dir(guac_rdp_fs* fs, int file_id) {
 
 }
 
+int guac_rdp_fs_get_metadata(guac_rdp_fs* fs, const char* path,
+        guac_rdp_fs_metadata* metadata) {
+
+    char real_path[GUAC_RDP_FS_MAX_PATH];
+    char normalized_path[GUAC_RDP_FS_MAX_PATH];
+
+    struct stat file_stat;
+    guac_common_stat_cache_info info;
+
+    /* Normalize path, return no-such-file if invalid  */
+    if (guac_rdp_fs_normalize_path(path, normalized_path))
+        return GUAC_RDP_FS_ENOENT;
+
+    /* Translate normalized path to real path */
+    __guac_rdp_fs_translate_path(fs, normalized_path, real_path);
+
+    /* Query and cache file status only if not already cached */
+    if (!guac_common_stat_cache_get(fs->stat_cache, real_path, &info)) {
+
+        if (stat(real_path, &file_stat))
+            return guac_rdp_fs_get_errorcode(errno);
+
+        __guac_rdp_fs_stat_to_info(&file_stat, &info);
+        guac_common_stat_cache_put(fs->stat_cache, real_path, &info);
+
+    }
+
+    /* Convert to Windows attributes and timestamps */
+    metadata->size  = info.size;
+    metadata->ctime = WINDOWS_TIME(info.ctime);
+    metadata->mtime = WINDOWS_TIME(info.mtime);
+    metadata->atime = WINDOWS_TIME(info.atime);
+
+    if (info.directory)
+        metadata->attributes = FILE_ATTRIBUTE_DIRECTORY;
+    else
+        metadata->attributes = FILE_ATTRIBUTE_NORMAL;
+
+    return 0;
+
+}
+
 const char* guac_rdp_fs_basename(const char* path) {
 
     for (const char* c = path; *c != '\0'; c++) {
@@ -31,6 +31,9 @@
  * @file fs.h 
  */
 
+#include "common/listing.h"
+#include "common/stat-cache.h"
+
 #include <guacamole/client.h>
 #include <guacamole/object.h>
 #include <guacamole/pool.h>
@@ -54,6 +57,14 @@
  */
 #define GUAC_RDP_MAX_PATH_DEPTH 64
 
+/**
+ * The number of milliseconds that cached file metadata remains valid. As
+ * directories are watched for changes made by other processes where
+ * supported, this duration only bounds the staleness of metadata where such
+ * changes cannot be detected.
+ */
+#define GUAC_RDP_FS_STAT_CACHE_TTL 5000
+
 /**
  * Error code returned when no more file IDs can be allocated.
  */
@@ -182,6 +193,39 @@ typedef struct guac_rdp_fs_file {
 
 } guac_rdp_fs_file;
 
+/**
+ * The metadata of an arbitrary file on the virtual filesystem of the
+ * Guacamole drive, as retrieved without opening that file.
+ */
+typedef struct guac_rdp_fs_metadata {
+
+    /**
+     * Bitwise OR of all associated Windows file attributes.
+     */
+    int attributes;
+
+    /**
+     * The size of the file, in bytes.
+     */
+    uint64_t size;
+
+    /**
+     * The time the file was created, as a Windows timestamp.
+     */
+    uint64_t ctime;
+
+    /**
+     * The time the file was last modified, as a Windows timestamp.
+     */
+    uint64_t mtime;
+
+    /**
+     * The time the file was last accessed, as a Windows timestamp.
+     */
+    uint64_t atime;
+
+} guac_rdp_fs_metadata;
+
 /**
  * A virtual filesystem implementing RDP-style operations.
  */
@@ -211,6 +255,20 @@ typedef struct guac_rdp_fs {
      * All available file structures.
      */
     guac_rdp_fs_file files[GUAC_RDP_FS_MAX_FILES];
+
+    /**
+     * Cache of the metadata of files within the drive, keyed by real path,
+     * such that directories may be listed without opening each file.
+     */
+    guac_common_stat_cache* stat_cache;
+
+    /**
+     * The state of the most recent paged directory listing, retained such
+     * that the following page continues that listing rather than reading the
+     * directory again. The retained listing is discarded whenever an entry
+     * of the drive is created, renamed, or deleted.
+     */
+    guac_common_listing_cache listings;
     
     /**
      * If downloads from the remote server to the browser should be disabled.
@@ -465,6 +523,28 @@ int guac_rdp_fs_read(guac_rdp_fs* fs, int file_id, uint64_t offset,
 int guac_rdp_fs_write(guac_rdp_fs* fs, int file_id, uint64_t offset,
         void* buffer, int length);
 
+/**
+ * Advises the operating system that the given range of bytes within the file
+ * having the given ID will be read soon, allowing that range to be read ahead
+ * into the page cache. If such advice is not supported by the platform, or
+ * the file ID is invalid, this function has no effect.
+ *
+ * @param fs
+ *     The filesystem containing the file which will be read.
+ *
+ * @param file_id
+ *     The ID of the file which will be read, as returned by
+ *     guac_rdp_fs_open().
+ *
+ * @param offset
+ *     The byte offset of the start of the range which will be read.
+ *
+ * @param length
+ *     The number of bytes which will be read.
+ */
+void guac_rdp_fs_read_ahead(guac_rdp_fs* fs, int file_id, uint64_t offset,
+        int length);
+
 /**
  * Renames (moves) the file with the given ID to the new path specified.
  * Returns zero on success, or an error code if an error occurs.
@@ -603,6 +683,26 @@ int guac_rdp_fs_convert_path(const char* parent, const char* rel_path,
  */
 const char* guac_rdp_fs_read_dir(guac_rdp_fs* fs, int file_id);
 
+/**
+ * Retrieves the metadata of the file at the given path without opening that
+ * file, using previously-cached metadata if available.
+ *
+ * @param fs
+ *     The filesystem containing the file.
+ *
+ * @param path
+ *     The absolute path of the file within the given filesystem.
+ *
+ * @param metadata
+ *     The structure to populate with the metadata of the file.
+ *
+ * @return
+ *     Zero on success, or an error code defined above as a negative value
+ *     if the file does not exist or its metadata cannot be retrieved.
+ */
+int guac_rdp_fs_get_metadata(guac_rdp_fs* fs, const char* path,
+        guac_rdp_fs_metadata* metadata);
+
 /**
  * Returns the file having the given ID, or NULL if no such file exists.
  *
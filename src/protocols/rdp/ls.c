@@ -24,6 +24,7 @@
 #include <guacamole/protocol.h>
 #include <guacamole/socket.h>
 #include <guacamole/stream.h>
+#include <guacamole/string.h>
 #include <guacamole/user.h>
 #include <winpr/nt.h>
 #include <winpr/shell.h>
@@ -31,33 +32,151 @@
 #include <stdlib.h>
 #include <string.h>
 
+guac_rdp_ls_status* guac_rdp_ls_status_alloc(guac_rdp_fs* fs, int file_id,
+        const guac_common_listing_page* page) {
+
+    const char* filename;
+
+    guac_rdp_ls_status* ls_status = calloc(1, sizeof(guac_rdp_ls_status));
+    ls_status->fs = fs;
+    ls_status->file_id = file_id;
+    ls_status->page = *page;
+    ls_status->page.path = ls_status->directory_name;
+
+    /* Fail if directory name is too long to store */
+    if (guac_strlcpy(ls_status->directory_name, page->path,
+                sizeof(ls_status->directory_name))
+            >= sizeof(ls_status->directory_name)) {
+        free(ls_status);
+        return NULL;
+    }
+
+    /* Read all entries up front if they must be sorted */
+    if (page->order == GUAC_COMMON_LISTING_ORDER_NAME) {
+
+        while ((filename = guac_rdp_fs_read_dir(fs, file_id)) != NULL) {
+
+            /* Skip current and parent directory entries */
+            if (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0)
+                continue;
+
+            if (guac_common_listing_entries_add(&ls_status->entries, filename,
+                        GUAC_COMMON_LISTING_TYPE_UNKNOWN))
+                break;
+
+        }
+
+        guac_common_listing_entries_sort(&ls_status->entries);
+
+    }
+
+    return ls_status;
+
+}
+
+void guac_rdp_ls_status_free(void* data) {
+    guac_rdp_ls_status* ls_status = (guac_rdp_ls_status*) data;
+    guac_rdp_fs_close(ls_status->fs, ls_status->file_id);
+    guac_common_listing_entries_free(&ls_status->entries);
+    free(ls_status);
+}
+
+/**
+ * Returns the name of the next entry of the directory being listed, skipping
+ * the current and parent directory entries, and advancing the position of
+ * the listing.
+ *
+ * @param ls_status
+ *     The directory listing state to read from.
+ *
+ * @return
+ *     The name of the next entry, or NULL if no entries remain.
+ */
+static const char* guac_rdp_ls_next(guac_rdp_ls_status* ls_status) {
+
+    const char* filename;
+
+    /* Read from sorted entries, if sorted */
+    if (ls_status->page.order == GUAC_COMMON_LISTING_ORDER_NAME) {
+
+        if (ls_status->position >= ls_status->entries.count)
+            return NULL;
+
+        return ls_status->entries.entries[ls_status->position++].name;
+
+    }
+
+    /* Otherwise, read directly from directory */
+    do {
+        filename = guac_rdp_fs_read_dir(ls_status->fs, ls_status->file_id);
+        if (filename == NULL)
+            return NULL;
+    } while (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0);
+
+    ls_status->position++;
+    return filename;
+
+}
+
 int guac_rdp_ls_ack_handler(guac_user* user, guac_stream* stream,
         char* message, guac_protocol_status status) {
 
     int blob_written = 0;
+    int complete = 0;
+    int retain = 0;
     const char* filename;
 
     guac_rdp_ls_status* ls_status = (guac_rdp_ls_status*) stream->data;
+    guac_common_listing_page* page = &ls_status->page;
 
     /* If unsuccessful, free stream and abort */
     if (status != GUAC_PROTOCOL_STATUS_SUCCESS) {
-        guac_rdp_fs_close(ls_status->fs, ls_status->file_id);
         guac_user_free_stream(user, stream);
-        free(ls_status);
+        guac_rdp_ls_status_free(ls_status);
         return 0;
     }
 
-    /* While directory entries remain */
-    while ((filename = guac_rdp_fs_read_dir(ls_status->fs,
-                    ls_status->file_id)) != NULL
-            && !blob_written) {
+    /* While directory entries remain and no blob has yet been written */
+    while (!blob_written) {
 
-        char absolute_path[GUAC_RDP_FS_MAX_PATH];
+        /* Stop at end of requested page, linking to the following page */
+        if (page->paged && ls_status->position >= page->offset + page->limit) {
+
+            char next[GUAC_COMMON_LISTING_MAX_PREFIX_LENGTH
+                + GUAC_RDP_FS_MAX_PATH];
+
+            /* Only link to pages which are known to be non-empty, if known */
+            if ((page->order != GUAC_COMMON_LISTING_ORDER_NAME
+                    || ls_status->position < ls_status->entries.count)
+                    && !guac_common_listing_next(page, next, sizeof(next))) {
+                guac_common_json_write_property(user, stream,
+                        &ls_status->json_state, next,
+                        GUAC_COMMON_LISTING_NEXT_MIMETYPE);
+                retain = 1;
+            }
 
-        /* Skip current and parent directory entries */
-        if (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0)
+            complete = 1;
+            break;
+
+        }
+
+        /* Skip directly to the requested page, if sorted */
+        if (page->order == GUAC_COMMON_LISTING_ORDER_NAME
+                && ls_status->position < page->offset)
+            ls_status->position = page->offset;
+
+        /* Stop at end of directory */
+        if ((filename = guac_rdp_ls_next(ls_status)) == NULL) {
+            complete = 1;
+            break;
+        }
+
+        /* Skip entries preceding the requested page */
+        if (ls_status->position <= page->offset)
             continue;
 
+        char absolute_path[GUAC_RDP_FS_MAX_PATH];
+
         /* Concatenate into absolute path - skip if invalid */
         if (!guac_rdp_fs_append_filename(absolute_path,
                     ls_status->directory_name, filename)) {
@@ -69,45 +188,38 @@ int guac_rdp_ls_ack_handler(guac_user* user, guac_stream* stream,
             continue;
         }
 
-        /* Attempt to open file to determine type */
-        int file_id = guac_rdp_fs_open(ls_status->fs, absolute_path,
-                GENERIC_READ, 0, FILE_OPEN, 0);
-        if (file_id < 0)
+        /* Retrieve metadata of file to determine type */
+        guac_rdp_fs_metadata metadata;
+        if (guac_rdp_fs_get_metadata(ls_status->fs, absolute_path, &metadata))
             continue;
 
-        /* Get opened file */
-        guac_rdp_fs_file* file = guac_rdp_fs_get_file(ls_status->fs, file_id);
-        if (file == NULL) {
-            guac_user_log(user, GUAC_LOG_DEBUG, "%s: Successful open produced "
-                    "bad file_id: %i", __func__, file_id);
-            return 0;
-        }
-
         /* Determine mimetype */
         const char* mimetype;
-        if (file->attributes & FILE_ATTRIBUTE_DIRECTORY)
+        if (metadata.attributes & FILE_ATTRIBUTE_DIRECTORY)
             mimetype = GUAC_USER_STREAM_INDEX_MIMETYPE;
         else
             mimetype = "application/octet-stream";
 
-        /* Write entry */
-        blob_written |= guac_common_json_write_property(user, stream,
+        /* Write entry, waiting for next ack if a blob is written */
+        blob_written = guac_common_json_write_property(user, stream,
                 &ls_status->json_state, absolute_path, mimetype);
 
-        guac_rdp_fs_close(ls_status->fs, file_id);
-
     }
 
-    /* Complete JSON and cleanup at end of directory */
-    if (filename == NULL) {
+    /* Complete JSON and cleanup at end of directory or page */
+    if (complete) {
 
         /* Complete JSON object */
         guac_common_json_end_object(user, stream, &ls_status->json_state);
         guac_common_json_flush(user, stream, &ls_status->json_state);
 
-        /* Clean up resources */
-        guac_rdp_fs_close(ls_status->fs, ls_status->file_id);
-        free(ls_status);
+        /* Retain listing for the following page, if any, cleaning up
+         * otherwise */
+        if (retain)
+            guac_common_listing_cache_store(&ls_status->fs->listings, page,
+                    ls_status->position, ls_status);
+        else
+            guac_rdp_ls_status_free(ls_status);
 
         /* Signal of stream */
         guac_protocol_send_end(user->socket, stream);
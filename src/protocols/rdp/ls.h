@@ -21,6 +21,7 @@
 #define GUAC_RDP_LS_H
 
 #include "common/json.h"
+#include "common/listing.h"
 #include "fs.h"
 
 #include <guacamole/protocol.h>
@@ -49,6 +50,24 @@ typedef struct guac_rdp_ls_status {
      */
     char directory_name[GUAC_RDP_FS_MAX_PATH];
 
+    /**
+     * The portion of the directory being listed, as requested by the user.
+     * The path of this page points to directory_name.
+     */
+    guac_common_listing_page page;
+
+    /**
+     * The number of entries of the directory which have been skipped or
+     * listed so far.
+     */
+    int position;
+
+    /**
+     * All entries of the directory, sorted by name, if the listing has been
+     * requested in that order. Unused otherwise.
+     */
+    guac_common_listing_entries entries;
+
     /**
      * The current state of the JSON directory object being written.
      */
@@ -56,9 +75,43 @@ typedef struct guac_rdp_ls_status {
 
 } guac_rdp_ls_status;
 
+/**
+ * Allocates the state of a new directory listing operation for the given
+ * directory. If the entries of the directory must be sorted, all entries are
+ * read immediately.
+ *
+ * @param fs
+ *     The filesystem containing the directory.
+ *
+ * @param file_id
+ *     The file ID of the directory, as returned by guac_rdp_fs_open(). The
+ *     directory will be closed once the listing is complete or aborted, or
+ *     once the listing is no longer retained for a following page.
+ *
+ * @param page
+ *     The portion of the directory requested, as parsed with
+ *     guac_common_listing_parse().
+ *
+ * @return
+ *     The newly-allocated listing state, or NULL if the path of the directory
+ *     is too long.
+ */
+guac_rdp_ls_status* guac_rdp_ls_status_alloc(guac_rdp_fs* fs, int file_id,
+        const guac_common_listing_page* page);
+
+/**
+ * Closes the directory being listed and frees the given listing state,
+ * a guac_rdp_ls_status. This handler frees any listing retained between
+ * pages but never continued.
+ */
+guac_common_listing_free_handler guac_rdp_ls_status_free;
+
 /**
  * Handler for ack messages received due to receipt of a "body" or "blob"
- * instruction associated with a directory list operation.
+ * instruction associated with a directory list operation. Each ack results in
+ * at most one further blob of the directory listing. If only a single page of
+ * the directory was requested, the listing ends after the last entry of that
+ * page with a property whose name is the request for the following page.
  */
 guac_user_ack_handler guac_rdp_ls_ack_handler;
 
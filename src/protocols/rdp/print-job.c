@@ -23,10 +23,13 @@
 #include <guacamole/protocol.h>
 #include <guacamole/socket.h>
 #include <guacamole/stream.h>
+#include <guacamole/timestamp.h>
 #include <guacamole/user.h>
 
 #include <errno.h>
+#include <inttypes.h>
 #include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -54,8 +57,8 @@ char* const guac_rdp_pdf_filter_command[] = {
 };
 
 /**
- * Updates the state of the given print job. Any threads currently blocked by a
- * call to guac_rdp_print_job_wait_for_ack() will be unblocked.
+ * Updates the state of the given print job. Any threads currently waiting on
+ * the state_modified conditional of the print job will be unblocked.
  *
  * @param job
  *     The print job whose state should be updated.
@@ -70,44 +73,12 @@ static void guac_rdp_print_job_set_state(guac_rdp_print_job* job,
 
     /* Update stream state, signalling modification */
     job->state = state;
-    pthread_cond_signal(&(job->state_modified));
+    pthread_cond_broadcast(&(job->state_modified));
 
     pthread_mutex_unlock(&(job->state_lock));
 
 }
 
-/**
- * Suspends execution of the current thread until the state of the given print
- * job is not GUAC_RDP_PRINT_JOB_WAITING_FOR_ACK. If the state of the print
- * job is GUAC_RDP_PRINT_JOB_ACK_RECEIVED, the state is automatically reset
- * back to GUAC_RDP_PRINT_JOB_WAITING_FOR_ACK prior to returning.
- *
- * @param job
- *     The print job to wait for.
- *
- * @return
- *     Zero if the state of the print job is GUAC_RDP_PRINT_JOB_CLOSED,
- *     non-zero if the state was GUAC_RDP_PRINT_JOB_ACK_RECEIVED and has been
- *     automatically reset to GUAC_RDP_PRINT_JOB_WAITING_FOR_ACK.
- */
-static int guac_rdp_print_job_wait_for_ack(guac_rdp_print_job* job) {
-
-    /* Wait for ack if stream open and not yet received */
-    pthread_mutex_lock(&(job->state_lock));
-    if (job->state == GUAC_RDP_PRINT_JOB_WAITING_FOR_ACK)
-        pthread_cond_wait(&job->state_modified, &job->state_lock);
-
-    /* Reset state if ack received */
-    int got_ack = (job->state == GUAC_RDP_PRINT_JOB_ACK_RECEIVED);
-    if (got_ack)
-        job->state = GUAC_RDP_PRINT_JOB_WAITING_FOR_ACK;
-
-    /* Return whether ack was successfully received */
-    pthread_mutex_unlock(&(job->state_lock));
-    return got_ack;
-
-}
-
 /**
  * Sends a "file" instruction to the given user describing the PDF file that
  * will be sent using the output of the given print job. If the given user no
@@ -165,9 +136,6 @@ static void* guac_rdp_print_job_send_blob(guac_user* user, void* data) {
     guac_rdp_print_blob* blob = (guac_rdp_print_blob*) data;
     guac_rdp_print_job* job = blob->job;
 
-    guac_client_log(job->client, GUAC_LOG_DEBUG, "Sending %i byte(s) "
-            "of filtered output.", blob->length);
-
     /* Kill job and do nothing if user no longer exists */
     if (user == NULL) {
         guac_rdp_print_job_kill(job);
@@ -221,18 +189,17 @@ static void* guac_rdp_print_job_end_stream(guac_user* user, void* data) {
 }
 
 /**
- * Handler for "ack" messages received in response to printed data. Additional
- * data will be sent as a result or, if no data remains, the stream will be
- * terminated. It is required that the data pointer of the provided stream be
- * set to the file descriptor from which the printed data should be read.
+ * Handler for "ack" messages received in response to printed data. Each ack
+ * frees space within the window of unacknowledged blobs, allowing additional
+ * data to be sent by the stream thread. An ack having an error status kills
+ * the print job.
  *
  * @param user
  *     The user to whom the printed data is being sent.
  *
  * @param stream
  *     The stream along which the printed data is to be sent. The data pointer
- *     of this stream MUST be set to the file descriptor from which the data
- *     being sent is to be read.
+ *     of this stream MUST be set to the associated guac_rdp_print_job.
  *
  * @param message
  *     An arbitrary, human-readable message describing the success/failure of
@@ -252,8 +219,21 @@ static int guac_rdp_print_filter_ack_handler(guac_user* user,
     guac_rdp_print_job* job = (guac_rdp_print_job*) stream->data;
 
     /* Update state for successful acks */
-    if (status == GUAC_PROTOCOL_STATUS_SUCCESS)
-        guac_rdp_print_job_set_state(job, GUAC_RDP_PRINT_JOB_ACK_RECEIVED);
+    if (status == GUAC_PROTOCOL_STATUS_SUCCESS) {
+
+        pthread_mutex_lock(&(job->state_lock));
+
+        /* The first ack confirms creation of the stream, while each
+         * subsequent ack confirms receipt of a single blob */
+        if (job->state == GUAC_RDP_PRINT_JOB_WAITING_FOR_ACK)
+            job->state = GUAC_RDP_PRINT_JOB_ACK_RECEIVED;
+        else if (job->unacked_blobs > 0)
+            job->unacked_blobs--;
+
+        pthread_cond_broadcast(&(job->state_modified));
+        pthread_mutex_unlock(&(job->state_lock));
+
+    }
 
     /* Terminate stream if ack signals an error */
     else {
@@ -377,9 +357,10 @@ static pid_t guac_rdp_create_filter_process(guac_client* client,
 
 /**
  * Thread which continuously reads from the output file descriptor associated
- * with the given print job, writing filtered PDF output to the associated
- * Guacamole stream, and terminating only after the print job has completed
- * processing or the associated Guacamole stream has closed.
+ * with the given print job, storing filtered PDF output within the output
+ * buffer of the print job until the print filter process has completed
+ * processing or the associated Guacamole stream has closed. Reads are paused
+ * while the output buffer is full.
  *
  * @param data
  *     A pointer to the guac_rdp_print_job representing the print job that
@@ -390,54 +371,176 @@ static pid_t guac_rdp_create_filter_process(guac_client* client,
  */
 static void* guac_rdp_print_job_output_thread(void* data) {
 
-    int length;
-    char buffer[6048];
+    int length = 0;
 
     guac_rdp_print_job* job = (guac_rdp_print_job*) data;
     guac_client_log(job->client, GUAC_LOG_DEBUG, "Reading output from filter "
             "process...");
 
-    /* Read continuously while data remains */
-    while ((length = read(job->output_fd, buffer, sizeof(buffer))) > 0) {
+    pthread_mutex_lock(&(job->state_lock));
+    for (;;) {
+
+        /* Wait for space within buffer */
+        while (job->buffer_length == GUAC_RDP_PRINT_JOB_BUFFER_SIZE
+                && job->state != GUAC_RDP_PRINT_JOB_CLOSED)
+            pthread_cond_wait(&(job->state_modified), &(job->state_lock));
 
-        /* Wait for client to be ready for blob */
-        if (guac_rdp_print_job_wait_for_ack(job)) {
+        /* Abort if stream is closed */
+        if (job->state == GUAC_RDP_PRINT_JOB_CLOSED)
+            break;
 
-            guac_rdp_print_blob blob = {
-                .job    = job,
-                .buffer = buffer,
-                .length = length
-            };
+        /* Determine contiguous free space following buffered data */
+        int end = (job->buffer_start + job->buffer_length)
+                % GUAC_RDP_PRINT_JOB_BUFFER_SIZE;
 
-            /* Write a single blob of output */
-            guac_client_for_user(job->client, job->user,
-                    guac_rdp_print_job_send_blob, &blob);
+        int available = GUAC_RDP_PRINT_JOB_BUFFER_SIZE - job->buffer_length;
+        if (available > GUAC_RDP_PRINT_JOB_BUFFER_SIZE - end)
+            available = GUAC_RDP_PRINT_JOB_BUFFER_SIZE - end;
 
-        }
+        /* Read directly into free space without holding the lock (free space
+         * is never touched by the stream thread) */
+        pthread_mutex_unlock(&(job->state_lock));
+        length = read(job->output_fd, job->buffer + end, available);
+        pthread_mutex_lock(&(job->state_lock));
 
-        /* Abort if stream is closed */
-        else {
-            guac_client_log(job->client, GUAC_LOG_DEBUG, "Print stream "
-                    "explicitly aborted.");
+        /* Stop once filter output is exhausted */
+        if (length <= 0)
             break;
-        }
+
+        /* Make read data available to stream thread */
+        job->buffer_length += length;
+        if (job->buffer_length > job->buffer_max_length)
+            job->buffer_max_length = job->buffer_length;
+
+        pthread_cond_broadcast(&(job->state_modified));
 
     }
 
+    /* No further data will be buffered */
+    job->output_complete = 1;
+    pthread_cond_broadcast(&(job->state_modified));
+    pthread_mutex_unlock(&(job->state_lock));
+
     /* Warn of read errors */
     if (length < 0)
         guac_client_log(job->client, GUAC_LOG_ERROR,
                 "Error reading from filter: %s", strerror(errno));
 
+    return NULL;
+
+}
+
+/**
+ * Thread which continuously sends filtered PDF output from the output buffer
+ * of the given print job along the associated Guacamole stream, terminating
+ * only after all output has been sent and acknowledged or the associated
+ * Guacamole stream has closed. Up to GUAC_RDP_PRINT_JOB_MAX_UNACKED_BLOBS blobs are sent before
+ * waiting for any of those blobs to be acknowledged, such that throughput is
+ * not limited to a single blob per round trip.
+ *
+ * @param data
+ *     A pointer to the guac_rdp_print_job representing the print job whose
+ *     output should be streamed.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_rdp_print_job_stream_thread(void* data) {
+
+    guac_rdp_print_job* job = (guac_rdp_print_job*) data;
+    guac_timestamp start = guac_timestamp_current();
+
+    pthread_mutex_lock(&(job->state_lock));
+    for (;;) {
+
+        /* Wait until data can be sent or no further data remains */
+        while (job->state != GUAC_RDP_PRINT_JOB_CLOSED
+                && !(job->buffer_length == 0 && job->output_complete)
+                && (job->buffer_length == 0
+                    || job->state != GUAC_RDP_PRINT_JOB_ACK_RECEIVED
+                    || job->unacked_blobs
+                        >= GUAC_RDP_PRINT_JOB_MAX_UNACKED_BLOBS))
+            pthread_cond_wait(&(job->state_modified), &(job->state_lock));
+
+        /* Abort if stream is closed */
+        if (job->state == GUAC_RDP_PRINT_JOB_CLOSED) {
+            guac_client_log(job->client, GUAC_LOG_DEBUG, "Print stream "
+                    "explicitly aborted.");
+            break;
+        }
+
+        /* Stop once all output has been sent and every blob has been
+         * acknowledged, such that no ack can arrive for this stream after its
+         * index has been freed (and possibly reused by another stream) */
+        if (job->buffer_length == 0) {
+
+            while (job->unacked_blobs > 0
+                    && job->state != GUAC_RDP_PRINT_JOB_CLOSED)
+                pthread_cond_wait(&(job->state_modified), &(job->state_lock));
+
+            break;
+
+        }
+
+        /* Send as much contiguous buffered data as fits within one blob */
+        int length = job->buffer_length;
+        if (length > GUAC_RDP_PRINT_JOB_BLOB_SIZE)
+            length = GUAC_RDP_PRINT_JOB_BLOB_SIZE;
+        if (length > GUAC_RDP_PRINT_JOB_BUFFER_SIZE - job->buffer_start)
+            length = GUAC_RDP_PRINT_JOB_BUFFER_SIZE - job->buffer_start;
+
+        guac_rdp_print_blob blob = {
+            .job    = job,
+            .buffer = job->buffer + job->buffer_start,
+            .length = length
+        };
+
+        job->unacked_blobs++;
+
+        guac_client_log(job->client, GUAC_LOG_DEBUG, "Sending %i byte(s) "
+                "of filtered output (%i byte(s) buffered, %i blob(s) "
+                "awaiting ack).", length, job->buffer_length,
+                job->unacked_blobs);
+
+        /* Send blob directly from buffer without holding the lock (the
+         * data being sent is not freed until the send completes) */
+        pthread_mutex_unlock(&(job->state_lock));
+        guac_client_for_user(job->client, job->user,
+                guac_rdp_print_job_send_blob, &blob);
+        pthread_mutex_lock(&(job->state_lock));
+
+        /* Free buffer space occupied by sent data */
+        job->buffer_start = (job->buffer_start + length)
+                % GUAC_RDP_PRINT_JOB_BUFFER_SIZE;
+        job->buffer_length -= length;
+        job->bytes_sent += length;
+        job->blobs_sent++;
+
+        pthread_cond_broadcast(&(job->state_modified));
+
+    }
+
+    int bytes_sent = job->bytes_sent;
+    int blobs_sent = job->blobs_sent;
+    int buffer_max_length = job->buffer_max_length;
+    pthread_mutex_unlock(&(job->state_lock));
+
     /* Terminate stream */
     guac_client_for_user(job->client, job->user,
             guac_rdp_print_job_end_stream, job);
 
-    /* Ensure all associated file descriptors are closed */
-    close(job->input_fd);
-    close(job->output_fd);
+    /* Ensure output thread does not wait for buffer space indefinitely */
+    guac_rdp_print_job_set_state(job, GUAC_RDP_PRINT_JOB_CLOSED);
+
+    /* Report overall throughput of print stream */
+    guac_timestamp duration = guac_timestamp_current() - start;
+    guac_client_log(job->client, GUAC_LOG_INFO, "Print job completed: "
+            "%i byte(s) sent in %i blob(s) over %" PRId64 " ms "
+            "(%" PRId64 " KiB/s), with at most %i byte(s) buffered.",
+            bytes_sent, blobs_sent, duration,
+            duration > 0 ? (int64_t) bytes_sent * 1000 / 1024 / duration : 0,
+            buffer_max_length);
 
-    guac_client_log(job->client, GUAC_LOG_DEBUG, "Print job completed.");
     return NULL;
 
 }
@@ -454,10 +557,18 @@ void* guac_rdp_print_job_alloc(guac_user* user, void* data) {
         return NULL;
 
     /* Bail early if allocation fails */
-    guac_rdp_print_job* job = malloc(sizeof(guac_rdp_print_job));
+    guac_rdp_print_job* job = calloc(1, sizeof(guac_rdp_print_job));
     if (job == NULL)
         return NULL;
 
+    /* Allocate buffer for filtered output awaiting transmission */
+    job->buffer = malloc(GUAC_RDP_PRINT_JOB_BUFFER_SIZE);
+    if (job->buffer == NULL) {
+        guac_user_free_stream(user, stream);
+        free(job);
+        return NULL;
+    }
+
     /* Associate job with stream and dependent data */
     job->client = user->client;
     job->user = user;
@@ -478,6 +589,7 @@ void* guac_rdp_print_job_alloc(guac_user* user, void* data) {
     /* Abort if print filter process cannot be created */
     if (job->filter_pid == -1) {
         guac_user_free_stream(user, stream);
+        free(job->buffer);
         free(job);
         return NULL;
     }
@@ -487,9 +599,11 @@ void* guac_rdp_print_job_alloc(guac_user* user, void* data) {
     pthread_cond_init(&job->state_modified, NULL);
     pthread_mutex_init(&job->state_lock, NULL);
 
-    /* Start output thread */
+    /* Start output and stream threads */
     pthread_create(&job->output_thread, NULL,
             guac_rdp_print_job_output_thread, job);
+    pthread_create(&job->stream_thread, NULL,
+            guac_rdp_print_job_stream_thread, job);
 
     /* Print job allocated successfully */
     return job;
@@ -629,24 +743,36 @@ void guac_rdp_print_job_free(guac_rdp_print_job* job) {
     close(job->input_fd);
 
     /* Wait for job to terminate */
+    pthread_join(job->stream_thread, NULL);
     pthread_join(job->output_thread, NULL);
 
-    /* Destroy lock */
+    /* Output can be closed only once no thread may be reading from it */
+    close(job->output_fd);
+
+    /* Destroy lock and conditional */
+    pthread_cond_destroy(&(job->state_modified));
     pthread_mutex_destroy(&(job->state_lock));
 
     /* Free base structure */
+    free(job->buffer);
     free(job);
 
 }
 
 void guac_rdp_print_job_kill(guac_rdp_print_job* job) {
 
-    /* Stop all handling of I/O */
-    close(job->input_fd);
-    close(job->output_fd);
+    pthread_mutex_lock(&(job->state_lock));
+
+    /* Stop the filter process if it may still be producing output, such
+     * that any read blocked within the output thread returns. The file
+     * descriptors of the job are closed only by guac_rdp_print_job_free(). */
+    if (job->state != GUAC_RDP_PRINT_JOB_CLOSED && !job->output_complete)
+        kill(job->filter_pid, SIGKILL);
 
     /* Mark stream as closed */
-    guac_rdp_print_job_set_state(job, GUAC_RDP_PRINT_JOB_CLOSED);
+    job->state = GUAC_RDP_PRINT_JOB_CLOSED;
+    pthread_cond_broadcast(&(job->state_modified));
+    pthread_mutex_unlock(&(job->state_lock));
 
 }
 
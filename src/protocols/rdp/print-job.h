@@ -45,6 +45,26 @@
  */
 #define GUAC_RDP_PRINT_JOB_TITLE_SEARCH_LENGTH 2048
 
+/**
+ * The maximum number of bytes of filtered output to send within a single
+ * "blob" instruction.
+ */
+#define GUAC_RDP_PRINT_JOB_BLOB_SIZE 6048
+
+/**
+ * The number of bytes of filtered output which may be buffered in memory
+ * while awaiting transmission to the Guacamole user. If this buffer is full,
+ * reads from the print filter process will be paused until space is
+ * available.
+ */
+#define GUAC_RDP_PRINT_JOB_BUFFER_SIZE 262144
+
+/**
+ * The maximum number of blobs which may be sent along the print stream
+ * without yet having been acknowledged by the Guacamole user.
+ */
+#define GUAC_RDP_PRINT_JOB_MAX_UNACKED_BLOBS 8
+
 /**
  * The current state of an RDP print job.
  */
@@ -59,8 +79,8 @@ typedef enum guac_rdp_print_job_state {
     /**
      * The print stream has been opened with the Guacamole client, and the
      * client has responded with an "ack", confirming that it is ready to
-     * receive data (or that data has been received and it is ready to receive
-     * more).
+     * receive data. Up to GUAC_RDP_PRINT_JOB_MAX_UNACKED_BLOBS blobs may be
+     * awaiting acknowledgement at any given time.
      */
     GUAC_RDP_PRINT_JOB_ACK_RECEIVED,
 
@@ -125,22 +145,78 @@ typedef struct guac_rdp_print_job {
     guac_rdp_print_job_state state;
 
     /**
-     * Lock which is acquired prior to modifying the state property or waiting
-     * on the state_modified conditional.
+     * Lock which is acquired prior to modifying the state property, the
+     * contents of the output buffer, or any counters related to the print
+     * stream, or waiting on the state_modified conditional.
      */
     pthread_mutex_t state_lock;
 
     /**
      * Conditional which signals modification to the state property of this
-     * structure.
+     * structure, the receipt of an "ack" for a blob, or a change in the
+     * amount of data within the output buffer.
      */
     pthread_cond_t state_modified;
 
     /**
-     * Thread which transfers data from the printer to the Guacamole client.
+     * Thread which reads filtered output from the printer into the output
+     * buffer.
      */
     pthread_t output_thread;
 
+    /**
+     * Thread which transfers data from the output buffer to the Guacamole
+     * client.
+     */
+    pthread_t stream_thread;
+
+    /**
+     * Ring buffer of GUAC_RDP_PRINT_JOB_BUFFER_SIZE bytes containing filtered
+     * output which has not yet been sent to the Guacamole client.
+     */
+    char* buffer;
+
+    /**
+     * The offset within the output buffer of the first byte which has not yet
+     * been sent.
+     */
+    int buffer_start;
+
+    /**
+     * The number of bytes within the output buffer which have not yet been
+     * sent, including any bytes currently being sent.
+     */
+    int buffer_length;
+
+    /**
+     * The largest number of bytes stored within the output buffer at any one
+     * time, for the sake of reporting.
+     */
+    int buffer_max_length;
+
+    /**
+     * Non-zero if the print filter process has closed its output, and no
+     * further data will be added to the output buffer.
+     */
+    int output_complete;
+
+    /**
+     * The number of blobs sent along the print stream which have not yet been
+     * acknowledged by the Guacamole user.
+     */
+    int unacked_blobs;
+
+    /**
+     * The total number of blobs sent along the print stream.
+     */
+    int blobs_sent;
+
+    /**
+     * The total number of bytes of filtered output sent along the print
+     * stream.
+     */
+    int bytes_sent;
+
     /**
      * The number of bytes received in the current print job.
      */
@@ -224,8 +300,9 @@ void guac_rdp_print_job_free(guac_rdp_print_job* job);
 
 /**
  * Forcibly kills the given print job, stopping all associated processing and
- * streaming. The memory associated with the print job will still need to be
- * reclaimed via guac_rdp_print_job_free().
+ * streaming. The print filter process is terminated, but no file descriptors
+ * are closed. The memory and file descriptors associated with the print job
+ * will still need to be reclaimed via guac_rdp_print_job_free().
  *
  * @param job
  *     The print job to kill.
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "pipe.h"
 #include "ssh.h"
+#include "terminal/search.h"
 #include "terminal/terminal.h"
 
 #include <guacamole/protocol.h>
@@ -40,6 +41,12 @@ int guac_ssh_pipe_handler(guac_user* user, guac_stream* stream,
         return 0;
     }
 
+    /* Search terminal if pipe has required name */
+    if (strcmp(name, GUAC_SSH_SEARCH_PIPE_NAME) == 0) {
+        guac_terminal_search_stream(ssh_client->term, user, stream);
+        return 0;
+    }
+
     /* No other inbound pipe streams are supported */
     guac_protocol_send_ack(user->socket, stream, "No such input stream.",
             GUAC_PROTOCOL_STATUS_RESOURCE_NOT_FOUND);
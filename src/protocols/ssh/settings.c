@@ -68,6 +68,7 @@ const char* GUAC_SSH_CLIENT_ARGS[] = {
     "timezone",
     "disable-copy",
     "disable-paste",
+    "clipboard-buffer-size",
     "wol-send-packet",
     "wol-mac-addr",
     "wol-broadcast-addr",
@@ -293,6 +294,13 @@ enum SSH_ARGS_IDX {
      * the clipboard. By default, clipboard access is not blocked.
      */
     IDX_DISABLE_PASTE,
+
+    /**
+     * The maximum number of bytes of text which may be copied from the
+     * terminal to the clipboard. By default, 256 KiB may be copied. Values
+     * larger than 50 MiB are reduced to 50 MiB.
+     */
+    IDX_CLIPBOARD_BUFFER_SIZE,
     
     /**
      * Whether the magic WoL packet should be sent prior to starting the
@@ -510,6 +518,14 @@ guac_ssh_settings* guac_ssh_parse_args(guac_user* user,
     settings->disable_paste =
         guac_user_parse_args_boolean(user, GUAC_SSH_CLIENT_ARGS, argv,
                 IDX_DISABLE_PASTE, false);
+
+    /* Parse maximum clipboard size */
+    settings->clipboard_buffer_size =
+        guac_user_parse_args_int(user, GUAC_SSH_CLIENT_ARGS, argv,
+                IDX_CLIPBOARD_BUFFER_SIZE, GUAC_SSH_DEFAULT_CLIPBOARD_BUFFER_SIZE);
+
+    if (settings->clipboard_buffer_size <= 0)
+        settings->clipboard_buffer_size = GUAC_SSH_DEFAULT_CLIPBOARD_BUFFER_SIZE;
     
     /* Parse Wake-on-LAN (WoL) parameters. */
     settings->wol_send_packet =
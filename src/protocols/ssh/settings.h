@@ -63,6 +63,12 @@
  */
 #define GUAC_SSH_DEFAULT_MAX_SCROLLBACK 1000
 
+/**
+ * The default maximum number of bytes of text which may be copied from the
+ * terminal to the clipboard.
+ */
+#define GUAC_SSH_DEFAULT_CLIPBOARD_BUFFER_SIZE 262144
+
 /**
  * Settings for the SSH connection. The values for this structure are parsed
  * from the arguments given during the Guacamole protocol handshake using the
@@ -169,6 +175,12 @@ typedef struct guac_ssh_settings {
      */
     bool disable_paste;
 
+    /**
+     * The maximum number of bytes of text which may be copied from the
+     * terminal to the clipboard.
+     */
+    int clipboard_buffer_size;
+
     /**
      * Whether SFTP is enabled.
      */
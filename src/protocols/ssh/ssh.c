@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include "argv.h"
+#include "common/clipboard.h"
 #include "common/recording.h"
 #include "common-ssh/sftp.h"
 #include "common-ssh/ssh.h"
@@ -250,6 +251,10 @@ void* ssh_client_thread(void* data) {
         return NULL;
     }
 
+    /* Allow as much text to be copied as configured */
+    guac_terminal_set_copy_limit(ssh_client->term,
+            settings->clipboard_buffer_size);
+
     /* Send current values of exposed arguments to owner only */
     guac_client_for_owner(client, guac_ssh_send_current_argv, ssh_client);
 
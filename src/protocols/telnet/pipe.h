@@ -31,10 +31,19 @@
  */
 #define GUAC_TELNET_STDIN_PIPE_NAME "STDIN"
 
+/**
+ * The name reserved for the inbound pipe stream whose contents are searched
+ * for within the terminal emulator's display and scrollback once the pipe is
+ * closed.
+ */
+#define GUAC_TELNET_SEARCH_PIPE_NAME "SEARCH"
+
 /**
  * Handles an incoming stream from a Guacamole "pipe" instruction. If the pipe
  * is named "STDIN", the the contents of the pipe stream are redirected to
- * STDIN of the terminal emulator for as long as the pipe is open.
+ * STDIN of the terminal emulator for as long as the pipe is open. If the pipe
+ * is named "SEARCH", the terminal is searched for the contents of the pipe
+ * stream once the pipe is closed.
  */
 guac_user_pipe_handler guac_telnet_pipe_handler;
 
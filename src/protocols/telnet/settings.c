@@ -59,6 +59,7 @@ const char* GUAC_TELNET_CLIENT_ARGS[] = {
     "login-failure-regex",
     "disable-copy",
     "disable-paste",
+    "clipboard-buffer-size",
     "wol-send-packet",
     "wol-mac-addr",
     "wol-broadcast-addr",
@@ -237,6 +238,13 @@ enum TELNET_ARGS_IDX {
      * the clipboard. By default, clipboard access is not blocked.
      */
     IDX_DISABLE_PASTE,
+
+    /**
+     * The maximum number of bytes of text which may be copied from the
+     * terminal to the clipboard. By default, 256 KiB may be copied. Values
+     * larger than 50 MiB are reduced to 50 MiB.
+     */
+    IDX_CLIPBOARD_BUFFER_SIZE,
     
     /**
      * Whether to send the magic Wake-on-LAN (WoL) packet.  If set to "true"
@@ -485,6 +493,14 @@ guac_telnet_settings* guac_telnet_parse_args(guac_user* user,
     settings->disable_paste =
         guac_user_parse_args_boolean(user, GUAC_TELNET_CLIENT_ARGS, argv,
                 IDX_DISABLE_PASTE, false);
+
+    /* Parse maximum clipboard size */
+    settings->clipboard_buffer_size =
+        guac_user_parse_args_int(user, GUAC_TELNET_CLIENT_ARGS, argv,
+                IDX_CLIPBOARD_BUFFER_SIZE, GUAC_TELNET_DEFAULT_CLIPBOARD_BUFFER_SIZE);
+
+    if (settings->clipboard_buffer_size <= 0)
+        settings->clipboard_buffer_size = GUAC_TELNET_DEFAULT_CLIPBOARD_BUFFER_SIZE;
     
     /* Parse Wake-on-LAN (WoL) settings */
     settings->wol_send_packet =
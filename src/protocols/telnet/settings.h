@@ -72,6 +72,12 @@
  */
 #define GUAC_TELNET_DEFAULT_MAX_SCROLLBACK 1000
 
+/**
+ * The default maximum number of bytes of text which may be copied from the
+ * terminal to the clipboard.
+ */
+#define GUAC_TELNET_DEFAULT_CLIPBOARD_BUFFER_SIZE 262144
+
 /**
  * Settings for the telnet connection. The values for this structure are parsed
  * from the arguments given during the Guacamole protocol handshake using the
@@ -185,6 +191,12 @@ typedef struct guac_telnet_settings {
      */
     bool disable_paste;
 
+    /**
+     * The maximum number of bytes of text which may be copied from the
+     * terminal to the clipboard.
+     */
+    int clipboard_buffer_size;
+
     /**
      * The path in which the typescript should be saved, if enabled. If no
      * typescript should be saved, this will be NULL.
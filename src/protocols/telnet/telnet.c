@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include "argv.h"
+#include "common/clipboard.h"
 #include "common/recording.h"
 #include "telnet.h"
 #include "terminal/terminal.h"
@@ -597,6 +598,10 @@ void* guac_telnet_client_thread(void* data) {
         return NULL;
     }
 
+    /* Allow as much text to be copied as configured */
+    guac_terminal_set_copy_limit(telnet_client->term,
+            settings->clipboard_buffer_size);
+
     /* Send current values of exposed arguments to owner only */
     guac_client_for_owner(client, guac_telnet_send_current_argv,
             telnet_client);
@@ -26,38 +26,6 @@
 #include <guacamole/user.h>
 #include <pulse/pulseaudio.h>
 
-/**
- * Returns whether the given buffer contains only silence (only null bytes).
- *
- * @param buffer
- *     The audio buffer to check.
- *
- * @param length
- *     The length of the buffer to check.
- *
- * @return
- *     Non-zero if the audio buffer contains silence, zero otherwise.
- */
-static int guac_pa_is_silence(const void* buffer, size_t length) {
-
-    int i;
-
-    const unsigned char* current = (const unsigned char*) buffer;
-
-    /* For each byte in buffer */
-    for (i = 0; i < length; i++) {
-
-        /* If current value non-zero, then not silence */
-        if (*(current++))
-            return 0;
-
-    }
-
-    /* Otherwise, the buffer contains 100% silence */
-    return 1;
-
-}
-
 /**
  * Callback invoked by PulseAudio when PCM data is available for reading
  * from the given stream. The PCM data can be read using pa_stream_peek().
@@ -83,14 +51,11 @@ static void __stream_read_callback(pa_stream* stream, size_t length,
     /* Read data */
     pa_stream_peek(stream, &buffer, &length);
 
-    /* Continuously write received PCM data */
-    if (!guac_pa_is_silence(buffer, length))
+    /* Continuously write received PCM data, skipping any holes. Silence is
+     * dropped by the audio stream itself. */
+    if (buffer != NULL)
         guac_audio_stream_write_pcm(audio, buffer, length);
 
-    /* Flush upon silence */
-    else
-        guac_audio_stream_flush(audio);
-
     /* Advance buffer */
     pa_stream_drop(stream);
 
@@ -22,6 +22,7 @@
 #include "terminal/buffer.h"
 #include "terminal/common.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -31,30 +32,21 @@ guac_terminal_buffer* guac_terminal_buffer_alloc(int rows, guac_terminal_char* d
     guac_terminal_buffer* buffer =
         malloc(sizeof(guac_terminal_buffer));
 
-    int i;
-    guac_terminal_buffer_row* row;
-
     /* Init scrollback data */
     buffer->default_character = *default_character;
     buffer->available = rows;
     buffer->top = 0;
     buffer->length = 0;
-    buffer->rows = malloc(sizeof(guac_terminal_buffer_row) *
-            buffer->available);
-
-    /* Init scrollback rows */
-    row = buffer->rows;
-    for (i=0; i<rows; i++) {
 
-        /* Allocate row  */
-        row->available = 256;
-        row->length = 0;
-        row->characters = malloc(sizeof(guac_terminal_char) * row->available);
+    /* Rows are allocated only once used */
+    buffer->rows = calloc(buffer->available, sizeof(guac_terminal_buffer_row));
 
-        /* Next row */
-        row++;
-
-    }
+    /* No attributes are interned until rows are packed */
+    buffer->attributes = NULL;
+    buffer->attribute_count = 0;
+    buffer->attribute_capacity = 0;
+    buffer->attribute_table = NULL;
+    buffer->attribute_table_size = 0;
 
     return buffer;
 
@@ -68,15 +60,412 @@ void guac_terminal_buffer_free(guac_terminal_buffer* buffer) {
     /* Free all rows */
     for (i=0; i<buffer->available; i++) {
         free(row->characters);
+        free(row->packed);
         row++;
     }
 
+    /* Free interned attributes */
+    free(buffer->attributes);
+    free(buffer->attribute_table);
+
     /* Free actual buffer */
     free(buffer->rows);
     free(buffer);
 
 }
 
+/**
+ * Returns whether the given colors are identical, including their palette
+ * indices. Unlike guac_terminal_colorcmp(), colors which merely render
+ * identically are not considered equal.
+ *
+ * @param a
+ *     The first color to compare.
+ *
+ * @param b
+ *     The second color to compare.
+ *
+ * @return
+ *     Non-zero if the colors are identical, zero otherwise.
+ */
+static int guac_terminal_buffer_color_equals(const guac_terminal_color* a,
+        const guac_terminal_color* b) {
+    return a->palette_index == b->palette_index
+        && a->red   == b->red
+        && a->green == b->green
+        && a->blue  == b->blue;
+}
+
+int guac_terminal_buffer_attributes_equal(const guac_terminal_attributes* a,
+        const guac_terminal_attributes* b) {
+    return a->bold        == b->bold
+        && a->half_bright == b->half_bright
+        && a->reverse     == b->reverse
+        && a->cursor      == b->cursor
+        && a->underscore  == b->underscore
+        && guac_terminal_buffer_color_equals(&a->foreground, &b->foreground)
+        && guac_terminal_buffer_color_equals(&a->background, &b->background);
+}
+
+int guac_terminal_buffer_char_equals(const guac_terminal_char* a,
+        const guac_terminal_char* b) {
+    return a->value == b->value
+        && a->width == b->width
+        && guac_terminal_buffer_attributes_equal(&a->attributes,
+                &b->attributes);
+}
+
+/**
+ * Returns a hash of the given set of attributes, suitable for locating those
+ * attributes within the attribute table of a buffer.
+ *
+ * @param attributes
+ *     The attributes to hash.
+ *
+ * @return
+ *     A hash of the given attributes.
+ */
+static unsigned int guac_terminal_buffer_hash_attributes(
+        const guac_terminal_attributes* attributes) {
+
+    const guac_terminal_color* fg = &attributes->foreground;
+    const guac_terminal_color* bg = &attributes->background;
+
+    unsigned int hash = attributes->bold
+                     | (attributes->half_bright << 1)
+                     | (attributes->reverse     << 2)
+                     | (attributes->cursor      << 3)
+                     | (attributes->underscore  << 4);
+
+    hash = hash * 31 + (unsigned int) fg->palette_index;
+    hash = hash * 31 + ((fg->red << 16) | (fg->green << 8) | fg->blue);
+    hash = hash * 31 + (unsigned int) bg->palette_index;
+    hash = hash * 31 + ((bg->red << 16) | (bg->green << 8) | bg->blue);
+
+    return hash ^ (hash >> 16);
+
+}
+
+/**
+ * Rebuilds the attribute hash table of the given buffer with the given
+ * number of entries.
+ *
+ * @param buffer
+ *     The buffer whose attribute hash table should be rebuilt.
+ *
+ * @param size
+ *     The number of entries in the new hash table. This must be a power of
+ *     two greater than the number of interned attributes.
+ *
+ * @return
+ *     Zero if the hash table was rebuilt successfully, non-zero otherwise.
+ */
+static int guac_terminal_buffer_rehash(guac_terminal_buffer* buffer,
+        int size) {
+
+    int i;
+
+    int* table = malloc(sizeof(int) * size);
+    if (table == NULL)
+        return 1;
+
+    for (i = 0; i < size; i++)
+        table[i] = -1;
+
+    /* Reinsert all interned attributes */
+    for (i = 0; i < buffer->attribute_count; i++) {
+        unsigned int slot = guac_terminal_buffer_hash_attributes(
+                &buffer->attributes[i]) & (size - 1);
+        while (table[slot] != -1)
+            slot = (slot + 1) & (size - 1);
+        table[slot] = i;
+    }
+
+    free(buffer->attribute_table);
+    buffer->attribute_table = table;
+    buffer->attribute_table_size = size;
+
+    return 0;
+
+}
+
+/**
+ * Returns the index of the given attributes within the attributes interned
+ * by the given buffer, interning those attributes if not already present.
+ *
+ * @param buffer
+ *     The buffer which should intern the given attributes.
+ *
+ * @param attributes
+ *     The attributes to look up.
+ *
+ * @return
+ *     The index of the given attributes within the attributes array of the
+ *     buffer, or -1 if the attributes are not yet interned and cannot be
+ *     interned.
+ */
+static int guac_terminal_buffer_intern_attributes(guac_terminal_buffer* buffer,
+        const guac_terminal_attributes* attributes) {
+
+    /* Keep hash table at most half full */
+    if (buffer->attribute_count * 2 >= buffer->attribute_table_size) {
+        int size = buffer->attribute_table_size ?
+                buffer->attribute_table_size * 2 : 64;
+        if (guac_terminal_buffer_rehash(buffer, size))
+            return -1;
+    }
+
+    int mask = buffer->attribute_table_size - 1;
+    unsigned int slot = guac_terminal_buffer_hash_attributes(attributes) & mask;
+
+    /* Search for existing attributes */
+    int index;
+    while ((index = buffer->attribute_table[slot]) != -1) {
+        if (guac_terminal_buffer_attributes_equal(&buffer->attributes[index],
+                    attributes))
+            return index;
+        slot = (slot + 1) & mask;
+    }
+
+    /* Refuse to intern more attributes than can be referenced by a run */
+    if (buffer->attribute_count == GUAC_TERMINAL_BUFFER_MAX_ATTRIBUTES)
+        return -1;
+
+    /* Expand attributes array if necessary */
+    if (buffer->attribute_count == buffer->attribute_capacity) {
+
+        int capacity = buffer->attribute_capacity ?
+                buffer->attribute_capacity * 2 : 16;
+
+        guac_terminal_attributes* interned = realloc(buffer->attributes,
+                sizeof(guac_terminal_attributes) * capacity);
+        if (interned == NULL)
+            return -1;
+
+        buffer->attributes = interned;
+        buffer->attribute_capacity = capacity;
+
+    }
+
+    /* Intern new attributes */
+    index = buffer->attribute_count++;
+    buffer->attributes[index] = *attributes;
+    buffer->attribute_table[slot] = index;
+
+    return index;
+
+}
+
+/**
+ * Returns the bit representing the given pair of adjacent codepoints within
+ * the signature of a row, ignoring the case of ASCII letters.
+ *
+ * @param first
+ *     The first codepoint of the pair.
+ *
+ * @param second
+ *     The codepoint immediately following the first.
+ *
+ * @return
+ *     A 64-bit value having exactly one bit set.
+ */
+static uint64_t guac_terminal_buffer_signature_bit(int32_t first,
+        int32_t second) {
+
+    if (first >= 'A' && first <= 'Z')
+        first += 'a' - 'A';
+
+    if (second >= 'A' && second <= 'Z')
+        second += 'a' - 'A';
+
+    uint64_t hash = ((uint64_t) (uint32_t) first << 32) | (uint32_t) second;
+    return UINT64_C(1) << ((hash * UINT64_C(0x9E3779B97F4A7C15)) >> 58);
+
+}
+
+uint64_t guac_terminal_buffer_signature(const int32_t* text, int length) {
+
+    uint64_t signature = 0;
+
+    for (int i = 1; i < length; i++)
+        signature |= guac_terminal_buffer_signature_bit(text[i-1], text[i]);
+
+    return signature;
+
+}
+
+void guac_terminal_buffer_pack_row(guac_terminal_buffer* buffer, int row) {
+
+    int i;
+
+    /* Normalize row index into a scrollback buffer index */
+    int index = (buffer->top + row) % buffer->available;
+    if (index < 0)
+        index += buffer->available;
+
+    guac_terminal_buffer_row* buffer_row = &(buffer->rows[index]);
+
+    /* Nothing to pack if already packed or never used */
+    if (buffer_row->characters == NULL)
+        return;
+
+    guac_terminal_char* characters = buffer_row->characters;
+
+    /* Trailing default characters need not be stored */
+    int stored = buffer_row->length;
+    while (stored > 0 && guac_terminal_buffer_char_equals(
+                &characters[stored - 1], &buffer->default_character))
+        stored--;
+
+    /* Count runs of identical attributes */
+    int run_count = 0;
+    int run_length = 0;
+    for (i = 0; i < stored; i++) {
+        if (run_length == 0 || run_length == UINT16_MAX
+                || !guac_terminal_buffer_attributes_equal(
+                    &characters[i].attributes, &characters[i-1].attributes)) {
+            run_count++;
+            run_length = 0;
+        }
+        run_length++;
+    }
+
+    /* Allocate header, runs, values and widths as a single block */
+    guac_terminal_buffer_packed_row* packed = malloc(
+              sizeof(guac_terminal_buffer_packed_row)
+            + sizeof(guac_terminal_buffer_run) * run_count
+            + sizeof(int32_t) * stored
+            + sizeof(int8_t) * stored);
+
+    /* Leave row unpacked if memory is not available */
+    if (packed == NULL)
+        return;
+
+    packed->stored = stored;
+    packed->run_count = run_count;
+    packed->runs = (guac_terminal_buffer_run*) (packed + 1);
+    packed->values = (int32_t*) (packed->runs + run_count);
+    packed->widths = (int8_t*) (packed->values + stored);
+
+    /* Store runs, codepoints and widths */
+    guac_terminal_buffer_run* run = packed->runs - 1;
+    for (i = 0; i < stored; i++) {
+
+        /* Begin new run whenever attributes change */
+        if (i == 0 || run->length == UINT16_MAX
+                || !guac_terminal_buffer_attributes_equal(
+                    &characters[i].attributes, &characters[i-1].attributes)) {
+
+            int attributes = guac_terminal_buffer_intern_attributes(buffer,
+                    &characters[i].attributes);
+
+            /* Leave row unpacked if attributes cannot be interned */
+            if (attributes == -1) {
+                free(packed);
+                return;
+            }
+
+            run++;
+            run->attributes = attributes;
+            run->length = 0;
+
+        }
+
+        run->length++;
+        packed->values[i] = characters[i].value;
+        packed->widths[i] = characters[i].width;
+
+    }
+
+    /* Index text of row, including the first two trailing default
+     * characters. Any further trailing default characters contribute only
+     * the pair already contributed by the second, yet must remain matchable
+     * by searches ending in several blanks. */
+    int32_t previous = GUAC_CHAR_CONTINUATION;
+    packed->signature = 0;
+    for (i = 0; i < stored + 2 && i < buffer_row->length; i++) {
+
+        int32_t value = (i < stored) ? packed->values[i]
+                : buffer->default_character.value;
+
+        if (value == GUAC_CHAR_CONTINUATION)
+            continue;
+
+        if (previous != GUAC_CHAR_CONTINUATION)
+            packed->signature |= guac_terminal_buffer_signature_bit(
+                    previous, value);
+
+        previous = value;
+
+    }
+
+    /* Replace characters with packed representation */
+    free(buffer_row->characters);
+    buffer_row->characters = NULL;
+    buffer_row->available = 0;
+    buffer_row->packed = packed;
+
+}
+
+/**
+ * Restores the given packed row to its full representation as an array of
+ * guac_terminal_char, freeing its packed representation. If the row cannot
+ * be unpacked due to lack of memory, the row is cleared.
+ *
+ * @param buffer
+ *     The buffer containing the row.
+ *
+ * @param buffer_row
+ *     The packed row to unpack.
+ */
+static void guac_terminal_buffer_unpack_row(guac_terminal_buffer* buffer,
+        guac_terminal_buffer_row* buffer_row) {
+
+    int i, j;
+    guac_terminal_buffer_packed_row* packed = buffer_row->packed;
+
+    buffer_row->packed = NULL;
+    buffer_row->characters = malloc(sizeof(guac_terminal_char)
+            * buffer_row->length);
+
+    /* Clear row if memory is not available */
+    if (buffer_row->characters == NULL) {
+        buffer_row->length = 0;
+        free(packed);
+        return;
+    }
+
+    buffer_row->available = buffer_row->length;
+
+    /* Restore all stored cells */
+    guac_terminal_char* current = buffer_row->characters;
+    guac_terminal_buffer_run* run = packed->runs;
+    int cell = 0;
+    for (i = 0; i < packed->run_count; i++) {
+
+        guac_terminal_attributes* attributes =
+            &buffer->attributes[run->attributes];
+
+        for (j = 0; j < run->length; j++) {
+            current->value = packed->values[cell];
+            current->width = packed->widths[cell];
+            current->attributes = *attributes;
+            current++;
+            cell++;
+        }
+
+        run++;
+
+    }
+
+    /* Restore trailing default characters */
+    for (i = packed->stored; i < buffer_row->length; i++)
+        *(current++) = buffer->default_character;
+
+    free(packed);
+
+}
+
 guac_terminal_buffer_row* guac_terminal_buffer_get_row(guac_terminal_buffer* buffer, int row, int width) {
 
     int i;
@@ -91,12 +480,24 @@ guac_terminal_buffer_row* guac_terminal_buffer_get_row(guac_terminal_buffer* buf
     /* Get row */
     buffer_row = &(buffer->rows[index]);
 
+    /* Restore full representation if packed */
+    if (buffer_row->packed != NULL)
+        guac_terminal_buffer_unpack_row(buffer, buffer_row);
+
+    /* Allocate storage for rows not yet used even if no particular width is
+     * required, such that the characters of any returned row are valid */
+    if (buffer_row->characters == NULL && width < 1) {
+        buffer_row->characters = malloc(sizeof(guac_terminal_char));
+        buffer_row->available = 1;
+    }
+
     /* If resizing is needed */
-    if (width >= buffer_row->length) {
+    if (width > buffer_row->length) {
 
-        /* Expand if necessary */
+        /* Expand if necessary, allocating exactly the requested width for
+         * rows not yet used */
         if (width > buffer_row->available) {
-            buffer_row->available = width*2;
+            buffer_row->available = buffer_row->available ? width*2 : width;
             buffer_row->characters = realloc(buffer_row->characters, sizeof(guac_terminal_char) * buffer_row->available);
         }
 
@@ -211,3 +612,88 @@ void guac_terminal_buffer_set_columns(guac_terminal_buffer* buffer, int row,
 
 }
 
+void guac_terminal_buffer_set_text(guac_terminal_buffer* buffer, int row,
+        int start_column, const char* text, int length,
+        guac_terminal_attributes* attributes) {
+
+    int i;
+
+    /* Do nothing if no text */
+    if (length <= 0)
+        return;
+
+    /* Get and expand row */
+    guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_row(buffer,
+            row, start_column + length);
+
+    /* Set values */
+    guac_terminal_char* current = &(buffer_row->characters[start_column]);
+    for (i = 0; i < length; i++) {
+        current->value = (unsigned char) text[i];
+        current->attributes = *attributes;
+        current->width = 1;
+        current++;
+    }
+
+    /* Update length depending on row written (printable text is never
+     * blank) */
+    if (row >= buffer->length)
+        buffer->length = row+1;
+
+}
+
+int guac_terminal_buffer_get_text(guac_terminal_buffer* buffer, int row,
+        uint64_t signature, int32_t* text, int* columns, int max_length) {
+
+    int length = 0;
+
+    /* Normalize row index into a scrollback buffer index */
+    int index = (buffer->top + row) % buffer->available;
+    if (index < 0)
+        index += buffer->available;
+
+    guac_terminal_buffer_row* buffer_row = &(buffer->rows[index]);
+    guac_terminal_buffer_packed_row* packed = buffer_row->packed;
+
+    /* Read packed rows in place, skipping those which cannot match */
+    if (packed != NULL) {
+
+        if ((packed->signature & signature) != signature)
+            return 0;
+
+        for (int column = 0; column < buffer_row->length
+                && length < max_length; column++) {
+
+            int32_t value = (column < packed->stored) ? packed->values[column]
+                    : buffer->default_character.value;
+
+            if (value == GUAC_CHAR_CONTINUATION)
+                continue;
+
+            text[length] = value;
+            columns[length] = column;
+            length++;
+
+        }
+
+        return length;
+
+    }
+
+    /* Rows which are not packed are read directly */
+    guac_terminal_char* current = buffer_row->characters;
+    for (int column = 0; current != NULL && column < buffer_row->length
+            && length < max_length; column++, current++) {
+
+        if (current->value == GUAC_CHAR_CONTINUATION)
+            continue;
+
+        text[length] = current->value;
+        columns[length] = column;
+        length++;
+
+    }
+
+    return length;
+
+}
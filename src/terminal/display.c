@@ -20,12 +20,15 @@
 #include "config.h"
 
 #include "common/surface.h"
+#include "terminal/buffer.h"
 #include "terminal/common.h"
 #include "terminal/display.h"
+#include "terminal/glyph-cache.h"
 #include "terminal/palette.h"
 #include "terminal/types.h"
 
 #include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -97,63 +100,123 @@ int __guac_terminal_set_colors(guac_terminal_display* display,
 }
 
 /**
- * Sends the given character to the terminal at the given row and column,
- * rendering the character immediately. This bypasses the guac_terminal_display
- * mechanism and is intended for flushing of updates only.
+ * Marks the contents of every cell of the given display as unknown, as
+ * described by guac_terminal_display_invalidate(). The render lock of the
+ * display must be held.
+ *
+ * @param display
+ *     The display whose cell contents should be considered unknown.
  */
-int __guac_terminal_set(guac_terminal_display* display, int row, int col, int codepoint) {
+static void __guac_terminal_display_invalidate(guac_terminal_display* display) {
 
-    int width;
+    /* Cells having a width of zero never match any character set */
+    if (display->shadow != NULL)
+        memset(display->shadow, 0, display->width * display->height
+                * sizeof(guac_terminal_char));
 
-    int bytes;
-    char utf8[4];
+}
 
-    /* Use foreground color */
-    const guac_terminal_color* color = &display->glyph_foreground;
+static void __guac_terminal_display_render(guac_terminal_display* display);
 
-    /* Use background color */
-    const guac_terminal_color* background = &display->glyph_background;
+/**
+ * Returns the number of columns occupied by the glyph which would be drawn
+ * for the given codepoint.
+ *
+ * @param codepoint
+ *     The codepoint of the glyph.
+ *
+ * @return
+ *     The number of columns occupied by the glyph, or zero if the glyph is
+ *     empty and need not be drawn.
+ */
+static int __guac_terminal_glyph_width(int codepoint) {
+
+    int width = wcwidth(codepoint);
+    if (width < 0)
+        return 1;
+
+    return width;
+
+}
+
+/**
+ * Returns the codepoint which should be drawn for the character set by the
+ * given operation, substituting a space for characters having no glyph.
+ *
+ * @param operation
+ *     The GUAC_CHAR_SET operation whose codepoint should be returned.
+ *
+ * @return
+ *     The codepoint to draw.
+ */
+static int __guac_terminal_glyph_codepoint(guac_terminal_operation* operation) {
+
+    int codepoint = operation->character.value;
+
+    /* Use space if no glyph */
+    if (!guac_terminal_has_glyph(codepoint))
+        return ' ';
+
+    return codepoint;
+
+}
+
+/**
+ * Renders the glyph for the given codepoint as an 8-bit alpha mask occupying
+ * the given number of columns, using the current font of the given display.
+ * If the glyph has already been rendered by any terminal using the same font,
+ * the glyph is retrieved from the shared glyph cache rather than rendered
+ * again. Newly-rendered glyphs are added to the cache.
+ *
+ * @param display
+ *     The display whose font should be used to render the glyph.
+ *
+ * @param codepoint
+ *     The codepoint of the glyph to render.
+ *
+ * @param width
+ *     The number of columns the glyph occupies.
+ *
+ * @return
+ *     A new CAIRO_FORMAT_A8 surface containing the rendered glyph, which must
+ *     be destroyed with cairo_surface_destroy() once no longer needed.
+ */
+static cairo_surface_t* __guac_terminal_render_glyph(
+        guac_terminal_display* display, int codepoint, int width) {
+
+    int bytes;
+    char utf8[4];
 
     cairo_surface_t* surface;
     cairo_t* cairo;
     int surface_width, surface_height;
-   
+
     PangoLayout* layout;
     int layout_width, layout_height;
     int ideal_layout_width, ideal_layout_height;
 
-    /* Calculate width in columns */
-    width = wcwidth(codepoint);
-    if (width < 0)
-        width = 1;
+    surface_width = width * display->char_width;
+    surface_height = display->char_height;
 
-    /* Do nothing if glyph is empty */
-    if (width == 0)
-        return 0;
+    /* Reuse glyph if already rendered by any terminal */
+    if (display->glyph_cache != NULL) {
+        surface = guac_terminal_glyph_cache_lookup(display->glyph_cache,
+                &display->font_key, codepoint, surface_width, surface_height);
+        if (surface != NULL)
+            return surface;
+    }
 
     /* Convert to UTF-8 */
     bytes = guac_terminal_encode_utf8(codepoint, utf8);
 
-    surface_width = width * display->char_width;
-    surface_height = display->char_height;
-
     ideal_layout_width = surface_width * PANGO_SCALE;
     ideal_layout_height = surface_height * PANGO_SCALE;
 
     /* Prepare surface */
-    surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+    surface = cairo_image_surface_create(CAIRO_FORMAT_A8,
                                          surface_width, surface_height);
     cairo = cairo_create(surface);
 
-    /* Fill background */
-    cairo_set_source_rgb(cairo,
-            background->red   / 255.0,
-            background->green / 255.0,
-            background->blue  / 255.0);
-
-    cairo_rectangle(cairo, 0, 0, surface_width, surface_height); 
-    cairo_fill(cairo);
-
     /* Get layout */
     layout = pango_cairo_create_layout(cairo);
     pango_layout_set_font_description(layout, display->font_desc);
@@ -177,14 +240,112 @@ int __guac_terminal_set(guac_terminal_display* display, int row, int col, int co
 
     }
 
-    /* Draw */
+    /* Draw glyph as fully-opaque coverage */
+    cairo_set_source_rgba(cairo, 0.0, 0.0, 0.0, 1.0);
+    cairo_move_to(cairo, 0.0, 0.0);
+    pango_cairo_show_layout(cairo, layout);
+
+    /* Free all but surface */
+    g_object_unref(layout);
+    cairo_destroy(cairo);
+
+    /* Share glyph with all other terminals */
+    if (display->glyph_cache != NULL)
+        guac_terminal_glyph_cache_add(display->glyph_cache,
+                &display->font_key, codepoint, surface);
+
+    return surface;
+
+}
+
+/**
+ * Sends the characters of the given run of GUAC_CHAR_SET operations to the
+ * terminal, starting at the given row and column, rendering all characters
+ * immediately as a single image using the current glyph colors. Each
+ * operation within the run is assumed to begin at the column immediately
+ * following the glyph of the previous operation. This bypasses the
+ * guac_terminal_display mechanism and is intended for flushing of updates
+ * only.
+ *
+ * @param display
+ *     The display to draw to.
+ *
+ * @param row
+ *     The row at which the run begins.
+ *
+ * @param col
+ *     The column at which the run begins.
+ *
+ * @param run
+ *     An array of pointers to the operations whose characters should be
+ *     drawn, in order.
+ *
+ * @param length
+ *     The number of operations within the run.
+ *
+ * @param columns
+ *     The total number of columns occupied by the glyphs of the run.
+ *
+ * @return
+ *     Zero if the run was drawn successfully, non-zero otherwise.
+ */
+int __guac_terminal_set(guac_terminal_display* display, int row, int col,
+        guac_terminal_operation** run, int length, int columns) {
+
+    int i;
+    int x = 0;
+
+    /* Use foreground color */
+    const guac_terminal_color* color = &display->glyph_foreground;
+
+    /* Use background color */
+    const guac_terminal_color* background = &display->glyph_background;
+
+    cairo_surface_t* surface;
+    cairo_t* cairo;
+    int surface_width, surface_height;
+
+    /* Do nothing if all glyphs are empty */
+    if (columns == 0)
+        return 0;
+
+    surface_width = columns * display->char_width;
+    surface_height = display->char_height;
+
+    /* Prepare surface */
+    surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                         surface_width, surface_height);
+    cairo = cairo_create(surface);
+
+    /* Fill background */
+    cairo_set_source_rgb(cairo,
+            background->red   / 255.0,
+            background->green / 255.0,
+            background->blue  / 255.0);
+
+    cairo_rectangle(cairo, 0, 0, surface_width, surface_height); 
+    cairo_fill(cairo);
+
+    /* Draw each glyph in foreground color within its own columns */
     cairo_set_source_rgb(cairo,
             color->red   / 255.0,
             color->green / 255.0,
             color->blue  / 255.0);
 
-    cairo_move_to(cairo, 0.0, 0.0);
-    pango_cairo_show_layout(cairo, layout);
+    for (i = 0; i < length; i++) {
+
+        int codepoint = __guac_terminal_glyph_codepoint(run[i]);
+        int width = __guac_terminal_glyph_width(codepoint);
+
+        cairo_surface_t* glyph = __guac_terminal_render_glyph(display,
+                codepoint, width);
+
+        cairo_mask_surface(cairo, glyph, x, 0);
+        cairo_surface_destroy(glyph);
+
+        x += width * display->char_width;
+
+    }
 
     /* Draw */
     guac_common_surface_draw(display->display_surface,
@@ -193,7 +354,6 @@ int __guac_terminal_set(guac_terminal_display* display, int row, int col, int co
         surface);
 
     /* Free all */
-    g_object_unref(layout);
     cairo_destroy(cairo);
     cairo_surface_destroy(surface);
 
@@ -210,8 +370,12 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
     guac_terminal_display* display = malloc(sizeof(guac_terminal_display));
     display->client = client;
 
+    pthread_mutex_init(&display->render_lock, NULL);
+
     /* Initially no font loaded */
     display->font_desc = NULL;
+    guac_terminal_glyph_cache_key_init(&display->font_key, "", 0, 0);
+    display->glyph_cache = guac_terminal_glyph_cache_get();
     display->char_width = 0;
     display->char_height = 0;
 
@@ -233,6 +397,11 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
     display->width = 0;
     display->height = 0;
     display->operations = NULL;
+    display->flush_operations = NULL;
+    display->flush_pending = false;
+    display->shadow = NULL;
+    display->next_shadow = NULL;
+    display->suspended = false;
 
     /* Initially nothing selected */
     display->text_selected = false;
@@ -241,6 +410,9 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
     if (guac_terminal_display_set_font(display, font_name, font_size, dpi)) {
         guac_client_abort(display->client, GUAC_PROTOCOL_STATUS_SERVER_ERROR,
                 "Unable to set initial font \"%s\"", font_name);
+        if (display->glyph_cache != NULL)
+            guac_terminal_glyph_cache_release(display->glyph_cache);
+        pthread_mutex_destroy(&display->render_lock);
         free(display);
         return NULL;
     }
@@ -259,6 +431,15 @@ void guac_terminal_display_free(guac_terminal_display* display) {
 
     /* Free operations buffers */
     free(display->operations);
+    free(display->flush_operations);
+    free(display->shadow);
+    free(display->next_shadow);
+
+    /* Release shared glyph cache */
+    if (display->glyph_cache != NULL)
+        guac_terminal_glyph_cache_release(display->glyph_cache);
+
+    pthread_mutex_destroy(&display->render_lock);
 
     /* Free display */
     free(display);
@@ -267,15 +448,20 @@ void guac_terminal_display_free(guac_terminal_display* display) {
 
 void guac_terminal_display_reset_palette(guac_terminal_display* display) {
 
+    pthread_mutex_lock(&display->render_lock);
+
+    /* Cells must be redrawn if their colors may have changed */
+    __guac_terminal_display_invalidate(display);
+
     /* Reinitialize palette with default values */
-    if (display->default_palette) {
+    if (display->default_palette)
         memcpy(display->palette, *display->default_palette,
                sizeof(GUAC_TERMINAL_INITIAL_PALETTE));
-        return;
-    }
+    else
+        memcpy(display->palette, GUAC_TERMINAL_INITIAL_PALETTE,
+                sizeof(GUAC_TERMINAL_INITIAL_PALETTE));
 
-    memcpy(display->palette, GUAC_TERMINAL_INITIAL_PALETTE,
-            sizeof(GUAC_TERMINAL_INITIAL_PALETTE));
+    pthread_mutex_unlock(&display->render_lock);
 
 }
 
@@ -286,11 +472,18 @@ int guac_terminal_display_assign_color(guac_terminal_display* display,
     if (index < 0 || index > 255)
         return 1;
 
+    pthread_mutex_lock(&display->render_lock);
+
     /* Copy color components */
     display->palette[index].red   = color->red;
     display->palette[index].green = color->green;
     display->palette[index].blue  = color->blue;
 
+    /* Cells using the modified color must be redrawn */
+    __guac_terminal_display_invalidate(display);
+
+    pthread_mutex_unlock(&display->render_lock);
+
     /* Color successfully stored */
     return 0;
 
@@ -328,6 +521,10 @@ void guac_terminal_display_copy_columns(guac_terminal_display* display, int row,
     guac_terminal_operation* src_current;
     guac_terminal_operation* current;
 
+    /* Ignore all changes while suspended */
+    if (display->suspended)
+        return;
+
     /* Ignore operations outside display bounds */
     if (row < 0 || row >= display->height)
         return;
@@ -369,6 +566,10 @@ void guac_terminal_display_copy_rows(guac_terminal_display* display,
     guac_terminal_operation* src_current_row;
     guac_terminal_operation* current_row;
 
+    /* Ignore all changes while suspended */
+    if (display->suspended)
+        return;
+
     /* Fit range within bounds */
     start_row = guac_terminal_fit_to_range(start_row,          0, display->height - 1);
     end_row   = guac_terminal_fit_to_range(end_row,            0, display->height - 1);
@@ -413,6 +614,10 @@ void guac_terminal_display_set_columns(guac_terminal_display* display, int row,
     int i;
     guac_terminal_operation* current;
 
+    /* Ignore all changes while suspended */
+    if (display->suspended)
+        return;
+
     /* Do nothing if glyph is empty */
     if (character->width == 0)
         return;
@@ -441,9 +646,68 @@ void guac_terminal_display_set_columns(guac_terminal_display* display, int row,
 
 }
 
-void guac_terminal_display_resize(guac_terminal_display* display, int width, int height) {
+void guac_terminal_display_set_text(guac_terminal_display* display, int row,
+        int start_column, const char* text, int length,
+        guac_terminal_attributes* attributes) {
 
+    int i;
     guac_terminal_operation* current;
+
+    /* Ignore all changes while suspended */
+    if (display->suspended)
+        return;
+
+    /* Ignore operations outside display bounds */
+    if (row < 0 || row >= display->height)
+        return;
+
+    /* Fit range within bounds */
+    if (start_column < 0) {
+        text -= start_column;
+        length += start_column;
+        start_column = 0;
+    }
+
+    if (start_column + length > display->width)
+        length = display->width - start_column;
+
+    current = &(display->operations[row * display->width + start_column]);
+
+    /* Set operation for each column */
+    for (i = 0; i < length; i++) {
+        current->type                 = GUAC_CHAR_SET;
+        current->character.value      = (unsigned char) text[i];
+        current->character.attributes = *attributes;
+        current->character.width      = 1;
+        current++;
+    }
+
+}
+
+void guac_terminal_display_invalidate(guac_terminal_display* display) {
+    pthread_mutex_lock(&display->render_lock);
+    __guac_terminal_display_invalidate(display);
+    pthread_mutex_unlock(&display->render_lock);
+}
+
+/**
+ * Resizes the given display to the given dimensions, rendering any pending
+ * snapshot beforehand. The render lock of the display must be held.
+ *
+ * @param display
+ *     The display to resize.
+ *
+ * @param width
+ *     The new width of the display, in characters.
+ *
+ * @param height
+ *     The new height of the display, in characters.
+ */
+static void __guac_terminal_display_resize(guac_terminal_display* display,
+        int width, int height) {
+
+    guac_terminal_operation* current;
+    guac_terminal_char* shadow;
     int x, y;
 
     /* Fill with background color */
@@ -456,13 +720,37 @@ void guac_terminal_display_resize(guac_terminal_display* display, int width, int
         .width = 1
     };
 
-    /* Free old operations buffer */
-    if (display->operations != NULL)
-        free(display->operations);
+    /* Any snapshot of the old display must be rendered first */
+    __guac_terminal_display_render(display);
+
+    /* Free old operations buffers */
+    free(display->operations);
+    free(display->flush_operations);
+
+    /* Alloc shadow, preserving the known contents of the old part of the
+     * screen (all other cells are initially unknown) */
+    shadow = calloc(width * height, sizeof(guac_terminal_char));
+    if (display->shadow != NULL) {
+
+        int copy_width  = width  < display->width  ? width  : display->width;
+        int copy_height = height < display->height ? height : display->height;
+
+        for (y=0; y<copy_height; y++)
+            memcpy(&shadow[y * width], &display->shadow[y * display->width],
+                    copy_width * sizeof(guac_terminal_char));
+
+    }
+
+    free(display->shadow);
+    free(display->next_shadow);
+    display->shadow = shadow;
+    display->next_shadow = calloc(width * height, sizeof(guac_terminal_char));
 
     /* Alloc operations */
     display->operations = malloc(width * height *
             sizeof(guac_terminal_operation));
+    display->flush_operations = malloc(width * height *
+            sizeof(guac_terminal_operation));
 
     /* Init each operation buffer row */
     current = display->operations;
@@ -504,9 +792,15 @@ void guac_terminal_display_resize(guac_terminal_display* display, int width, int
 
 }
 
+void guac_terminal_display_resize(guac_terminal_display* display, int width, int height) {
+    pthread_mutex_lock(&display->render_lock);
+    __guac_terminal_display_resize(display, width, height);
+    pthread_mutex_unlock(&display->render_lock);
+}
+
 void __guac_terminal_display_flush_copy(guac_terminal_display* display) {
 
-    guac_terminal_operation* current = display->operations;
+    guac_terminal_operation* current = display->flush_operations;
     int row, col;
 
     /* For each operation */
@@ -631,7 +925,7 @@ void __guac_terminal_display_flush_copy(guac_terminal_display* display) {
 
 void __guac_terminal_display_flush_clear(guac_terminal_display* display) {
 
-    guac_terminal_operation* current = display->operations;
+    guac_terminal_operation* current = display->flush_operations;
     int row, col;
 
     /* For each operation */
@@ -764,11 +1058,99 @@ void __guac_terminal_display_flush_clear(guac_terminal_display* display) {
 }
 
 
+void __guac_terminal_display_flush_shadow(guac_terminal_display* display) {
+
+    guac_terminal_operation* current = display->flush_operations;
+    guac_terminal_char* shadow = display->shadow;
+    guac_terminal_char* next = display->next_shadow;
+    int row, col;
+
+    /* Determine the contents of each cell after copies are performed */
+    for (row=0; row<display->height; row++) {
+        for (col=0; col<display->width; col++) {
+
+            if (current->type == GUAC_CHAR_COPY)
+                *next = shadow[current->row * display->width + current->column];
+            else
+                *next = *shadow;
+
+            /* Next cell */
+            current++;
+            next++;
+            shadow++;
+
+        }
+    }
+
+    /* Skip sets which would not change the contents of a cell */
+    current = display->flush_operations;
+    next = display->next_shadow;
+    for (row=0; row<display->height; row++) {
+        for (col=0; col<display->width; col++) {
+
+            if (current->type == GUAC_CHAR_SET) {
+
+                int width = current->character.width;
+
+                /* Whether this cell will be partially overdrawn by a wider
+                 * character set immediately to the left */
+                bool overdrawn = col > 0
+                    && (current - 1)->type == GUAC_CHAR_SET
+                    && (current - 1)->character.width > 1;
+
+                /* Skip single-column characters which are already present */
+                if (width == 1 && !overdrawn
+                        && guac_terminal_buffer_char_equals(
+                            &current->character, next))
+                    current->type = GUAC_CHAR_NOP;
+
+                /* Otherwise, record new contents if they will be known */
+                else if (width == 1 && !overdrawn)
+                    *next = current->character;
+
+                /* Wider characters are always redrawn, and cells covered by
+                 * such characters are considered unknown */
+                else {
+                    int i;
+                    for (i = 0; i < width && col + i < display->width; i++)
+                        memset(&next[i], 0, sizeof(guac_terminal_char));
+                    if (overdrawn)
+                        memset(next, 0, sizeof(guac_terminal_char));
+                }
+
+            }
+
+            /* Next cell */
+            current++;
+            next++;
+
+        }
+    }
+
+    /* Updated contents are now current */
+    shadow = display->shadow;
+    display->shadow = display->next_shadow;
+    display->next_shadow = shadow;
+
+}
+
 void __guac_terminal_display_flush_set(guac_terminal_display* display) {
 
-    guac_terminal_operation* current = display->operations;
+    guac_terminal_operation* current = display->flush_operations;
     int row, col;
 
+    /* Draw each character individually if no memory is available for
+     * batching runs of characters */
+    guac_terminal_operation* single;
+    guac_terminal_operation** run = malloc(display->width
+            * sizeof(guac_terminal_operation*));
+
+    int capacity = display->width;
+    if (run == NULL) {
+        run = &single;
+        capacity = 1;
+    }
+
     /* For each operation */
     for (row=0; row<display->height; row++) {
         for (col=0; col<display->width; col++) {
@@ -776,21 +1158,45 @@ void __guac_terminal_display_flush_set(guac_terminal_display* display) {
             /* Perform given operation */
             if (current->type == GUAC_CHAR_SET) {
 
-                int codepoint = current->character.value;
+                int length = 0;
+                int columns = 0;
+                int next_col = col;
+
+                /* Gather run of adjacent characters having identical
+                 * attributes, each beginning where the previous glyph ends */
+                guac_terminal_operation* next = current;
+                while (next_col < display->width && length < capacity
+                        && next->type == GUAC_CHAR_SET
+                        && guac_terminal_buffer_attributes_equal(
+                            &next->character.attributes,
+                            &current->character.attributes)) {
+
+                    int width = __guac_terminal_glyph_width(
+                            __guac_terminal_glyph_codepoint(next));
+
+                    /* Empty glyphs end the run, drawing nothing */
+                    if (width == 0) {
+                        if (length == 0)
+                            current->type = GUAC_CHAR_NOP;
+                        break;
+                    }
 
-                /* Use space if no glyph */
-                if (!guac_terminal_has_glyph(codepoint))
-                    codepoint = ' ';
+                    /* Mark operation as handled */
+                    next->type = GUAC_CHAR_NOP;
+                    run[length++] = next;
+
+                    columns += width;
+                    next_col += width;
+                    next += width;
+
+                }
 
                 /* Set attributes */
                 __guac_terminal_set_colors(display,
                         &(current->character.attributes));
 
-                /* Send character */
-                __guac_terminal_set(display, row, col, codepoint);
-
-                /* Mark operation as handled */
-                current->type = GUAC_CHAR_NOP;
+                /* Send characters */
+                __guac_terminal_set(display, row, col, run, length, columns);
 
             }
 
@@ -800,9 +1206,26 @@ void __guac_terminal_display_flush_set(guac_terminal_display* display) {
         }
     }
 
+    if (run != &single)
+        free(run);
+
 }
 
-void guac_terminal_display_flush(guac_terminal_display* display) {
+/**
+ * Renders the most recent snapshot of the given display, if not already
+ * rendered. The render lock of the display must be held.
+ *
+ * @param display
+ *     The display whose snapshot should be rendered.
+ */
+static void __guac_terminal_display_render(guac_terminal_display* display) {
+
+    /* Do nothing if no snapshot needs to be rendered */
+    if (!display->flush_pending)
+        return;
+
+    /* Skip any operations which would not change the screen */
+    __guac_terminal_display_flush_shadow(display);
 
     /* Flush operations, copies first, then clears, then sets. */
     __guac_terminal_display_flush_copy(display);
@@ -812,11 +1235,49 @@ void guac_terminal_display_flush(guac_terminal_display* display) {
     /* Flush surface */
     guac_common_surface_flush(display->display_surface);
 
+    display->flush_pending = false;
+
+}
+
+void guac_terminal_display_snapshot(guac_terminal_display* display) {
+
+    int i;
+
+    pthread_mutex_lock(&display->render_lock);
+
+    /* Any previous snapshot must be rendered before it can be replaced */
+    __guac_terminal_display_render(display);
+
+    /* Take all pending operations for rendering */
+    guac_terminal_operation* operations = display->flush_operations;
+    display->flush_operations = display->operations;
+    display->operations = operations;
+    display->flush_pending = true;
+
+    /* Continue with no pending operations */
+    for (i = 0; i < display->width * display->height; i++)
+        operations[i].type = GUAC_CHAR_NOP;
+
+    pthread_mutex_unlock(&display->render_lock);
+
+}
+
+void guac_terminal_display_render(guac_terminal_display* display) {
+    pthread_mutex_lock(&display->render_lock);
+    __guac_terminal_display_render(display);
+    pthread_mutex_unlock(&display->render_lock);
+}
+
+void guac_terminal_display_flush(guac_terminal_display* display) {
+    guac_terminal_display_snapshot(display);
+    guac_terminal_display_render(display);
 }
 
 void guac_terminal_display_dup(guac_terminal_display* display, guac_user* user,
         guac_socket* socket) {
 
+    pthread_mutex_lock(&display->render_lock);
+
     /* Create default surface */
     guac_common_surface_dup(display->display_surface, user, socket);
 
@@ -829,6 +1290,8 @@ void guac_terminal_display_dup(guac_terminal_display* display, guac_user* user,
             display->char_width  * display->width,
             display->char_height * display->height);
 
+    pthread_mutex_unlock(&display->render_lock);
+
 }
 
 void guac_terminal_display_select(guac_terminal_display* display,
@@ -992,6 +1455,9 @@ int guac_terminal_display_set_font(guac_terminal_display* display,
         return 1;
     }
 
+    /* Font and dimensions must not change while rendering */
+    pthread_mutex_lock(&display->render_lock);
+
     /* Save effective size of current display */
     int pixel_width = display->width * display->char_width;
     int pixel_height = display->height * display->char_height;
@@ -1008,13 +1474,24 @@ int guac_terminal_display_set_font(guac_terminal_display* display,
     display->font_desc = font_desc;
     pango_font_description_free(old_font_desc);
 
+    /* Identify font within the glyph cache shared by all terminals */
+    char* font_string = pango_font_description_to_string(font_desc);
+    guac_terminal_glyph_cache_key_init(&display->font_key, font_string,
+            display->char_width, display->char_height);
+    g_free(font_string);
+
     /* Recalculate dimensions which will fit within current surface */
     int new_width = pixel_width / display->char_width;
     int new_height = pixel_height / display->char_height;
 
     /* Resize display if dimensions have changed */
     if (new_width != display->width || new_height != display->height)
-        guac_terminal_display_resize(display, new_width, new_height);
+        __guac_terminal_display_resize(display, new_width, new_height);
+
+    /* All cells must be redrawn using the new font */
+    __guac_terminal_display_invalidate(display);
+
+    pthread_mutex_unlock(&display->render_lock);
 
     return 0;
 
@@ -0,0 +1,639 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "terminal/glyph-cache.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/timestamp.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The glyph cache of the current process, loaded upon first call to
+ * guac_terminal_glyph_cache_get() and unloaded once all references have been
+ * released.
+ */
+static guac_terminal_glyph_cache glyph_cache;
+
+/**
+ * The number of references to glyph_cache which have not yet been released.
+ * glyph_cache is loaded only while this value is non-zero.
+ */
+static int glyph_cache_refs = 0;
+
+/**
+ * Lock which guards glyph_cache and glyph_cache_refs.
+ */
+static pthread_mutex_t glyph_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Initializes the header of a newly-created glyph cache, including its
+ * process-shared lock. The magic value is written last, signalling to other
+ * processes that the cache is ready for use.
+ *
+ * @param header
+ *     The header of the glyph cache to initialize, which must be zeroed.
+ *
+ * @param shared
+ *     Non-zero if the cache will be shared between processes, zero if the
+ *     cache is private to the current process.
+ *
+ * @return
+ *     Zero if initialization succeeded, non-zero otherwise.
+ */
+static int guac_terminal_glyph_cache_init(
+        guac_terminal_glyph_cache_header* header, int shared) {
+
+    pthread_mutexattr_t lock_attributes;
+    if (pthread_mutexattr_init(&lock_attributes))
+        return 1;
+
+    /* Lock must be usable by all processes, even if a process dies while
+     * holding it */
+    if (shared) {
+        pthread_mutexattr_setpshared(&lock_attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&lock_attributes, PTHREAD_MUTEX_ROBUST);
+    }
+
+    int result = pthread_mutex_init(&header->lock, &lock_attributes);
+    pthread_mutexattr_destroy(&lock_attributes);
+
+    if (result)
+        return 1;
+
+    /* Publish initialized cache */
+    __sync_synchronize();
+    header->magic = GUAC_TERMINAL_GLYPH_CACHE_MAGIC;
+    return 0;
+
+}
+
+/**
+ * Empties the given glyph cache, discarding all fonts, entries, and glyph
+ * data. Any font indexes remembered by keys are invalidated. The cache must
+ * be locked.
+ *
+ * @param header
+ *     The header of the glyph cache to empty.
+ */
+static void guac_terminal_glyph_cache_clear(
+        guac_terminal_glyph_cache_header* header) {
+
+    memset(header->fonts, 0, sizeof(header->fonts));
+    memset(header->entries, 0, sizeof(header->entries));
+
+    header->font_count = 0;
+    header->entry_count = 0;
+    header->data_used = 0;
+    header->generation++;
+
+}
+
+/**
+ * Acquires the lock of the given glyph cache header, recovering the lock if
+ * it was held by a process which has since died. As entries are only
+ * published once completely written, the cache remains consistent
+ * regardless of when any such process died.
+ *
+ * @param header
+ *     The header of the glyph cache to lock.
+ *
+ * @return
+ *     Zero if the lock was acquired, non-zero otherwise.
+ */
+static int guac_terminal_glyph_cache_lock(
+        guac_terminal_glyph_cache_header* header) {
+
+    int result = pthread_mutex_lock(&header->lock);
+    if (result == EOWNERDEAD) {
+        guac_terminal_glyph_cache_clear(header);
+        return pthread_mutex_consistent(&header->lock);
+    }
+
+    return result;
+
+}
+
+#ifdef HAVE_SHM_OPEN
+/**
+ * Stores the name of the shared memory object containing the glyph cache of
+ * the current user within the given buffer.
+ *
+ * @param name
+ *     The buffer in which to store the name, which must be at least
+ *     GUAC_TERMINAL_GLYPH_CACHE_MAX_NAME_LENGTH bytes long.
+ */
+static void guac_terminal_glyph_cache_name(char* name) {
+    snprintf(name, GUAC_TERMINAL_GLYPH_CACHE_MAX_NAME_LENGTH,
+            GUAC_TERMINAL_GLYPH_CACHE_NAME, (unsigned int) geteuid());
+}
+#endif
+
+/**
+ * Maps the glyph cache shared by all terminals of the current user, creating
+ * the underlying shared memory if it does not yet exist. The current process
+ * is counted as attached to the cache until guac_terminal_glyph_cache_close()
+ * is invoked.
+ *
+ * @return
+ *     The mapped header of the shared glyph cache, or NULL if the cache could
+ *     not be opened or created.
+ */
+static guac_terminal_glyph_cache_header* guac_terminal_glyph_cache_open() {
+
+#ifdef HAVE_SHM_OPEN
+
+    char name[GUAC_TERMINAL_GLYPH_CACHE_MAX_NAME_LENGTH];
+    guac_terminal_glyph_cache_name(name);
+
+    /* Attempt to create cache, opening existing cache if creation fails */
+    int created = 1;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd == -1 && errno == EEXIST) {
+        created = 0;
+        fd = shm_open(name, O_RDWR, 0);
+    }
+
+    if (fd == -1)
+        return NULL;
+
+    /* Newly-created caches must be sized before use */
+    if (created && ftruncate(fd, GUAC_TERMINAL_GLYPH_CACHE_SIZE)) {
+        shm_unlink(name);
+        close(fd);
+        return NULL;
+    }
+
+    /* Wait for size to be set if created by another process */
+    guac_timestamp start = guac_timestamp_current();
+    struct stat cache_stat;
+    while (!fstat(fd, &cache_stat)
+            && cache_stat.st_size < GUAC_TERMINAL_GLYPH_CACHE_SIZE) {
+
+        if (guac_timestamp_current() - start
+                > GUAC_TERMINAL_GLYPH_CACHE_INIT_TIMEOUT) {
+            close(fd);
+            return NULL;
+        }
+
+        guac_timestamp_msleep(10);
+
+    }
+
+    guac_terminal_glyph_cache_header* header = mmap(NULL,
+            GUAC_TERMINAL_GLYPH_CACHE_SIZE, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (header == MAP_FAILED)
+        return NULL;
+
+    /* Initialize cache if newly created */
+    if (created) {
+        if (guac_terminal_glyph_cache_init(header, 1)) {
+            shm_unlink(name);
+            munmap(header, GUAC_TERMINAL_GLYPH_CACHE_SIZE);
+            return NULL;
+        }
+    }
+
+    /* Otherwise, wait for the creating process to finish initialization */
+    else {
+
+        while (header->magic != GUAC_TERMINAL_GLYPH_CACHE_MAGIC) {
+
+            if (guac_timestamp_current() - start
+                    > GUAC_TERMINAL_GLYPH_CACHE_INIT_TIMEOUT) {
+                munmap(header, GUAC_TERMINAL_GLYPH_CACHE_SIZE);
+                return NULL;
+            }
+
+            guac_timestamp_msleep(10);
+
+        }
+
+        __sync_synchronize();
+
+    }
+
+    /* Count current process as attached */
+    if (guac_terminal_glyph_cache_lock(header)) {
+        munmap(header, GUAC_TERMINAL_GLYPH_CACHE_SIZE);
+        return NULL;
+    }
+
+    header->attached++;
+    pthread_mutex_unlock(&header->lock);
+
+    return header;
+
+#else
+    return NULL;
+#endif
+
+}
+
+/**
+ * Unmaps the given glyph cache, previously mapped by
+ * guac_terminal_glyph_cache_open(). If no other process remains attached to
+ * the cache, its underlying shared memory object is removed.
+ *
+ * @param header
+ *     The mapped header of the shared glyph cache.
+ */
+static void guac_terminal_glyph_cache_close(
+        guac_terminal_glyph_cache_header* header) {
+
+#ifdef HAVE_SHM_OPEN
+
+    /* Remove cache once no process remains attached (a process attaching
+     * concurrently may still map the removed cache, which will simply not be
+     * shared with processes started later) */
+    if (!guac_terminal_glyph_cache_lock(header)) {
+
+        if (header->attached > 0)
+            header->attached--;
+
+        if (header->attached == 0) {
+            char name[GUAC_TERMINAL_GLYPH_CACHE_MAX_NAME_LENGTH];
+            guac_terminal_glyph_cache_name(name);
+            shm_unlink(name);
+        }
+
+        pthread_mutex_unlock(&header->lock);
+
+    }
+
+    munmap(header, GUAC_TERMINAL_GLYPH_CACHE_SIZE);
+
+#endif
+
+}
+
+/**
+ * Loads glyph_cache, mapping the shared glyph cache if possible and falling
+ * back to a private cache otherwise. glyph_cache_lock must be held.
+ *
+ * @return
+ *     Zero if glyph_cache was loaded successfully, non-zero otherwise.
+ */
+static int guac_terminal_glyph_cache_load() {
+
+    int shared = 1;
+    guac_terminal_glyph_cache_header* header = guac_terminal_glyph_cache_open();
+
+    /* Fall back to private cache if shared cache is unavailable */
+    if (header == NULL) {
+
+        header = calloc(1, GUAC_TERMINAL_GLYPH_CACHE_SIZE);
+        if (header == NULL)
+            return 1;
+
+        if (guac_terminal_glyph_cache_init(header, 0)) {
+            free(header);
+            return 1;
+        }
+
+        shared = 0;
+
+    }
+
+    glyph_cache.header = header;
+    glyph_cache.data = (unsigned char*) header
+        + sizeof(guac_terminal_glyph_cache_header);
+    glyph_cache.data_size = GUAC_TERMINAL_GLYPH_CACHE_SIZE
+        - sizeof(guac_terminal_glyph_cache_header);
+    glyph_cache.shared = shared;
+
+    return 0;
+
+}
+
+guac_terminal_glyph_cache* guac_terminal_glyph_cache_get() {
+
+    guac_terminal_glyph_cache* cache = NULL;
+
+    pthread_mutex_lock(&glyph_cache_lock);
+
+    /* Load cache upon first reference */
+    if (glyph_cache_refs > 0 || !guac_terminal_glyph_cache_load()) {
+        glyph_cache_refs++;
+        cache = &glyph_cache;
+    }
+
+    pthread_mutex_unlock(&glyph_cache_lock);
+
+    return cache;
+
+}
+
+void guac_terminal_glyph_cache_release(guac_terminal_glyph_cache* cache) {
+
+    pthread_mutex_lock(&glyph_cache_lock);
+
+    /* Unload cache once all references are released */
+    if (--glyph_cache_refs == 0) {
+
+        if (cache->shared)
+            guac_terminal_glyph_cache_close(cache->header);
+        else {
+            pthread_mutex_destroy(&cache->header->lock);
+            free(cache->header);
+        }
+
+        cache->header = NULL;
+        cache->data = NULL;
+
+    }
+
+    pthread_mutex_unlock(&glyph_cache_lock);
+
+}
+
+void guac_terminal_glyph_cache_key_init(guac_terminal_glyph_cache_key* key,
+        const char* font, int char_width, int char_height) {
+
+    /* Glyphs of fonts whose descriptions cannot be stored are never cached */
+    if (strlen(font) >= sizeof(key->description))
+        key->description[0] = '\0';
+    else
+        strcpy(key->description, font);
+
+    key->char_width = char_width;
+    key->char_height = char_height;
+    key->index = -1;
+    key->generation = 0;
+
+}
+
+/**
+ * Returns the index of the font identified by the given key within the font
+ * table of the given cache, comparing the full font description and
+ * character dimensions. The index is remembered within the key until the
+ * cache is emptied. The cache must be locked.
+ *
+ * @param cache
+ *     The glyph cache to search.
+ *
+ * @param key
+ *     The key identifying the font.
+ *
+ * @param add
+ *     Non-zero if the font should be added to the font table if not already
+ *     present, zero otherwise.
+ *
+ * @return
+ *     The index of the font within the font table of the cache, or -1 if
+ *     the font is not present and was not added.
+ */
+static int guac_terminal_glyph_cache_find_font(
+        guac_terminal_glyph_cache* cache, guac_terminal_glyph_cache_key* key,
+        int add) {
+
+    guac_terminal_glyph_cache_header* header = cache->header;
+
+    /* Fonts whose descriptions cannot be stored are never cached */
+    if (key->description[0] == '\0')
+        return -1;
+
+    /* Reuse index unless the cache has been emptied since */
+    if (key->index != -1 && key->generation == header->generation)
+        return key->index;
+
+    key->index = -1;
+    key->generation = header->generation;
+
+    for (int i = 0; i < header->font_count; i++) {
+
+        guac_terminal_glyph_cache_font* font = &header->fonts[i];
+
+        if (font->char_width == key->char_width
+                && font->char_height == key->char_height
+                && strcmp(font->description, key->description) == 0) {
+            key->index = i;
+            return i;
+        }
+
+    }
+
+    if (!add || header->font_count >= GUAC_TERMINAL_GLYPH_CACHE_FONTS)
+        return -1;
+
+    /* Add new font to end of table */
+    int index = header->font_count;
+    guac_terminal_glyph_cache_font* font = &header->fonts[index];
+    strcpy(font->description, key->description);
+    font->char_width = key->char_width;
+    font->char_height = key->char_height;
+    header->font_count++;
+
+    key->index = index;
+    return index;
+
+}
+
+/**
+ * Searches the hash table of the given glyph cache for the given glyph. The
+ * cache must be locked.
+ *
+ * @param cache
+ *     The glyph cache to search.
+ *
+ * @param font
+ *     The index of the font of the glyph within the font table of the cache.
+ *
+ * @param codepoint
+ *     The codepoint of the glyph.
+ *
+ * @param width
+ *     The width of the glyph, in pixels.
+ *
+ * @param height
+ *     The height of the glyph, in pixels.
+ *
+ * @return
+ *     The entry containing the glyph or, if the glyph is not present, the
+ *     unused entry in which the glyph should be stored.
+ */
+static guac_terminal_glyph_cache_entry* guac_terminal_glyph_cache_find(
+        guac_terminal_glyph_cache* cache, int font, int codepoint,
+        int width, int height) {
+
+    guac_terminal_glyph_cache_entry* entries = cache->header->entries;
+
+    uint64_t hash = ((uint64_t) font << 32 | (uint32_t) codepoint)
+        * 0x9e3779b97f4a7c15;
+    unsigned int index = (hash ^ (hash >> 32))
+        & (GUAC_TERMINAL_GLYPH_CACHE_ENTRIES - 1);
+
+    /* Probe until glyph or unused entry is found (the table is never
+     * allowed to become full) */
+    for (;;) {
+
+        guac_terminal_glyph_cache_entry* entry = &entries[index];
+
+        if (!entry->valid
+                || (entry->font      == font
+                 && entry->codepoint == codepoint
+                 && entry->width     == width
+                 && entry->height    == height))
+            return entry;
+
+        index = (index + 1) & (GUAC_TERMINAL_GLYPH_CACHE_ENTRIES - 1);
+
+    }
+
+}
+
+cairo_surface_t* guac_terminal_glyph_cache_lookup(
+        guac_terminal_glyph_cache* cache, guac_terminal_glyph_cache_key* key,
+        int codepoint, int width, int height) {
+
+    if (guac_terminal_glyph_cache_lock(cache->header))
+        return NULL;
+
+    cairo_surface_t* surface = NULL;
+
+    int font = guac_terminal_glyph_cache_find_font(cache, key, 0);
+    if (font != -1) {
+
+        guac_terminal_glyph_cache_entry* entry = guac_terminal_glyph_cache_find(
+                cache, font, codepoint, width, height);
+
+        /* Copy glyph while locked, as the cache may be emptied and reused
+         * by another terminal at any time once unlocked */
+        if (entry->valid) {
+
+            surface = cairo_image_surface_create(CAIRO_FORMAT_A8,
+                    width, height);
+
+            int stride = cairo_format_stride_for_width(CAIRO_FORMAT_A8, width);
+            if (cairo_image_surface_get_stride(surface) == stride) {
+                cairo_surface_flush(surface);
+                memcpy(cairo_image_surface_get_data(surface),
+                        cache->data + entry->offset, stride * height);
+                cairo_surface_mark_dirty(surface);
+            }
+
+            /* Treat glyph as absent if it cannot be copied */
+            else {
+                cairo_surface_destroy(surface);
+                surface = NULL;
+            }
+
+        }
+
+    }
+
+    pthread_mutex_unlock(&cache->header->lock);
+
+    return surface;
+
+}
+
+void guac_terminal_glyph_cache_add(guac_terminal_glyph_cache* cache,
+        guac_terminal_glyph_cache_key* key, int codepoint,
+        cairo_surface_t* glyph) {
+
+    int width = cairo_image_surface_get_width(glyph);
+    int height = cairo_image_surface_get_height(glyph);
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_A8, width);
+
+    /* Ignore glyphs which cannot be represented */
+    if (width <= 0 || height <= 0 || width > UINT16_MAX || height > UINT16_MAX
+            || cairo_image_surface_get_stride(glyph) != stride)
+        return;
+
+    /* Keep all glyph data aligned */
+    uint32_t size = stride * height;
+    uint32_t aligned_size = (size + 15) & ~15;
+
+    /* Ignore glyphs which could never fit */
+    if (aligned_size > cache->data_size)
+        return;
+
+    /* Glyph data must be current before being copied */
+    cairo_surface_flush(glyph);
+
+    if (guac_terminal_glyph_cache_lock(cache->header))
+        return;
+
+    guac_terminal_glyph_cache_header* header = cache->header;
+
+    /* Empty cache once the table or data area is full, keeping the table
+     * no more than 75% occupied */
+    if (header->entry_count >= GUAC_TERMINAL_GLYPH_CACHE_ENTRIES / 4 * 3
+            || aligned_size > cache->data_size - header->data_used)
+        guac_terminal_glyph_cache_clear(header);
+
+    /* Likewise empty cache if the font table is full */
+    int font = guac_terminal_glyph_cache_find_font(cache, key, 1);
+    if (font == -1 && key->description[0] != '\0') {
+        guac_terminal_glyph_cache_clear(header);
+        font = guac_terminal_glyph_cache_find_font(cache, key, 1);
+    }
+
+    if (font == -1) {
+        pthread_mutex_unlock(&header->lock);
+        return;
+    }
+
+    guac_terminal_glyph_cache_entry* entry = guac_terminal_glyph_cache_find(
+            cache, font, codepoint, width, height);
+
+    /* Store glyph only if not added by another terminal in the meantime */
+    if (!entry->valid) {
+
+        /* Reserve space for glyph data before writing, such that a process
+         * dying part way through never leaves space in use by an entry
+         * available for reuse */
+        uint32_t offset = header->data_used;
+        header->data_used += aligned_size;
+
+        memcpy(cache->data + offset, cairo_image_surface_get_data(glyph),
+                size);
+
+        entry->font = font;
+        entry->codepoint = codepoint;
+        entry->width = width;
+        entry->height = height;
+        entry->offset = offset;
+
+        /* Publish entry only once completely written */
+        __sync_synchronize();
+        entry->valid = 1;
+
+        header->entry_count++;
+
+    }
+
+    pthread_mutex_unlock(&header->lock);
+
+}
@@ -0,0 +1,312 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "terminal/buffer.h"
+#include "terminal/search.h"
+#include "terminal/select.h"
+#include "terminal/terminal.h"
+
+#include <guacamole/protocol.h>
+#include <guacamole/socket.h>
+#include <guacamole/stream.h>
+#include <guacamole/unicode.h>
+#include <guacamole/user.h>
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Returns the given codepoint, converted to lowercase if it is an uppercase
+ * ASCII letter.
+ *
+ * @param codepoint
+ *     The codepoint to convert.
+ *
+ * @return
+ *     The lowercase form of the given codepoint.
+ */
+static int32_t guac_terminal_search_fold(int32_t codepoint) {
+
+    if (codepoint >= 'A' && codepoint <= 'Z')
+        return codepoint + 'a' - 'A';
+
+    return codepoint;
+
+}
+
+/**
+ * Searches the given text for the last occurrence of the given needle which
+ * begins before the given limit.
+ *
+ * @param text
+ *     The text to search, already converted with guac_terminal_search_fold().
+ *
+ * @param length
+ *     The number of codepoints within the text.
+ *
+ * @param needle
+ *     The text to search for, already converted with
+ *     guac_terminal_search_fold().
+ *
+ * @param needle_length
+ *     The number of codepoints within the needle.
+ *
+ * @param limit
+ *     The index within the text before which the occurrence must begin.
+ *
+ * @return
+ *     The index of the start of the last occurrence within the text, or -1
+ *     if there is no such occurrence.
+ */
+static int guac_terminal_search_text(const int32_t* text, int length,
+        const int32_t* needle, int needle_length, int limit) {
+
+    int start = length - needle_length;
+    if (start >= limit)
+        start = limit - 1;
+
+    for (; start >= 0; start--) {
+
+        int i;
+        for (i = 0; i < needle_length; i++) {
+            if (text[start + i] != needle[i])
+                break;
+        }
+
+        if (i == needle_length)
+            return start;
+
+    }
+
+    return -1;
+
+}
+
+/**
+ * Scrolls the display of the given terminal such that the given row is
+ * visible, centering the row within the display if it is not already
+ * visible.
+ *
+ * @param terminal
+ *     The guac_terminal to scroll.
+ *
+ * @param row
+ *     The row that should be visible, where the first (top-most) row in the
+ *     terminal is row 0. Rows within the scrollback buffer (above the
+ *     top-most row of the terminal) will be negative.
+ */
+static void guac_terminal_search_reveal(guac_terminal* terminal, int row) {
+
+    /* Nothing to do if row is already in view */
+    int visible_row = row + terminal->scroll_offset;
+    if (visible_row >= 0 && visible_row < terminal->term_height)
+        return;
+
+    /* Center row within display, within the bounds of the scrollback */
+    int scroll_offset = terminal->term_height / 2 - row;
+    int available_scroll = guac_terminal_available_scroll(terminal);
+    if (scroll_offset > available_scroll)
+        scroll_offset = available_scroll;
+    else if (scroll_offset < 0)
+        scroll_offset = 0;
+
+    int delta = scroll_offset - terminal->scroll_offset;
+    if (delta > 0)
+        guac_terminal_scroll_display_up(terminal, delta);
+    else if (delta < 0)
+        guac_terminal_scroll_display_down(terminal, -delta);
+
+}
+
+int guac_terminal_search(guac_terminal* terminal, const char* query,
+        int length) {
+
+    int32_t needle[GUAC_TERMINAL_MAX_SEARCH_LENGTH];
+    int needle_length = 0;
+
+    int32_t text[GUAC_TERMINAL_MAX_COLUMNS];
+    int columns[GUAC_TERMINAL_MAX_COLUMNS];
+
+    /* Decode search string */
+    while (length > 0 && needle_length < GUAC_TERMINAL_MAX_SEARCH_LENGTH) {
+
+        int codepoint;
+        int bytes = guac_utf8_read(query, length, &codepoint);
+        if (bytes == 0)
+            break;
+
+        needle[needle_length++] = guac_terminal_search_fold(codepoint);
+        query += bytes;
+        length -= bytes;
+
+    }
+
+    /* An empty string can never be found */
+    if (needle_length == 0)
+        return 1;
+
+    uint64_t signature = guac_terminal_buffer_signature(needle, needle_length);
+
+    /* Continue from just before the current selection, if any, or from the
+     * bottom of the display otherwise */
+    int row = terminal->term_height - terminal->scroll_offset - 1;
+    int limit_column = INT_MAX;
+    if (terminal->text_selected) {
+
+        row = terminal->selection_start_row;
+        limit_column = terminal->selection_start_column;
+
+        if (terminal->selection_end_row < row
+                || (terminal->selection_end_row == row
+                    && terminal->selection_end_column < limit_column)) {
+            row = terminal->selection_end_row;
+            limit_column = terminal->selection_end_column;
+        }
+
+    }
+
+    int first_row = -guac_terminal_available_scroll(terminal);
+    for (; row >= first_row; row--, limit_column = INT_MAX) {
+
+        /* Skip rows which cannot contain the search string */
+        int text_length = guac_terminal_buffer_get_text(terminal->buffer,
+                row, signature, text, columns, GUAC_TERMINAL_MAX_COLUMNS);
+        if (text_length < needle_length)
+            continue;
+
+        /* Translate column limit into an index within the row's text */
+        int limit = 0;
+        while (limit < text_length && columns[limit] < limit_column)
+            limit++;
+
+        for (int i = 0; i < text_length; i++)
+            text[i] = guac_terminal_search_fold(text[i]);
+
+        int start = guac_terminal_search_text(text, text_length,
+                needle, needle_length, limit);
+        if (start == -1)
+            continue;
+
+        /* Jump directly to the match, without redrawing intermediate rows */
+        guac_terminal_search_reveal(terminal, row);
+
+        /* Highlight match without replacing the clipboard contents */
+        guac_terminal_select_start(terminal, row, columns[start]);
+        guac_terminal_select_update(terminal, row,
+                columns[start + needle_length - 1]);
+        terminal->text_selected = true;
+        terminal->selection_committed = true;
+
+        return 0;
+
+    }
+
+    return 1;
+
+}
+
+/**
+ * Handler for "blob" instructions which appends the data of received blobs
+ * to the search string of the stream.
+ *
+ * @see guac_user_blob_handler
+ */
+static int guac_terminal_search_stream_blob_handler(guac_user* user,
+        guac_stream* stream, void* data, int length) {
+
+    guac_terminal_search_stream_state* state =
+        (guac_terminal_search_stream_state*) stream->data;
+
+    /* Truncate search strings which are too long */
+    int remaining = sizeof(state->query) - state->length;
+    if (length > remaining)
+        length = remaining;
+
+    memcpy(state->query + state->length, data, length);
+    state->length += length;
+
+    guac_protocol_send_ack(user->socket, stream, "OK (DATA RECEIVED)",
+            GUAC_PROTOCOL_STATUS_SUCCESS);
+
+    guac_socket_flush(user->socket);
+    return 0;
+
+}
+
+/**
+ * Handler for "end" instructions which searches the terminal for the search
+ * string received over the stream.
+ *
+ * @see guac_user_end_handler
+ */
+static int guac_terminal_search_stream_end_handler(guac_user* user,
+        guac_stream* stream) {
+
+    guac_terminal_search_stream_state* state =
+        (guac_terminal_search_stream_state*) stream->data;
+
+    guac_terminal* terminal = state->terminal;
+
+    guac_terminal_lock(terminal);
+    int result = guac_terminal_search(terminal, state->query, state->length);
+    guac_terminal_unlock(terminal);
+
+    if (result)
+        guac_user_log(user, GUAC_LOG_DEBUG, "Search string not found within "
+                "terminal.");
+
+    free(state);
+    return 0;
+
+}
+
+int guac_terminal_search_stream(guac_terminal* terminal, guac_user* user,
+        guac_stream* stream) {
+
+    guac_terminal_search_stream_state* state =
+        calloc(1, sizeof(guac_terminal_search_stream_state));
+
+    if (state == NULL) {
+
+        guac_protocol_send_ack(user->socket, stream,
+                "Unable to allocate search.",
+                GUAC_PROTOCOL_STATUS_SERVER_ERROR);
+
+        guac_socket_flush(user->socket);
+        return 1;
+
+    }
+
+    state->terminal = terminal;
+
+    stream->blob_handler = guac_terminal_search_stream_blob_handler;
+    stream->end_handler = guac_terminal_search_stream_end_handler;
+    stream->data = state;
+
+    guac_protocol_send_ack(user->socket, stream, "Ready for search string.",
+            GUAC_PROTOCOL_STATUS_SUCCESS);
+
+    guac_socket_flush(user->socket);
+    return 0;
+
+}
@@ -27,10 +27,14 @@
 #include "terminal/types.h"
 
 #include <guacamole/client.h>
+#include <guacamole/protocol.h>
 #include <guacamole/socket.h>
+#include <guacamole/stream.h>
 #include <guacamole/unicode.h>
 
+#include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * Returns the coordinates for the currently-selected range of text within the
@@ -252,89 +256,93 @@ void guac_terminal_select_resume(guac_terminal* terminal, int row, int column) {
 }
 
 /**
- * Appends the text within the given subsection of a terminal row to the
- * clipboard. The provided coordinates are considered inclusiveley (the
- * characters at the start and end column are included in the copied
- * text). Any out-of-bounds coordinates will be automatically clipped within
- * the bounds of the given row.
+ * Reads as much of the remaining text of the selection being copied as fits
+ * within the given buffer, encoded as UTF-8, advancing the copy position of
+ * the terminal accordingly. Rows are read in place, without unpacking rows
+ * within the scrollback buffer. Rows which have been discarded from the
+ * scrollback buffer since copying began are skipped.
  *
  * @param terminal
- *     The guac_terminal instance associated with the buffer containing the
- *     text being copied and the clipboard receiving the copied text.
+ *     The guac_terminal whose selection is being copied.
  *
- * @param row
- *     The row number of the text within the terminal to be copied into the
- *     clipboard, where the first (top-most) row in the terminal is row 0. Rows
- *     within the scrollback buffer (above the top-most row of the terminal)
- *     will be negative.
+ * @param buffer
+ *     The buffer which should receive the text read.
  *
- * @param start
- *     The first column of the text to be copied from the given row into the
- *     clipboard associated with the given terminal, where 0 is the first
- *     (left-most) column within the row.
+ * @param length
+ *     The size of the buffer, in bytes.
  *
- * @param end
- *     The last column of the text to be copied from the given row into the
- *     clipboard associated with the given terminal, where 0 is the first
- *     (left-most) column within the row, or a negative value to denote that
- *     the last column in the row should be used.
+ * @return
+ *     The number of bytes read into the buffer.
  */
-static void guac_terminal_clipboard_append_row(guac_terminal* terminal,
-        int row, int start, int end) {
+static int guac_terminal_select_read(guac_terminal* terminal, char* buffer,
+        int length) {
 
-    char buffer[1024];
-    int i = start;
+    int32_t text[GUAC_TERMINAL_MAX_COLUMNS];
+    int columns[GUAC_TERMINAL_MAX_COLUMNS];
 
-    guac_terminal_buffer_row* buffer_row =
-        guac_terminal_buffer_get_row(terminal->buffer, row, 0);
+    char* current = buffer;
+    int remaining = length;
 
-    /* If selection is entirely outside the bounds of the row, then there is
-     * nothing to append */
-    if (start < 0 || start > buffer_row->length - 1)
-        return;
+    /* Skip any rows no longer present within the scrollback buffer */
+    int first_row = -guac_terminal_available_scroll(terminal);
+    if (terminal->copy_row < first_row) {
+        terminal->copy_row = first_row;
+        terminal->copy_column = -1;
+    }
+
+    while (terminal->copy_row <= terminal->copy_end_row) {
 
-    /* Clip given range to actual bounds of row */
-    if (end < 0 || end > buffer_row->length - 1)
-        end = buffer_row->length - 1;
+        /* Separate each row from the previous row with a newline */
+        if (terminal->copy_column == -1) {
 
-    /* Repeatedly convert chunks of terminal buffer rows until entire specified
-     * region has been appended to clipboard */
-    while (i <= end) {
+            if (remaining == 0)
+                break;
+
+            *(current++) = '\n';
+            remaining--;
+            terminal->copy_column = 0;
+
+        }
 
-        int remaining = sizeof(buffer);
-        char* current = buffer;
+        int end_column = INT_MAX;
+        if (terminal->copy_row == terminal->copy_end_row)
+            end_column = terminal->copy_end_column;
 
-        /* Convert as many codepoints within the given range as possible */
-        for (i = start; i <= end; i++) {
+        int text_length = guac_terminal_buffer_get_text(terminal->buffer,
+                terminal->copy_row, 0, text, columns,
+                GUAC_TERMINAL_MAX_COLUMNS);
 
-            int codepoint = buffer_row->characters[i].value;
+        /* Convert as many codepoints within the row as possible */
+        for (int i = 0; i < text_length && columns[i] <= end_column; i++) {
 
-            /* Ignore null (blank) characters */
-            if (codepoint == 0 || codepoint == GUAC_CHAR_CONTINUATION)
+            /* Ignore characters already copied, as well as null (blank)
+             * characters */
+            if (columns[i] < terminal->copy_column || text[i] == 0)
                 continue;
 
-            /* Encode current codepoint as UTF-8 */
-            int bytes = guac_utf8_write(codepoint, current, remaining);
-            if (bytes == 0)
-                break;
+            /* Resume from current character once space is available */
+            int bytes = guac_utf8_write(text[i], current, remaining);
+            if (bytes == 0) {
+                terminal->copy_column = columns[i];
+                return current - buffer;
+            }
 
             current += bytes;
             remaining -= bytes;
 
         }
 
-        /* Append converted buffer to clipboard */
-        guac_common_clipboard_append(terminal->clipboard, buffer, current - buffer);
+        terminal->copy_row++;
+        terminal->copy_column = -1;
 
     }
 
+    return current - buffer;
+
 }
 
 void guac_terminal_select_end(guac_terminal* terminal) {
 
-    guac_client* client = terminal->client;
-    guac_socket* socket = client->socket;
-
     /* If no text is selected, nothing to do */
     if (!terminal->text_selected)
         return;
@@ -342,45 +350,125 @@ void guac_terminal_select_end(guac_terminal* terminal) {
     /* Selection is now committed */
     terminal->selection_committed = true;
 
-    /* Reset current clipboard contents */
-    guac_common_clipboard_reset(terminal->clipboard, "text/plain");
+    /* Reset current clipboard contents, allowing as much text to be copied
+     * as configured */
+    guac_common_clipboard_reset_size(terminal->clipboard, "text/plain",
+            terminal->copy_limit);
+    terminal->copy_length = 0;
 
-    int start_row, start_col;
-    int end_row, end_col;
-
-    /* Ensure proper ordering of start and end coords */
+    /* Copy selection from its start, in proper order, replacing any copy
+     * still in progress */
     guac_terminal_select_normalized_range(terminal,
-            &start_row, &start_col, &end_row, &end_col);
+            &terminal->copy_row, &terminal->copy_column,
+            &terminal->copy_end_row, &terminal->copy_end_column);
 
-    /* If only one row, simply copy */
-    if (end_row == start_row)
-        guac_terminal_clipboard_append_row(terminal, start_row, start_col, end_col);
+    terminal->copy_restart = true;
+    guac_terminal_notify(terminal);
 
-    /* Otherwise, copy multiple rows */
-    else {
+}
+
+bool guac_terminal_select_copy(guac_terminal* terminal) {
+
+    guac_client* client = terminal->client;
+    guac_socket* socket = client->socket;
+
+    char buffer[GUAC_COMMON_CLIPBOARD_BLOCK_SIZE];
 
-        /* Store first row */
-        guac_terminal_clipboard_append_row(terminal, start_row, start_col, -1);
+    /* Read next chunk of selection while terminal contents are stable */
+    guac_terminal_lock(terminal);
 
-        /* Store all middle rows */
-        for (int row = start_row + 1; row < end_row; row++) {
-            guac_common_clipboard_append(terminal->clipboard, "\n", 1);
-            guac_terminal_clipboard_append_row(terminal, row, 0, -1);
+    bool restart = terminal->copy_restart;
+    terminal->copy_restart = false;
+
+    /* Read no more than the remaining copy limit, such that the text
+     * streamed always matches the clipboard contents */
+    int limit = terminal->copy_limit - terminal->copy_length;
+    if (limit < 0)
+        limit = 0;
+
+    int max_length = sizeof(buffer);
+    if (max_length > limit)
+        max_length = limit;
+
+    bool truncated = false;
+    int length = guac_terminal_select_read(terminal, buffer, max_length);
+    if (length > 0) {
+
+        /* Stream only what the clipboard actually accepted */
+        int appended = guac_common_clipboard_append(terminal->clipboard,
+                buffer, length);
+        if (appended < length) {
+            length = appended;
+            truncated = true;
         }
 
-        /* Store last row */
-        guac_common_clipboard_append(terminal->clipboard, "\n", 1);
-        guac_terminal_clipboard_append_row(terminal, end_row, 0, end_col);
+        terminal->copy_length += length;
+
+    }
+
+    /* If the read was bounded by the limit yet text remains, the next
+     * codepoint cannot fit within the limit and copying must stop */
+    if (max_length == limit)
+        truncated = true;
+
+    /* Stop copying once the limit is reached */
+    if (truncated && terminal->copy_row <= terminal->copy_end_row) {
+        guac_client_log(client, GUAC_LOG_DEBUG, "Copied text truncated to "
+                "%i bytes.", terminal->copy_length);
+        terminal->copy_row = terminal->copy_end_row + 1;
+    }
+
+    bool remaining = terminal->copy_row <= terminal->copy_end_row;
+    bool send = !terminal->disable_copy;
+
+    guac_terminal_unlock(terminal);
+
+    /* Nothing further to do if no copy is in progress */
+    if (!restart && length == 0 && !remaining
+            && terminal->copy_stream == NULL)
+        return false;
+
+    /* Abandon the stream of any previous selection */
+    if (restart && terminal->copy_stream != NULL) {
+        guac_protocol_send_end(socket, terminal->copy_stream);
+        guac_client_free_stream(client, terminal->copy_stream);
+        terminal->copy_stream = NULL;
+    }
+
+    /* Begin new stream for newly-committed selection */
+    if (restart && send) {
+
+        terminal->copy_stream = guac_client_alloc_stream(client);
+        if (terminal->copy_stream != NULL) {
+            guac_protocol_send_clipboard(socket, terminal->copy_stream,
+                    "text/plain");
+            guac_client_log(client, GUAC_LOG_DEBUG, "Created stream %i for "
+                    "copied terminal text.", terminal->copy_stream->index);
+        }
 
     }
 
-    /* Send data */
-    if (!terminal->disable_copy) {
-        guac_common_clipboard_send(terminal->clipboard, client);
+    if (terminal->copy_stream != NULL) {
+
+        /* Send chunk without blocking terminal output */
+        if (length > 0)
+            guac_protocol_send_blob(socket, terminal->copy_stream,
+                    buffer, length);
+
+        /* End stream once entire selection has been sent */
+        if (!remaining) {
+            guac_client_log(client, GUAC_LOG_DEBUG, "Clipboard stream %i "
+                    "complete.", terminal->copy_stream->index);
+            guac_protocol_send_end(socket, terminal->copy_stream);
+            guac_client_free_stream(client, terminal->copy_stream);
+            terminal->copy_stream = NULL;
+        }
+
         guac_socket_flush(socket);
+
     }
 
-    guac_terminal_notify(terminal);
+    return remaining;
 
 }
 
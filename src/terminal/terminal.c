@@ -78,8 +78,9 @@ static void __guac_terminal_force_break(guac_terminal* terminal, int row, int ed
 
     guac_terminal_buffer_row* buffer_row = guac_terminal_buffer_get_row(terminal->buffer, row, 0);
 
-    /* Ensure character to left of edge is unbroken */
-    if (edge > 0) {
+    /* Ensure character to left of edge is unbroken (cells beyond the end of
+     * the row are never part of a wider character) */
+    if (edge > 0 && edge <= buffer_row->length) {
 
         int end_column = edge - 1;
         int start_column = end_column;
@@ -218,6 +219,9 @@ void guac_terminal_reset(guac_terminal* term) {
     /* Reset flags */
     term->text_selected = false;
     term->selection_committed = false;
+    term->copy_restart = false;
+    term->copy_row = 0;
+    term->copy_end_row = -1;
     term->application_cursor_keys = false;
     term->automatic_carriage_return = false;
     term->insert_mode = false;
@@ -343,6 +347,7 @@ guac_terminal* guac_terminal_create(guac_client* client,
     term->client = client;
     term->upload_path_handler = NULL;
     term->file_download_handler = NULL;
+    term->copy_stream = NULL;
 
     /* Copy initially-provided color scheme and font details */
     term->color_scheme = strdup(color_scheme);
@@ -355,6 +360,16 @@ guac_terminal* guac_terminal_create(guac_client* client,
 
     /* Init modified flag and conditional */
     term->modified = 0;
+    term->scrolled_rows = 0;
+    term->last_keypress = 0;
+
+    /* Frames are initially short, with no statistics yet gathered */
+    term->frame_duration = GUAC_TERMINAL_FRAME_DURATION;
+    term->last_frame_start = guac_timestamp_current();
+    term->stats_start = term->last_frame_start;
+    term->stats_frames = 0;
+    term->stats_render_time = 0;
+    term->stats_max_render_time = 0;
     pthread_cond_init(&(term->modified_cond), NULL);
     pthread_mutex_init(&(term->modified_lock), NULL);
 
@@ -393,6 +408,7 @@ guac_terminal* guac_terminal_create(guac_client* client,
     term->current_attributes = default_char.attributes;
     term->default_char = default_char;
     term->clipboard = clipboard;
+    term->copy_limit = clipboard->size;
     term->disable_copy = disable_copy;
 
     /* Calculate character size */
@@ -506,6 +522,12 @@ void guac_terminal_free(guac_terminal* term) {
     /* Close and flush any open pipe stream */
     guac_terminal_pipe_stream_close(term);
 
+    /* End any clipboard stream left incomplete */
+    if (term->copy_stream != NULL) {
+        guac_protocol_send_end(term->client->socket, term->copy_stream);
+        guac_client_free_stream(term->client, term->copy_stream);
+    }
+
     /* Close and flush any active typescript */
     guac_terminal_typescript_free(term->typescript);
 
@@ -612,6 +634,77 @@ wait_complete:
 
 }
 
+/**
+ * Returns whether output which has just become available is likely the echo
+ * of a recently-pressed key, and thus should be flushed immediately. Once
+ * this function has been invoked, any previous key press is no longer
+ * considered.
+ *
+ * @param terminal
+ *     The terminal whose output has just become available.
+ *
+ * @param now
+ *     The current time, as returned by guac_timestamp_current().
+ *
+ * @return
+ *     true if a key was pressed within the last GUAC_TERMINAL_ECHO_TIMEOUT
+ *     milliseconds, false otherwise.
+ */
+static bool guac_terminal_is_echo(guac_terminal* terminal,
+        guac_timestamp now) {
+
+    pthread_mutex_lock(&(terminal->modified_lock));
+
+    bool echo = terminal->last_keypress != 0
+        && now - terminal->last_keypress <= GUAC_TERMINAL_ECHO_TIMEOUT;
+
+    terminal->last_keypress = 0;
+
+    pthread_mutex_unlock(&(terminal->modified_lock));
+    return echo;
+
+}
+
+/**
+ * Records the given frame within the frame statistics of the given terminal,
+ * logging a summary of those statistics once GUAC_TERMINAL_STATS_INTERVAL
+ * has elapsed since the previous summary.
+ *
+ * @param terminal
+ *     The terminal that rendered the frame.
+ *
+ * @param render_time
+ *     The time taken to render the frame, in milliseconds.
+ */
+static void guac_terminal_record_frame(guac_terminal* terminal,
+        int render_time) {
+
+    terminal->stats_frames++;
+    terminal->stats_render_time += render_time;
+    if (render_time > terminal->stats_max_render_time)
+        terminal->stats_max_render_time = render_time;
+
+    guac_timestamp now = guac_timestamp_current();
+    int elapsed = now - terminal->stats_start;
+    if (elapsed < GUAC_TERMINAL_STATS_INTERVAL)
+        return;
+
+    guac_client_log(terminal->client, GUAC_LOG_DEBUG, "Terminal rendered %i "
+            "frames in %i ms (%.1f fps), spending %i ms rendering (average "
+            "%.1f ms, maximum %i ms per frame). Current frame duration is "
+            "%i ms.", terminal->stats_frames, elapsed,
+            terminal->stats_frames * 1000.0 / elapsed,
+            terminal->stats_render_time,
+            (double) terminal->stats_render_time / terminal->stats_frames,
+            terminal->stats_max_render_time, terminal->frame_duration);
+
+    terminal->stats_start = now;
+    terminal->stats_frames = 0;
+    terminal->stats_render_time = 0;
+    terminal->stats_max_render_time = 0;
+
+}
+
 int guac_terminal_render_frame(guac_terminal* terminal) {
 
     guac_client* client = terminal->client;
@@ -624,28 +717,90 @@ int guac_terminal_render_frame(guac_terminal* terminal) {
 
         guac_timestamp frame_start = guac_timestamp_current();
 
-        do {
+        /* Flush the echo of a key press immediately, for minimum latency */
+        bool echo = guac_terminal_is_echo(terminal, frame_start);
+
+        /* Calculate time that client needs to catch up */
+        int processing_lag = guac_client_get_processing_lag(client);
+        int required_wait = processing_lag
+            - (frame_start - terminal->last_frame_start);
+
+        /* Whether output continued for the full duration of the frame */
+        bool sustained = false;
+
+        while (!echo && client->state == GUAC_CLIENT_RUNNING
+                && (wait_result > 0 || !terminal->started)) {
+
+            /* Extend frame if client is lagging, further so if flooded with
+             * output such that only the final screen need be sent */
+            int max_duration = GUAC_TERMINAL_MAX_FRAME_DURATION;
+            if (terminal->display->suspended)
+                max_duration = GUAC_TERMINAL_FLOOD_MAX_FRAME_DURATION;
+
+            int lag_duration = required_wait;
+            if (lag_duration > max_duration)
+                lag_duration = max_duration;
 
             /* Calculate time remaining in frame */
             guac_timestamp frame_end = guac_timestamp_current();
-            int frame_remaining = frame_start + GUAC_TERMINAL_FRAME_DURATION
-                                - frame_end;
+            int frame_remaining = frame_start + terminal->frame_duration
+                            - frame_end;
+            int lag_remaining = frame_start + lag_duration - frame_end;
+
+            /* Wait for client to catch up */
+            if (lag_remaining > GUAC_TERMINAL_FRAME_TIMEOUT)
+                wait_result = guac_terminal_wait(terminal, lag_remaining);
 
             /* Wait again if frame remaining */
-            if (frame_remaining > 0 || !terminal->started)
+            else if (frame_remaining > 0 || !terminal->started)
                 wait_result = guac_terminal_wait(terminal,
                         GUAC_TERMINAL_FRAME_TIMEOUT);
-            else
+
+            else {
+                sustained = true;
                 break;
+            }
+
+        }
+
+        /* Coalesce more output into each frame while output is sustained,
+         * returning to short frames once output pauses */
+        if (sustained) {
+            terminal->frame_duration += GUAC_TERMINAL_FRAME_DURATION;
+            if (terminal->frame_duration > GUAC_TERMINAL_MAX_FRAME_DURATION)
+                terminal->frame_duration = GUAC_TERMINAL_MAX_FRAME_DURATION;
+        }
+        else
+            terminal->frame_duration = GUAC_TERMINAL_FRAME_DURATION;
 
-        } while (client->state == GUAC_CLIENT_RUNNING
-                && (wait_result > 0 || !terminal->started));
+        /* Record start of frame, excluding rendering time (this time is
+         * assumed to be consistent between frames, and should thus be
+         * excluded from the required wait period of the next frame) */
+        terminal->last_frame_start = frame_start;
 
-        /* Flush terminal */
+        guac_timestamp render_start = guac_timestamp_current();
+
+        /* Take snapshot of terminal display */
         guac_terminal_lock(terminal);
-        guac_terminal_flush(terminal);
+        guac_terminal_flush_snapshot(terminal);
         guac_terminal_unlock(terminal);
 
+        /* Render snapshot without blocking further output or input */
+        guac_terminal_display_render(terminal->display);
+
+        guac_terminal_record_frame(terminal,
+                guac_timestamp_current() - render_start);
+
+        /* Continue streaming any selection copied to the clipboard, resuming
+         * with the next frame if more remains */
+        int chunks = 0;
+        while (guac_terminal_select_copy(terminal)) {
+            if (++chunks == GUAC_TERMINAL_COPY_FRAME_CHUNKS) {
+                guac_terminal_notify(terminal);
+                break;
+            }
+        }
+
     }
 
     return 0;
@@ -819,30 +974,131 @@ void guac_terminal_commit_cursor(guac_terminal* term) {
 
 }
 
+void guac_terminal_set_text(guac_terminal* term, int row, int col,
+        const char* text, int length) {
+
+    int end_column = col + length - 1;
+
+    /* Do nothing if no text */
+    if (length <= 0)
+        return;
+
+    guac_terminal_display_set_text(term->display, row + term->scroll_offset,
+            col, text, length, &term->current_attributes);
+
+    guac_terminal_buffer_set_text(term->buffer, row, col, text, length,
+            &term->current_attributes);
+
+    /* Clear selection if region is modified */
+    guac_terminal_select_touch(term, row, col, row, end_column);
+
+    /* If visible cursor in current row, preserve state */
+    if (row == term->visible_cursor_row
+            && term->visible_cursor_col >= col
+            && term->visible_cursor_col <= end_column) {
+
+        guac_terminal_char cursor_character = {
+            .value      = (unsigned char) text[term->visible_cursor_col - col],
+            .attributes = term->current_attributes,
+            .width      = 1
+        };
+
+        cursor_character.attributes.cursor = true;
+
+        __guac_terminal_set_columns(term, row,
+                term->visible_cursor_col, term->visible_cursor_col, &cursor_character);
+
+    }
+
+    /* Force breaks around destination region */
+    __guac_terminal_force_break(term, row, col);
+    __guac_terminal_force_break(term, row, end_column + 1);
+
+}
+
 int guac_terminal_write(guac_terminal* term, const char* c, int size) {
 
-    guac_terminal_lock(term);
     while (size > 0) {
 
-        /* Read and advance to next character */
-        char current = *(c++);
-        size--;
+        /* Handle output in slices, releasing the terminal between slices
+         * such that input never waits for an entire buffer to be handled */
+        int slice = size;
+        if (slice > GUAC_TERMINAL_MAX_WRITE_SLICE)
+            slice = GUAC_TERMINAL_MAX_WRITE_SLICE;
+
+        size -= slice;
 
-        /* Write character to typescript, if any */
+        guac_terminal_lock(term);
+
+        /* Write all received data to typescript, if any */
         if (term->typescript != NULL)
-            guac_terminal_typescript_write(term->typescript, current);
+            guac_terminal_typescript_write_buffer(term->typescript, c, slice);
+
+        while (slice > 0) {
+
+            /* Echo runs of printable ASCII in bulk where possible */
+            if (term->char_handler == guac_terminal_echo) {
+
+                int length = guac_terminal_echo_text(term, c, slice);
+                if (length > 0) {
+                    c += length;
+                    slice -= length;
+                    continue;
+                }
+
+            }
+
+            /* Read and advance to next character */
+            char current = *(c++);
+            slice--;
+
+            /* Handle character and its meaning */
+            term->char_handler(term, current);
+
+        }
 
-        /* Handle character and its meaning */
-        term->char_handler(term, current);
+        guac_terminal_unlock(term);
 
     }
-    guac_terminal_unlock(term);
 
     guac_terminal_notify(term);
     return 0;
 
 }
 
+/**
+ * Packs all rows within the given range of the scrollback buffer of the given
+ * terminal, reducing the memory required to store those rows until they are
+ * next accessed. Rows whose storage within the buffer is shared with the
+ * visible area of the terminal are never packed.
+ *
+ * @param term
+ *     The terminal whose scrollback rows should be packed.
+ *
+ * @param start_row
+ *     The first row to pack, relative to the top of the terminal display.
+ *
+ * @param end_row
+ *     The last row to pack, relative to the top of the terminal display.
+ */
+static void guac_terminal_pack_scrollback(guac_terminal* term,
+        int start_row, int end_row) {
+
+    int row;
+
+    /* Restrict range to rows which are strictly within scrollback */
+    int min_row = term->term_height - term->buffer->available;
+    if (start_row < min_row)
+        start_row = min_row;
+
+    if (end_row > -1)
+        end_row = -1;
+
+    for (row = start_row; row <= end_row; row++)
+        guac_terminal_buffer_pack_row(term->buffer, row);
+
+}
+
 int guac_terminal_scroll_up(guac_terminal* term,
         int start_row, int end_row, int amount) {
 
@@ -861,6 +1117,16 @@ int guac_terminal_scroll_up(guac_terminal* term,
         if (term->buffer->length > term->buffer->available)
             term->buffer->length = term->buffer->available;
 
+        /* Stop updating the display once an entire screen has scrolled past
+         * within this frame, as it will need to be redrawn anyway */
+        term->scrolled_rows += amount;
+        if (term->scrolled_rows >= term->term_height)
+            term->display->suspended = true;
+
+        /* Pack rows which are now a full screen above the visible display */
+        guac_terminal_pack_scrollback(term, -term->term_height - amount,
+                -term->term_height - 1);
+
         /* Reset scrollbar bounds */
         guac_terminal_scrollbar_set_bounds(term->scrollbar,
                 -guac_terminal_available_scroll(term), 0);
@@ -876,6 +1142,12 @@ int guac_terminal_scroll_up(guac_terminal* term,
             term->selection_end_row -= amount;
         }
 
+        /* Update region still being copied to the clipboard */
+        if (term->copy_row <= term->copy_end_row) {
+            term->copy_row -= amount;
+            term->copy_end_row -= amount;
+        }
+
     }
 
     /* Otherwise, just copy row data upwards */
@@ -1028,6 +1300,18 @@ void guac_terminal_scroll_display_down(guac_terminal* terminal,
     terminal->scroll_offset -= scroll_amount;
     guac_terminal_scrollbar_set_value(terminal->scrollbar, -terminal->scroll_offset);
 
+    /* Pack any rows scrolled out of view which had been unpacked for display */
+    start_row = -terminal->scroll_offset - scroll_amount;
+    end_row   = -terminal->scroll_offset - 1;
+    if (end_row > start_row + terminal->term_height - 1)
+        end_row = start_row + terminal->term_height - 1;
+
+    guac_terminal_pack_scrollback(terminal, start_row, end_row);
+
+    /* Only rows which are ultimately in view need be drawn */
+    if (scroll_amount > terminal->term_height)
+        scroll_amount = terminal->term_height;
+
     /* Get row range */
     end_row   = terminal->term_height - terminal->scroll_offset - 1;
     start_row = end_row - scroll_amount + 1;
@@ -1091,6 +1375,18 @@ void guac_terminal_scroll_display_up(guac_terminal* terminal,
     terminal->scroll_offset += scroll_amount;
     guac_terminal_scrollbar_set_value(terminal->scrollbar, -terminal->scroll_offset);
 
+    /* Pack any rows scrolled out of view which had been unpacked for display */
+    end_row   = terminal->term_height - terminal->scroll_offset + scroll_amount - 1;
+    start_row = end_row - scroll_amount + 1;
+    if (start_row < end_row - terminal->term_height + 1)
+        start_row = end_row - terminal->term_height + 1;
+
+    guac_terminal_pack_scrollback(terminal, start_row, end_row);
+
+    /* Only rows which are ultimately in view need be drawn */
+    if (scroll_amount > terminal->term_height)
+        scroll_amount = terminal->term_height;
+
     /* Get row range */
     start_row = -terminal->scroll_offset;
     end_row   = start_row + scroll_amount - 1;
@@ -1410,7 +1706,7 @@ int guac_terminal_resize(guac_terminal* terminal, int width, int height) {
 
 }
 
-void guac_terminal_flush(guac_terminal* terminal) {
+void guac_terminal_flush_snapshot(guac_terminal* terminal) {
 
     /* Flush typescript if in use */
     if (terminal->typescript != NULL)
@@ -1420,14 +1716,28 @@ void guac_terminal_flush(guac_terminal* terminal) {
     if (terminal->pipe_stream_flags & GUAC_TERMINAL_PIPE_AUTOFLUSH)
         guac_terminal_pipe_stream_flush(terminal);
 
+    /* Redraw entire screen from buffer if display updates were skipped */
+    if (terminal->display->suspended) {
+        terminal->display->suspended = false;
+        __guac_terminal_redraw_rect(terminal, 0, 0,
+                terminal->term_height - 1, terminal->term_width - 1);
+    }
+
+    terminal->scrolled_rows = 0;
+
     /* Flush display state */
     guac_terminal_select_redraw(terminal);
     guac_terminal_commit_cursor(terminal);
-    guac_terminal_display_flush(terminal->display);
+    guac_terminal_display_snapshot(terminal->display);
     guac_terminal_scrollbar_flush(terminal->scrollbar);
 
 }
 
+void guac_terminal_flush(guac_terminal* terminal) {
+    guac_terminal_flush_snapshot(terminal);
+    guac_terminal_display_render(terminal->display);
+}
+
 void guac_terminal_lock(guac_terminal* terminal) {
     pthread_mutex_lock(&(terminal->lock));
 }
@@ -1631,6 +1941,13 @@ int guac_terminal_send_key(guac_terminal* term, int keysym, int pressed) {
     result = __guac_terminal_send_key(term, keysym, pressed);
     guac_terminal_unlock(term);
 
+    /* Flush the echo of this key as soon as it is received */
+    if (pressed) {
+        pthread_mutex_lock(&(term->modified_lock));
+        term->last_keypress = guac_timestamp_current();
+        pthread_mutex_unlock(&(term->modified_lock));
+    }
+
     return result;
 
 }
@@ -2031,3 +2348,14 @@ void guac_terminal_apply_font(guac_terminal* terminal, const char* font_name,
 
 }
 
+void guac_terminal_set_copy_limit(guac_terminal* terminal, int limit) {
+
+    if (limit > GUAC_COMMON_CLIPBOARD_MAX_LENGTH)
+        limit = GUAC_COMMON_CLIPBOARD_MAX_LENGTH;
+
+    guac_terminal_lock(terminal);
+    terminal->copy_limit = limit;
+    guac_terminal_unlock(terminal);
+
+}
+
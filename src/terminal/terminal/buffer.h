@@ -25,6 +25,80 @@
 
 #include "types.h"
 
+#include <stdint.h>
+
+/**
+ * The maximum number of distinct sets of character attributes which may be
+ * interned by a single buffer. Rows using attributes beyond this limit remain
+ * unpacked.
+ */
+#define GUAC_TERMINAL_BUFFER_MAX_ATTRIBUTES 65536
+
+/**
+ * A run of consecutive characters within a packed row which all share the
+ * same attributes.
+ */
+typedef struct guac_terminal_buffer_run {
+
+    /**
+     * The index of the attributes shared by all characters in this run,
+     * within the table of attributes interned by the buffer.
+     */
+    uint16_t attributes;
+
+    /**
+     * The number of characters in this run.
+     */
+    uint16_t length;
+
+} guac_terminal_buffer_run;
+
+/**
+ * The compact representation of a row which is not currently being accessed.
+ * Rather than storing a full guac_terminal_char for each cell, only the
+ * codepoint and width of each cell are stored, with attributes stored once
+ * per run of identically-attributed cells. Trailing cells which are identical
+ * to the default character of the buffer are not stored at all. The runs,
+ * codepoints and widths are stored in the same allocation as this structure.
+ */
+typedef struct guac_terminal_buffer_packed_row {
+
+    /**
+     * The number of cells which are explicitly stored. Any cells beyond this
+     * point, up to the length of the row, are the default character.
+     */
+    int stored;
+
+    /**
+     * The number of runs within the runs array.
+     */
+    int run_count;
+
+    /**
+     * All runs of identically-attributed cells, in order. The sum of the
+     * lengths of all runs is equal to the number of stored cells.
+     */
+    guac_terminal_buffer_run* runs;
+
+    /**
+     * The codepoint of each stored cell.
+     */
+    int32_t* values;
+
+    /**
+     * The width of each stored cell.
+     */
+    int8_t* widths;
+
+    /**
+     * The signature of the text of this row, as would be produced by
+     * guac_terminal_buffer_signature(), allowing rows which cannot contain a
+     * particular string to be skipped by searches without being read.
+     */
+    uint64_t signature;
+
+} guac_terminal_buffer_packed_row;
+
 /**
  * A single variable-length row of terminal data.
  */
@@ -48,6 +122,13 @@ typedef struct guac_terminal_buffer_row {
      */
     int available;
 
+    /**
+     * The packed contents of this row, or NULL if the row is not packed. While
+     * a row is packed, the characters array is NULL and available is zero.
+     * Packed rows are automatically unpacked by guac_terminal_buffer_get_row().
+     */
+    guac_terminal_buffer_packed_row* packed;
+
 } guac_terminal_buffer_row;
 
 /**
@@ -88,11 +169,42 @@ typedef struct guac_terminal_buffer {
      */
     int available;
 
+    /**
+     * All distinct sets of attributes used by packed rows. Packed rows refer
+     * to attributes by their index within this array.
+     */
+    guac_terminal_attributes* attributes;
+
+    /**
+     * The number of attributes within the attributes array.
+     */
+    int attribute_count;
+
+    /**
+     * The number of attributes which may be stored within the attributes
+     * array before it must be reallocated.
+     */
+    int attribute_capacity;
+
+    /**
+     * Hash table mapping attributes to their index within the attributes
+     * array, using open addressing. Each entry is either an index within the
+     * attributes array or -1 if unused.
+     */
+    int* attribute_table;
+
+    /**
+     * The number of entries in the attribute_table array. This is always a
+     * power of two.
+     */
+    int attribute_table_size;
+
 } guac_terminal_buffer;
 
 /**
  * Allocates a new buffer having the given maximum number of rows. New character cells will
- * be initialized to the given character.
+ * be initialized to the given character. Storage for each row is allocated only once that
+ * row is first used.
  */
 guac_terminal_buffer* guac_terminal_buffer_alloc(int rows, guac_terminal_char* default_character);
 
@@ -103,7 +215,9 @@ void guac_terminal_buffer_free(guac_terminal_buffer* buffer);
 
 /**
  * Returns the row at the given location. The row returned is guaranteed to be at least the given
- * width.
+ * width, and to have allocated characters even if the given width is zero. If the row is packed,
+ * it is unpacked first. The returned row remains valid until the row is packed with
+ * guac_terminal_buffer_pack_row().
  */
 guac_terminal_buffer_row* guac_terminal_buffer_get_row(guac_terminal_buffer* buffer, int row, int width);
 
@@ -128,5 +242,59 @@ void guac_terminal_buffer_copy_rows(guac_terminal_buffer* buffer,
 void guac_terminal_buffer_set_columns(guac_terminal_buffer* buffer, int row,
         int start_column, int end_column, guac_terminal_char* character);
 
+/**
+ * Sets the given range of columns within the given row to the given string of
+ * single-column characters, all having the given attributes. Each byte of the
+ * string is stored as the codepoint of one column, thus the string must
+ * contain only printable ASCII.
+ */
+void guac_terminal_buffer_set_text(guac_terminal_buffer* buffer, int row,
+        int start_column, const char* text, int length,
+        guac_terminal_attributes* attributes);
+
+/**
+ * Converts the row at the given location to its packed representation,
+ * freeing its array of guac_terminal_char. This should be invoked for rows
+ * which are unlikely to be accessed again soon, such as rows which have
+ * scrolled well out of view. Packing a row which is already packed or which
+ * has never been used has no effect. The row will be transparently unpacked
+ * if later retrieved with guac_terminal_buffer_get_row().
+ */
+void guac_terminal_buffer_pack_row(guac_terminal_buffer* buffer, int row);
+
+/**
+ * Returns non-zero if the given sets of attributes are identical, including
+ * the palette indices of their colors, and zero otherwise.
+ */
+int guac_terminal_buffer_attributes_equal(const guac_terminal_attributes* a,
+        const guac_terminal_attributes* b);
+
+/**
+ * Returns non-zero if the given characters are identical, including their
+ * widths and attributes, and zero otherwise.
+ */
+int guac_terminal_buffer_char_equals(const guac_terminal_char* a,
+        const guac_terminal_char* b);
+
+/**
+ * Returns the signature of the given text: a 64-bit Bloom filter of each pair
+ * of adjacent codepoints, ignoring the case of ASCII letters. Text containing
+ * another string will always have a signature containing all bits of the
+ * signature of that string.
+ */
+uint64_t guac_terminal_buffer_signature(const int32_t* text, int length);
+
+/**
+ * Reads the codepoints of the given row into the given array, skipping
+ * continuation cells, without unpacking the row if packed. The column of each
+ * codepoint is stored in the corresponding element of the columns array. If
+ * the row is packed and its signature does not contain all bits of the given
+ * signature, the row cannot contain the text being searched for, and nothing
+ * is read. Returns the number of codepoints read, which will not exceed the
+ * given maximum.
+ */
+int guac_terminal_buffer_get_text(guac_terminal_buffer* buffer, int row,
+        uint64_t signature, int32_t* text, int* columns, int max_length);
+
 #endif
 
@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include "common/surface.h"
+#include "glyph-cache.h"
 #include "palette.h"
 #include "types.h"
 
@@ -31,6 +32,7 @@
 #include <guacamole/layer.h>
 #include <pango/pangocairo.h>
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -108,6 +110,53 @@ typedef struct guac_terminal_display {
      */
     guac_terminal_operation* operations;
 
+    /**
+     * Array of all operations taken from the operations array by the most
+     * recent call to guac_terminal_display_snapshot(), and which are
+     * rendered by guac_terminal_display_render().
+     */
+    guac_terminal_operation* flush_operations;
+
+    /**
+     * Whether the operations within flush_operations have not yet been
+     * rendered.
+     */
+    bool flush_pending;
+
+    /**
+     * Lock which guards all state used while rendering, including the
+     * flush_operations and shadow arrays, the palette, the font, and the
+     * dimensions of the display. This lock is acquired independently of the
+     * lock of the terminal, such that a snapshot of the display may be
+     * rendered while the terminal continues to handle output and input.
+     */
+    pthread_mutex_t render_lock;
+
+    /**
+     * The characters most recently drawn to each cell of the visible screen
+     * area, as of the last flush. Operations which would set a cell to the
+     * character it already contains are skipped when flushed. Cells whose
+     * contents are not known, such as cells partially covered by a character
+     * spanning multiple columns, have a width of zero and thus never match
+     * any character being set.
+     */
+    guac_terminal_char* shadow;
+
+    /**
+     * Scratch space of the same size as the shadow array, used to build the
+     * updated shadow array while a flush is in progress.
+     */
+    guac_terminal_char* next_shadow;
+
+    /**
+     * Whether changes to the contents of the display are currently being
+     * ignored. While suspended, all calls which would set or copy characters
+     * have no effect, and the entire visible screen must be redrawn from the
+     * terminal buffer once the display is resumed. This allows intermediate
+     * states of a rapidly-scrolling terminal to be skipped entirely.
+     */
+    bool suspended;
+
     /**
      * The width of the screen, in characters.
      */
@@ -133,6 +182,18 @@ typedef struct guac_terminal_display {
      */
     int char_height;
 
+    /**
+     * Key identifying the current font and character dimensions within the
+     * glyph cache.
+     */
+    guac_terminal_glyph_cache_key font_key;
+
+    /**
+     * The glyph cache shared by all terminals, or NULL if no glyph cache is
+     * available and all glyphs must be rendered directly.
+     */
+    guac_terminal_glyph_cache* glyph_cache;
+
     /**
      * The current palette.
      */
@@ -292,13 +353,54 @@ void guac_terminal_display_copy_rows(guac_terminal_display* display,
 void guac_terminal_display_set_columns(guac_terminal_display* display, int row,
         int start_column, int end_column, guac_terminal_char* character);
 
+/**
+ * Sets the given range of columns within the given row to the given string of
+ * single-column characters, all having the given attributes. Each byte of the
+ * string is drawn as the codepoint of one column, thus the string must
+ * contain only printable ASCII.
+ */
+void guac_terminal_display_set_text(guac_terminal_display* display, int row,
+        int start_column, const char* text, int length,
+        guac_terminal_attributes* attributes);
+
+/**
+ * Marks the contents of every cell of the visible screen area as unknown,
+ * such that the next flush will redraw each cell which is set, even if the
+ * character being set appears to be unchanged. This must be invoked whenever
+ * the rendering of characters changes without the characters themselves
+ * changing, such as when the palette or font is modified.
+ *
+ * @param display
+ *     The display whose cell contents should be considered unknown.
+ */
+void guac_terminal_display_invalidate(guac_terminal_display* display);
+
 /**
  * Resize the terminal to the given dimensions.
  */
 void guac_terminal_display_resize(guac_terminal_display* display, int width, int height);
 
 /**
- * Flushes all pending operations within the given guac_terminal_display.
+ * Takes all pending operations within the given guac_terminal_display for
+ * rendering by a later call to guac_terminal_display_render(), leaving no
+ * operations pending. If a previous snapshot has not yet been rendered, it is
+ * rendered first. As with all other functions which modify the pending
+ * operations, the terminal must be locked.
+ */
+void guac_terminal_display_snapshot(guac_terminal_display* display);
+
+/**
+ * Renders the operations taken by the most recent call to
+ * guac_terminal_display_snapshot(), if not already rendered, flushing the
+ * result to the display surface. The terminal need not be locked, thus
+ * output may continue to be handled while a snapshot is being rendered.
+ */
+void guac_terminal_display_render(guac_terminal_display* display);
+
+/**
+ * Flushes all pending operations within the given guac_terminal_display,
+ * equivalent to guac_terminal_display_snapshot() followed immediately by
+ * guac_terminal_display_render().
  */
 void guac_terminal_display_flush(guac_terminal_display* display);
 
@@ -0,0 +1,389 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_TERMINAL_GLYPH_CACHE_H
+#define GUAC_TERMINAL_GLYPH_CACHE_H
+
+#include "config.h"
+
+#include <cairo/cairo.h>
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * The name of the POSIX shared memory object containing the glyph cache
+ * shared by all terminals of the current user, as a printf-style format
+ * string which accepts the effective UID. The name includes the version of
+ * the cache layout such that incompatible versions of guacd never share the
+ * same cache.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_NAME "/guac-terminal-glyphs-2-%u"
+
+/**
+ * The maximum length of the name of the shared memory object containing the
+ * glyph cache, in bytes, including NULL terminator.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_MAX_NAME_LENGTH 64
+
+/**
+ * Arbitrary value stored at the beginning of an initialized glyph cache.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_MAGIC 0x67756163
+
+/**
+ * The number of entries within the hash table of the glyph cache. This value
+ * MUST be a power of two.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_ENTRIES 65536
+
+/**
+ * The maximum number of distinct fonts which may be stored within the glyph
+ * cache at any one time.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_FONTS 64
+
+/**
+ * The maximum length of the string form of any font description stored
+ * within the glyph cache, in bytes, including NULL terminator. Glyphs of
+ * fonts with longer descriptions are never cached.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_MAX_FONT_LENGTH 256
+
+/**
+ * The total size of the glyph cache, in bytes, including its header, hash
+ * table, and glyph data. As the cache is backed by shared memory which is
+ * only populated as written, space which has not yet been used by any glyph
+ * does not consume memory. Once full, the cache is emptied and refilled, and
+ * thus never occupies more than this amount of memory.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_SIZE 33554432
+
+/**
+ * The number of milliseconds to wait for another process to finish
+ * initializing a newly-created glyph cache before falling back to a cache
+ * private to the current process.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_INIT_TIMEOUT 1000
+
+/**
+ * A font whose glyphs are stored within the glyph cache.
+ */
+typedef struct guac_terminal_glyph_cache_font {
+
+    /**
+     * The string form of the font description, as produced by
+     * pango_font_description_to_string(), or an empty string if this font
+     * entry is unused.
+     */
+    char description[GUAC_TERMINAL_GLYPH_CACHE_MAX_FONT_LENGTH];
+
+    /**
+     * The width of each character cell, in pixels.
+     */
+    int char_width;
+
+    /**
+     * The height of each character cell, in pixels.
+     */
+    int char_height;
+
+} guac_terminal_glyph_cache_font;
+
+/**
+ * A single rasterized glyph within the glyph cache. Once published, entries
+ * are not modified until the entire cache is emptied.
+ */
+typedef struct guac_terminal_glyph_cache_entry {
+
+    /**
+     * Non-zero if this entry has been completely written and may be used,
+     * zero if this entry is unused. This value is written only after all
+     * other members of the entry and the glyph data itself, such that an
+     * entry left incomplete by a process which died while writing it is
+     * never used.
+     */
+    uint32_t valid;
+
+    /**
+     * The index of the font used to render the glyph within the font table
+     * of the cache.
+     */
+    uint32_t font;
+
+    /**
+     * The codepoint of the glyph.
+     */
+    int32_t codepoint;
+
+    /**
+     * The width of the glyph, in pixels.
+     */
+    uint16_t width;
+
+    /**
+     * The height of the glyph, in pixels.
+     */
+    uint16_t height;
+
+    /**
+     * The offset of the glyph's 8-bit alpha mask from the beginning of the
+     * glyph data area of the cache, in bytes.
+     */
+    uint32_t offset;
+
+} guac_terminal_glyph_cache_entry;
+
+/**
+ * Header of the glyph cache, stored at the beginning of the shared memory
+ * containing the cache and followed immediately by the glyph data area.
+ */
+typedef struct guac_terminal_glyph_cache_header {
+
+    /**
+     * Always GUAC_TERMINAL_GLYPH_CACHE_MAGIC once the cache has been fully
+     * initialized.
+     */
+    uint32_t magic;
+
+    /**
+     * Process-shared, robust lock which guards access to all fonts, entries,
+     * and glyph data, as well as all counters below.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * The number of processes which currently have the cache mapped. The
+     * last such process to release the cache removes the underlying shared
+     * memory object.
+     */
+    uint32_t attached;
+
+    /**
+     * The number of times the cache has been emptied. Font indexes remembered
+     * by a guac_terminal_glyph_cache_key are valid only while this value is
+     * unchanged.
+     */
+    uint32_t generation;
+
+    /**
+     * The number of fonts within the font table which are in use.
+     */
+    uint32_t font_count;
+
+    /**
+     * The number of entries within the hash table which are in use.
+     */
+    uint32_t entry_count;
+
+    /**
+     * The number of bytes of the glyph data area which are in use.
+     */
+    uint32_t data_used;
+
+    /**
+     * All fonts whose glyphs are stored within the cache.
+     */
+    guac_terminal_glyph_cache_font fonts[GUAC_TERMINAL_GLYPH_CACHE_FONTS];
+
+    /**
+     * Hash table of all cached glyphs, using open addressing with linear
+     * probing.
+     */
+    guac_terminal_glyph_cache_entry entries[GUAC_TERMINAL_GLYPH_CACHE_ENTRIES];
+
+} guac_terminal_glyph_cache_header;
+
+/**
+ * Cache of rasterized glyphs, stored as 8-bit alpha masks, which is shared
+ * between all terminals of all connections handled by the same user. As each
+ * connection is handled by a separate process, the cache is stored within
+ * POSIX shared memory such that a new terminal can immediately reuse any
+ * glyph already rendered by any other terminal using the same font.
+ *
+ * The shared memory object persists only while mapped by at least one
+ * process; the last process to release the cache removes it. If a process
+ * terminates without releasing the cache, the object instead remains until
+ * removed manually or until the system is restarted, and is reused by later
+ * terminals in the meantime. In either case, the cache never exceeds
+ * GUAC_TERMINAL_GLYPH_CACHE_SIZE bytes, as it is emptied whenever full.
+ */
+typedef struct guac_terminal_glyph_cache {
+
+    /**
+     * The mapped header of the cache.
+     */
+    guac_terminal_glyph_cache_header* header;
+
+    /**
+     * The mapped glyph data area of the cache.
+     */
+    unsigned char* data;
+
+    /**
+     * The size of the glyph data area, in bytes.
+     */
+    uint32_t data_size;
+
+    /**
+     * Non-zero if the cache is backed by shared memory, zero if the cache is
+     * private to the current process.
+     */
+    int shared;
+
+} guac_terminal_glyph_cache;
+
+/**
+ * Identifies a font, and the dimensions of the character cells its glyphs
+ * are rendered within, when looking up or adding glyphs within the glyph
+ * cache. The position of the font within the font table of the cache is
+ * remembered between calls, and is looked up again only if the cache has
+ * since been emptied.
+ */
+typedef struct guac_terminal_glyph_cache_key {
+
+    /**
+     * The string form of the font description, as produced by
+     * pango_font_description_to_string(), or an empty string if glyphs of
+     * the font cannot be cached.
+     */
+    char description[GUAC_TERMINAL_GLYPH_CACHE_MAX_FONT_LENGTH];
+
+    /**
+     * The width of each character cell, in pixels.
+     */
+    int char_width;
+
+    /**
+     * The height of each character cell, in pixels.
+     */
+    int char_height;
+
+    /**
+     * The index of the font within the font table of the cache, or -1 if
+     * not yet known.
+     */
+    int index;
+
+    /**
+     * The generation of the cache for which index was determined.
+     */
+    uint32_t generation;
+
+} guac_terminal_glyph_cache_key;
+
+/**
+ * Returns the glyph cache shared by all terminals of the current process,
+ * opening (and, if necessary, creating) the underlying shared memory upon
+ * first use. If shared memory is unavailable, a cache private to the current
+ * process is used instead. Each successful call must be paired with a call
+ * to guac_terminal_glyph_cache_release().
+ *
+ * @return
+ *     The glyph cache of the current process, or NULL if no cache could be
+ *     allocated at all.
+ */
+guac_terminal_glyph_cache* guac_terminal_glyph_cache_get();
+
+/**
+ * Releases a reference to the given glyph cache, as returned by
+ * guac_terminal_glyph_cache_get(). Once all references within the current
+ * process are released, the cache is unmapped and, if no other process has
+ * the cache mapped, its underlying shared memory object is removed.
+ *
+ * @param cache
+ *     The glyph cache to release.
+ */
+void guac_terminal_glyph_cache_release(guac_terminal_glyph_cache* cache);
+
+/**
+ * Initializes the given key such that it identifies the given font, as
+ * described by pango_font_description_to_string(), when used to render
+ * glyphs within character cells of the given dimensions. If the description
+ * is too long to be stored within the cache, the key is initialized such
+ * that glyphs of the font are never cached.
+ *
+ * @param key
+ *     The key to initialize.
+ *
+ * @param font
+ *     The string form of the font description.
+ *
+ * @param char_width
+ *     The width of each character cell, in pixels.
+ *
+ * @param char_height
+ *     The height of each character cell, in pixels.
+ */
+void guac_terminal_glyph_cache_key_init(guac_terminal_glyph_cache_key* key,
+        const char* font, int char_width, int char_height);
+
+/**
+ * Returns a new cairo surface containing a copy of the 8-bit alpha mask of
+ * the given glyph, if present within the given cache. The returned surface
+ * must be destroyed with cairo_surface_destroy() once no longer needed.
+ *
+ * @param cache
+ *     The glyph cache to search.
+ *
+ * @param key
+ *     The key identifying the font of the glyph, as initialized by
+ *     guac_terminal_glyph_cache_key_init().
+ *
+ * @param codepoint
+ *     The codepoint of the glyph.
+ *
+ * @param width
+ *     The width of the glyph, in pixels.
+ *
+ * @param height
+ *     The height of the glyph, in pixels.
+ *
+ * @return
+ *     A new CAIRO_FORMAT_A8 surface containing the glyph, or NULL if the
+ *     glyph is not present within the cache.
+ */
+cairo_surface_t* guac_terminal_glyph_cache_lookup(
+        guac_terminal_glyph_cache* cache, guac_terminal_glyph_cache_key* key,
+        int codepoint, int width, int height);
+
+/**
+ * Adds a copy of the given glyph to the given cache. If the glyph is already
+ * present, this function has no effect. If the cache is full, the cache is
+ * first emptied.
+ *
+ * @param cache
+ *     The glyph cache to add the glyph to.
+ *
+ * @param key
+ *     The key identifying the font of the glyph, as initialized by
+ *     guac_terminal_glyph_cache_key_init().
+ *
+ * @param codepoint
+ *     The codepoint of the glyph.
+ *
+ * @param glyph
+ *     A CAIRO_FORMAT_A8 surface containing the alpha mask of the glyph.
+ */
+void guac_terminal_glyph_cache_add(guac_terminal_glyph_cache* cache,
+        guac_terminal_glyph_cache_key* key, int codepoint,
+        cairo_surface_t* glyph);
+
+#endif
+
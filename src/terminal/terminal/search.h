@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_TERMINAL_SEARCH_H
+#define GUAC_TERMINAL_SEARCH_H
+
+#include "config.h"
+#include "terminal.h"
+
+#include <guacamole/stream.h>
+#include <guacamole/user.h>
+
+/**
+ * The maximum length of a search string, in codepoints. Longer search strings
+ * are truncated.
+ */
+#define GUAC_TERMINAL_MAX_SEARCH_LENGTH 256
+
+/**
+ * The maximum number of bytes of a search string received through an inbound
+ * stream. As each codepoint occupies at most four bytes of UTF-8, this is
+ * sufficient for any search string of GUAC_TERMINAL_MAX_SEARCH_LENGTH
+ * codepoints.
+ */
+#define GUAC_TERMINAL_MAX_SEARCH_BYTES (GUAC_TERMINAL_MAX_SEARCH_LENGTH * 4)
+
+/**
+ * The state of an inbound stream whose contents are a search string which
+ * should be searched for once the stream is closed.
+ */
+typedef struct guac_terminal_search_stream_state {
+
+    /**
+     * The terminal to search.
+     */
+    guac_terminal* terminal;
+
+    /**
+     * The search string received thus far, in UTF-8.
+     */
+    char query[GUAC_TERMINAL_MAX_SEARCH_BYTES];
+
+    /**
+     * The number of bytes within the query buffer.
+     */
+    int length;
+
+} guac_terminal_search_stream_state;
+
+/**
+ * Searches the terminal and its scrollback for the given text, ignoring the
+ * case of ASCII letters. The search proceeds upward (toward older output),
+ * starting just before the current selection if text is selected, or from
+ * the bottom of the visible display otherwise, such that repeated searches
+ * for the same text visit each match in turn. If a match is found, it is
+ * selected and the display is scrolled directly to the matching row, with
+ * only the rows finally in view being redrawn. Rows which have been packed
+ * are searched without being unpacked, and are skipped entirely if their
+ * signatures show they cannot contain the text. This function should only be
+ * invoked while the guac_terminal is locked through a call to
+ * guac_terminal_lock().
+ *
+ * @param terminal
+ *     The guac_terminal to search.
+ *
+ * @param query
+ *     The text to search for, as a UTF-8 string of the given length.
+ *
+ * @param length
+ *     The length of the query, in bytes.
+ *
+ * @return
+ *     Zero if a match was found, non-zero if the text does not occur within
+ *     the remainder of the terminal.
+ */
+int guac_terminal_search(guac_terminal* terminal, const char* query,
+        int length);
+
+/**
+ * Initializes the handlers of the given guac_stream such that its contents
+ * are received as a search string. Once the stream is closed through
+ * receiving an "end" instruction, the terminal is searched for that string
+ * as if by guac_terminal_search(), jumping to the next match. Each stream
+ * thus searches once, and the same text may be sent repeatedly to step
+ * through successive matches.
+ *
+ * Calling this function will overwrite the data member of the given
+ * guac_stream.
+ *
+ * @param terminal
+ *     The terminal to search.
+ *
+ * @param user
+ *     The user that opened the stream.
+ *
+ * @param stream
+ *     The guac_stream which will contain the search string.
+ *
+ * @return
+ *     Zero if the stream has successfully been configured, non-zero
+ *     otherwise.
+ */
+int guac_terminal_search_stream(guac_terminal* terminal, guac_user* user,
+        guac_stream* stream);
+
+#endif
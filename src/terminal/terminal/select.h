@@ -26,6 +26,13 @@
 
 #include <stdbool.h>
 
+/**
+ * The maximum number of chunks of GUAC_COMMON_CLIPBOARD_BLOCK_SIZE bytes of
+ * selected text which will be streamed to connected users per frame. Larger
+ * selections are streamed over multiple frames.
+ */
+#define GUAC_TERMINAL_COPY_FRAME_CHUNKS 64
+
 /**
  * Forwards the visible portion of the text selection rectangle to the
  * underlying terminal display, requesting that it be redrawn. If no
@@ -101,18 +108,37 @@ void guac_terminal_select_update(guac_terminal* terminal, int row, int column);
 void guac_terminal_select_resume(guac_terminal* terminal, int row, int column);
 
 /**
- * Ends text selection, removing any highlight and storing the selected
- * character data within the clipboard associated with the given terminal. If
- * more text is selected than can fit within the clipboard, text at the end of
- * the selected area will be dropped as necessary. This function should only be
- * invoked while the guac_terminal is locked through a call to
- * guac_terminal_lock().
+ * Ends text selection, removing any highlight and beginning to copy the
+ * selected character data to the clipboard associated with the given
+ * terminal. The text is not copied immediately, but is instead read from the
+ * terminal and streamed to connected users in chunks by the render thread
+ * through guac_terminal_select_copy(), such that large selections do not
+ * hold the terminal lock. If more text is selected than can fit within the
+ * clipboard, text at the end of the selected area will be dropped as
+ * necessary. This function should only be invoked while the guac_terminal
+ * is locked through a call to guac_terminal_lock().
  *
  * @param terminal
  *     The guac_terminal instance associated with the text being selected.
  */
 void guac_terminal_select_end(guac_terminal* terminal);
 
+/**
+ * Copies the next chunk of the most recently committed selection to the
+ * clipboard, broadcasting that chunk to all connected users unless copying
+ * is disabled. The terminal lock is acquired only while the chunk is read
+ * from the terminal. This function should only be invoked by the render
+ * thread of the terminal, and must NOT be invoked while the guac_terminal is
+ * locked.
+ *
+ * @param terminal
+ *     The guac_terminal whose selection is being copied.
+ *
+ * @return
+ *     true if more of the selection remains to be copied, false otherwise.
+ */
+bool guac_terminal_select_copy(guac_terminal* terminal);
+
 /**
  * Returns whether at least one character within the given range is currently
  * selected.
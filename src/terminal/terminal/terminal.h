@@ -36,6 +36,7 @@
 
 #include <guacamole/client.h>
 #include <guacamole/stream.h>
+#include <guacamole/timestamp.h>
 
 /**
  * The absolute maximum number of rows to allow within the display.
@@ -49,7 +50,8 @@
 #define GUAC_TERMINAL_MAX_COLUMNS 1024
 
 /**
- * The maximum duration of a single frame, in milliseconds.
+ * The maximum duration of a single frame, in milliseconds, while output is
+ * not sustained and connected clients are not lagging.
  */
 #define GUAC_TERMINAL_FRAME_DURATION 40
 
@@ -59,6 +61,42 @@
  */
 #define GUAC_TERMINAL_FRAME_TIMEOUT 10
 
+/**
+ * The maximum duration of a single frame, in milliseconds, while output is
+ * sustained across consecutive frames or connected clients are lagging. Each
+ * frame which is cut short by its duration while output continues increases
+ * the duration of the next frame by GUAC_TERMINAL_FRAME_DURATION, up to this
+ * limit.
+ */
+#define GUAC_TERMINAL_MAX_FRAME_DURATION 160
+
+/**
+ * The maximum duration of a single frame, in milliseconds, while the terminal
+ * is flooded with output and the client is lagging. Output received during
+ * this time is folded into a single redraw of the final screen.
+ */
+#define GUAC_TERMINAL_FLOOD_MAX_FRAME_DURATION 500
+
+/**
+ * The amount of time after a key is pressed, in milliseconds, during which
+ * the next output received is assumed to be the echo of that key. Such output
+ * is flushed immediately rather than waiting for the frame to complete.
+ */
+#define GUAC_TERMINAL_ECHO_TIMEOUT 1000
+
+/**
+ * The interval between logged summaries of the frames rendered by a
+ * terminal, in milliseconds.
+ */
+#define GUAC_TERMINAL_STATS_INTERVAL 60000
+
+/**
+ * The maximum number of bytes of output which guac_terminal_write() will
+ * handle while holding the terminal lock. Larger writes are handled in
+ * slices of this size, releasing the lock between slices.
+ */
+#define GUAC_TERMINAL_MAX_WRITE_SLICE 4096
+
 /**
  * The maximum number of custom tab stops.
  */
@@ -184,11 +222,63 @@ struct guac_terminal {
      */
     int modified;
 
+    /**
+     * The number of rows the entire display has been scrolled by terminal
+     * output since the last flush. Once a full screen of rows has been
+     * scrolled within a single frame, updates to the display are suspended
+     * until the next flush, at which point the screen is redrawn once from
+     * the terminal buffer.
+     */
+    int scrolled_rows;
+
     /**
      * Condition which is signalled when the modified flag has been set
      */
     pthread_cond_t modified_cond;
 
+    /**
+     * The time at which a key was last pressed, or zero if output has been
+     * flushed since. The modified_lock will always be acquired before this
+     * value is altered.
+     */
+    guac_timestamp last_keypress;
+
+    /**
+     * The duration of the next frame, in milliseconds, adjusted with each
+     * frame depending on whether output is sustained. This value is only
+     * accessed by the render thread.
+     */
+    int frame_duration;
+
+    /**
+     * The time at which the most recent frame began, excluding the time taken
+     * to render that frame. This value is only accessed by the render thread.
+     */
+    guac_timestamp last_frame_start;
+
+    /**
+     * The time at which the current frame statistics began to be gathered.
+     * This value is only accessed by the render thread.
+     */
+    guac_timestamp stats_start;
+
+    /**
+     * The number of frames rendered since stats_start.
+     */
+    int stats_frames;
+
+    /**
+     * The total time spent rendering frames since stats_start, in
+     * milliseconds.
+     */
+    int stats_render_time;
+
+    /**
+     * The longest time spent rendering any single frame since stats_start, in
+     * milliseconds.
+     */
+    int stats_max_render_time;
+
     /**
      * Pipe which will be the source of user input. When a terminal code
      * generates synthesized user input, that data will be written to
@@ -464,6 +554,61 @@ struct guac_terminal {
      */
     int selection_end_width;
 
+    /**
+     * Whether a new selection has been committed since the text of the
+     * previous selection was last streamed to connected users, such that a
+     * new clipboard stream must be started.
+     */
+    bool copy_restart;
+
+    /**
+     * The row of the next character of the committed selection which has not
+     * yet been copied to the clipboard. Like the selection itself, this row is
+     * adjusted as the terminal scrolls. Copying is complete once this row is
+     * beyond copy_end_row.
+     */
+    int copy_row;
+
+    /**
+     * The column of the next character of the committed selection which has
+     * not yet been copied to the clipboard, or -1 if the newline separating
+     * copy_row from the previous row has not yet been copied.
+     */
+    int copy_column;
+
+    /**
+     * The last row of the committed selection being copied to the clipboard.
+     */
+    int copy_end_row;
+
+    /**
+     * The last column of the committed selection being copied to the
+     * clipboard, taking into account the width of the final character.
+     */
+    int copy_end_column;
+
+    /**
+     * The maximum number of bytes of the text of any committed selection
+     * which will be copied to the clipboard and streamed to connected users.
+     * Text beyond this limit is neither copied nor streamed. This limit
+     * applies only to copied text, not to clipboard data received from
+     * users.
+     */
+    int copy_limit;
+
+    /**
+     * The number of bytes of the text of the committed selection which have
+     * been copied to the clipboard so far.
+     */
+    int copy_length;
+
+    /**
+     * The stream over which the text of the committed selection is being
+     * broadcast to all connected users, or NULL if no such stream is open.
+     * This stream is only accessed by the render thread.
+     */
+    guac_stream* copy_stream;
+
     /**
      * Whether the cursor (arrow) keys should send cursor sequences
      * or application sequences (DECCKM).
@@ -850,6 +995,31 @@ int guac_terminal_write(guac_terminal* term, const char* c, int size);
  */
 int guac_terminal_set(guac_terminal* term, int row, int col, int codepoint);
 
+/**
+ * Sets the characters beginning at the given row and column to the given
+ * string of printable ASCII, using the current attributes of the terminal.
+ * The result is identical to invoking guac_terminal_set() for each character
+ * in turn, but the row, display and selection are each updated only once for
+ * the entire string. The string must fit entirely within the given row.
+ *
+ * @param term
+ *     The terminal to write to.
+ *
+ * @param row
+ *     The row containing the first character to set.
+ *
+ * @param col
+ *     The column of the first character to set.
+ *
+ * @param text
+ *     The characters to write, each of which must be printable ASCII.
+ *
+ * @param length
+ *     The number of characters to write.
+ */
+void guac_terminal_set_text(guac_terminal* term, int row, int col,
+        const char* text, int length);
+
 /**
  * Clears the given region within a single row.
  */
@@ -926,10 +1096,20 @@ void guac_terminal_set_columns(guac_terminal* terminal, int row,
 int guac_terminal_resize(guac_terminal* term, int width, int height);
 
 /**
- * Flushes all pending operations within the given guac_terminal.
+ * Flushes all pending operations within the given guac_terminal, including
+ * rendering of the display. The terminal must be locked.
  */
 void guac_terminal_flush(guac_terminal* terminal);
 
+/**
+ * Flushes all pending operations within the given guac_terminal, with the
+ * exception of rendering the display. The pending operations of the display
+ * are instead taken as a snapshot, which must later be rendered with
+ * guac_terminal_display_render(). The terminal must be locked, but need not
+ * remain locked while the snapshot is rendered.
+ */
+void guac_terminal_flush_snapshot(guac_terminal* terminal);
+
 /**
  * Sends the given string as if typed by the user. If terminal input is
  * currently coming from a stream due to a prior call to
@@ -1161,5 +1341,20 @@ void guac_terminal_apply_color_scheme(guac_terminal* terminal,
 void guac_terminal_apply_font(guac_terminal* terminal, const char* font_name,
         int font_size, int dpi);
 
+/**
+ * Sets the maximum number of bytes of text which may be copied from the
+ * given terminal to the clipboard with each selection. By default, this is
+ * the number of bytes the clipboard given to guac_terminal_create() may hold.
+ * The limit is itself limited to GUAC_COMMON_CLIPBOARD_MAX_LENGTH, and does
+ * not affect the amount of clipboard data which may be received from users.
+ *
+ * @param terminal
+ *     The terminal whose copy limit should be set.
+ *
+ * @param limit
+ *     The maximum number of bytes of text to copy with each selection.
+ */
+void guac_terminal_set_copy_limit(guac_terminal* terminal, int limit);
+
 #endif
 
@@ -38,6 +38,31 @@
  */
 int guac_terminal_echo(guac_terminal* term, unsigned char c);
 
+/**
+ * Echoes the run of printable ASCII at the beginning of the given buffer to
+ * the terminal display, exactly as if each character had been received by
+ * guac_terminal_echo(), but updating the terminal one row at a time rather
+ * than one character at a time. This is only possible while characters are
+ * written untranslated, without insert mode, and without an open pipe
+ * stream. The buffer is scanned a word at a time for the end of the run.
+ *
+ * @param term
+ *     The terminal that received the given data.
+ *
+ * @param text
+ *     The data received by the given terminal.
+ *
+ * @param length
+ *     The number of bytes of data received.
+ *
+ * @return
+ *     The number of bytes handled, which may be zero if the buffer does not
+ *     begin with printable ASCII or if the terminal is in a state which
+ *     requires each character to be handled individually. Any bytes not
+ *     handled must be handled by guac_terminal_echo().
+ */
+int guac_terminal_echo_text(guac_terminal* term, const char* text, int length);
+
 /**
  * Handles any characters which follow an ANSI ESC (0x1B) character.
  *
@@ -25,6 +25,8 @@
 
 #include <guacamole/timestamp.h>
 
+#include <pthread.h>
+
 /**
  * A NULL-terminated string of raw bytes which should be written at the
  * beginning of any typescript.
@@ -71,22 +73,129 @@
 #define GUAC_TERMINAL_TYPESCRIPT_TIMING_SUFFIX "timing"
 
 /**
- * An active typescript, consisting of a data file (raw terminal output) and
- * timing file (related timestamps and byte counts).
+ * The number of bytes of raw terminal output which may be stored within each
+ * segment of a typescript before that segment must be written.
  */
-typedef struct guac_terminal_typescript {
+#define GUAC_TERMINAL_TYPESCRIPT_BUFFER_SIZE 65536
+
+/**
+ * The maximum number of timing entries which may be stored within each
+ * segment of a typescript before that segment must be written.
+ */
+#define GUAC_TERMINAL_TYPESCRIPT_MAX_TIMINGS 256
+
+/**
+ * The maximum length of a single line of the timing file, in bytes.
+ */
+#define GUAC_TERMINAL_TYPESCRIPT_MAX_TIMING_LENGTH 32
+
+/**
+ * A single entry within the timing file of a typescript, describing the
+ * amount of terminal output flushed at once.
+ */
+typedef struct guac_terminal_typescript_timing {
+
+    /**
+     * The number of milliseconds elapsed since the previous flush.
+     */
+    int elapsed;
+
+    /**
+     * The number of bytes of terminal output flushed.
+     */
+    int length;
+
+} guac_terminal_typescript_timing;
+
+/**
+ * A buffer of raw terminal output along with its associated timing entries.
+ * Each typescript has two segments: one which receives terminal output, and
+ * one which may be in the process of being written to disk by the writer
+ * thread of the typescript. Each segment accumulates the output of many
+ * flushes, and is handed to the writer thread only once its buffer or timing
+ * entries are full, or when the typescript is freed.
+ */
+typedef struct guac_terminal_typescript_segment {
 
     /**
      * Buffer of raw terminal output which has not yet been written to the
      * data file.
      */
-    char buffer[4096];
+    char buffer[GUAC_TERMINAL_TYPESCRIPT_BUFFER_SIZE];
 
     /**
      * The number of bytes currently stored in the buffer.
      */
     int length;
 
+    /**
+     * Timing entries covering the terminal output within the buffer, in
+     * order. Output which has not yet been flushed is not covered by any
+     * timing entry.
+     */
+    guac_terminal_typescript_timing timings[GUAC_TERMINAL_TYPESCRIPT_MAX_TIMINGS];
+
+    /**
+     * The number of entries within the timings array.
+     */
+    int timing_count;
+
+    /**
+     * The number of bytes of the buffer which are covered by timing entries.
+     */
+    int flushed_length;
+
+} guac_terminal_typescript_segment;
+
+/**
+ * An active typescript, consisting of a data file (raw terminal output) and
+ * timing file (related timestamps and byte counts). Terminal output is
+ * appended to an in-memory segment, with file I/O performed entirely by a
+ * separate writer thread, such that recording a typescript does not block
+ * the terminal unless the writer thread is still writing the previous
+ * segment when the active segment becomes full.
+ */
+typedef struct guac_terminal_typescript {
+
+    /**
+     * The two segments of this typescript, alternately receiving terminal
+     * output and being written.
+     */
+    guac_terminal_typescript_segment segments[2];
+
+    /**
+     * The segment currently receiving terminal output.
+     */
+    guac_terminal_typescript_segment* active;
+
+    /**
+     * The segment which has been handed to the writer thread and has not yet
+     * been completely written, or NULL if the writer thread is idle.
+     */
+    guac_terminal_typescript_segment* pending;
+
+    /**
+     * Non-zero if the writer thread should stop once any pending segment has
+     * been written.
+     */
+    int stopping;
+
+    /**
+     * The thread which writes pending segments to the data and timing files.
+     */
+    pthread_t writer;
+
+    /**
+     * Lock which guards access to the pending segment and the stopping flag.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever the pending segment or stopping
+     * flag change.
+     */
+    pthread_cond_t modified;
+
     /**
      * The full path to the file which will contain the raw terminal output for
      * this typescript.
@@ -162,8 +271,30 @@ void guac_terminal_typescript_write(guac_terminal_typescript* typescript,
         char c);
 
 /**
- * Flushes any pending data to the typescript, writing a new timestamp to the
- * timing file if any data was flushed.
+ * Writes multiple bytes of terminal data to the given typescript. The data
+ * will be written to the data file as-is, exactly as if each byte had been
+ * written with guac_terminal_typescript_write(). The timing file will be
+ * updated when the typescript is flushed.
+ *
+ * @param typescript
+ *     The typescript to write to.
+ *
+ * @param buffer
+ *     The terminal data to write.
+ *
+ * @param length
+ *     The number of bytes of terminal data to write.
+ */
+void guac_terminal_typescript_write_buffer(
+        guac_terminal_typescript* typescript, const char* buffer, int length);
+
+/**
+ * Flushes any pending data to the typescript, recording a new timestamp for
+ * the timing file if any data was flushed. Flushed data and timestamps are
+ * written by the writer thread of the typescript in batches, once a full
+ * segment of data or timestamps has accumulated or the typescript is freed,
+ * and thus may not yet be present within the data and timing files when this
+ * function returns.
  *
  * @param typescript
  *     The typescript which should be flushed.
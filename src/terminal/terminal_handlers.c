@@ -31,7 +31,9 @@
 #include <guacamole/socket.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 
 /**
@@ -49,6 +51,18 @@
  */
 #define GUAC_TERMINAL_OK          "\x1B[0n"
 
+/**
+ * The number of continuation bytes still expected by guac_terminal_echo()
+ * for the UTF-8 sequence currently being decoded, if any.
+ */
+static int guac_terminal_echo_bytes_remaining = 0;
+
+/**
+ * The portion of the codepoint decoded so far by guac_terminal_echo() from
+ * the UTF-8 sequence currently being decoded.
+ */
+static int guac_terminal_echo_codepoint = 0;
+
 /**
  * Advances the cursor to the next row, scrolling if the cursor would otherwise
  * leave the scrolling region. If the cursor is already outside the scrolling
@@ -128,8 +142,8 @@ int guac_terminal_echo(guac_terminal* term, unsigned char c) {
 
     int width;
 
-    static int bytes_remaining = 0;
-    static int codepoint = 0;
+    int bytes_remaining = guac_terminal_echo_bytes_remaining;
+    int codepoint = guac_terminal_echo_codepoint;
 
     const int* char_mapping = term->char_mapping[term->active_char_set];
 
@@ -187,6 +201,9 @@ int guac_terminal_echo(guac_terminal* term, unsigned char c) {
         bytes_remaining = 0;
     }
 
+    guac_terminal_echo_bytes_remaining = bytes_remaining;
+    guac_terminal_echo_codepoint = codepoint;
+
     /* If we need more bytes, wait for more bytes */
     if (bytes_remaining != 0)
         return 0;
@@ -296,6 +313,114 @@ int guac_terminal_echo(guac_terminal* term, unsigned char c) {
 
 }
 
+/**
+ * Returns whether the given byte is printable ASCII, and thus would be
+ * written as a single-column character by guac_terminal_echo().
+ *
+ * @param c
+ *     The byte to test.
+ *
+ * @return
+ *     Non-zero if the given byte is printable ASCII, zero otherwise.
+ */
+static int guac_terminal_is_printable(char c) {
+    return c >= 0x20 && c <= 0x7E;
+}
+
+/**
+ * Returns the number of bytes at the beginning of the given buffer which are
+ * printable ASCII. The buffer is scanned a word at a time, checking eight
+ * bytes at once for any byte outside the printable range.
+ *
+ * @param c
+ *     The buffer to scan.
+ *
+ * @param size
+ *     The number of bytes within the buffer.
+ *
+ * @return
+ *     The number of bytes at the beginning of the given buffer which are
+ *     printable ASCII.
+ */
+static int guac_terminal_printable_length(const char* c, int size) {
+
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t high = 0x8080808080808080ULL;
+
+    int length = 0;
+
+    /* Skip whole words containing only printable ASCII */
+    while (size - length >= sizeof(uint64_t)) {
+
+        uint64_t word;
+        memcpy(&word, c + length, sizeof(word));
+
+        /* Any byte less than 0x20 or greater than 0x7E (including all bytes
+         * with the high bit set) marks the end of the printable run */
+        uint64_t below = (word - ones * 0x20) & ~word;
+        uint64_t above = (word + ones * (0x7F - 0x7E)) | word;
+        if ((below | above) & high)
+            break;
+
+        length += sizeof(uint64_t);
+
+    }
+
+    /* Check remaining bytes individually */
+    while (length < size && guac_terminal_is_printable(c[length]))
+        length++;
+
+    return length;
+
+}
+
+int guac_terminal_echo_text(guac_terminal* term, const char* text,
+        int length) {
+
+    /* Bulk handling is possible only if characters are written untranslated
+     * and without shifting existing characters */
+    if (term->pipe_stream != NULL
+            || term->char_mapping[term->active_char_set] != NULL
+            || term->insert_mode)
+        return 0;
+
+    length = guac_terminal_printable_length(text, length);
+    int handled = length;
+
+    /* Like guac_terminal_echo(), abandon any incomplete UTF-8 sequence once
+     * ASCII is received */
+    if (handled > 0) {
+        guac_terminal_echo_bytes_remaining = 0;
+        guac_terminal_echo_codepoint = text[handled - 1];
+    }
+
+    while (length > 0) {
+
+        /* Wrap if necessary */
+        if (term->cursor_col >= term->term_width) {
+            term->cursor_col = 0;
+            guac_terminal_linefeed(term);
+        }
+
+        /* Write as much as fits within the current row */
+        int chunk = term->term_width - term->cursor_col;
+        if (chunk > length)
+            chunk = length;
+
+        guac_terminal_set_text(term, term->cursor_row, term->cursor_col,
+                text, chunk);
+
+        /* Advance cursor */
+        term->cursor_col += chunk;
+        text += chunk;
+        length -= chunk;
+
+    }
+
+    return handled;
+
+}
+
 int guac_terminal_escape(guac_terminal* term, unsigned char c) {
 
     switch (c) {
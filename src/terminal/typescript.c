@@ -24,8 +24,10 @@
 #include <guacamole/timestamp.h>
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <sys/types.h>
@@ -108,6 +110,108 @@ static int guac_terminal_typescript_open_data_file(const char* path,
 
 }
 
+/**
+ * Writes the given segment to the data and timing files of the given
+ * typescript, producing one line within the timing file for each timing entry
+ * of the segment. As all timing lines and all terminal output of the segment
+ * are each stored contiguously, each file receives only a single write per
+ * segment.
+ *
+ * @param typescript
+ *     The typescript whose files should be written.
+ *
+ * @param segment
+ *     The segment to write.
+ */
+static void guac_terminal_typescript_write_segment(
+        guac_terminal_typescript* typescript,
+        guac_terminal_typescript_segment* segment) {
+
+    char timing_buffer[GUAC_TERMINAL_TYPESCRIPT_MAX_TIMINGS
+        * GUAC_TERMINAL_TYPESCRIPT_MAX_TIMING_LENGTH];
+    int timing_length = 0;
+
+    /* Produce one line of timestamp output per flush */
+    for (int i = 0; i < segment->timing_count; i++) {
+
+        guac_terminal_typescript_timing* timing = &segment->timings[i];
+
+        int length = snprintf(timing_buffer + timing_length,
+                GUAC_TERMINAL_TYPESCRIPT_MAX_TIMING_LENGTH,
+                "%0.6f %i\n", timing->elapsed / 1000.0, timing->length);
+
+        /* Calculate actual length of timestamp line */
+        if (length >= GUAC_TERMINAL_TYPESCRIPT_MAX_TIMING_LENGTH)
+            length = GUAC_TERMINAL_TYPESCRIPT_MAX_TIMING_LENGTH - 1;
+
+        timing_length += length;
+
+    }
+
+    /* Write timestamps to timing file */
+    guac_common_write(typescript->timing_fd, timing_buffer, timing_length);
+
+    /* Empty buffer into data file */
+    guac_common_write(typescript->data_fd, segment->buffer,
+            segment->flushed_length);
+
+}
+
+/**
+ * Writer thread which writes each segment handed off by
+ * guac_terminal_typescript_flush() to the data and timing files of the
+ * typescript, until the typescript is freed.
+ *
+ * @param data
+ *     The guac_terminal_typescript whose segments should be written.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_terminal_typescript_writer(void* data) {
+
+    guac_terminal_typescript* typescript = (guac_terminal_typescript*) data;
+
+    pthread_mutex_lock(&typescript->lock);
+    for (;;) {
+
+        /* Wait for a segment to write or for the typescript to be freed */
+        while (typescript->pending == NULL && !typescript->stopping)
+            pthread_cond_wait(&typescript->modified, &typescript->lock);
+
+        guac_terminal_typescript_segment* segment = typescript->pending;
+        if (segment == NULL)
+            break;
+
+        /* Write segment without blocking the terminal */
+        pthread_mutex_unlock(&typescript->lock);
+        guac_terminal_typescript_write_segment(typescript, segment);
+        pthread_mutex_lock(&typescript->lock);
+
+        /* Segment may now be reused */
+        typescript->pending = NULL;
+        pthread_cond_broadcast(&typescript->modified);
+
+    }
+    pthread_mutex_unlock(&typescript->lock);
+
+    return NULL;
+
+}
+
+/**
+ * Resets the given segment such that it contains no terminal output.
+ *
+ * @param segment
+ *     The segment to reset.
+ */
+static void guac_terminal_typescript_reset_segment(
+        guac_terminal_typescript_segment* segment) {
+    segment->length = 0;
+    segment->timing_count = 0;
+    segment->flushed_length = 0;
+}
+
 guac_terminal_typescript* guac_terminal_typescript_alloc(const char* path,
         const char* name, int create_path) {
 
@@ -149,33 +253,109 @@ guac_terminal_typescript* guac_terminal_typescript_alloc(const char* path,
     }
 
     /* Typescript starts out flushed */
-    typescript->length = 0;
+    guac_terminal_typescript_reset_segment(&typescript->segments[0]);
+    guac_terminal_typescript_reset_segment(&typescript->segments[1]);
+    typescript->active = &typescript->segments[0];
+    typescript->pending = NULL;
+    typescript->stopping = 0;
     typescript->last_flush = guac_timestamp_current();
 
     /* Write header */
     guac_common_write(typescript->data_fd, GUAC_TERMINAL_TYPESCRIPT_HEADER,
             sizeof(GUAC_TERMINAL_TYPESCRIPT_HEADER) - 1);
 
+    pthread_mutex_init(&typescript->lock, NULL);
+    pthread_cond_init(&typescript->modified, NULL);
+
+    /* Start writing segments in the background */
+    if (pthread_create(&typescript->writer, NULL,
+                guac_terminal_typescript_writer, typescript)) {
+        pthread_cond_destroy(&typescript->modified);
+        pthread_mutex_destroy(&typescript->lock);
+        close(typescript->data_fd);
+        close(typescript->timing_fd);
+        free(typescript);
+        return NULL;
+    }
+
     return typescript;
 
 }
 
+/**
+ * Hands the active segment of the given typescript to its writer thread,
+ * replacing it with the other, empty segment. The active segment must have
+ * been flushed with guac_terminal_typescript_flush(). If the writer thread is
+ * still writing the other segment, this function waits for the writer thread
+ * to finish. As segments are handed off only once full, this wait occurs only
+ * if the writer thread cannot keep up with terminal output.
+ *
+ * @param typescript
+ *     The typescript whose active segment should be written.
+ */
+static void guac_terminal_typescript_submit(
+        guac_terminal_typescript* typescript) {
+
+    pthread_mutex_lock(&typescript->lock);
+
+    /* Wait for previous segment to be written */
+    while (typescript->pending != NULL)
+        pthread_cond_wait(&typescript->modified, &typescript->lock);
+
+    guac_terminal_typescript_segment* segment = typescript->active;
+
+    /* Hand off active segment, continuing with the other (now written)
+     * segment */
+    typescript->pending = segment;
+    typescript->active = (segment == &typescript->segments[0])
+        ? &typescript->segments[1] : &typescript->segments[0];
+
+    guac_terminal_typescript_reset_segment(typescript->active);
+
+    pthread_cond_broadcast(&typescript->modified);
+    pthread_mutex_unlock(&typescript->lock);
+
+}
+
 void guac_terminal_typescript_write(guac_terminal_typescript* typescript,
         char c) {
+    guac_terminal_typescript_write_buffer(typescript, &c, 1);
+}
+
+void guac_terminal_typescript_write_buffer(
+        guac_terminal_typescript* typescript, const char* buffer, int length) {
+
+    while (length > 0) {
+
+        guac_terminal_typescript_segment* segment = typescript->active;
+
+        /* Flush buffer (handing it off) if no space is available */
+        if (segment->length == sizeof(segment->buffer)) {
+            guac_terminal_typescript_flush(typescript);
+            continue;
+        }
+
+        /* Append as much data as fits within buffer */
+        int chunk = sizeof(segment->buffer) - segment->length;
+        if (chunk > length)
+            chunk = length;
 
-    /* Flush buffer if no space is available */
-    if (typescript->length == sizeof(typescript->buffer))
-        guac_terminal_typescript_flush(typescript);
+        memcpy(segment->buffer + segment->length, buffer, chunk);
+        segment->length += chunk;
 
-    /* Append single byte to buffer */
-    typescript->buffer[typescript->length++] = c;
+        buffer += chunk;
+        length -= chunk;
+
+    }
 
 }
 
 void guac_terminal_typescript_flush(guac_terminal_typescript* typescript) {
 
-    /* Do nothing if nothing to flush */
-    if (typescript->length == 0)
+    guac_terminal_typescript_segment* segment = typescript->active;
+
+    /* Record timing only if there is something to flush */
+    if (segment->length == segment->flushed_length)
         return;
 
     /* Get timestamps of previous and current flush */
@@ -187,27 +367,25 @@ void guac_terminal_typescript_flush(guac_terminal_typescript* typescript) {
     if (elapsed_time > GUAC_TERMINAL_TYPESCRIPT_MAX_DELAY)
         elapsed_time = GUAC_TERMINAL_TYPESCRIPT_MAX_DELAY;
 
-    /* Produce single line of timestamp output */
-    char timestamp_buffer[32];
-    int timestamp_length = snprintf(timestamp_buffer, sizeof(timestamp_buffer),
-            "%0.6f %i\n", elapsed_time / 1000.0, typescript->length);
+    /* Record timing of all newly-flushed output */
+    guac_terminal_typescript_timing* timing =
+        &segment->timings[segment->timing_count++];
 
-    /* Calculate actual length of timestamp line */
-    if (timestamp_length > sizeof(timestamp_buffer))
-        timestamp_length = sizeof(timestamp_buffer);
-
-    /* Write timestamp to timing file */
-    guac_common_write(typescript->timing_fd,
-            timestamp_buffer, timestamp_length);
-
-    /* Empty buffer into data file */
-    guac_common_write(typescript->data_fd,
-            typescript->buffer, typescript->length);
+    timing->elapsed = elapsed_time;
+    timing->length = segment->length - segment->flushed_length;
 
     /* Buffer is now flushed */
-    typescript->length = 0;
+    segment->flushed_length = segment->length;
     typescript->last_flush = this_flush;
 
+    /* Accumulate flushes within the active segment, writing the segment in
+     * the background only once it can hold no further output or timings.
+     * Any remaining flushed output is handed off when the typescript is
+     * freed. */
+    if (segment->length == sizeof(segment->buffer)
+            || segment->timing_count == GUAC_TERMINAL_TYPESCRIPT_MAX_TIMINGS)
+        guac_terminal_typescript_submit(typescript);
+
 }
 
 void guac_terminal_typescript_free(guac_terminal_typescript* typescript) {
@@ -216,8 +394,21 @@ void guac_terminal_typescript_free(guac_terminal_typescript* typescript) {
     if (typescript == NULL)
         return;
 
-    /* Flush any pending data */
+    /* Flush any pending data, handing off any flushed output which has not
+     * yet filled a segment */
     guac_terminal_typescript_flush(typescript);
+    if (typescript->active->timing_count > 0)
+        guac_terminal_typescript_submit(typescript);
+
+    /* Wait for all segments to be written */
+    pthread_mutex_lock(&typescript->lock);
+    typescript->stopping = 1;
+    pthread_cond_broadcast(&typescript->modified);
+    pthread_mutex_unlock(&typescript->lock);
+
+    pthread_join(typescript->writer, NULL);
+    pthread_cond_destroy(&typescript->modified);
+    pthread_mutex_destroy(&typescript->lock);
 
     /* Write footer */
     guac_common_write(typescript->data_fd, GUAC_TERMINAL_TYPESCRIPT_FOOTER,